@@ -5,17 +5,19 @@
 
     Custom adc-wrapper around the Raspberry-Pi-Pico-SDK. Lets user configure single channel and multi channel measurement with RP-Pi-Pico ADC.
     This module uses DMA-Channels to get the data from ADC to RAM.
+    In block capture mode the ADC samples with the exact ADC clock rate into two alternating buffers (double buffering),
+    a callback is called from the DMA interrupt for every completed block while the DMA already fills the other buffer.
+    A block capture could be triggered too (adc_arm_block_capture()), then the ADC captures a single block p. trigger.
+    In multi-channel mode the ADC samples the channels round-robin (ascending channel number), the DMA writes the samples interleaved
+    (one sample p. channel and round), use adc_deinterleave_block() to split a block into channel buffers.
 
-    NOTE: This module is not multi-core-save
-    NOTE: Except the temperature sensor all measurements are with fixed 8-Bit resolution, as the ENOB of the ADC is 8.9 (see RP2040 Data-sheet)
-    NOTE: Multichannel function was not properly tested - as it may needs changes
-    NOTE: Temperature Sensor in multi-channel measurement makes no sense as in multi-channel mode the resolution is set to 8-Bit, the temperature sensor needs a resolution
-          of 12-Bits (because the change in voltage with temperature is to small to measure properly with 8-Bit)
+    The resolution is 8-Bit by default (the ENOB of the ADC is 8.9, see RP2040 Data-sheet) or 12-Bit (adc_set_resolution()) with 16-bit DMA elements.
+    In 12-Bit mode the blocks could be oversampled and decimated with a CIC filter (order 1 is a boxcar average), every 4x oversampling
+    gives about one effective bit more, e.g. 500 kS/s with ratio 8 gives 62.5 kS/s with 13-Bit output and about 10.4 ENOB.
 
-    //TODO: Test Multi-Channel measurement
+    NOTE: This module is not multi-core-save
+    NOTE: The temperature sensor needs the 12-Bit mode (the change in voltage with temperature is to small to measure properly with 8-Bit)
 
-    FUTURE_FEATURE: New and improved multichannel functions
-    FUTURE_FEATURE: New and improved temperature measurement
     FUTURE_FEATURE: Multi-core
 
 */
@@ -35,12 +37,110 @@
 
 //Preprocessor constants:
 
+//Number of ADC inputs (four gpio channels and the temperature sensor)
+#define MAX_ADC_CHANNELS 5
+
+//Maximum number of blocks of a ring capture
+#define ADC_MAX_BLOCK_BUFFERS 16
+
+//Limits of the oversample and decimate stage
+#define ADC_MAX_OVERSAMPLING_RATIO 256
+#define ADC_MAX_CIC_ORDER 3
+
+//Sample rate limits (one conversion takes 96 cycles of the 48 MHz ADC clock, the clock divider has 16 integer bits)
+#define ADC_MAX_SAMPLE_RATE 500000
+#define ADC_MIN_SAMPLE_RATE 733
+
+//System monitor: rolling window (samples p. channel), VSYS (Pico: GPIO29 = VSYS/3) and temperature sensor
+#define ADC_MONITOR_WINDOW_SIZE 64
+#define ADC_MONITOR_VSYS_CHANNEL 3
+#define ADC_MONITOR_VSYS_GPIO 29
+#define ADC_MONITOR_TEMPERATURE_CHANNEL 4
+
 //Type definitions:
 
+//Instrumentation of the capture (see adc_get_capture_statistic())
+typedef struct ADC_Capture_Statistic_s {
+
+    //Checks that found the sticky FIFO flags set: overflow (samples lost, the DMA did not keep up) and underflow (FIFO read while empty)
+    uint32_t fifo_overflows;
+    uint32_t fifo_underflows;
+    //Checks that found the sticky conversion error flag set
+    uint32_t conversion_errors;
+    //Highest FIFO level at the end of a block (0 or 1 if the DMA keeps up)
+    uint8_t max_fifo_level;
+    //Completed DMA blocks and samples (all channels) of the block capture
+    uint32_t completed_blocks;
+    uint64_t number_of_samples;
+    //Measured sample rate (samples per second and channel) over the captured blocks
+    float effective_sample_rate;
+
+}ADC_Capture_Statistic_t;
+
+//Rolling statistic of the system monitor (raw 12-bit ADC codes)
+typedef struct ADC_System_Monitor_Statistic_s {
+
+    //Samples in the window (up to ADC_MONITOR_WINDOW_SIZE)
+    uint16_t number_of_samples;
+    float vsys_mean_value;
+    float vsys_std_deviation;
+    float temperature_mean_value;
+    float temperature_std_deviation;
+    //Time since the last sample, the monitor pauses while the ADC is configured
+    uint32_t age_ms;
+
+}ADC_System_Monitor_Statistic_t;
+
+//Callback that is called from the DMA interrupt when a block is complete (buffer_index 0 or 1, 0 to number_of_blocks - 1 for a ring capture),
+//the DMA fills the next buffer meanwhile
+//The block holds uint8_t samples in 8-bit mode and uint16_t samples in 12-bit mode
+typedef void (*adc_block_callback_t)(const void *block, uint32_t num_of_samples, uint8_t buffer_index);
+
 //Function prototypes:
 
 //Configuration:
 
+/**
+ * @brief Sets the resolution of the following configurations.
+ *
+ * In 8-bit mode the ADC FIFO shifts the result to 8 bit and block buffers hold uint8_t samples,
+ * in 12-bit mode the full result is transferred with 16-bit DMA elements and block buffers hold uint16_t samples.
+ *
+ * @param resolution_in_bits 8 or 12 (default 8).
+ *
+ * @return Returns 1 on success, -1 for wrong parameters and -2 if the ADC is configured already.
+ */
+int adc_set_resolution(uint8_t resolution_in_bits);
+
+/**
+ * @brief Returns the configured resolution (8 or 12 bit).
+ */
+uint8_t adc_get_resolution(void);
+
+/**
+ * @brief Configures the oversample and decimate stage of adc_decimate_block().
+ *
+ * A CIC filter of order cic_order (1 is a boxcar average of oversampling_ratio samples) decimates every channel by oversampling_ratio.
+ * The output has adc_get_decimated_resolution() bits: every 4x oversampling adds one bit (12 bit + log2(ratio)/2, at most 16 bit).
+ * Higher orders suppress the aliasing better, but the first cic_order - 1 outputs after a start are not settled.
+ *
+ * @param oversampling_ratio Decimation ratio, power of two from 1 to ADC_MAX_OVERSAMPLING_RATIO.
+ * @param cic_order Order of the CIC filter, 1 to ADC_MAX_CIC_ORDER (12 + cic_order*log2(ratio) has to fit into 32 bit).
+ *
+ * @return Returns 1 on success and -1 for wrong parameters.
+ */
+int adc_set_decimation(uint16_t oversampling_ratio, uint8_t cic_order);
+
+/**
+ * @brief Returns the resolution of the decimated samples in bits.
+ */
+uint8_t adc_get_decimated_resolution(void);
+
+/**
+ * @brief Resets the state of the decimation filter (done by adc_start_measurement() too).
+ */
+void adc_reset_decimation(void);
+
 /**
  * @brief Configures ADC for single-channel data capture.
  *
@@ -52,7 +152,7 @@
  * @param dma_capture_channel The DMA channel to be used for capturing ADC data.
  * @param dma_control_channel The DMA channel to be used for controlling ADC data transfer.
  *
- * @return Returns 1 on successful configuration, -1 for wrong parameters, and -3 if DMA channel is already claimed.
+ * @return Returns 1 on successful configuration, -1 for wrong parameters, -2 if the ADC is configured already and -3 if DMA channel is already claimed.
  */
 int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel);
 
@@ -60,26 +160,96 @@ int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint d
  * @brief Configures ADC for multi-channel data capture.
  *
  * This function configures the ADC (Analog-to-Digital Converter) for capturing data from multiple ADC channels.
- * It sets up the ADC sampling rate, DMA channels for data transfer, and other necessary configurations.
+ * The ADC samples the channels round-robin in ascending order, the DMA writes the last round to RAM,
+ * the value of each channel could be read with adc_get_channel_measurement().
  *
- * @param adc_channels An array containing the ADC channels to be configured for data capture.
+ * @param adc_channels An array containing the ADC channels to be configured for data capture (2 to 5 different channels, any order).
  * @param number_of_adc_channels The number of ADC channels in the adc_channels array.
- * @param adc_sample_rate The desired sample rate for ADC data capture (samples per second).
+ * @param adc_sample_rate The desired sample rate of each channel (samples per second), the ADC converts with number_of_adc_channels times this rate.
  * @param dma_capture_channel The DMA channel to be used for capturing ADC data.
  * @param dma_control_channel The DMA channel to be used for controlling ADC data transfer.
  *
- * @return Returns 1 on successful configuration, -1 for wrong parameters, -2 if ADC is configured in single-channel already, and -3 if DMA channel is already claimed.
+ * @return Returns 1 on successful configuration, -1 for wrong parameters, -2 if ADC is configured already, and -3 if DMA channel is already claimed.
  */
 int configure_adc_multi_channel(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel);
 
+/**
+ * @brief Configures ADC for single-channel block capture with double buffered DMA.
+ *
+ * The capture DMA channel writes block_size consecutive samples into buffer_0, then the control DMA channel restarts it on buffer_1
+ * and so on, so the capture runs gap-free with the exact ADC sample rate and without CPU per sample.
+ * After every block the block_callback is called from the DMA interrupt (DMA_IRQ_1).
+ *
+ * @param adc_channel The ADC channel to be configured for data capture.
+ * @param adc_sample_rate The desired sample rate for ADC data capture (ADC_MIN_SAMPLE_RATE to ADC_MAX_SAMPLE_RATE samples per second).
+ * @param dma_capture_channel The DMA channel to be used for capturing ADC data.
+ * @param dma_control_channel The DMA channel to be used for switching between the buffers.
+ * @param buffer_0 First buffer, needs space for block_size samples (uint8_t in 8-bit mode, uint16_t in 12-bit mode).
+ * @param buffer_1 Second buffer, needs space for block_size samples (uint8_t in 8-bit mode, uint16_t in 12-bit mode).
+ * @param block_size Number of samples p. block.
+ * @param block_callback Function that is called after every completed block (could be NULL).
+ *
+ * @return Returns 1 on successful configuration, -1 for wrong parameters, -2 if the ADC is configured already and -3 if DMA channel is already claimed.
+ *
+ * @note The callback runs in interrupt context, the block has to be processed (or copied) before the next block is complete.
+ *       Start and stop the capture with adc_start_measurement(), de-configure with deconfigure_adc().
+ */
+int configure_adc_block_capture(uint adc_channel, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel, void *buffer_0, 
+    void *buffer_1, uint32_t block_size, adc_block_callback_t block_callback);
+
+/**
+ * @brief Configures ADC for multi-channel (round-robin) block capture with double buffered DMA.
+ *
+ * Like configure_adc_block_capture(), but the ADC samples the channels round-robin in ascending order,
+ * so every block holds block_size/number_of_adc_channels complete rounds of interleaved samples
+ * (e.g. channels {4, 3}: ch3, ch4, ch3, ch4, ...). Every block starts with the first channel.
+ *
+ * @param adc_channels An array containing the ADC channels to be configured for data capture (1 to 5 different channels, any order).
+ * @param number_of_adc_channels The number of ADC channels in the adc_channels array.
+ * @param adc_sample_rate The desired sample rate of each channel, the ADC converts with number_of_adc_channels times this rate.
+ * @param dma_capture_channel The DMA channel to be used for capturing ADC data.
+ * @param dma_control_channel The DMA channel to be used for switching between the buffers.
+ * @param buffer_0 First buffer, needs space for block_size samples (uint8_t in 8-bit mode, uint16_t in 12-bit mode).
+ * @param buffer_1 Second buffer, needs space for block_size samples (uint8_t in 8-bit mode, uint16_t in 12-bit mode).
+ * @param block_size Number of samples p. block (all channels), has to be a multiple of number_of_adc_channels.
+ * @param block_callback Function that is called after every completed block (could be NULL).
+ *
+ * @return Returns 1 on successful configuration, -1 for wrong parameters, -2 if the ADC is configured already and -3 if DMA channel is already claimed.
+ *
+ * @note Use adc_deinterleave_block() to split a block into one buffer p. channel.
+ */
+int configure_adc_multi_channel_block_capture(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, 
+    uint dma_control_channel, void *buffer_0, void *buffer_1, uint32_t block_size, adc_block_callback_t block_callback);
+
+/**
+ * @brief Configures ADC for a continuous capture into a ring of blocks.
+ *
+ * Like configure_adc_multi_channel_block_capture(), but with number_of_blocks consecutive blocks in one ring buffer,
+ * the DMA writes block 0, 1, ..., number_of_blocks - 1, 0, ... without CPU. So the last (number_of_blocks - 1) blocks are
+ * always in the ring (sample n of the capture is at ring position n%(number_of_blocks*block_size)).
+ *
+ * @param adc_channels An array containing the ADC channels to be configured for data capture (1 to 5 different channels, any order).
+ * @param number_of_adc_channels The number of ADC channels in the adc_channels array.
+ * @param adc_sample_rate The desired sample rate of each channel, the ADC converts with number_of_adc_channels times this rate.
+ * @param dma_capture_channel The DMA channel to be used for capturing ADC data.
+ * @param dma_control_channel The DMA channel to be used for switching between the blocks.
+ * @param ring_buffer Ring buffer, needs space for number_of_blocks*block_size samples (uint8_t in 8-bit mode, uint16_t in 12-bit mode).
+ * @param number_of_blocks Number of blocks, power of two from 2 to ADC_MAX_BLOCK_BUFFERS.
+ * @param block_size Number of samples p. block (all channels), has to be a multiple of number_of_adc_channels.
+ * @param block_callback Function that is called after every completed block (could be NULL).
+ *
+ * @return Returns 1 on successful configuration, -1 for wrong parameters, -2 if the ADC is configured already and -3 if DMA channel is already claimed.
+ */
+int configure_adc_ring_capture(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, 
+    uint dma_control_channel, void *ring_buffer, uint8_t number_of_blocks, uint32_t block_size, adc_block_callback_t block_callback);
+
 /**
  * @brief De-configures ADC and associated resources.
  *
- * This function stops the ADC and DMA operations, cleans up associated resources,
- * and resets relevant flags and variables.
+ * This function stops the ADC and DMA operations, cleans up associated resources
+ * (gpio pins and temperature sensor of all configured channels) and resets relevant flags and variables.
  *
- * @return Returns 1 on successful de-configuration, -1 if there is another function for single-channel setup,
- * and -1 if there are only five ADC channels.
+ * @return Returns 1 on successful de-configuration and -1 if the ADC is not configured.
  */
 int deconfigure_adc(void);
 
@@ -90,6 +260,7 @@ int deconfigure_adc(void);
  *
  * This function starts or stops ADC measurement based on the provided flag.
  * If the measurement is started, DMA transfer is also initiated to transfer ADC data.
+ * Every start begins with the first channel of the round, so the interleaved order is always the same.
  *
  * @param start Boolean flag indicating whether to start (true) or stop (false) the ADC measurement.
  *
@@ -97,6 +268,36 @@ int deconfigure_adc(void);
  */
 int adc_start_measurement(bool start);
 
+/**
+ * @brief Captures a single block (triggered block capture).
+ *
+ * Starts the ADC and the capture DMA on the next buffer of the configured block capture, the ADC stops when the block is complete
+ * (the block callback and adc_get_block_count() work like in the continuous block capture, the first trigger resets the count).
+ * Meant to be called from an event, e.g. the DAC step callback of the pwm module, so every block has the same position to the event.
+ *
+ * @return Returns 1 on success, -1 if no block capture is configured and -2 if the ADC is still capturing.
+ *
+ * @note adc_start_measurement(true) switches back to the continuous block capture.
+ */
+int adc_arm_block_capture(void);
+
+/**
+ * @brief Retrieves the last ADC measurement of a configured channel (single or multi-channel mode) with 8 bit.
+ *
+ * @param adc_channel The ADC channel (0-3 gpio pins 26-29, 4 temperature sensor).
+ * @param measured_value Pointer to store the measured ADC value.
+ *
+ * @return Returns 1 on successful retrieval, -2 if ADC channel is not configured and -3 in block capture mode (samples are in the blocks).
+ */
+int adc_get_channel_measurement(uint adc_channel, uint8_t *measured_value);
+
+/**
+ * @brief Retrieves the last ADC measurement of a configured channel with the configured resolution (8 or 12 bit).
+ *
+ * @return Returns 1 on successful retrieval, -2 if ADC channel is not configured and -3 in block capture mode (samples are in the blocks).
+ */
+int adc_get_channel_raw_measurement(uint adc_channel, uint16_t *measured_value);
+
 /**
  * @brief Retrieves ADC measurement for a specified GPIO pin.
  *
@@ -106,7 +307,7 @@ int adc_start_measurement(bool start);
  * @param measured_value Pointer to store the measured ADC value.
  *
  * @return Returns 1 on successful retrieval, -1 if configured ADC channel is not connected to gpio_pin
- * or gpio_pin doesn't have analog channel function, -2 if ADC channel is not configured.
+ * or gpio_pin doesn't have analog channel function, -2 if ADC channel is not configured and -3 in block capture mode.
  * 
  */
 int adc_get_gpio_measurement(uint adc_gpio_pin, uint8_t *measured_value);
@@ -122,4 +323,123 @@ int adc_get_gpio_measurement(uint adc_gpio_pin, uint8_t *measured_value);
  */
 int adc_get_temperature_measurement(uint8_t *temperature_value);
 
+/**
+ * @brief Returns the position of a channel in the round-robin order (index of its samples in a round), -1 if the channel is not configured.
+ */
+int adc_get_channel_position(uint adc_channel);
+
+/**
+ * @brief Returns the number of configured channels (0 if the ADC is not configured).
+ */
+uint8_t adc_get_number_of_channels(void);
+
+/**
+ * @brief Splits an interleaved block (multi-channel block capture) into one buffer p. channel.
+ *
+ * @param block Interleaved block, starting with the first channel of the round.
+ * @param num_of_samples Number of samples in the block (all channels).
+ * @param channel_samples Destination buffer p. ADC channel (index is the ADC channel number), each needs space for
+ *        num_of_samples/number_of_channels samples (uint8_t or uint16_t like the block). Channels with a NULL entry are skipped.
+ *
+ * @return Returns the number of samples p. channel, -1 for wrong parameters or if the ADC is not configured.
+ */
+int adc_deinterleave_block(const void *block, uint32_t num_of_samples, void *channel_samples[MAX_ADC_CHANNELS]);
+
+/**
+ * @brief Oversamples and decimates a 12-bit block (single or multi-channel) with the stage set by adc_set_decimation().
+ *
+ * Every channel is filtered on its own, the output is interleaved like the block (one round p. oversampling_ratio rounds)
+ * with adc_get_decimated_resolution() bits. The filter state is kept between the blocks, so the blocks don't have to hold
+ * a multiple of oversampling_ratio rounds. The block could be decimated in place (decimated == block).
+ *
+ * @param block 12-bit block, starting with the first channel of the round.
+ * @param num_of_samples Number of samples in the block (complete rounds).
+ * @param decimated Output buffer, needs space for num_of_samples/oversampling_ratio + number_of_channels samples.
+ *
+ * @return Returns the number of decimated samples, -1 for wrong parameters and -2 if the ADC is not in 12-bit mode.
+ */
+int adc_decimate_block(const uint16_t *block, uint32_t num_of_samples, uint16_t *decimated);
+
+/**
+ * @brief Returns the number of samples the DMA has written since the start of the block (or ring) capture.
+ *
+ * Could be called from other interrupts (e.g. a gpio trigger) to get the position of an event in the capture.
+ */
+uint32_t adc_get_sample_count(void);
+
+/**
+ * @brief Returns the number of completed blocks since the start of the block capture.
+ */
+uint32_t adc_get_block_count(void);
+
+/**
+ * @brief Returns the start time (system timer, us since boot) of the block in a buffer of the block (or ring) capture.
+ *
+ * The time is taken in the DMA interrupt and corrected by the samples the DMA has written into the next block since the end of the block,
+ * so the interrupt latency does not add jitter. Sample n of the block (all channels, in round-robin order) was converted at
+ * start_time_us + n*adc_get_conversion_period_us(). The timestamp is valid from the block callback till the buffer is written again.
+ *
+ * @param buffer_index Index of the buffer (as passed to the block callback, 0 ... number of buffers - 1).
+ * @param start_time_us Output of the start time.
+ *
+ * @return Returns 1 on success, -1 if the block capture is not configured and -2 for a wrong buffer index.
+ */
+int adc_get_block_timestamp(uint8_t buffer_index, uint64_t *start_time_us);
+
+/**
+ * @brief Returns the time between two conversions of the ADC in us (all channels, from the clock divider), set at the start of the capture.
+ */
+float adc_get_conversion_period_us(void);
+
+/**
+ * @brief Returns the instrumentation of the capture since the last adc_start_measurement(true) (or the first adc_arm_block_capture()).
+ *
+ * The sticky FIFO and error flags are checked (and cleared) at the end of every block, when the measurement is stopped and by this function,
+ * so in continuous mode (no blocks) call it regularly. Each counter counts the checks that found the flag set, not single samples
+ * (the FIFO holds no error bit, so the samples stay plain 8 or 12 bit values).
+ * The effective sample rate is measured with the system timer from the start (or the trigger) to the end of every block,
+ * so it is only available in block capture mode.
+ *
+ * @param statistic Output of the counters.
+ *
+ * @return Returns 1 on success and -1 if the ADC is not configured.
+ */
+int adc_get_capture_statistic(ADC_Capture_Statistic_t *statistic);
+
+/**
+ * @brief Starts the background system monitor (VSYS and temperature sensor).
+ *
+ * A repeating timer takes one 12-bit sample of VSYS and of the temperature sensor every period_ms (single conversions, a few us),
+ * but only while the ADC is not configured, so running captures are never disturbed (the monitor samples in the gaps between them).
+ * The last ADC_MONITOR_WINDOW_SIZE samples are kept with running sums, so the statistic could be read in O(1).
+ *
+ * @note The timer callback runs on the core that started the monitor, configure the ADC on the same core.
+ *
+ * @param period_ms Time between two samples.
+ *
+ * @return Returns 1 on success, -1 for a wrong period, -2 if the monitor is running already and -3 if no timer is free.
+ */
+int adc_system_monitor_start(uint32_t period_ms);
+
+/**
+ * @brief Stops the background system monitor.
+ *
+ * @return Returns 1 on success and -1 if the monitor is not running.
+ */
+int adc_system_monitor_stop(void);
+
+/**
+ * @brief Returns mean value and standard deviation (ADC codes) of the rolling window of the system monitor.
+ *
+ * @param statistic Output of the statistic.
+ *
+ * @return Returns 1 on success, -1 if the monitor is not running and -2 if there is no sample yet.
+ */
+int adc_system_monitor_get_statistic(ADC_System_Monitor_Statistic_t *statistic);
+
+/**
+ * @brief Returns the real sample rate of the ADC (samples per second and channel), calculated from the configured clock divider.
+ */
+float adc_get_sample_rate(void);
+
 //end file adc.h
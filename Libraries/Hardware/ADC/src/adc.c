@@ -5,17 +5,19 @@
 
     Custom adc-wrapper around the Raspberry-Pi-Pico-SDK. Lets user configure single channel and multi channel measurement with RP-Pi-Pico ADC.
     This module uses DMA-Channels to get the data from ADC to RAM.
+    In block capture mode the ADC samples with the exact ADC clock rate into two alternating buffers (double buffering),
+    a callback is called from the DMA interrupt for every completed block while the DMA already fills the other buffer.
+    A block capture could be triggered too (adc_arm_block_capture()), then the ADC captures a single block p. trigger.
+    In multi-channel mode the ADC samples the channels round-robin (ascending channel number), the DMA writes the samples interleaved
+    (one sample p. channel and round), use adc_deinterleave_block() to split a block into channel buffers.
 
-    NOTE: This module is not multi-core-save
-    NOTE: Except the temperature sensor all measurements are with fixed 8-Bit resolution, as the ENOB of the ADC is 8.9 (see RP2040 Data-sheet)
-    NOTE: Multichannel function was not properly tested - as it may needs changes
-    NOTE: Temperature Sensor in multi-channel measurement makes no sense as in multi-channel mode the resolution is set to 8-Bit, the temperature sensor needs a resolution
-          of 12-Bits (because the change in voltage with temperature is to small to measure properly with 8-Bit)
+    The resolution is 8-Bit by default (the ENOB of the ADC is 8.9, see RP2040 Data-sheet) or 12-Bit (adc_set_resolution()) with 16-bit DMA elements.
+    In 12-Bit mode the blocks could be oversampled and decimated with a CIC filter (order 1 is a boxcar average), every 4x oversampling
+    gives about one effective bit more, e.g. 500 kS/s with ratio 8 gives 62.5 kS/s with 13-Bit output and about 10.4 ENOB.
 
-    //TODO: Test Multi-Channel measurement
+    NOTE: This module is not multi-core-save
+    NOTE: The temperature sensor needs the 12-Bit mode (the change in voltage with temperature is to small to measure properly with 8-Bit)
 
-    FUTURE_FEATURE: New and improved multichannel functions
-    FUTURE_FEATURE: New and improved temperature measurement
     FUTURE_FEATURE: Multi-core
 
 */
@@ -27,6 +29,7 @@
 //Libraries:
 
 //Standard-C:
+#include <math.h>
 
 //Pico:
 
@@ -35,38 +38,94 @@
 //Pico Hardware-Libraries:
 #include "hardware/adc.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 
 //Own Libraries:
 #include "uart.h"
 
 //Preprocessor constants:
-#define MAX_ADC_CHANNELS 5
 #define MAX_ADC_SAMPLES 10240
+#define ADC_CLK_FREQUENCY (48*1000*1000)
+#define ADC_CYCLES_PER_CONVERSION 96
 
 //File global (static) variables:
 
+
 //Data:
 
-//Multi-channel-mode data and count of channels
+//Number of configured channels (1 in single channel mode)
 static uint8_t adc_number_of_channels = 0;
-//Data of each channel in single or multi-channel mode when using all channels
-static uint8_t adc_data[MAX_ADC_CHANNELS];
+//Data of the last round, in round-robin order (adc_data[k] is the sample of channel_list[k]), 8 or 12 bit
+static uint16_t adc_data[MAX_ADC_CHANNELS];
 
-//Data if using multi-channel-mode without using all channels: 
+//Configured channels in the order the ADC samples them in round-robin mode (ascending)
 static uint8_t channel_list[MAX_ADC_CHANNELS];
-static uint8_t adc_data_2_channels[2];
-static uint8_t adc_data_3_channels[3];
-static uint8_t adc_data_4_channels[4];
 
 //Start address for DMA
-static uint8_t* start_address[1] = {NULL};
+static uint16_t* start_address[1] = {NULL};
 
 //DMA Channels
 static uint dma_adc_capture_channel = 0;
 static uint dma_adc_control_channel = 0;
 
+//Block capture:
+
+//Start addresses of the buffers, the control channel reads them in a ring (aligned to the size of the list for the DMA read ring)
+static void* adc_block_addresses[ADC_MAX_BLOCK_BUFFERS] __attribute__((aligned(4*ADC_MAX_BLOCK_BUFFERS)));
+//Number of buffers (power of two, 2 for double buffering)
+static uint8_t adc_number_of_block_buffers = 0;
+static uint32_t adc_block_size = 0;
+static adc_block_callback_t adc_block_callback = NULL;
+//Buffer of the block that is filled at the moment and number of completed blocks
+static volatile uint8_t adc_block_index = 0;
+static volatile uint32_t adc_block_count = 0;
+//Triggered mode: every adc_arm_block_capture() captures a single block, the ADC stops after it
+static volatile bool adc_block_single_shot = false;
+
+//Instrumentation:
+
+static volatile uint32_t adc_fifo_overflows = 0;
+static volatile uint32_t adc_fifo_underflows = 0;
+static volatile uint32_t adc_conversion_errors = 0;
+static volatile uint8_t adc_max_fifo_level = 0;
+//Start of the block that is captured at the moment and sum of the block capture times
+static volatile uint64_t adc_block_start_time_us = 0;
+static volatile uint64_t adc_capture_time_us = 0;
+//Start time of the block in every buffer and time between two conversions (all channels)
+static volatile uint64_t adc_block_timestamps[ADC_MAX_BLOCK_BUFFERS];
+static float adc_conversion_period_us = 0;
+
+//System monitor (VSYS and temperature sensor in the gaps between the captures):
+
+static struct repeating_timer adc_monitor_timer;
+static volatile bool adc_monitor_is_running = false;
+//Rolling window of raw 12-bit samples p. channel and their sums (64*4095^2 fits into 32 bit)
+static uint16_t adc_monitor_window[2][ADC_MONITOR_WINDOW_SIZE];
+static uint32_t adc_monitor_sum[2];
+static uint32_t adc_monitor_sum_of_squares[2];
+static uint16_t adc_monitor_window_index = 0;
+static uint16_t adc_monitor_number_of_samples = 0;
+static uint64_t adc_monitor_last_sample_time_us = 0;
+
+//Oversampling and decimation (CIC filter, order 1 is a boxcar average):
+
+static uint16_t adc_oversampling_ratio = 1;
+static uint8_t adc_oversampling_ratio_log2 = 0;
+static uint8_t adc_cic_order = 1;
+//Right shift from the CIC gain (ratio^order) down to the decimated resolution
+static uint8_t adc_cic_output_shift = 0;
+//Round within the ratio rounds of one decimated sample
+static uint16_t adc_cic_phase = 0;
+//Filter state p. position in the round, 32 bit wrap-around arithmetic is exact as long as the output fits into 32 bit
+static uint32_t adc_cic_integrators[MAX_ADC_CHANNELS][ADC_MAX_CIC_ORDER];
+static uint32_t adc_cic_combs[MAX_ADC_CHANNELS][ADC_MAX_CIC_ORDER];
+
 //Configuration:
 
+//Resolution of the samples (8 or 12 bit)
+static uint8_t adc_resolution = 8;
+
 //ADC mode (singe or multi channel)
 static bool adc_channel_is_configured[MAX_ADC_CHANNELS];
 //Flag of each channel wich indicates if the channel is configured
@@ -75,6 +134,9 @@ static bool adc_mode_single_channel = false;
 //Temperature sensor flag
 static bool temperature_sensor_is_configured = false;
 
+//Block capture flag
+static bool adc_block_capture_is_configured = false;
+
 //Function definition:
 
 //File global (static) function definitions:
@@ -98,41 +160,220 @@ static int8_t get_gpio_from_channel(uint adc_channel) {
     }
 }//end get_gpio_from_channel
 
-//Function definitions:
+//Clock divider for a sample rate, the sample period is (1 + div) cycles of the ADC clock but at least one conversion (96 cycles)
+static float adc_get_clkdiv(float adc_sample_rate) {
 
-//Configuration:
-int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel) {
+    if(adc_sample_rate >= ADC_MAX_SAMPLE_RATE) {
+        return 0;
+    }
+    return ((float)ADC_CLK_FREQUENCY/adc_sample_rate) - 1;
+
+}//end adc_get_clkdiv
+
+//Takes one VSYS and one temperature sample if the ADC is not configured (capture gap), single conversions without FIFO (about 4 us)
+static bool adc_monitor_timer_callback(struct repeating_timer *timer) {
+
+    uint16_t samples[2];
+
+    if(adc_number_of_channels != 0) {
+        return true; //ADC is in use, skip this sample
+    }
+
+    if(!(adc_hw->cs & ADC_CS_EN_BITS)) {
+        adc_init();
+    }
+    adc_gpio_init(ADC_MONITOR_VSYS_GPIO);
+    adc_set_temp_sensor_enabled(true);
+    adc_set_round_robin(0);
+    adc_fifo_setup(false, false, 0, false, false);
+    adc_select_input(ADC_MONITOR_VSYS_CHANNEL);
+    samples[0] = adc_read();
+    adc_select_input(ADC_MONITOR_TEMPERATURE_CHANNEL);
+    samples[1] = adc_read();
+
+    //Replace the oldest sample of the window
+    for(uint8_t k = 0; k < 2; k++) {
+        uint16_t oldest = adc_monitor_window[k][adc_monitor_window_index];
+        adc_monitor_sum[k] += samples[k] - oldest;
+        adc_monitor_sum_of_squares[k] += (uint32_t)samples[k]*samples[k] - (uint32_t)oldest*oldest;
+        adc_monitor_window[k][adc_monitor_window_index] = samples[k];
+    }
+    adc_monitor_window_index = (adc_monitor_window_index + 1)%ADC_MONITOR_WINDOW_SIZE;
+    if(adc_monitor_number_of_samples < ADC_MONITOR_WINDOW_SIZE) {
+        adc_monitor_number_of_samples++;
+    }
+    adc_monitor_last_sample_time_us = time_us_64();
+
+    return true;
+
+}//end adc_monitor_timer_callback
+
+static void adc_monitor_get_channel(uint32_t sum, uint32_t sum_of_squares, uint16_t number_of_samples, float *mean_value, float *std_deviation) {
+
+    *mean_value = (float)sum/number_of_samples;
+    *std_deviation = 0;
+    if(number_of_samples > 1) {
+        //n*sum_of_squares - sum^2 is exact in 64 bit
+        uint64_t m2_scaled = (uint64_t)number_of_samples*sum_of_squares - (uint64_t)sum*sum;
+        *std_deviation = sqrtf((float)m2_scaled/((float)number_of_samples*(number_of_samples - 1)));
+    }
+
+}//end adc_monitor_get_channel
+
+//Counts and clears the sticky FIFO over-/underflow and conversion error flags
+static void adc_check_error_flags(void) {
+
+    uint32_t fcs = adc_hw->fcs;
+    uint8_t fifo_level = (uint8_t)((fcs & ADC_FCS_LEVEL_BITS) >> ADC_FCS_LEVEL_LSB);
+
+    if(fcs & ADC_FCS_OVER_BITS) {
+        adc_fifo_overflows++;
+    }
+    if(fcs & ADC_FCS_UNDER_BITS) {
+        adc_fifo_underflows++;
+    }
+    if(adc_hw->cs & ADC_CS_ERR_STICKY_BITS) {
+        adc_conversion_errors++;
+        hw_set_bits(&adc_hw->cs, ADC_CS_ERR_STICKY_BITS);
+    }
+    if(fifo_level > adc_max_fifo_level) {
+        adc_max_fifo_level = fifo_level;
+    }
+    //Write 1 to clear, the other bits are not touched
+    hw_set_bits(&adc_hw->fcs, fcs & (ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS));
+
+}//end adc_check_error_flags
+
+static void adc_reset_capture_statistic(void) {
+
+    adc_fifo_overflows = 0;
+    adc_fifo_underflows = 0;
+    adc_conversion_errors = 0;
+    adc_max_fifo_level = 0;
+    adc_capture_time_us = 0;
+    //Flags of an earlier capture are not counted
+    hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS);
+    hw_set_bits(&adc_hw->cs, ADC_CS_ERR_STICKY_BITS);
+
+}//end adc_reset_capture_statistic
+
+//Aborts control and capture channel. RP2040-E13: the abort of a running channel raises its completion interrupt, so the irq1 enable
+//of the capture channel is cleared for the abort and the spurious interrupt is cleared before it is enabled again
+static void adc_abort_dma_channels(void) {
+
+    bool irq_enabled = (dma_hw->inte1 & (1u << dma_adc_capture_channel)) != 0;
+
+    dma_channel_set_irq1_enabled(dma_adc_capture_channel, false);
+    dma_channel_abort(dma_adc_control_channel);
+    dma_channel_abort(dma_adc_capture_channel);
+    //Abort control channel again, in case the capture channel chained to it before the abort
+    dma_channel_abort(dma_adc_control_channel);
+    dma_hw->ints1 = (1u << dma_adc_capture_channel);
+    dma_channel_set_irq1_enabled(dma_adc_capture_channel, irq_enabled);
+
+}//end adc_abort_dma_channels
+
+//Block mode: chain the capture channel to the control channel (continuous) or to itself (no chaining, triggered block)
+static void adc_set_block_chaining(bool chain_to_control_channel) {
+
+    dma_channel_config dma_capture_conf = dma_get_channel_config(dma_adc_capture_channel);
+    channel_config_set_chain_to(&dma_capture_conf, chain_to_control_channel ? dma_adc_control_channel : dma_adc_capture_channel);
+    dma_channel_set_config(dma_adc_capture_channel, &dma_capture_conf, false);
+
+}//end adc_set_block_chaining
+
+static void adc_dma_irq_handler(void) {
+
+    //DMA_IRQ_1 is shared, only handle the capture channel
+    if(!(dma_hw->ints1 & (1u << dma_adc_capture_channel))) {
+        return;
+    }
+    dma_hw->ints1 = (1u << dma_adc_capture_channel);
+
+    //End of the block: time of the interrupt minus the samples the DMA has written into the next block since then (interrupt latency)
+    uint64_t time_us = time_us_64();
+    uint32_t remaining_samples = dma_hw->ch[dma_adc_capture_channel].transfer_count;
+    uint32_t next_block_samples = (remaining_samples == 0) ? 0 : (adc_block_size - remaining_samples);
+    uint64_t block_end_time_us = time_us - (uint64_t)(next_block_samples*adc_conversion_period_us + 0.5f);
+    adc_block_timestamps[adc_block_index] = block_end_time_us - (uint64_t)(adc_block_size*adc_conversion_period_us + 0.5f);
+    //Capture time of the block, in continuous block mode the next block starts at the end of this one
+    adc_capture_time_us += block_end_time_us - adc_block_start_time_us;
+    adc_block_start_time_us = block_end_time_us;
+    adc_check_error_flags();
+
+    //Triggered block: the capture channel is not chained, stop the ADC and drop the samples after the block
+    if(adc_block_single_shot) {
+        adc_run(false);
+        while(!(adc_hw->cs & ADC_CS_READY_BITS)) {
+            tight_loop_contents();
+        }
+        adc_abort_dma_channels();
+        adc_fifo_drain();
+    }
+
+    //In continuous block mode the control channel restarted the capture on the next buffer already
+    uint8_t completed_index = adc_block_index;
+    adc_block_index = (adc_block_index + 1) & (adc_number_of_block_buffers - 1);
+    adc_block_count++;
+
+    if(adc_block_callback != NULL) {
+        adc_block_callback(adc_block_addresses[completed_index], adc_block_size, completed_index);
+    }
+
+}//end adc_dma_irq_handler
+
+//Checks the channels and sorts them into channel_list (the round-robin always samples in ascending order), returns the channel mask
+static int adc_set_channel_list(const uint *adc_channels, uint8_t number_of_adc_channels) {
 
-    float adc_clk_div = 0;
-    int8_t adc_gpio_pin = 0;
     int channel_mask = 0;
 
-    if(adc_channel > 4) {
-        return -1; //Error wrong parameter, there are only 5 ADC-channels
+    if(adc_channels == NULL || number_of_adc_channels == 0 || number_of_adc_channels > MAX_ADC_CHANNELS) {
+        return -1; //Error: wrong number of channels
+    }
+    for(uint8_t k = 0; k < number_of_adc_channels; k++) {
+        if(adc_channels[k] >= MAX_ADC_CHANNELS || (channel_mask & (1 << adc_channels[k]))) {
+            return -1; //Error: there are only five adc channels, every channel could only be used once
+        }
+        channel_mask |= (1 << adc_channels[k]);
+    }
+
+    uint8_t n = 0;
+    for(uint8_t channel = 0; channel < MAX_ADC_CHANNELS; channel++) {
+        if(channel_mask & (1 << channel)) {
+            channel_list[n++] = channel;
+        }
     }
-    channel_mask += 1 << adc_channel;
-    uint8_t* new_start_address[1] = {&adc_data[adc_channel]};
-    start_address[0] = new_start_address[0];
 
-    adc_gpio_pin = get_gpio_from_channel(adc_channel);
+    return channel_mask;
 
-    //If ADC is connected to gpio pin init gpio pin
-    if(adc_gpio_pin != -1) {    
-        gpio_init(adc_gpio_pin);
-        adc_gpio_init(adc_gpio_pin);
-    } 
-    else {
-        if(adc_channel == 4) {
+}//end adc_set_channel_list
+
+//Inits gpio pins/temperature sensor of the channels in channel_list and the ADC itself (FIFO, round-robin, clock divider)
+static void adc_init_channels(int channel_mask, uint8_t number_of_adc_channels, float adc_sample_rate) {
+
+    //Set first, the system monitor (timer interrupt) does not touch the ADC from now on
+    adc_number_of_channels = number_of_adc_channels;
+
+    for(uint8_t k = 0; k < number_of_adc_channels; k++) {
+        int8_t adc_gpio_pin = get_gpio_from_channel(channel_list[k]);
+        //If ADC is connected to gpio pin init gpio pin
+        if(adc_gpio_pin != -1) {
+            gpio_init(adc_gpio_pin);
+            adc_gpio_init(adc_gpio_pin);
+        }
+        else {
             adc_set_temp_sensor_enabled(true);
             temperature_sensor_is_configured = true;
         }
+        adc_channel_is_configured[channel_list[k]] = true;
     }
+
     //TODO: check if adc is already claimed if not claim adc hardware
     //Init adc
     adc_init();
-    adc_set_round_robin(channel_mask);
-    //Select input channel
-    adc_select_input(adc_channel);
+    adc_set_round_robin((number_of_adc_channels > 1) ? channel_mask : 0);
+    //Select input channel, the round starts with the first channel of the list
+    adc_select_input(channel_list[0]);
 
     //FIFO setup of adc
     adc_fifo_setup(
@@ -140,39 +381,36 @@ int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint d
         true, //Set DMA-DREQ
         1, //One transfer
         false, //Do not use error bit
-        true  //8-bit transfer
+        (adc_resolution == 8)  //8-bit: shift the result, 12-bit: full result
     );
-    
     adc_fifo_drain();
 
-    if(adc_sample_rate > 500*1000) {
-        return -1; //Error: wrong parameter to high sample rate
-    }
-    //Set sample rate with the adc clk divisor
-    adc_clk_div = ((48*1000*1000)/(adc_sample_rate*96))-1;
-    adc_set_clkdiv(adc_clk_div);
+    //The clock divider sets the time between two conversions, in round-robin mode every channel is sampled once p. round
+    adc_set_clkdiv(adc_get_clkdiv(adc_sample_rate*number_of_adc_channels));
 
-    //DMA-Setup:
+}//end adc_init_channels
+
+//Continuous mode: the capture channel writes one round (one sample p. channel) to adc_data, the control channel restarts it
+//16 bit transfers in both resolutions (in 8-bit mode the FIFO holds the shifted result in the lower byte)
+static void adc_configure_dma(uint dma_capture_channel, uint dma_control_channel, uint8_t number_of_adc_channels) {
 
-    //Check if one of the used dma channels are already claimed
-    if(dma_channel_is_claimed(dma_capture_channel) || dma_channel_is_claimed(dma_control_channel)) {
-        return -3; //Error dma channel is already claimed
-    }
     //Claim dma channels
     dma_channel_claim(dma_capture_channel);
     dma_channel_claim(dma_control_channel);
     dma_adc_capture_channel = dma_capture_channel;
     dma_adc_control_channel = dma_control_channel;
 
+    start_address[0] = &adc_data[0];
+
     //Get configuration for dma control channel
     dma_channel_config dma_ctrl_conf = dma_channel_get_default_config(dma_control_channel);
     //Get configuration for capture dma channel
     dma_channel_config dma_capture_conf = dma_channel_get_default_config(dma_capture_channel);
 
-   //Configure dma capture channel
-    channel_config_set_transfer_data_size(&dma_capture_conf, DMA_SIZE_8); 
+    //Configure dma capture channel
+    channel_config_set_transfer_data_size(&dma_capture_conf, DMA_SIZE_16); 
     channel_config_set_read_increment(&dma_capture_conf, false); //Read not incrementing (adc FIFO register is a single register)
-    channel_config_set_write_increment(&dma_capture_conf, false); //In single channel mode do not increment write address
+    channel_config_set_write_increment(&dma_capture_conf, (number_of_adc_channels > 1)); //In multi channel mode write one sample p. channel
     channel_config_set_irq_quiet(&dma_capture_conf, true); 
     channel_config_set_dreq(&dma_capture_conf, DREQ_ADC); //If a adc-sample is taken start DMA-transfer
     channel_config_set_chain_to(&dma_capture_conf, dma_control_channel); //Set chain to the dma control channel
@@ -183,11 +421,11 @@ int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint d
     &dma_capture_conf, //Channel configuration
     NULL,            // write (destination) address will be controlled by the dma control channel.
     &adc_hw->fifo,      // read (source) address. Does not change.
-    1, // Number of word transfers.
+    number_of_adc_channels, // One round p. trigger
     false //Don't Start immediately.
     );
 
-    //Configure dma capture channel
+    //Configure dma control channel
     channel_config_set_transfer_data_size(&dma_ctrl_conf, DMA_SIZE_32);
     channel_config_set_read_increment(&dma_ctrl_conf, false); //Read a single uint32.
     channel_config_set_write_increment(&dma_ctrl_conf, false);//No write increment write a single uint32
@@ -205,123 +443,41 @@ int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint d
         false       // Don't Start immediately.
     );
 
-    //Set configuration flag:
-    adc_channel_is_configured[adc_channel] = true;
-    //ADC is setup for single channel conversion
-    adc_mode_single_channel = true;
-    adc_number_of_channels = 1;
-    
-    return 1;
+}//end adc_configure_dma
 
-}//end configure_adc_single_channel
+//Block mode: the capture channel writes block_size samples (8 bit or 16 bit elements), the control channel restarts it on the next buffer
+static void adc_configure_block_dma(uint dma_capture_channel, uint dma_control_channel, void **buffers, uint8_t number_of_buffers, 
+    uint32_t block_size, adc_block_callback_t block_callback) {
 
-//TODO: Multichannel needs proper testing
-int configure_adc_multi_channel(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel) {
-    
-    float adc_clk_div = 0;
-    int channel_mask = 0;
-
-    if(number_of_adc_channels > MAX_ADC_CHANNELS) {
-        return -1; //Error: there are only five adc channels
-    }
-
-    if(configure_adc_single_channel) {
-        return -2; //Error: adc is configured in single channel already
-    }
+    uint8_t ring_size_bits = 2;
 
-    //TODO: Implement function further
-
-    //Configure channel gpio/temperature sensor
-    for(uint8_t k = 0; k < number_of_adc_channels; k++) {
-
-        int8_t adc_gpio_pin = get_gpio_from_channel(adc_channels[k]);
-
-        if(adc_gpio_pin != -1) {
-            gpio_init(adc_gpio_pin);
-            adc_gpio_init(adc_gpio_pin);
-            channel_list[number_of_adc_channels] = adc_channels[k];
-            number_of_adc_channels++;
-        }
-        else if(adc_channels[k] == 4) {
-            adc_set_temp_sensor_enabled(true);
-            temperature_sensor_is_configured = true;
-            channel_list[number_of_adc_channels] = adc_channels[k];
-            number_of_adc_channels++;
-        }
-        else {
-            number_of_adc_channels = 0;
-            return -1; //Error there are no other ADC-channels
-        }
-        //Set channel mask
-        channel_mask |= (1 << adc_channels[k]);
-    }
-    uint8_t* new_start_address[1] = {NULL};
-    //Set start address of the right array
-    switch(number_of_adc_channels) {
-
-        case 1: return -1; //Error: there is another function for single channel setup    
-        case 2: new_start_address[0] = &adc_data_2_channels[0];
-                start_address[0] = new_start_address[0];
-                break;
-        case 3: new_start_address[0] = &adc_data_3_channels[0];
-                start_address[0] = new_start_address[0];
-                break;
-        case 4: new_start_address[0] = &adc_data_4_channels[0];
-                start_address[0] = new_start_address[0];
-                break;
-        case 5: new_start_address[0] = &adc_data[0];
-                start_address[0] = new_start_address[0];
-                break;
-        default: return -1; //Error: there are only five adc channels;
-    }
-
-    //TODO: check if adc is already claimed if not claim adc hardware
-    //Init adc
-    adc_init();
-    adc_set_round_robin(channel_mask);
-    //Select input channel, first channel in array
-    adc_select_input(adc_channels[0]);
-
-     //FIFO setup of adc
-    adc_fifo_setup(
-        true, //Enable FIFO
-        true, //Set DMA-DREQ
-        1, //One transfer
-        false, //Do not use error bit
-        true  //8-bit transfer
-    );
-    
-    adc_fifo_drain();
-
-    if(adc_sample_rate > 500*1000) {
-        return -1; //Error: wrong parameter to high sample rate
-    }
-    //Set sample rate with the adc clk divisor
-    adc_clk_div = ((48*1000*1000)/(adc_sample_rate*96))-1;
-    adc_set_clkdiv(adc_clk_div);
-
-    //DMA-Setup:
-
-    //Check if one of the used dma channels are already claimed
-    if(dma_channel_is_claimed(dma_capture_channel) || dma_channel_is_claimed(dma_control_channel)) {
-        return -3; //Error dma channel is already claimed
-    }
     //Claim dma channels
     dma_channel_claim(dma_capture_channel);
     dma_channel_claim(dma_control_channel);
     dma_adc_capture_channel = dma_capture_channel;
     dma_adc_control_channel = dma_control_channel;
 
-    //Get configuration for dma control channel
+    for(uint8_t k = 0; k < number_of_buffers; k++) {
+        adc_block_addresses[k] = buffers[k];
+    }
+    adc_number_of_block_buffers = number_of_buffers;
+    //The read ring wraps after the address list (4 bytes p. address)
+    while((1u << ring_size_bits) < (4u*number_of_buffers)) {
+        ring_size_bits++;
+    }
+    adc_block_size = block_size;
+    adc_block_callback = block_callback;
+    adc_block_index = 0;
+    adc_block_count = 0;
+
     dma_channel_config dma_ctrl_conf = dma_channel_get_default_config(dma_control_channel);
-    //Get configuration for capture dma channel
     dma_channel_config dma_capture_conf = dma_channel_get_default_config(dma_capture_channel);
 
-   //Configure dma capture channel
-    channel_config_set_transfer_data_size(&dma_capture_conf, DMA_SIZE_8); 
+    //Configure dma capture channel
+    channel_config_set_transfer_data_size(&dma_capture_conf, (adc_resolution == 8) ? DMA_SIZE_8 : DMA_SIZE_16); 
     channel_config_set_read_increment(&dma_capture_conf, false); //Read not incrementing (adc FIFO register is a single register)
-    channel_config_set_write_increment(&dma_capture_conf, false); //In single channel mode do not increment write address
-    channel_config_set_irq_quiet(&dma_capture_conf, true); 
+    channel_config_set_write_increment(&dma_capture_conf, true); //Write consecutive samples into the block
+    channel_config_set_irq_quiet(&dma_capture_conf, false); //Interrupt after every block
     channel_config_set_dreq(&dma_capture_conf, DREQ_ADC); //If a adc-sample is taken start DMA-transfer
     channel_config_set_chain_to(&dma_capture_conf, dma_control_channel); //Set chain to the dma control channel
     channel_config_set_enable(&dma_capture_conf, true);
@@ -331,32 +487,135 @@ int configure_adc_multi_channel(uint *adc_channels, uint8_t number_of_adc_channe
     &dma_capture_conf, //Channel configuration
     NULL,            // write (destination) address will be controlled by the dma control channel.
     &adc_hw->fifo,      // read (source) address. Does not change.
-    number_of_adc_channels, // Number of word transfers.
+    block_size, // Number of samples p. block, reloaded on every trigger
     false //Don't Start immediately.
     );
 
-    //Configure dma capture channel
+    //Configure dma control channel, it reads the buffer addresses in a ring: buffer_0, buffer_1, ..., buffer_0, ...
     channel_config_set_transfer_data_size(&dma_ctrl_conf, DMA_SIZE_32);
-    channel_config_set_read_increment(&dma_ctrl_conf, false); //Read a single uint32.
-    channel_config_set_write_increment(&dma_ctrl_conf, false);//No write increment write a single uint32
+    channel_config_set_read_increment(&dma_ctrl_conf, true);
+    channel_config_set_ring(&dma_ctrl_conf, false, ring_size_bits); //Wrap read address after the address list
+    channel_config_set_write_increment(&dma_ctrl_conf, false);
     channel_config_set_irq_quiet(&dma_ctrl_conf, true);
     channel_config_set_dreq(&dma_ctrl_conf, DREQ_FORCE); //Go as fast as possible.
     channel_config_set_enable(&dma_ctrl_conf, true);
 
-    // Apply reconfig channel configuration.
     dma_channel_configure(
         dma_control_channel,  // Channel to be configured
         &dma_ctrl_conf,
         &dma_hw->ch[dma_capture_channel].al2_write_addr_trig, //Write (destination) address, writing at this address re-triggers the capture channel.
-        start_address,  //Read (source) address is a single array with the starting address.
-        1,          // Number of word transfers.
+        &adc_block_addresses[0],  //Read (source) address, first buffer
+        1,          // One address p. trigger
         false       // Don't Start immediately.
     );
 
-    //Set configuration flag
-    for(uint8_t k = 0; k < adc_number_of_channels; k++) {
-        adc_channel_is_configured[adc_channels[k]] = true;
+    //Block interrupt (DMA_IRQ_1 could be shared with other DMA users)
+    dma_channel_set_irq1_enabled(dma_capture_channel, true);
+    irq_add_shared_handler(DMA_IRQ_1, adc_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+}//end adc_configure_block_dma
+
+//Block capture with number_of_buffers buffers (2 for double buffering), the buffers are written in a ring
+static int adc_setup_block_capture(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, 
+    uint dma_control_channel, void **buffers, uint8_t number_of_buffers, uint32_t block_size, adc_block_callback_t block_callback) {
+
+    int channel_mask = 0;
+
+    if(number_of_adc_channels == 0 || number_of_adc_channels > MAX_ADC_CHANNELS) {
+        return -1; //Error: wrong parameter, there are only five adc channels
+    }
+    for(uint8_t k = 0; k < number_of_buffers; k++) {
+        if(buffers[k] == NULL) {
+            return -1; //Error: wrong parameter
+        }
+    }
+    if(block_size == 0 || (block_size%number_of_adc_channels) != 0) {
+        return -1; //Error: wrong parameter, a block has to hold complete rounds
+    }
+    if(adc_sample_rate*number_of_adc_channels < ADC_MIN_SAMPLE_RATE || adc_sample_rate*number_of_adc_channels > ADC_MAX_SAMPLE_RATE) {
+        return -1; //Error: wrong parameter, sample rate could not be set with the clock divider
+    }
+    if(adc_number_of_channels != 0) {
+        return -2; //Error: adc is configured already
+    }
+    //Check if one of the used dma channels are already claimed
+    if(dma_channel_is_claimed(dma_capture_channel) || dma_channel_is_claimed(dma_control_channel)) {
+        return -3; //Error dma channel is already claimed
+    }
+
+    channel_mask = adc_set_channel_list(adc_channels, number_of_adc_channels);
+    if(channel_mask < 0) {
+        return -1; //Error: wrong channel or channel used twice
+    }
+    adc_init_channels(channel_mask, number_of_adc_channels, adc_sample_rate);
+    adc_configure_block_dma(dma_capture_channel, dma_control_channel, buffers, number_of_buffers, block_size, block_callback);
+
+    //Set configuration flags
+    adc_mode_single_channel = (number_of_adc_channels == 1);
+    adc_block_capture_is_configured = true;
+
+    return 1;
+
+}//end adc_setup_block_capture
+
+//Function definitions:
+
+//Configuration:
+int configure_adc_single_channel(uint adc_channel, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel) {
+
+    int channel_mask = 0;
+
+    if(adc_channel > 4) {
+        return -1; //Error wrong parameter, there are only 5 ADC-channels
+    }
+    if(adc_sample_rate < ADC_MIN_SAMPLE_RATE || adc_sample_rate > ADC_MAX_SAMPLE_RATE) {
+        return -1; //Error: wrong parameter, sample rate could not be set with the clock divider
+    }
+    if(adc_number_of_channels != 0) {
+        return -2; //Error: adc is configured already
+    }
+    //Check if one of the used dma channels are already claimed
+    if(dma_channel_is_claimed(dma_capture_channel) || dma_channel_is_claimed(dma_control_channel)) {
+        return -3; //Error dma channel is already claimed
+    }
+
+    channel_mask = adc_set_channel_list(&adc_channel, 1);
+    adc_init_channels(channel_mask, 1, adc_sample_rate);
+    adc_configure_dma(dma_capture_channel, dma_control_channel, 1);
+
+    //ADC is setup for single channel conversion
+    adc_mode_single_channel = true;
+    
+    return 1;
+
+}//end configure_adc_single_channel
+
+int configure_adc_multi_channel(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel) {
+    
+    int channel_mask = 0;
+
+    if(number_of_adc_channels < 2 || number_of_adc_channels > MAX_ADC_CHANNELS) {
+        return -1; //Error: wrong parameter, there are only five adc channels (use single channel function for one channel)
+    }
+    if(adc_sample_rate*number_of_adc_channels < ADC_MIN_SAMPLE_RATE || adc_sample_rate*number_of_adc_channels > ADC_MAX_SAMPLE_RATE) {
+        return -1; //Error: wrong parameter, the ADC has to sample all channels within one sample period
+    }
+    if(adc_number_of_channels != 0) {
+        return -2; //Error: adc is configured already
+    }
+    //Check if one of the used dma channels are already claimed
+    if(dma_channel_is_claimed(dma_capture_channel) || dma_channel_is_claimed(dma_control_channel)) {
+        return -3; //Error dma channel is already claimed
     }
+
+    channel_mask = adc_set_channel_list(adc_channels, number_of_adc_channels);
+    if(channel_mask < 0) {
+        return -1; //Error: wrong channel or channel used twice
+    }
+    adc_init_channels(channel_mask, number_of_adc_channels, adc_sample_rate);
+    adc_configure_dma(dma_capture_channel, dma_control_channel, number_of_adc_channels);
+
     //ADC is setup for multi channel conversion
     adc_mode_single_channel = false;
 
@@ -364,14 +623,73 @@ int configure_adc_multi_channel(uint *adc_channels, uint8_t number_of_adc_channe
     
 }//end configure_adc_multi_channel
 
+int configure_adc_block_capture(uint adc_channel, float adc_sample_rate, uint dma_capture_channel, uint dma_control_channel, void *buffer_0, 
+    void *buffer_1, uint32_t block_size, adc_block_callback_t block_callback) {
+
+    return configure_adc_multi_channel_block_capture(&adc_channel, 1, adc_sample_rate, dma_capture_channel, dma_control_channel, 
+        buffer_0, buffer_1, block_size, block_callback);
+
+}//end configure_adc_block_capture
+
+int configure_adc_multi_channel_block_capture(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, 
+    uint dma_control_channel, void *buffer_0, void *buffer_1, uint32_t block_size, adc_block_callback_t block_callback) {
+
+    void *buffers[2] = {buffer_0, buffer_1};
+
+    return adc_setup_block_capture(adc_channels, number_of_adc_channels, adc_sample_rate, dma_capture_channel, dma_control_channel, 
+        buffers, 2, block_size, block_callback);
+
+}//end configure_adc_multi_channel_block_capture
+
+int configure_adc_ring_capture(uint *adc_channels, uint8_t number_of_adc_channels, float adc_sample_rate, uint dma_capture_channel, 
+    uint dma_control_channel, void *ring_buffer, uint8_t number_of_blocks, uint32_t block_size, adc_block_callback_t block_callback) {
+
+    void *buffers[ADC_MAX_BLOCK_BUFFERS];
+    uint32_t block_size_in_bytes = block_size*((adc_resolution == 8) ? 1 : 2);
+
+    if(ring_buffer == NULL || number_of_blocks < 2 || number_of_blocks > ADC_MAX_BLOCK_BUFFERS || (number_of_blocks & (number_of_blocks - 1)) != 0) {
+        return -1; //Error: wrong parameter, number of blocks has to be a power of two
+    }
+    //Consecutive blocks of the ring buffer
+    for(uint8_t k = 0; k < number_of_blocks; k++) {
+        buffers[k] = (uint8_t*)ring_buffer + k*block_size_in_bytes;
+    }
+
+    return adc_setup_block_capture(adc_channels, number_of_adc_channels, adc_sample_rate, dma_capture_channel, dma_control_channel, 
+        buffers, number_of_blocks, block_size, block_callback);
+
+}//end configure_adc_ring_capture
+
 int deconfigure_adc(void) {
 
+    if(adc_number_of_channels == 0) {
+        return -1; //Error: adc is not configured
+    }
+
     //Stop hardware
     adc_run(false);
     dma_channel_abort(dma_adc_control_channel);
 
+    if(adc_block_capture_is_configured) {
+        dma_channel_set_irq1_enabled(dma_adc_capture_channel, false);
+        irq_remove_handler(DMA_IRQ_1, adc_dma_irq_handler);
+        for(uint8_t k = 0; k < ADC_MAX_BLOCK_BUFFERS; k++) {
+            adc_block_addresses[k] = NULL;
+            adc_block_timestamps[k] = 0;
+        }
+        adc_number_of_block_buffers = 0;
+        adc_block_size = 0;
+        adc_block_callback = NULL;
+        adc_block_single_shot = false;
+        adc_block_capture_is_configured = false;
+    }
+    dma_channel_abort(dma_adc_capture_channel);
+    //Abort control channel again, in case the capture channel chained to it before the abort
+    dma_channel_abort(dma_adc_control_channel);
+
     //Deinit hardware:
     adc_fifo_drain();
+    adc_set_round_robin(0);
        
     dma_channel_cleanup(dma_adc_capture_channel);
     dma_channel_cleanup(dma_adc_control_channel);
@@ -382,85 +700,27 @@ int deconfigure_adc(void) {
 
     start_address[0] = NULL;
 
-    if(adc_mode_single_channel) {
-
-        uint8_t adc_channel = 0;
-        //Deinit GPIO pins
-        for(uint j = 0; j < MAX_ADC_CHANNELS; j++) {
-            uint adc_gpio = 0;
-            //If one channel is configured deinit gpio/temperature-sensor and return (single channel mode)
-            if(adc_channel_is_configured[j]) {
-                if(j != 4) {
-                    adc_gpio = get_gpio_from_channel(j);
-                    gpio_deinit(adc_gpio);
-                    adc_channel = j;
-                    break;
-                }
-                else {
-                    adc_set_temp_sensor_enabled(false);
-                    temperature_sensor_is_configured = false;
-                    adc_channel = j;
-                    break;
-                }
-               
-            }   
+    //Deinit gpio pins/temperature sensor of all configured channels
+    for(uint8_t k = 0; k < adc_number_of_channels; k++) {
+        int8_t adc_gpio_pin = get_gpio_from_channel(channel_list[k]);
+        if(adc_gpio_pin != -1) {
+            gpio_deinit(adc_gpio_pin);
         }
+        else {
+            adc_set_temp_sensor_enabled(false);
+            temperature_sensor_is_configured = false;
+        }
+        adc_channel_is_configured[channel_list[k]] = false;
+        adc_data[k] = 0;
+        channel_list[k] = 0;
+    }
 
-       //Reset flags, static variables and data array
-       adc_mode_single_channel = false;
-       adc_channel_is_configured[adc_channel] = false;
-       dma_adc_capture_channel = 0;
-       dma_adc_control_channel = 0;
-       adc_data[adc_channel] = 0;
-
-       return 1;
+    //Reset flags and static variables
+    adc_mode_single_channel = false;
+    dma_adc_capture_channel = 0;
+    dma_adc_control_channel = 0;
+    adc_number_of_channels = 0;
 
-    } 
-    
-    //Multi channel
-    //Deinit data array
-    switch(adc_number_of_channels) {
-        case 1: return -1; //Error: there is another function for single channel setup    
-        case 2: adc_data_2_channels[0] = 0;
-                adc_data_2_channels[1] = 0;
-                break;
-        case 3: adc_data_3_channels[0] = 0;
-                adc_data_3_channels[1] = 0;
-                adc_data_3_channels[2] = 0;
-                break;
-        case 4: adc_data_4_channels[0] = 0;
-                adc_data_4_channels[1] = 0;
-                adc_data_4_channels[2] = 0;
-                adc_data_4_channels[3] = 0;
-                break;
-        case 5: adc_data[0] = 0;
-                adc_data[1] = 0;
-                adc_data[2] = 0;
-                adc_data[3] = 0;
-                adc_data[4] = 0;
-                break;
-        default: return -1; //Error: there are only five adc channels;
-    }
-
-    //Deinit GPIO pins
-    for(uint j = 0; j < MAX_ADC_CHANNELS; j++) {
-    uint adc_gpio = 0;
-    //If a channel is configured deinit gpio/temperature-sensor
-        if(adc_channel_is_configured[j]) {
-            if(j != 4) {
-                adc_gpio = get_gpio_from_channel(j);
-                gpio_deinit(adc_gpio);
-            }
-            else {
-                adc_set_temp_sensor_enabled(false);
-                temperature_sensor_is_configured = false;
-                }
-            adc_channel_is_configured[j] = false;
-            adc_number_of_channels--;  
-        }   
-        channel_list[j] = 0;
-    }
-    
     return 1;
     
 }//end deconfigure_adc
@@ -472,86 +732,462 @@ int adc_start_measurement(bool start) {
         return -1; //Error no channel was configured
     }
 
-    adc_run(start);
     if(start) {
+        //Every round (and every block) starts with the first channel of the list
+        adc_fifo_drain();
+        adc_reset_decimation();
+        adc_reset_capture_statistic();
+        adc_conversion_period_us = 1000000.0f/(adc_get_sample_rate()*adc_number_of_channels);
+        adc_select_input(channel_list[0]);
+        if(adc_block_capture_is_configured) {
+            //Start with the first buffer
+            adc_block_single_shot = false;
+            adc_block_index = 0;
+            adc_block_count = 0;
+            adc_set_block_chaining(true);
+            dma_channel_set_read_addr(dma_adc_control_channel, &adc_block_addresses[0], false);
+        }
+        else {
+            dma_channel_set_read_addr(dma_adc_control_channel, start_address, false);
+        }
+        //The DMA is started before the ADC so no sample is lost and the samples stay in round-robin order
         dma_channel_start(dma_adc_control_channel);
+        adc_block_start_time_us = time_us_64();
+        adc_run(true);
         return 1;
     }
-    dma_channel_abort(dma_adc_control_channel);
+
+    adc_run(false);
+    //Wait for the last conversion, its sample would shift the order of the next round
+    while(!(adc_hw->cs & ADC_CS_READY_BITS)) {
+        tight_loop_contents();
+    }
+    adc_abort_dma_channels();
+    adc_check_error_flags();
+    adc_fifo_drain();
     return 1;
     
 }//end adc_start_measurment
 
+int adc_arm_block_capture(void) {
+
+    if(!adc_block_capture_is_configured) {
+        return -1; //Error: block capture is not configured
+    }
+    if(adc_hw->cs & ADC_CS_START_MANY_BITS) {
+        return -2; //Error: the ADC is still capturing (block not complete or continuous capture running)
+    }
+    if(!adc_block_single_shot) {
+        //First trigger after configuration or a continuous capture
+        adc_block_single_shot = true;
+        adc_set_block_chaining(false);
+        adc_block_index = 0;
+        adc_block_count = 0;
+        adc_reset_capture_statistic();
+        adc_conversion_period_us = 1000000.0f/(adc_get_sample_rate()*adc_number_of_channels);
+    }
+
+    //Every triggered block starts with the first channel and a new decimation filter state
+    adc_fifo_drain();
+    adc_select_input(channel_list[0]);
+    adc_reset_decimation();
+    dma_channel_set_trans_count(dma_adc_capture_channel, adc_block_size, false);
+    dma_channel_set_write_addr(dma_adc_capture_channel, adc_block_addresses[adc_block_index], true);
+    //Only the time from the trigger to the end of the block is counted as capture time
+    adc_block_start_time_us = time_us_64();
+    adc_run(true);
+
+    return 1;
+
+}//end adc_arm_block_capture
+
+int adc_get_channel_measurement(uint adc_channel, uint8_t *measured_value) {
+
+    int position = adc_get_channel_position(adc_channel);
+    if(position < 0) {
+        return -2; //Error: adc channel is not configured
+    }
+    if(adc_block_capture_is_configured) {
+        return -3; //Error: in block capture mode the samples are in the block buffers
+    }
+
+    //Always 8 bit, in 12-bit mode the lower bits are dropped
+    *measured_value = (uint8_t)(adc_data[position] >> (adc_resolution - 8));
+    return 1;
+
+}//end adc_get_channel_measurement
+
+int adc_get_channel_raw_measurement(uint adc_channel, uint16_t *measured_value) {
+
+    int position = adc_get_channel_position(adc_channel);
+    if(position < 0) {
+        return -2; //Error: adc channel is not configured
+    }
+    if(adc_block_capture_is_configured) {
+        return -3; //Error: in block capture mode the samples are in the block buffers
+    }
+
+    *measured_value = adc_data[position];
+    return 1;
+
+}//end adc_get_channel_raw_measurement
+
 int adc_get_gpio_measurement(uint adc_gpio_pin, uint8_t *measured_value) {
-    //TODO: implement for multi-channel-measurement
+
     int adc_channel = get_channel(adc_gpio_pin);
     if(adc_channel == -1) {
         return -1; //Error: configured ADC channel is not connected to gpio_pin, or gpio_pin doesn't have analog channel function
     }
+    return adc_get_channel_measurement(adc_channel, measured_value);
 
-    if(adc_channel_is_configured[adc_channel] == false) {
-        return -2; //Error: adc channel is not configured
+}//end adc_get_gpio_measurement
+
+int adc_get_temperature_measurement(uint8_t *temperature_value) {
+
+    if(!temperature_sensor_is_configured) {
+        return -1; //Error: temperature sensor not configured
     }
+    if(adc_get_channel_measurement(4, temperature_value) < 0) {
+        return -1; //Error: no sample in block capture mode
+    }
+    return 1;
 
-    if(adc_mode_single_channel == true) {
-        *measured_value = adc_data[adc_channel];
-        return 1;
+}//end adc_get_temperature_measurement
+
+int adc_get_channel_position(uint adc_channel) {
+
+    if(adc_channel >= MAX_ADC_CHANNELS || !adc_channel_is_configured[adc_channel]) {
+        return -1; //Error: adc channel is not configured
     }
-    else {
-        for(uint8_t c = 0; c < adc_number_of_channels; c++) {
-            //If the adc_channel of gpio pin matches the array entry in channels list get the value from index c
-            if(adc_channel == channel_list[c]) {
-                //Read from the right array depending on number of channels configured
-                switch(adc_number_of_channels) {
-                    case 1: return -1; //Error: there is another function for single channel setup    
-                    case 2: *measured_value = adc_data_2_channels[c];
-                            return 1;
-                    case 3: *measured_value = adc_data_3_channels[c];
-                            return 1;
-                    case 4: *measured_value = adc_data_4_channels[c];
-                            return 1;
-                    case 5: *measured_value = adc_data[c];
-                            return 1;
-                    default: return -1; //Error: there are only five adc channels;
-                }
+    for(uint8_t k = 0; k < adc_number_of_channels; k++) {
+        if(channel_list[k] == adc_channel) {
+            return k;
+        }
+    }
+    return -1; //Error: Channel was not found
+
+}//end adc_get_channel_position
+
+uint8_t adc_get_number_of_channels(void) {
+
+    return adc_number_of_channels;
+
+}//end adc_get_number_of_channels
+
+int adc_deinterleave_block(const void *block, uint32_t num_of_samples, void *channel_samples[MAX_ADC_CHANNELS]) {
+
+    if(block == NULL || channel_samples == NULL || adc_number_of_channels == 0) {
+        return -1; //Error: wrong parameter or adc not configured
+    }
+    uint32_t num_of_rounds = num_of_samples/adc_number_of_channels;
+
+    //One pass p. channel with a fixed stride, channels without buffer are skipped
+    for(uint8_t k = 0; k < adc_number_of_channels; k++) {
+        if(channel_samples[channel_list[k]] == NULL) {
+            continue;
+        }
+        if(adc_resolution == 8) {
+            const uint8_t *source = (const uint8_t*)block + k;
+            uint8_t *destination = channel_samples[channel_list[k]];
+            for(uint32_t r = 0; r < num_of_rounds; r++) {
+                destination[r] = *source;
+                source += adc_number_of_channels;
+            }
+        }
+        else {
+            const uint16_t *source = (const uint16_t*)block + k;
+            uint16_t *destination = channel_samples[channel_list[k]];
+            for(uint32_t r = 0; r < num_of_rounds; r++) {
+                destination[r] = *source;
+                source += adc_number_of_channels;
             }
         }
     }
 
-    return -1; //Error: Channel was not found
+    return (int)num_of_rounds;
 
-}//end adc_get_gpio_measurement
+}//end adc_deinterleave_block
 
-int adc_get_temperature_measurement(uint8_t *temperature_value) {
+int adc_decimate_block(const uint16_t *block, uint32_t num_of_samples, uint16_t *decimated) {
+
+    uint32_t num_of_decimated = 0;
+    uint8_t k = 0;
 
-    if(temperature_sensor_is_configured) {
-
-       if(adc_mode_single_channel) {
-            *temperature_value = adc_data[4];
-            return 1;
-       }
-       for(uint8_t c = 0; c < adc_number_of_channels; c++) {
-            //If the adc_channel of gpio pin matches the array entry in channels list get the value from index c
-            if(channel_list[c] == 4) {
-                //Read from the right array depending on number of channels configured
-                switch(adc_number_of_channels) {
-                    case 1: return -1; //Error: there is another function for single channel setup    
-                    case 2: *temperature_value = adc_data_2_channels[c];
-                            return 1;
-                    case 3: *temperature_value = adc_data_3_channels[c];
-                            return 1;
-                    case 4: *temperature_value = adc_data_4_channels[c];
-                            return 1;
-                    case 5: *temperature_value = adc_data[c];
-                            return 1;
-                    default: return -1; //Error: there are only five adc channels;
-                }
+    if(block == NULL || decimated == NULL || adc_number_of_channels == 0 || (num_of_samples%adc_number_of_channels) != 0) {
+        return -1; //Error: wrong parameter, the block has to hold complete rounds
+    }
+    if(adc_resolution != 12) {
+        return -2; //Error: decimation needs the 12-bit mode
+    }
+
+    for(uint32_t s = 0; s < num_of_samples; s++) {
+
+        //Integrators run with the full rate
+        uint32_t *integrator = adc_cic_integrators[k];
+        integrator[0] += block[s];
+        for(uint8_t o = 1; o < adc_cic_order; o++) {
+            integrator[o] += integrator[o - 1];
+        }
+
+        //Combs run with the decimated rate, in the last round of every ratio rounds
+        if(adc_cic_phase == (adc_oversampling_ratio - 1)) {
+            uint32_t value = integrator[adc_cic_order - 1];
+            for(uint8_t o = 0; o < adc_cic_order; o++) {
+                uint32_t difference = value - adc_cic_combs[k][o];
+                adc_cic_combs[k][o] = value;
+                value = difference;
             }
+            //Output index never passes the input index, so the block could be decimated in place
+            decimated[num_of_decimated++] = (uint16_t)(value >> adc_cic_output_shift);
+        }
+
+        k++;
+        if(k >= adc_number_of_channels) {
+            k = 0;
+            adc_cic_phase = (adc_cic_phase + 1) & (adc_oversampling_ratio - 1);
         }
     }
 
-    return -1; //Error: temperature sensor not configured
+    return (int)num_of_decimated;
 
-}//end adc_get_temperature_measurement
+}//end adc_decimate_block
+
+uint32_t adc_get_sample_count(void) {
+
+    if(!adc_block_capture_is_configured) {
+        return 0;
+    }
+    uint32_t block_count = 0;
+    bool block_pending = false;
+    uint32_t remaining_samples = 0;
+
+    //Block count, pending interrupt and transfer count have to belong to the same block, read again if a block completed meanwhile
+    do {
+        block_count = adc_block_count;
+        block_pending = (dma_hw->ints1 & (1u << dma_adc_capture_channel)) != 0;
+        remaining_samples = dma_hw->ch[dma_adc_capture_channel].transfer_count;
+    } while(block_count != adc_block_count || block_pending != ((dma_hw->ints1 & (1u << dma_adc_capture_channel)) != 0));
+
+    //A completed block that is not counted yet (interrupt pending) is already restarted on the next buffer
+    if(block_pending) {
+        block_count++;
+    }
+    //Transfer count 0: the block is complete, but the control channel did not restart the capture yet (no sample in the next block)
+    if(remaining_samples == 0) {
+        if(!block_pending) {
+            block_count++;
+        }
+        remaining_samples = adc_block_size;
+    }
+    return block_count*adc_block_size + (adc_block_size - remaining_samples);
+
+}//end adc_get_sample_count
+
+int adc_get_block_timestamp(uint8_t buffer_index, uint64_t *start_time_us) {
+
+    if(!adc_block_capture_is_configured) {
+        return -1; //Error: block capture is not configured
+    }
+    if(buffer_index >= adc_number_of_block_buffers) {
+        return -2; //Error: wrong buffer index
+    }
+    *start_time_us = adc_block_timestamps[buffer_index];
+    return 1;
+
+}//end adc_get_block_timestamp
+
+float adc_get_conversion_period_us(void) {
+
+    return adc_conversion_period_us;
+
+}//end adc_get_conversion_period_us
+
+int adc_get_capture_statistic(ADC_Capture_Statistic_t *statistic) {
+
+    if(adc_number_of_channels == 0) {
+        return -1; //Error: no channel was configured
+    }
+
+    adc_check_error_flags();
+    statistic->fifo_overflows = adc_fifo_overflows;
+    statistic->fifo_underflows = adc_fifo_underflows;
+    statistic->conversion_errors = adc_conversion_errors;
+    statistic->max_fifo_level = adc_max_fifo_level;
+    statistic->completed_blocks = adc_block_count;
+    statistic->number_of_samples = (uint64_t)adc_block_count*adc_block_size;
+    statistic->effective_sample_rate = 0;
+    if(adc_capture_time_us > 0) {
+        statistic->effective_sample_rate = ((float)statistic->number_of_samples*1000000.0f)/((float)adc_capture_time_us*adc_number_of_channels);
+    }
+
+    return 1;
+
+}//end adc_get_capture_statistic
+
+int adc_system_monitor_start(uint32_t period_ms) {
+
+    if(period_ms == 0) {
+        return -1; //Error: wrong period
+    }
+    if(adc_monitor_is_running) {
+        return -2; //Error: monitor is running already
+    }
+
+    for(uint8_t k = 0; k < 2; k++) {
+        for(uint16_t n = 0; n < ADC_MONITOR_WINDOW_SIZE; n++) {
+            adc_monitor_window[k][n] = 0;
+        }
+        adc_monitor_sum[k] = 0;
+        adc_monitor_sum_of_squares[k] = 0;
+    }
+    adc_monitor_window_index = 0;
+    adc_monitor_number_of_samples = 0;
+
+    //Negative delay: the period is from start to start of the callback
+    if(!add_repeating_timer_ms(-(int32_t)period_ms, adc_monitor_timer_callback, NULL, &adc_monitor_timer)) {
+        return -3; //Error: no free alarm
+    }
+    adc_monitor_is_running = true;
+
+    return 1;
+
+}//end adc_system_monitor_start
+
+int adc_system_monitor_stop(void) {
+
+    if(!adc_monitor_is_running) {
+        return -1; //Error: monitor is not running
+    }
+    cancel_repeating_timer(&adc_monitor_timer);
+    adc_monitor_is_running = false;
+    if(adc_number_of_channels == 0) {
+        adc_set_temp_sensor_enabled(false);
+        gpio_deinit(ADC_MONITOR_VSYS_GPIO);
+    }
+
+    return 1;
+
+}//end adc_system_monitor_stop
+
+int adc_system_monitor_get_statistic(ADC_System_Monitor_Statistic_t *statistic) {
+
+    if(!adc_monitor_is_running) {
+        return -1; //Error: monitor is not running
+    }
+
+    //Copy the window sums, the timer interrupt could change them
+    uint32_t interrupts = save_and_disable_interrupts();
+    uint16_t number_of_samples = adc_monitor_number_of_samples;
+    uint64_t last_sample_time_us = adc_monitor_last_sample_time_us;
+    uint32_t sum[2] = {adc_monitor_sum[0], adc_monitor_sum[1]};
+    uint32_t sum_of_squares[2] = {adc_monitor_sum_of_squares[0], adc_monitor_sum_of_squares[1]};
+    restore_interrupts(interrupts);
+
+    statistic->number_of_samples = number_of_samples;
+    if(number_of_samples == 0) {
+        return -2; //Error: no sample yet (ADC was always in use)
+    }
+    adc_monitor_get_channel(sum[0], sum_of_squares[0], number_of_samples, &statistic->vsys_mean_value, &statistic->vsys_std_deviation);
+    adc_monitor_get_channel(sum[1], sum_of_squares[1], number_of_samples, &statistic->temperature_mean_value, &statistic->temperature_std_deviation);
+    statistic->age_ms = (uint32_t)((time_us_64() - last_sample_time_us)/1000);
+
+    return 1;
+
+}//end adc_system_monitor_get_statistic
+
+uint32_t adc_get_block_count(void) {
+
+    return adc_block_count;
+
+}//end adc_get_block_count
+
+float adc_get_sample_rate(void) {
+
+    float adc_conversion_rate = 0;
+    //Divider register: 16 integer bits and 8 fractional bits
+    float adc_clk_div = (float)adc_hw->div/256.0f;
+
+    if((adc_clk_div + 1) < ADC_CYCLES_PER_CONVERSION) {
+        adc_conversion_rate = (float)ADC_CLK_FREQUENCY/ADC_CYCLES_PER_CONVERSION;
+    }
+    else {
+        adc_conversion_rate = (float)ADC_CLK_FREQUENCY/(adc_clk_div + 1);
+    }
+    //In round-robin mode the conversions are shared between the channels
+    if(adc_number_of_channels > 1) {
+        return adc_conversion_rate/adc_number_of_channels;
+    }
+    return adc_conversion_rate;
+
+}//end adc_get_sample_rate
+
+int adc_set_resolution(uint8_t resolution_in_bits) {
+
+    if(resolution_in_bits != 8 && resolution_in_bits != 12) {
+        return -1; //Error: wrong parameter, only 8 and 12 bit are supported
+    }
+    if(adc_number_of_channels != 0) {
+        return -2; //Error: adc is configured already, the resolution sets up FIFO and DMA
+    }
+    adc_resolution = resolution_in_bits;
+    return 1;
+
+}//end adc_set_resolution
+
+uint8_t adc_get_resolution(void) {
+
+    return adc_resolution;
+
+}//end adc_get_resolution
+
+int adc_set_decimation(uint16_t oversampling_ratio, uint8_t cic_order) {
+
+    uint8_t ratio_log2 = 0;
+
+    if(oversampling_ratio == 0 || oversampling_ratio > ADC_MAX_OVERSAMPLING_RATIO || (oversampling_ratio & (oversampling_ratio - 1)) != 0) {
+        return -1; //Error: wrong parameter, the ratio has to be a power of two
+    }
+    if(cic_order == 0 || cic_order > ADC_MAX_CIC_ORDER) {
+        return -1; //Error: wrong parameter, cic order
+    }
+    while((1u << ratio_log2) < oversampling_ratio) {
+        ratio_log2++;
+    }
+    if((12 + cic_order*ratio_log2) > 32) {
+        return -1; //Error: the filter output would not fit into 32 bit
+    }
+
+    adc_oversampling_ratio = oversampling_ratio;
+    adc_oversampling_ratio_log2 = ratio_log2;
+    adc_cic_order = cic_order;
+    adc_cic_output_shift = cic_order*ratio_log2 - (adc_get_decimated_resolution() - 12);
+    adc_reset_decimation();
+
+    return 1;
+
+}//end adc_set_decimation
+
+uint8_t adc_get_decimated_resolution(void) {
+
+    //Every 4x oversampling adds one bit (the noise of the ADC dithers the input), at most 16 bit
+    uint8_t resolution = 12 + adc_oversampling_ratio_log2/2;
+    if(resolution > 16) {
+        resolution = 16;
+    }
+    return resolution;
+
+}//end adc_get_decimated_resolution
+
+void adc_reset_decimation(void) {
+
+    adc_cic_phase = 0;
+    for(uint8_t k = 0; k < MAX_ADC_CHANNELS; k++) {
+        for(uint8_t o = 0; o < ADC_MAX_CIC_ORDER; o++) {
+            adc_cic_integrators[k][o] = 0;
+            adc_cic_combs[k][o] = 0;
+        }
+    }
+
+}//end adc_reset_decimation
 
 //end file adc.c
@@ -0,0 +1,141 @@
+//File: adc_stream.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Long ADC capture that is streamed into the flash, e.g. for soak runs over minutes (up to the whole free flash after the program).
+    The ADC captures continuously into a RAM ring of ADC_STREAM_NUMBER_OF_BLOCKS blocks (ring capture, see adc.h),
+    adc_stream_task() programs the captured pages into the flash while the DMA fills the next blocks.
+    The flash is erased ahead of the write position (erase-ahead), so an erase only runs while the ring has enough free space
+    to capture during the erase and the page programming never waits for an erase.
+
+    Sustained rate: the ring (ADC_STREAM_RING_SIZE bytes) has to bridge a flash erase (interrupts are disabled and the XIP is off during
+    erase and program). With the typical erase times this works up to about 100kS/s in 12-bit mode (200kS/s in 8-bit mode).
+    A capture that is to fast for the flash is stopped with the state ADC_STREAM_OVERRUN, the samples written so far stay valid.
+
+    NOTE: This module is not multi-core-save. Core 1 must not run from flash while the stream is running (see main.c).
+    NOTE: The block callback of the ADC is not used, the write position is taken from the DMA directly because several blocks
+          could complete while the interrupts are disabled.
+    NOTE: The flash region is not managed by the flash driver (flash.h), a region that overlaps the flash utility section or the user data
+          is rejected (set the sections of the flash driver before the start).
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+#include "adc.h"
+
+//Preprocessor constants:
+
+//Ring buffer: number of blocks (power of two) and samples p. block, a block is a multiple of the flash page size in both resolutions
+#define ADC_STREAM_NUMBER_OF_BLOCKS 16
+#define ADC_STREAM_BLOCK_SIZE 1024
+#define ADC_STREAM_RING_SIZE (ADC_STREAM_NUMBER_OF_BLOCKS*ADC_STREAM_BLOCK_SIZE*2)
+
+//Number of bytes that are kept erased ahead of the write position
+#define ADC_STREAM_ERASE_AHEAD_SIZE (2*65536)
+
+//Typical erase times of the flash (W25Q16JV), an erase is only started if the ring could capture this long without overrun
+#define ADC_STREAM_SECTOR_ERASE_TIME_US 45000
+#define ADC_STREAM_BLOCK_ERASE_TIME_US 150000
+
+//Type definitions:
+
+typedef enum ADC_Stream_State_e {
+
+    ADC_STREAM_IDLE = 0,
+    //Capturing and writing to flash
+    ADC_STREAM_RUNNING,
+    //All samples are written to flash
+    ADC_STREAM_DONE,
+    //The ADC overwrote samples in the ring that were not written to flash yet, capture stopped
+    ADC_STREAM_OVERRUN,
+
+}ADC_Stream_State_t;
+
+typedef struct ADC_Stream_Config_s {
+
+    //ADC
+    uint adc_channels[MAX_ADC_CHANNELS];
+    uint8_t number_of_adc_channels;
+    float adc_sample_rate;
+    uint dma_capture_channel;
+    uint dma_control_channel;
+    //Flash region (offset from the start of the flash), both multiple of FLASH_SECTOR_SIZE
+    uint32_t flash_offset;
+    uint32_t flash_size;
+    //Samples to capture (all channels, in round-robin order), 0 captures till the flash region is full
+    uint32_t number_of_samples;
+
+}ADC_Stream_Config_t;
+
+typedef struct ADC_Stream_Status_s {
+
+    ADC_Stream_State_t state;
+    uint32_t number_of_samples;
+    uint32_t number_of_written_samples;
+    //Maximum number of captured samples that waited in the ring for the flash
+    uint32_t max_backlog_samples;
+    uint32_t number_of_erases;
+    uint64_t start_time_us;
+
+}ADC_Stream_Status_t;
+
+//Function Prototypes:
+
+/**
+ * @brief Configures the ADC ring capture, erases the first part of the flash region and starts the capture.
+ *
+ * @param config ADC channels, sample rate, DMA channels, flash region and number of samples.
+ *
+ * @return int Returns 1 on success; otherwise, returns an error code:
+ *             -1: Wrong flash region (not sector aligned, overlaps the program, the flash driver sections or is outside of the flash).
+ *             -2: Wrong number of samples (more than fit into the flash region).
+ *             -3: The stream is running already.
+ *             -4: ADC could not be configured (see configure_adc_ring_capture()).
+ */
+int adc_stream_start(ADC_Stream_Config_t config);
+
+/**
+ * @brief Writes the captured pages to flash and erases ahead, has to be called continuously while the stream is running.
+ *
+ * Stops the ADC if all samples are written or the ring overran.
+ *
+ * @return Returns the state of the stream (ADC_STREAM_RUNNING till the capture is done).
+ */
+ADC_Stream_State_t adc_stream_task(void);
+
+/**
+ * @brief Stops the capture (if running) and de-configures the ADC, the samples in flash stay readable.
+ *
+ * @return int Returns 1 on success and -1 if the stream was never started.
+ */
+int adc_stream_stop(void);
+
+/**
+ * @brief Returns the state and counters of the stream.
+ */
+void adc_stream_get_status(ADC_Stream_Status_t *status);
+
+/**
+ * @brief Reads samples of the last stream from the flash.
+ *
+ * @param first_sample Index of the first sample (all channels, in round-robin order).
+ * @param num_of_samples Number of samples to read.
+ * @param samples Output buffer (ADC counts of the resolution of the stream).
+ *
+ * @return int Returns 1 on success and -1 if the samples are not written to flash (yet).
+ */
+int adc_stream_read(uint32_t first_sample, uint32_t num_of_samples, uint16_t *samples);
+
+//end file adc_stream.h
@@ -0,0 +1,291 @@
+//File: adc_stream.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    ADC capture streamed into the flash.
+    The capture position is taken from the write address of the DMA capture channel (position in the ring) and the
+    elapsed time since the start (number of ring laps), so blocks that complete while the interrupts are disabled by a flash
+    operation are not lost. Every page is programmed with its own flash_range_program() call, so the interrupts are only
+    disabled for one page program at a time. The erase uses 64kB blocks where the region is aligned (about 4 times the
+    throughput of 4kB sectors).
+
+*/
+
+
+//Corresponding header-file:
+#include "adc_stream.h"
+
+//Libraries:
+
+//Standard-C:
+#include <string.h>
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+
+//Pico Hardware-Libraries:
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+//Own Libraries:
+#include "flash.h"
+
+//Preprocessor constants:
+
+//End of the program in flash (linker script)
+extern char __flash_binary_end;
+
+//File global (static) variables:
+
+//Ring buffer, used as uint8_t array in 8-bit mode
+static uint16_t adc_stream_ring[ADC_STREAM_RING_SIZE/2];
+
+static ADC_Stream_Config_t adc_stream_config;
+static bool adc_stream_is_configured = false;
+static ADC_Stream_State_t adc_stream_state = ADC_STREAM_IDLE;
+static uint8_t adc_stream_bytes_per_sample = 2;
+static uint32_t adc_stream_ring_bytes = 0;
+static float adc_stream_conversion_period_us = 0;
+
+//Bytes of the capture (rounded up to full pages), written and erased bytes of the flash region
+static uint32_t adc_stream_total_bytes = 0;
+static uint32_t adc_stream_written_bytes = 0;
+static uint32_t adc_stream_erased_bytes = 0;
+
+static uint32_t adc_stream_max_backlog_bytes = 0;
+static uint32_t adc_stream_number_of_erases = 0;
+static uint64_t adc_stream_start_time_us = 0;
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Number of captured bytes since the start: position of the DMA in the ring plus the ring laps from the elapsed time
+static uint32_t adc_stream_get_captured_bytes(void) {
+
+    uint32_t ring_position = (dma_hw->ch[adc_stream_config.dma_capture_channel].write_addr - (uint32_t)adc_stream_ring)%adc_stream_ring_bytes;
+    //Double: a float has not enough digits for the elapsed time of long captures
+    double elapsed_us = (double)(time_us_64() - adc_stream_start_time_us);
+    int64_t estimated_bytes = (int64_t)(elapsed_us/adc_stream_conversion_period_us)*adc_stream_bytes_per_sample;
+
+    //Nearest lap count that matches the exact ring position
+    int64_t laps = (estimated_bytes - (int64_t)ring_position + (int64_t)(adc_stream_ring_bytes/2))/(int64_t)adc_stream_ring_bytes;
+    if(laps < 0) {
+        laps = 0;
+    }
+    return (uint32_t)(laps*adc_stream_ring_bytes + ring_position);
+
+}//end adc_stream_get_captured_bytes
+
+static void adc_stream_program_page(void) {
+
+    uint32_t interrupts;
+    const uint8_t *page = (const uint8_t*)adc_stream_ring + adc_stream_written_bytes%adc_stream_ring_bytes;
+
+    interrupts = save_and_disable_interrupts();
+    flash_range_program(adc_stream_config.flash_offset + adc_stream_written_bytes, page, FLASH_PAGE_SIZE);
+    restore_interrupts(interrupts);
+    adc_stream_written_bytes += FLASH_PAGE_SIZE;
+
+}//end adc_stream_program_page
+
+//Erases the next sector (or 64kB block if aligned) of the region, returns the duration of the erase in us
+static uint32_t adc_stream_erase_next(bool only_estimate) {
+
+    uint32_t interrupts;
+    uint32_t offset = adc_stream_config.flash_offset + adc_stream_erased_bytes;
+    uint32_t size = FLASH_SECTOR_SIZE;
+    uint32_t erase_time_us = ADC_STREAM_SECTOR_ERASE_TIME_US;
+
+    if((offset%FLASH_BLOCK_SIZE) == 0 && adc_stream_total_bytes - adc_stream_erased_bytes >= FLASH_BLOCK_SIZE) {
+        size = FLASH_BLOCK_SIZE;
+        erase_time_us = ADC_STREAM_BLOCK_ERASE_TIME_US;
+    }
+    if(only_estimate) {
+        return erase_time_us;
+    }
+
+    interrupts = save_and_disable_interrupts();
+    flash_range_erase(offset, size);
+    restore_interrupts(interrupts);
+    adc_stream_erased_bytes += size;
+    adc_stream_number_of_erases++;
+
+    return erase_time_us;
+
+}//end adc_stream_erase_next
+
+static void adc_stream_finish(ADC_Stream_State_t state) {
+
+    adc_start_measurement(false);
+    adc_stream_state = state;
+
+}//end adc_stream_finish
+
+//Function definition:
+
+int adc_stream_start(ADC_Stream_Config_t config) {
+
+    uint32_t program_end = (uint32_t)&__flash_binary_end - XIP_BASE;
+
+    if(adc_stream_state == ADC_STREAM_RUNNING) {
+        return -3; //Error: stream is running already
+    }
+    if((config.flash_offset%FLASH_SECTOR_SIZE) != 0 || (config.flash_size%FLASH_SECTOR_SIZE) != 0 || config.flash_size == 0) {
+        return -1; //Error: flash region is not sector aligned
+    }
+    if(config.flash_offset < program_end || config.flash_offset + config.flash_size > FLASH_END_OFFSET) {
+        return -1; //Error: flash region overlaps the program or is outside of the flash
+    }
+    if(flash_region_overlaps_driver_sections(config.flash_offset, config.flash_size)) {
+        return -1; //Error: flash region overlaps the utility section or the user data of the flash driver
+    }
+    if(adc_stream_is_configured) {
+        deconfigure_adc();
+        adc_stream_is_configured = false;
+    }
+
+    if(configure_adc_ring_capture(config.adc_channels, config.number_of_adc_channels, config.adc_sample_rate, config.dma_capture_channel,
+        config.dma_control_channel, adc_stream_ring, ADC_STREAM_NUMBER_OF_BLOCKS, ADC_STREAM_BLOCK_SIZE, NULL) < 0) {
+        return -4; //Error: ADC could not be configured
+    }
+    adc_stream_bytes_per_sample = (adc_get_resolution() == 8) ? 1 : 2;
+
+    uint32_t max_samples = config.flash_size/adc_stream_bytes_per_sample;
+    if(config.number_of_samples == 0) {
+        config.number_of_samples = max_samples;
+    }
+    if(config.number_of_samples > max_samples) {
+        deconfigure_adc();
+        return -2; //Error: samples do not fit into the flash region
+    }
+
+    adc_stream_config = config;
+    adc_stream_is_configured = true;
+    adc_stream_ring_bytes = ADC_STREAM_NUMBER_OF_BLOCKS*ADC_STREAM_BLOCK_SIZE*adc_stream_bytes_per_sample;
+    adc_stream_total_bytes = config.number_of_samples*adc_stream_bytes_per_sample;
+    adc_stream_total_bytes = ((adc_stream_total_bytes + FLASH_PAGE_SIZE - 1)/FLASH_PAGE_SIZE)*FLASH_PAGE_SIZE;
+    adc_stream_written_bytes = 0;
+    adc_stream_erased_bytes = 0;
+    adc_stream_max_backlog_bytes = 0;
+    adc_stream_number_of_erases = 0;
+
+    //Erase ahead before the start, the capture only has to wait for erases of later parts of the region
+    while(adc_stream_erased_bytes < adc_stream_total_bytes && adc_stream_erased_bytes < ADC_STREAM_ERASE_AHEAD_SIZE) {
+        adc_stream_erase_next(false);
+    }
+
+    adc_stream_state = ADC_STREAM_RUNNING;
+    adc_start_measurement(true);
+    adc_stream_start_time_us = time_us_64();
+    adc_stream_conversion_period_us = adc_get_conversion_period_us();
+
+    return 1;
+
+}//end adc_stream_start
+
+ADC_Stream_State_t adc_stream_task(void) {
+
+    if(adc_stream_state != ADC_STREAM_RUNNING) {
+        return adc_stream_state;
+    }
+
+    uint32_t captured_bytes = adc_stream_get_captured_bytes();
+    uint32_t backlog_bytes = captured_bytes - adc_stream_written_bytes;
+    if(backlog_bytes > adc_stream_max_backlog_bytes) {
+        adc_stream_max_backlog_bytes = backlog_bytes;
+    }
+    //The block in the ring that the DMA writes could not hold unwritten samples
+    if(backlog_bytes > adc_stream_ring_bytes - ADC_STREAM_BLOCK_SIZE*adc_stream_bytes_per_sample) {
+        adc_stream_finish(ADC_STREAM_OVERRUN);
+        return adc_stream_state;
+    }
+
+    //Program all complete pages that are erased already
+    while(adc_stream_written_bytes + FLASH_PAGE_SIZE <= captured_bytes && adc_stream_written_bytes < adc_stream_erased_bytes &&
+        adc_stream_written_bytes < adc_stream_total_bytes) {
+        adc_stream_program_page();
+    }
+    //Last page of the capture is only partly used
+    if(adc_stream_written_bytes < adc_stream_total_bytes && adc_stream_total_bytes - adc_stream_written_bytes == FLASH_PAGE_SIZE &&
+        captured_bytes >= adc_stream_config.number_of_samples*adc_stream_bytes_per_sample && adc_stream_written_bytes < adc_stream_erased_bytes) {
+        adc_stream_program_page();
+    }
+    if(adc_stream_written_bytes >= adc_stream_total_bytes) {
+        adc_stream_finish(ADC_STREAM_DONE);
+        return adc_stream_state;
+    }
+
+    //Erase ahead: only if the free part of the ring could capture during the erase, or if the writer reached the erased end
+    if(adc_stream_erased_bytes < adc_stream_total_bytes && adc_stream_erased_bytes - adc_stream_written_bytes < ADC_STREAM_ERASE_AHEAD_SIZE) {
+        backlog_bytes = adc_stream_get_captured_bytes() - adc_stream_written_bytes;
+        uint32_t usable_bytes = adc_stream_ring_bytes - ADC_STREAM_BLOCK_SIZE*adc_stream_bytes_per_sample;
+        uint32_t free_bytes = (backlog_bytes < usable_bytes) ? (usable_bytes - backlog_bytes) : 0;
+        float free_time_us = (float)(free_bytes/adc_stream_bytes_per_sample)*adc_stream_conversion_period_us;
+        if(free_time_us > (float)adc_stream_erase_next(true) || adc_stream_erased_bytes - adc_stream_written_bytes < FLASH_PAGE_SIZE) {
+            adc_stream_erase_next(false);
+        }
+    }
+
+    return adc_stream_state;
+
+}//end adc_stream_task
+
+int adc_stream_stop(void) {
+
+    if(!adc_stream_is_configured) {
+        return -1; //Error: stream was never started
+    }
+
+    if(adc_stream_state == ADC_STREAM_RUNNING) {
+        adc_stream_finish(ADC_STREAM_IDLE);
+    }
+    deconfigure_adc();
+    adc_stream_is_configured = false;
+
+    return 1;
+
+}//end adc_stream_stop
+
+void adc_stream_get_status(ADC_Stream_Status_t *status) {
+
+    status->state = adc_stream_state;
+    status->number_of_samples = adc_stream_config.number_of_samples;
+    status->number_of_written_samples = adc_stream_written_bytes/adc_stream_bytes_per_sample;
+    if(status->number_of_written_samples > adc_stream_config.number_of_samples) {
+        status->number_of_written_samples = adc_stream_config.number_of_samples;
+    }
+    status->max_backlog_samples = adc_stream_max_backlog_bytes/adc_stream_bytes_per_sample;
+    status->number_of_erases = adc_stream_number_of_erases;
+    status->start_time_us = adc_stream_start_time_us;
+
+}//end adc_stream_get_status
+
+int adc_stream_read(uint32_t first_sample, uint32_t num_of_samples, uint16_t *samples) {
+
+    uint32_t written_samples = adc_stream_written_bytes/adc_stream_bytes_per_sample;
+    if(first_sample + num_of_samples > written_samples || first_sample + num_of_samples < first_sample) {
+        return -1; //Error: samples are not written to flash
+    }
+
+    const uint8_t *flash_data = (const uint8_t*)(XIP_BASE + adc_stream_config.flash_offset);
+    for(uint32_t k = 0; k < num_of_samples; k++) {
+        if(adc_stream_bytes_per_sample == 1) {
+            samples[k] = flash_data[first_sample + k];
+        }
+        else {
+            uint16_t sample;
+            memcpy(&sample, &flash_data[2*(first_sample + k)], sizeof(sample));
+            samples[k] = sample;
+        }
+    }
+
+    return 1;
+
+}//end adc_stream_read
+
+//end file adc_stream.c
@@ -0,0 +1,133 @@
+//File: adc_trigger.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Oscilloscope like triggered capture on top of the ADC ring capture (see adc.h), e.g. to see the signal around a gradient induced glitch.
+    The ADC captures continuously into a ring of ADC_TRIGGER_NUMBER_OF_BLOCKS blocks (DMA, no CPU p. sample).
+    Every completed block is scanned for the trigger in the DMA interrupt:
+        -Level: first sample above (or below) the threshold
+        -Edge: first sample that crosses the threshold (rising or falling), the crossing between two blocks is detected too
+        -GPIO: rising edge on a gpio pin, the position in the capture is taken from the DMA transfer count in the gpio interrupt
+    After the trigger the capture runs till post_trigger_samples are captured, then the ADC stops (freeze) and the
+    pre_trigger_samples before and the post_trigger_samples after the trigger could be read out.
+
+    NOTE: This module is not multi-core-save. The GPIO trigger uses a raw gpio interrupt handler of the pin (gpio_add_raw_irq_handler()), the gpio callback stays free.
+    NOTE: The threshold is given in ADC counts of the configured resolution (see adc_set_resolution()).
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Ring buffer: number of blocks (power of two) and samples p. block
+#define ADC_TRIGGER_NUMBER_OF_BLOCKS 16
+#define ADC_TRIGGER_BLOCK_SIZE 512
+//Two blocks of the ring are in use by the DMA (the block that is written and the one that is scanned)
+#define ADC_TRIGGER_MAX_SAMPLES ((ADC_TRIGGER_NUMBER_OF_BLOCKS - 2)*ADC_TRIGGER_BLOCK_SIZE)
+
+//Type definitions:
+
+typedef enum ADC_Trigger_Mode_e {
+
+    ADC_TRIGGER_LEVEL_ABOVE = 0,
+    ADC_TRIGGER_LEVEL_BELOW,
+    ADC_TRIGGER_RISING_EDGE,
+    ADC_TRIGGER_FALLING_EDGE,
+    ADC_TRIGGER_GPIO,
+
+}ADC_Trigger_Mode_t;
+
+typedef enum ADC_Trigger_State_e {
+
+    ADC_TRIGGER_IDLE = 0,
+    //Capturing, waiting for the trigger
+    ADC_TRIGGER_ARMED,
+    //Trigger detected, capturing the post trigger samples
+    ADC_TRIGGER_TRIGGERED,
+    //Capture stopped, samples could be read out
+    ADC_TRIGGER_FROZEN,
+
+}ADC_Trigger_State_t;
+
+typedef struct ADC_Trigger_Config_s {
+
+    //ADC
+    uint adc_channel;
+    float adc_sample_rate;
+    uint dma_capture_channel;
+    uint dma_control_channel;
+    //Trigger
+    ADC_Trigger_Mode_t mode;
+    //Threshold in ADC counts (level and edge modes)
+    uint16_t threshold;
+    //Trigger input (GPIO mode)
+    uint trigger_gpio_pin;
+    //Samples before and after the trigger, the sum is limited to ADC_TRIGGER_MAX_SAMPLES
+    uint32_t pre_trigger_samples;
+    uint32_t post_trigger_samples;
+
+}ADC_Trigger_Config_t;
+
+//Function Prototypes:
+
+/**
+ * @brief Configures the ADC ring capture and the trigger.
+ *
+ * @param config ADC channel, sample rate, DMA channels, trigger mode and pre/post trigger depth.
+ *
+ * @return int Returns 1 on success; otherwise, returns an error code:
+ *             -1: Wrong configuration (e.g. pre_trigger_samples + post_trigger_samples > ADC_TRIGGER_MAX_SAMPLES).
+ *             -2: The trigger is configured already.
+ *             -3: ADC could not be configured (see configure_adc_ring_capture()).
+ */
+int configure_adc_trigger(ADC_Trigger_Config_t config);
+
+/**
+ * @brief Stops the capture and de-configures the ADC and the trigger.
+ *
+ * @return int Returns 1 on success and -1 if the trigger is not configured.
+ */
+int deconfigure_adc_trigger(void);
+
+/**
+ * @brief Starts the continuous capture and waits for the trigger (also re-arms after a readout).
+ *
+ * The trigger is accepted after pre_trigger_samples are captured, so the pre trigger part is always complete.
+ *
+ * @return int Returns 1 on success and -1 if the trigger is not configured.
+ */
+int adc_trigger_arm(void);
+
+/**
+ * @brief Returns the state of the triggered capture (idle, armed, triggered or frozen).
+ */
+ADC_Trigger_State_t adc_trigger_get_state(void);
+
+/**
+ * @brief Reads out the frozen capture in chronological order.
+ *
+ * The trigger sample is at index pre_trigger_samples of the output.
+ *
+ * @param samples Output buffer (ADC counts of the configured resolution).
+ * @param max_samples Size of the output buffer.
+ *
+ * @return int Returns the number of samples (pre_trigger_samples + post_trigger_samples); otherwise, returns an error code:
+ *             -1: No frozen capture (not triggered yet).
+ *             -2: Output buffer is to small.
+ */
+int adc_trigger_read(uint16_t *samples, uint32_t max_samples);
+
+//end file adc_trigger.h
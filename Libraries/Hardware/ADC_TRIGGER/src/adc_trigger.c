@@ -0,0 +1,289 @@
+//File: adc_trigger.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Triggered ADC capture with pre trigger ring buffer.
+    The ADC ring capture writes the samples into adc_trigger_ring without CPU, the block callback (DMA interrupt)
+    scans the completed block for the trigger and stops the ADC when the post trigger samples are captured.
+    The position of the trigger is counted in samples since the start of the capture (absolute index), sample n is at
+    ring position n%ADC_TRIGGER_RING_SIZE.
+
+*/
+
+
+//Corresponding header-file:
+#include "adc_trigger.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+#include "adc.h"
+
+//Preprocessor constants:
+#define ADC_TRIGGER_RING_SIZE (ADC_TRIGGER_NUMBER_OF_BLOCKS*ADC_TRIGGER_BLOCK_SIZE)
+
+//File global (static) variables:
+
+//Ring buffer, used as uint8_t array in 8-bit mode
+static uint16_t adc_trigger_ring[ADC_TRIGGER_RING_SIZE];
+
+static ADC_Trigger_Config_t adc_trigger_config;
+static uint8_t adc_trigger_resolution = 8;
+static bool adc_trigger_is_configured = false;
+
+static volatile ADC_Trigger_State_t adc_trigger_state = ADC_TRIGGER_IDLE;
+//Completed blocks since adc_trigger_arm()
+static volatile uint32_t adc_trigger_block_count = 0;
+//Absolute index of the trigger sample
+static volatile uint32_t adc_trigger_index = 0;
+//Last sample of the previous block (edge detection across two blocks)
+static uint16_t adc_trigger_previous_sample = 0;
+static bool adc_trigger_has_previous_sample = false;
+
+//Functions:
+
+//File global (static) function definitions:
+
+static inline uint16_t adc_trigger_get_sample(const void *block, uint32_t index) {
+
+    if(adc_trigger_resolution == 8) {
+        return ((const uint8_t*)block)[index];
+    }
+    return ((const uint16_t*)block)[index];
+
+}//end adc_trigger_get_sample
+
+//Returns the index of the trigger sample inside the block or -1 if there is no trigger in the block
+static int32_t adc_trigger_scan_block(const void *block, uint32_t num_of_samples, uint32_t first_sample_index) {
+
+    uint32_t start = 0;
+    uint16_t threshold = adc_trigger_config.threshold;
+
+    //Trigger is accepted after the pre trigger samples are captured
+    if(first_sample_index < adc_trigger_config.pre_trigger_samples) {
+        start = adc_trigger_config.pre_trigger_samples - first_sample_index;
+        if(start >= num_of_samples) {
+            adc_trigger_previous_sample = adc_trigger_get_sample(block, num_of_samples - 1);
+            adc_trigger_has_previous_sample = true;
+            return -1;
+        }
+    }
+
+    switch(adc_trigger_config.mode) {
+
+        case ADC_TRIGGER_LEVEL_ABOVE:
+            for(uint32_t k = start; k < num_of_samples; k++) {
+                if(adc_trigger_get_sample(block, k) > threshold) {
+                    return (int32_t)k;
+                }
+            }
+            break;
+
+        case ADC_TRIGGER_LEVEL_BELOW:
+            for(uint32_t k = start; k < num_of_samples; k++) {
+                if(adc_trigger_get_sample(block, k) < threshold) {
+                    return (int32_t)k;
+                }
+            }
+            break;
+
+        case ADC_TRIGGER_RISING_EDGE:
+        case ADC_TRIGGER_FALLING_EDGE: {
+            bool rising = (adc_trigger_config.mode == ADC_TRIGGER_RISING_EDGE);
+            uint16_t previous = adc_trigger_previous_sample;
+            bool has_previous = adc_trigger_has_previous_sample;
+            if(start > 0) {
+                previous = adc_trigger_get_sample(block, start - 1);
+                has_previous = true;
+            }
+            for(uint32_t k = start; k < num_of_samples; k++) {
+                uint16_t sample = adc_trigger_get_sample(block, k);
+                if(has_previous) {
+                    if(rising && previous < threshold && sample >= threshold) {
+                        return (int32_t)k;
+                    }
+                    if(!rising && previous >= threshold && sample < threshold) {
+                        return (int32_t)k;
+                    }
+                }
+                previous = sample;
+                has_previous = true;
+            }
+            adc_trigger_previous_sample = previous;
+            adc_trigger_has_previous_sample = has_previous;
+            break;
+        }
+
+        default:
+            break;
+
+    }
+
+    return -1;
+
+}//end adc_trigger_scan_block
+
+static void adc_trigger_block_callback(const void *block, uint32_t num_of_samples, uint8_t buffer_index) {
+
+    (void)buffer_index;
+    uint32_t first_sample_index = adc_trigger_block_count*num_of_samples;
+    adc_trigger_block_count++;
+
+    if(adc_trigger_state == ADC_TRIGGER_ARMED && adc_trigger_config.mode != ADC_TRIGGER_GPIO) {
+        int32_t trigger_position = adc_trigger_scan_block(block, num_of_samples, first_sample_index);
+        if(trigger_position >= 0) {
+            adc_trigger_index = first_sample_index + (uint32_t)trigger_position;
+            adc_trigger_state = ADC_TRIGGER_TRIGGERED;
+        }
+    }
+
+    //Freeze as soon as the post trigger samples are complete, the DMA overwrites the oldest block next
+    if(adc_trigger_state == ADC_TRIGGER_TRIGGERED) {
+        if(first_sample_index + num_of_samples >= adc_trigger_index + adc_trigger_config.post_trigger_samples) {
+            adc_start_measurement(false);
+            adc_trigger_state = ADC_TRIGGER_FROZEN;
+        }
+    }
+
+}//end adc_trigger_block_callback
+
+//Raw handler of the trigger pin, the global gpio callback (gpio_set_irq_enabled_with_callback) stays free for other modules
+static void adc_trigger_gpio_irq_handler(void) {
+
+    if(!(gpio_get_irq_event_mask(adc_trigger_config.trigger_gpio_pin) & GPIO_IRQ_EDGE_RISE)) {
+        return;
+    }
+    gpio_acknowledge_irq(adc_trigger_config.trigger_gpio_pin, GPIO_IRQ_EDGE_RISE);
+    if(adc_trigger_state != ADC_TRIGGER_ARMED) {
+        return;
+    }
+    //Position of the DMA in the capture is the position of the trigger
+    uint32_t sample_index = adc_get_sample_count();
+    if(sample_index < adc_trigger_config.pre_trigger_samples) {
+        return; //Pre trigger samples are not complete
+    }
+    adc_trigger_index = sample_index;
+    adc_trigger_state = ADC_TRIGGER_TRIGGERED;
+
+}//end adc_trigger_gpio_irq_handler
+
+//Function definition:
+
+int configure_adc_trigger(ADC_Trigger_Config_t config) {
+
+    if(adc_trigger_is_configured) {
+        return -2; //Error: trigger is configured already
+    }
+    if(config.mode > ADC_TRIGGER_GPIO) {
+        return -1; //Error: unknown trigger mode
+    }
+    if(config.pre_trigger_samples + config.post_trigger_samples > ADC_TRIGGER_MAX_SAMPLES) {
+        return -1; //Error: capture does not fit into the ring buffer
+    }
+    if(config.mode == ADC_TRIGGER_GPIO && config.trigger_gpio_pin >= NUM_BANK0_GPIOS) {
+        return -1; //Error: wrong gpio pin
+    }
+
+    uint adc_channels[1] = {config.adc_channel};
+    if(configure_adc_ring_capture(adc_channels, 1, config.adc_sample_rate, config.dma_capture_channel, config.dma_control_channel,
+        adc_trigger_ring, ADC_TRIGGER_NUMBER_OF_BLOCKS, ADC_TRIGGER_BLOCK_SIZE, adc_trigger_block_callback) < 0) {
+        return -3; //Error: ADC could not be configured
+    }
+
+    if(config.mode == ADC_TRIGGER_GPIO) {
+        gpio_init(config.trigger_gpio_pin);
+        gpio_set_dir(config.trigger_gpio_pin, GPIO_IN);
+    }
+
+    adc_trigger_config = config;
+    if(config.mode == ADC_TRIGGER_GPIO) {
+        gpio_add_raw_irq_handler(config.trigger_gpio_pin, adc_trigger_gpio_irq_handler);
+        gpio_set_irq_enabled(config.trigger_gpio_pin, GPIO_IRQ_EDGE_RISE, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+    }
+    adc_trigger_resolution = adc_get_resolution();
+    adc_trigger_state = ADC_TRIGGER_IDLE;
+    adc_trigger_is_configured = true;
+
+    return 1;
+
+}//end configure_adc_trigger
+
+int deconfigure_adc_trigger(void) {
+
+    if(!adc_trigger_is_configured) {
+        return -1; //Error: trigger is not configured
+    }
+
+    if(adc_trigger_config.mode == ADC_TRIGGER_GPIO) {
+        gpio_set_irq_enabled(adc_trigger_config.trigger_gpio_pin, GPIO_IRQ_EDGE_RISE, false);
+        gpio_remove_raw_irq_handler(adc_trigger_config.trigger_gpio_pin, adc_trigger_gpio_irq_handler);
+        gpio_deinit(adc_trigger_config.trigger_gpio_pin);
+    }
+    adc_start_measurement(false);
+    deconfigure_adc();
+
+    adc_trigger_state = ADC_TRIGGER_IDLE;
+    adc_trigger_is_configured = false;
+
+    return 1;
+
+}//end deconfigure_adc_trigger
+
+int adc_trigger_arm(void) {
+
+    if(!adc_trigger_is_configured) {
+        return -1; //Error: trigger is not configured
+    }
+
+    //Stop a running capture (re-arm without readout)
+    adc_start_measurement(false);
+
+    adc_trigger_block_count = 0;
+    adc_trigger_index = 0;
+    adc_trigger_has_previous_sample = false;
+    adc_trigger_state = ADC_TRIGGER_ARMED;
+
+    adc_start_measurement(true);
+
+    return 1;
+
+}//end adc_trigger_arm
+
+ADC_Trigger_State_t adc_trigger_get_state(void) {
+
+    return adc_trigger_state;
+
+}//end adc_trigger_get_state
+
+int adc_trigger_read(uint16_t *samples, uint32_t max_samples) {
+
+    if(adc_trigger_state != ADC_TRIGGER_FROZEN) {
+        return -1; //Error: no frozen capture
+    }
+    uint32_t num_of_samples = adc_trigger_config.pre_trigger_samples + adc_trigger_config.post_trigger_samples;
+    if(max_samples < num_of_samples) {
+        return -2; //Error: output buffer is to small
+    }
+
+    uint32_t ring_position = (adc_trigger_index - adc_trigger_config.pre_trigger_samples)%ADC_TRIGGER_RING_SIZE;
+    for(uint32_t k = 0; k < num_of_samples; k++) {
+        samples[k] = adc_trigger_get_sample(adc_trigger_ring, ring_position);
+        ring_position = (ring_position + 1)%ADC_TRIGGER_RING_SIZE;
+    }
+
+    return (int)num_of_samples;
+
+}//end adc_trigger_read
+
+//end file adc_trigger.c
@@ -129,6 +129,19 @@ int flash_set_flash_target_offset_for_user_data(uint32_t flash_target_offset, bo
  */
 uint32_t flash_get_current_user_data_offset(void);
 
+/**
+ * @brief Checks if a flash region overlaps the sections of this driver.
+ *
+ * The utility section (one sector, if its offset is set) and the user data (from the user data offset to FLASH_END_OFFSET, if set)
+ * are used by this driver, other modules that write to flash directly have to use regions outside of them.
+ *
+ * @param flash_offset Offset of the region.
+ * @param size Size of the region in bytes.
+ *
+ * @return Returns true if the region overlaps the utility section or the user data.
+ */
+bool flash_region_overlaps_driver_sections(uint32_t flash_offset, uint32_t size);
+
 /**
  * @brief Writes bytes to flash memory.
  *
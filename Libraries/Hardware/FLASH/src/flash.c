@@ -215,6 +215,23 @@ uint32_t flash_get_current_user_data_offset(void) {
 
 }//end flash_get_current_user_data_offset
 
+bool flash_region_overlaps_driver_sections(uint32_t flash_offset, uint32_t size) {
+
+    uint64_t region_end = (uint64_t)flash_offset + size;
+
+    if(flash_utility_section_offset_set_flag && flash_offset < flash_utility_section_offset + FLASH_SECTOR_SIZE &&
+        region_end > flash_utility_section_offset) {
+        return true;
+    }
+    //The user data grows from its offset up to the end of the flash
+    if(flash_target_offset_set_flag && region_end > flash_target_offset) {
+        return true;
+    }
+
+    return false;
+
+}//end flash_region_overlaps_driver_sections
+
 int write_bytes_to_flash(uint32_t *data_start_address, uint8_t *bytes, uint16_t num_of_bytes) {
 
     //Temp variable to store offset
@@ -343,6 +360,11 @@ int init_flash() {
     if(flash_utility_data[0] != 1) {
         user_data_to_flash_written = false;
         flash_delete_flash_utility_section();
+        //Only the counters and offset of the user data are reset, the utility user space (settings) is kept
+        for(uint32_t p = 0; p < FLASH_UTILITY_USER_DATA_START_INDEX; p++) {
+            flash_utility_data[p] = 0;
+        }
+        flash_write_flash_utility_section();
         return 1;
     }
     else {
@@ -2,7 +2,10 @@
 //Project: Pico_MRI_Test_M
 
 /* Description:
-
+    Let user configure pio state-machines as PWM output, square wave output or PWM input.
+    The PWM input counts high time and low time of every period in the state-machine, the counts are moved by DMA into a ring,
+    so the frequency and duty-cycle of every period could be evaluated (not only a gate interval average).
+    Only one PWM input could be configured at the same time.
 */
 
 //Libraries:
@@ -24,6 +27,19 @@
 
 //Type definitions:
 
+typedef struct PIO_PWM_Input_Statistic_s {
+
+    uint32_t number_of_periods;
+    uint32_t number_of_lost_periods;
+    float mean_frequency;
+    float std_frequency;
+    float min_frequency;
+    float max_frequency;
+    float mean_duty_cycle;
+    float std_duty_cycle;
+
+}PIO_PWM_Input_Statistic_t;
+
 //Function Prototypes:
 
 //PWM:
@@ -33,7 +49,9 @@ int configure_pio_pwm_output(PIO pio, uint sm, float pio_sm_clk_div, uint pwm_gp
 int set_pio_pwm_period(PIO pio, uint sm, uint32_t pwm_period);
 int set_pio_pwm_lvl(PIO pio, uint sm, uint32_t pwm_lvl);
 
-int configure_pio_pwm_intput(uint pwm_gpio_pin, float sample_frequency);
+int configure_pio_pwm_intput(PIO pio, uint sm, uint pwm_gpio_pin, float sample_frequency, uint dma_channel);
+int pio_pwm_input_get_statistic(PIO pio, uint sm, PIO_PWM_Input_Statistic_t *statistic);
+void pio_pwm_input_reset_statistic(void);
 
 
 //Square-Wave:
@@ -0,0 +1,67 @@
+// -------------------------------------------------- //
+// This file is autogenerated by pioasm; do not edit! //
+// -------------------------------------------------- //
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// ------ //
+// pwm_in //
+// ------ //
+
+#define pwm_in_wrap_target 2
+#define pwm_in_wrap 12
+
+static const uint16_t pwm_in_program_instructions[] = {
+    0x2020, //  0: wait   0 pin, 0
+    0x20a0, //  1: wait   1 pin, 0
+            //     .wrap_target
+    0xa02b, //  2: mov    x, ~null
+    0x00c5, //  3: jmp    pin, 5
+    0x0006, //  4: jmp    6
+    0x0043, //  5: jmp    x--, 3
+    0xa04b, //  6: mov    y, ~null
+    0x00c9, //  7: jmp    pin, 9
+    0x0087, //  8: jmp    y--, 7
+    0xa0c9, //  9: mov    isr, ~x
+    0x8020, // 10: push   block
+    0xa0ca, // 11: mov    isr, ~y
+    0x8020, // 12: push   block
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program pwm_in_program = {
+    .instructions = pwm_in_program_instructions,
+    .length = 13,
+    .origin = -1,
+};
+
+static inline pio_sm_config pwm_in_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + pwm_in_wrap_target, offset + pwm_in_wrap);
+    return c;
+}
+
+static inline void pwm_in_init(PIO pio, uint sm, uint offset, float pio_sm_clk_div, uint pwm_in_pin) {
+    //Init gpio pin
+    pio_gpio_init(pio, pwm_in_pin);
+    //Set pin direction
+    pio_sm_set_consecutive_pindirs(pio, sm, pwm_in_pin, 1, false);
+    //Get statemachine configuration
+    pio_sm_config config = pwm_in_program_get_default_config(offset);
+    //Set gpio pin as input pin (wait) and jump pin of this statemachine configuration
+    sm_config_set_in_pins(&config, pwm_in_pin);
+    sm_config_set_jmp_pin(&config, pwm_in_pin);
+    //Only the RX-FIFO is used, join both FIFOs to 8 entries
+    sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_RX);
+    //Set clk divider of state-machine (the resolution is two state-machine cycles)
+    sm_config_set_clkdiv(&config, pio_sm_clk_div);
+    //Init pio state-machine
+    pio_sm_init(pio, sm, offset, &config);
+}
+
+#endif
@@ -2,7 +2,9 @@
 //Project: Pico_MRI_Test_M
 
 /* Description:
-
+    PWM input: the state-machine (pio_pwm_in.pio) pushes the high count and the low count of every period, a DMA channel (paced by
+    the RX-FIFO DREQ) moves the counts into a ring, so the CPU only has to evaluate the ring from time to time.
+    In state-machine cycles: high time = 2*high_count + 6, low time = 2*low_count + 3.
 */
 
 //Libraries:
@@ -18,25 +20,36 @@
 
 //Pico Hardware-Libraries:
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
 
 //PIO header from pio assembly
 #include "pio_pwm_out.pio.h"
 #include "pio_square_wave_out.pio.h"
+#include "pio_pwm_in.pio.h"
 
 
 //Own Libraries:
+#include "statistic.h"
 
 //Preprocessor constants:
 
 #define NUM_OF_PIO 2
 #define NUM_OF_SM 4
 
+//Logged counts of the PWM input (high and low count p. period, power of two, the DMA write ring is aligned to the size of the log)
+#define PIO_PWM_INPUT_LOG_SIZE 256
+#define PIO_PWM_INPUT_LOG_RING_BITS 10
+//Constant state-machine cycles of the high time and the low time (instructions outside of the count loops)
+#define PIO_PWM_INPUT_HIGH_CYCLES 6
+#define PIO_PWM_INPUT_LOW_CYCLES 3
+
 //File global (static) typedefs:
 
 typedef enum pio_sm_configuration_type_e {
 
     PWM,
     SQUAREWAVE,
+    PWM_INPUT,
 
 }pio_sm_configuration_type_t;
 
@@ -54,6 +67,24 @@ typedef struct pio_sm_configuration_s {
 //File global (static) variables:
 pio_sm_configuration_t configuration_array[NUM_OF_PIO][NUM_OF_SM];
 
+//PWM-Input-Instance:
+static bool pio_pwm_input_is_configured = false;
+static uint pio_pwm_input_dma_channel = 0;
+static uint pio_pwm_input_program_offset = 0;
+static float pio_pwm_input_sample_frequency = 0;
+
+//Log of the counts, written by DMA
+static uint32_t pio_pwm_input_log[PIO_PWM_INPUT_LOG_SIZE] __attribute__((aligned(4*PIO_PWM_INPUT_LOG_SIZE)));
+//Number of logged counts that are added to the statistic
+static uint32_t pio_pwm_input_processed_counts = 0;
+
+//Statistic of the periods
+static Welford_Statistic_t pio_pwm_input_frequency_statistic;
+static Welford_Statistic_t pio_pwm_input_duty_cycle_statistic;
+static float pio_pwm_input_min_frequency = 0;
+static float pio_pwm_input_max_frequency = 0;
+static uint32_t pio_pwm_input_lost_periods = 0;
+
 //File global (static) functions
 
 int get_pio_index_from_pio(PIO pio) {
@@ -79,6 +110,13 @@ bool get_configuration_status(PIO pio, uint sm) {
 
 }//end get_configuration_status
 
+//Number of counts the DMA has logged since the start of the PWM input
+static uint32_t pio_pwm_input_get_logged_counts(void) {
+
+    return 0xFFFFFFFE - dma_hw->ch[pio_pwm_input_dma_channel].transfer_count;
+
+}//end pio_pwm_input_get_logged_counts
+
 //Function definition:
 
 //PWM:
@@ -168,6 +206,167 @@ int set_pio_pwm_lvl(PIO pio, uint sm, uint32_t pwm_lvl) {
 
 }//end set_new_pio_pwm_lvl
 
+int configure_pio_pwm_intput(PIO pio, uint sm, uint pwm_gpio_pin, float sample_frequency, uint dma_channel) {
+
+    float clk_div = 0;
+    int pio_index = 0;
+    dma_channel_config dma_conf;
+
+    pio_index = get_pio_index_from_pio(pio);
+
+    if(pio_index < 0 || sm >= NUM_OF_SM) {
+        return -1; //Error: the given parameter do not represent an actual hardware
+    }
+
+    if(get_configuration_status(pio, sm) || pio_pwm_input_is_configured) {
+        return -1; //Error: state-machine already used for other functionality, or PWM input already configured
+    }
+
+    if(pio_sm_is_claimed(pio, sm)) {
+        return -1; //Error: state machine already claimed
+    }
+
+    //The state-machine runs with the sample frequency
+    clk_div = (float)clock_get_hz(clk_sys)/sample_frequency;
+    if(sample_frequency <= 0 || clk_div < 1 || clk_div >= 65536) {
+        return -2; //Error: sample frequency out of range
+    }
+
+    if(dma_channel_is_claimed(dma_channel)) {
+        return -3; //Error: DMA channel already claimed
+    }
+
+    if(!pio_can_add_program(pio, &pwm_in_program)) {
+        return -4; //Error: no space for the program in the instruction memory
+    }
+
+    //Claim hardware
+    pio_sm_claim(pio, sm);
+    dma_channel_claim(dma_channel);
+
+    //Add program and get offset
+    pio_pwm_input_program_offset = pio_add_program(pio, &pwm_in_program);
+    //Init program
+    pwm_in_init(pio, sm, pio_pwm_input_program_offset, clk_div, pwm_gpio_pin);
+
+    //Move the counts from the RX-FIFO into the ring (count of transfers nearly endless, even number so the counts stay in pairs)
+    dma_conf = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&dma_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_conf, false);
+    channel_config_set_write_increment(&dma_conf, true);
+    channel_config_set_ring(&dma_conf, true, PIO_PWM_INPUT_LOG_RING_BITS);
+    channel_config_set_dreq(&dma_conf, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(dma_channel, &dma_conf, pio_pwm_input_log, &pio->rxf[sm], 0xFFFFFFFE, true);
+
+    //Set static pio and gpio_pin
+    configuration_array[pio_index][sm].gpio_pin = pwm_gpio_pin;
+    configuration_array[pio_index][sm].pio = pio;
+
+    //Set flags
+    configuration_array[pio_index][sm].pio_gpio_is_output = false;
+    configuration_array[pio_index][sm].pio_is_configured = true;
+
+    //Set type of configuration (the functionality of the state-machine)
+    configuration_array[pio_index][sm].type = PWM_INPUT;
+
+    pio_pwm_input_dma_channel = dma_channel;
+    pio_pwm_input_sample_frequency = (float)clock_get_hz(clk_sys)/clk_div;
+    pio_pwm_input_processed_counts = 0;
+    pio_pwm_input_is_configured = true;
+    pio_pwm_input_reset_statistic();
+
+    pio_sm_set_enabled(pio, sm, true);
+
+    return 1;
+
+}//end configure_pio_pwm_intput
+
+int pio_pwm_input_get_statistic(PIO pio, uint sm, PIO_PWM_Input_Statistic_t *statistic) {
+
+    int pio_index = get_pio_index_from_pio(pio);
+    int number_of_new_periods = 0;
+
+    if(!get_configuration_status(pio, sm)) {
+        return -1; //Error: state-machine is not configured, or the given parameters do not represent an actual hardware
+    }
+
+    if(configuration_array[pio_index][sm].type != PWM_INPUT) {
+        return -1; //Error: state-machine is not configured as PWM input
+    }
+
+    uint32_t logged_counts = pio_pwm_input_get_logged_counts();
+
+    //Only complete periods (high count and low count)
+    while(pio_pwm_input_processed_counts + 2 <= logged_counts) {
+
+        uint32_t high_count = pio_pwm_input_log[pio_pwm_input_processed_counts%PIO_PWM_INPUT_LOG_SIZE];
+        uint32_t low_count = pio_pwm_input_log[(pio_pwm_input_processed_counts + 1)%PIO_PWM_INPUT_LOG_SIZE];
+
+        //The DMA could have overwritten the counts in the ring before (or while) they were read, check them after the read
+        uint32_t current_logged_counts = pio_pwm_input_get_logged_counts();
+        if(current_logged_counts - pio_pwm_input_processed_counts >= PIO_PWM_INPUT_LOG_SIZE) {
+            //Restart with a complete period in the middle of the ring (so it is not overwritten before it is read)
+            uint32_t restart_count = (current_logged_counts - PIO_PWM_INPUT_LOG_SIZE/2) & ~1u;
+            pio_pwm_input_lost_periods += (restart_count - pio_pwm_input_processed_counts)/2;
+            pio_pwm_input_processed_counts = restart_count;
+            logged_counts = current_logged_counts;
+            continue;
+        }
+
+        //The first period after the start enters the high count from the wait for the rising edge (without the push of a
+        //previous period), its constant cycles differ, discard it
+        if(pio_pwm_input_processed_counts == 0) {
+            pio_pwm_input_processed_counts += 2;
+            continue;
+        }
+
+        float high_cycles = 2.0f*high_count + PIO_PWM_INPUT_HIGH_CYCLES;
+        float period_cycles = high_cycles + 2.0f*low_count + PIO_PWM_INPUT_LOW_CYCLES;
+        float frequency = pio_pwm_input_sample_frequency/period_cycles;
+
+        if(pio_pwm_input_frequency_statistic.count == 0 || frequency < pio_pwm_input_min_frequency) {
+            pio_pwm_input_min_frequency = frequency;
+        }
+        if(pio_pwm_input_frequency_statistic.count == 0 || frequency > pio_pwm_input_max_frequency) {
+            pio_pwm_input_max_frequency = frequency;
+        }
+        welford_add_value(&pio_pwm_input_frequency_statistic, frequency);
+        welford_add_value(&pio_pwm_input_duty_cycle_statistic, high_cycles/period_cycles);
+
+        pio_pwm_input_processed_counts += 2;
+        number_of_new_periods++;
+    }
+
+    //The transfer count of the DMA is nearly endless, restart if it ever ends
+    if(!dma_channel_is_busy(pio_pwm_input_dma_channel)) {
+        dma_channel_set_write_addr(pio_pwm_input_dma_channel, pio_pwm_input_log, false);
+        dma_channel_set_trans_count(pio_pwm_input_dma_channel, 0xFFFFFFFE, true);
+        pio_pwm_input_processed_counts = 0;
+    }
+
+    statistic->number_of_periods = pio_pwm_input_frequency_statistic.count;
+    statistic->number_of_lost_periods = pio_pwm_input_lost_periods;
+    statistic->mean_frequency = welford_get_mean_value(&pio_pwm_input_frequency_statistic);
+    statistic->std_frequency = welford_get_std_deviation(&pio_pwm_input_frequency_statistic);
+    statistic->min_frequency = pio_pwm_input_min_frequency;
+    statistic->max_frequency = pio_pwm_input_max_frequency;
+    statistic->mean_duty_cycle = welford_get_mean_value(&pio_pwm_input_duty_cycle_statistic);
+    statistic->std_duty_cycle = welford_get_std_deviation(&pio_pwm_input_duty_cycle_statistic);
+
+    return number_of_new_periods;
+
+}//end pio_pwm_input_get_statistic
+
+void pio_pwm_input_reset_statistic(void) {
+
+    welford_reset(&pio_pwm_input_frequency_statistic);
+    welford_reset(&pio_pwm_input_duty_cycle_statistic);
+    pio_pwm_input_min_frequency = 0;
+    pio_pwm_input_max_frequency = 0;
+    pio_pwm_input_lost_periods = 0;
+
+}//end pio_pwm_input_reset_statistic
+
 //Square-wave:
 //TODO: Maybe check for max frequency
 int configure_pio_square_wave_output(PIO pio, uint sm, float frequency, uint square_wave_gpio_pin) {
@@ -278,6 +477,14 @@ int deconfigure_pio_sm(PIO pio, uint sm) {
     //Deinit pin
     gpio_deinit(configuration_array[pio_index][sm].gpio_pin);
 
+    //PWM input: stop the DMA and remove the program from the instruction memory
+    if(configuration_array[pio_index][sm].type == PWM_INPUT) {
+        dma_channel_abort(pio_pwm_input_dma_channel);
+        dma_channel_unclaim(pio_pwm_input_dma_channel);
+        pio_remove_program(pio, &pwm_in_program, pio_pwm_input_program_offset);
+        pio_pwm_input_is_configured = false;
+    }
+
     //Unclaim hardware
     pio_sm_unclaim(pio, sm);
 
@@ -5,10 +5,20 @@
     Custom pwm-wrapper around the Raspberry-Pi-Pico-SDK (hardware/pwm.h). 
     Let user configure pwm output channels with given frequency and duty cycle.
     Let user configure pwm output channel for a PWM-DAC. User could set how many bits the DAC resolution is, if the DAC should ramp up and down or only up.
+    A step callback could be called from the pwm wrap interrupt a fixed number of pwm cycles after every DAC step (e.g. to trigger a ADC capture).
+    The divider (8.4 bit) and the wrap are selected by an integer solver (pwm_solve_divider, see pwm_divider.h), it searches all dividers
+    for the smallest frequency error and the biggest wrap, so the configured frequency is as exact as the system clock allows.
+    Let user configure a sigma-delta PWM-DAC: the level has extra_bits more resolution than the pwm wrap, a DMA channel (paced by the pwm wrap)
+    writes a pattern of compare values (first order sigma-delta of the level) every pwm period, the CPU only computes the pattern if the level changes.
+    Let user combine pwm outputs of several slices to a group: the slices are started and stopped together (one write of the enable register),
+    the counters could be preset for a phase offset, and new levels and wraps of all slices are written by DMA right after a wrap of the
+    first slice of the group, so all slices latch them at their next wrap (the same pwm period).
+    Let user measure frequency or duty-cycle of a PWM input on a B-pin (odd gpio) with the gated counter modes of the slice:
+    a DMA channel paced by a DMA timer logs the counter of the slice every gate interval, without CPU. The statistic of the
+    intervals is updated from the log when it is read (pwm_input_get_statistic). For a higher resolution see the PIO pwm input (pio.h).
     NOTE: This module is not multi-core-save
 
     FUTURE_FEATURE: Make this module multi-core-save
-    FUTURE_FEATURE: PWM input - lets user measure frequency/duty-cycle of PWM input
     FUTURE_FEATURE: Let user control DAC hold time (at the moment this is fixed)
 */
 
@@ -24,10 +34,40 @@
 //Pico Hardware-Libraries:
 
 //Own Libraries:
+#include "pwm_divider.h"
 
 //Preprocessor constants:
 
+//Maximum of additional bits of the sigma-delta PWM-DAC (pattern of 2^extra_bits pwm periods)
+#define PWM_SIGMA_DELTA_MAX_EXTRA_BITS 8
+
 //Type definitions:
+
+typedef enum PWM_Input_Mode_e {
+
+    //Counts the rising edges of the B-pin
+    PWM_INPUT_FREQUENCY = 0,
+    //Counts the system clock cycles while the B-pin is high
+    PWM_INPUT_DUTY_CYCLE,
+
+}PWM_Input_Mode_t;
+
+typedef struct PWM_Input_Statistic_s {
+
+    //Number of gate intervals in the statistic and intervals lost because the log was not read in time
+    uint32_t number_of_intervals;
+    uint32_t number_of_lost_intervals;
+    //Frequency in Hz or duty-cycle (0 ... 1) of the gate intervals
+    float mean_value;
+    float std_deviation;
+    float min_value;
+    float max_value;
+
+}PWM_Input_Statistic_t;
+
+//Called from the pwm wrap interrupt settle_cycles pwm cycles after the DAC changed to step dac_step
+typedef void (*pwm_dac_step_callback_t)(uint16_t dac_step);
+
 typedef struct PWM_Instance_s {
 
     bool pwm_is_configured;
@@ -47,13 +87,15 @@ typedef struct PWM_Instance_s {
  * @brief Configures PWM output.
  *
  * This function configures the specified GPIO pin as a PWM output with the given parameters.
+ * Divider and wrap are selected by pwm_solve_divider (smallest frequency error), pwm_clk_frequency/pwm_frequency is the minimum resolution.
  *
  * @param pwm_gpio_pin The GPIO pin to configure as PWM output.
  * @param pwm_clk_frequency The desired PWM clock frequency.
  * @param pwm_frequency The desired PWM frequency.
  * @param duty_cycle The desired duty cycle of the PWM signal.
  *
- * @return Returns the configured PWM frequency on successful configuration, -1 if the PWM channel is already in use.
+ * @return Returns the achieved PWM frequency on successful configuration, -1 if the PWM channel is already in use (or its slice is used by
+ * the sigma-delta DAC or the pwm group), -2 if the frequency could not be reached with the resolution.
  */
 float configure_pwm_output(uint pwm_gpio_pin, float pwm_clk_frequency, float pwm_frequency, float duty_cycle);
 
@@ -76,6 +118,180 @@ float configure_pwm_output(uint pwm_gpio_pin, float pwm_clk_frequency, float pwm
 */
 int configure_pwm_DAC(uint dac_gpio_pin, float pwm_clk_frequency, float pwm_frequency, uint8_t dac_resolution, bool ramp_up_down);
 
+/**
+ * @brief Sets a callback that is called after every DAC step when the output settled.
+ *
+ * The new DAC level is active with the pwm cycle after the step (the compare value is latched at the wrap), the callback is called
+ * from the pwm wrap interrupt after settle_cycles full pwm cycles with the new level. So the callback has a fixed position to every step,
+ * timed by the pwm counter and not by the CPU.
+ *
+ * @param settle_cycles Number of pwm cycles between the step and the callback (settle time of the LPF), has to be shorter than the hold time.
+ * @param step_callback Function to call (NULL disables the callback).
+ *
+ * @return Returns 1 on success, -1 if the DAC is not configured and -2 if settle_cycles is not shorter than the hold time.
+ */
+int pwm_dac_set_step_callback(uint32_t settle_cycles, pwm_dac_step_callback_t step_callback);
+
+/**
+ * @brief Returns the hold time of every DAC step in pwm cycles (0 if the DAC is not configured).
+ */
+uint32_t pwm_dac_get_hold_cycles(void);
+
+/**
+ * @brief Configures a PWM output as sigma-delta DAC with a higher resolution than the pwm wrap.
+ *
+ * The level is split into a compare value (level >> extra_bits) and a fraction of extra_bits, the fraction is spread by a first order
+ * sigma-delta over a pattern of 2^extra_bits pwm periods (compare value or compare value + 1). A data DMA channel (paced by the wrap of
+ * the slice) writes one compare value of the pattern every pwm period, a control DMA channel restarts the data channel at the end of every
+ * pattern. So the output needs no CPU, and a new level is applied at the end of a pattern (never a mixed pattern).
+ * The resolution is log2(wrap + 1) + extra_bits bits (e.g. 125MHz/100kHz and 6 extra bits: 16.3 bits), the lowest ripple frequency of the
+ * pattern is pwm_frequency/2^extra_bits, so the LPF needs a lower cut-off frequency than with the plain PWM-DAC.
+ *
+ * @param dac_gpio_pin The GPIO pin to configure as DAC output.
+ * @param pwm_clk_frequency The desired PWM clock frequency.
+ * @param pwm_frequency The desired PWM frequency.
+ * @param extra_bits Number of additional bits (1 ... PWM_SIGMA_DELTA_MAX_EXTRA_BITS).
+ * @param dma_data_channel The DMA channel that writes the compare values.
+ * @param dma_control_channel The DMA channel that restarts the data channel at the end of every pattern.
+ *
+ * @return Returns the maximum level ((wrap + 1) << extra_bits, 100% duty-cycle) on success, -1 if the PWM channel or the other channel
+ * of its slice is already in use, -2 if another DAC instance is already configured, -3 for a wrong number of extra bits and -4 if a DMA
+ * channel is already claimed.
+ */
+/*NOTE:
+    The compare register holds the level of both channels of the slice and the DMA writes the whole register every pwm period.
+    So the other channel of the slice has to stay unused while the sigma-delta DAC is configured (configure_pwm_output rejects it).
+*/
+int32_t configure_pwm_sigma_delta_DAC(uint dac_gpio_pin, float pwm_clk_frequency, float pwm_frequency, uint8_t extra_bits,
+    uint dma_data_channel, uint dma_control_channel);
+
+/**
+ * @brief Sets the level of the sigma-delta PWM-DAC.
+ *
+ * The pattern is computed into the inactive pattern buffer and applied at the end of the running pattern. If the inactive buffer is still
+ * read by the DMA (two levels within one pattern), the function waits for the end of the running pattern.
+ *
+ * @param level The new level from 0 (0%) to the maximum level returned by configure_pwm_sigma_delta_DAC (100%).
+ *
+ * @return Returns 1 on success, -1 if the sigma-delta DAC is not configured and -2 if the level is bigger than the maximum level.
+ */
+int pwm_sigma_delta_DAC_set_level(uint32_t level);
+
+/**
+ * @brief Combines configured PWM outputs to a group, for a synchronous start/stop and synchronous updates of levels and wraps.
+ *
+ * The slices of the pins are the slices of the group, the slice of the first pin is the reference slice: its wrap paces the updates.
+ * An update uses three DMA channels: the trigger channel waits for the wrap of the reference slice and starts the data channel with the
+ * first slice, the data channel writes compare and wrap (two adjacent registers) of one slice and chains to the control channel, the
+ * control channel starts the data channel with the next slice (a NULL address ends the update).
+ * Only one group could be configured, DAC outputs and inputs could not be part of it.
+ *
+ * @param gpio_pins The GPIO pins of the group (configured with configure_pwm_output).
+ * @param num_of_pins Number of pins (1 ... 16).
+ * @param dma_trigger_channel The DMA channel paced by the wrap of the reference slice.
+ * @param dma_control_channel The DMA channel that starts the data channel for every slice.
+ * @param dma_data_channel The DMA channel that writes compare and wrap.
+ *
+ * @return Returns the number of slices of the group on success, -1 if a pin is no configured PWM output (or a DAC output),
+ * -2 if a group is already configured, -3 if a DMA channel is already claimed and -4 if the other channel of a slice is configured
+ * but not in the group.
+ */
+/*NOTE:
+    The compare register holds the level of both channels of the slice and pwm_group_apply writes the whole register.
+    So both configured channels of a group slice have to be in the group, and the other channel of a group slice could not be
+    configured while the group is configured (configure_pwm_output rejects it).
+*/
+int pwm_group_configure(const uint *gpio_pins, uint8_t num_of_pins, uint dma_trigger_channel, uint dma_control_channel, uint dma_data_channel);
+
+/**
+ * @brief Starts or stops all slices of the group with one write of the enable register (slices outside of the group keep their state).
+ *
+ * @param new_pwm_state The new state of the slices (true for start, false for stop).
+ *
+ * @return Returns 1 on success, -1 if no group is configured.
+ */
+int pwm_group_start_stop(bool new_pwm_state);
+
+/**
+ * @brief Presets the counter of the slice of a pin in the group, the slice leads the slices with counter 0 by phase counts after the start.
+ *
+ * @param gpio_pin A GPIO pin of the group.
+ * @param phase Counter value (0 ... wrap of the slice).
+ *
+ * @return Returns 1 on success, -1 if the pin is not in the group, -2 if the slice is running and -3 if the phase is bigger than the staged wrap.
+ */
+int pwm_group_set_phase(uint gpio_pin, uint16_t phase);
+
+/**
+ * @brief Stages a new level of a pin in the group, it is written with the next pwm_group_apply.
+ *
+ * @return Returns 1 on success, -1 if the pin is not in the group.
+ */
+int pwm_group_set_level(uint gpio_pin, uint16_t pwm_lvl);
+
+/**
+ * @brief Stages a new wrap of the slice of a pin in the group, it is written with the next pwm_group_apply.
+ *
+ * @return Returns 1 on success, -1 if the pin is not in the group.
+ */
+int pwm_group_set_wrap(uint gpio_pin, uint16_t pwm_wrap);
+
+/**
+ * @brief Writes the staged levels and wraps of all slices of the group by DMA after the next wrap of the reference slice.
+ *
+ * The compare and wrap registers are double buffered, every slice latches the new values at its next wrap. So all slices with the
+ * same period change in the same pwm period, without CPU timing. The staged values could be changed while the update is pending.
+ *
+ * @return Returns 1 on success, -1 if no group is configured and -2 if the last update is still pending.
+ */
+int pwm_group_apply(void);
+
+/**
+ * @brief Returns true while an update of the group is waiting for the wrap or being written.
+ */
+bool pwm_group_update_is_pending(void);
+
+/**
+ * @brief Releases the group and its DMA channels, the slices keep their state.
+ *
+ * @return Returns 1 on success, -1 if no group is configured.
+ */
+int pwm_group_deconfigure(void);
+
+/**
+ * @brief Configures a PWM input (frequency or duty-cycle measurement) on a B-pin.
+ *
+ * The slice counts in the gated mode (rising edges or system clock cycles while high), a DMA channel paced by a DMA timer
+ * copies the counter into a log every gate interval. The number of counts p. interval gives the frequency (counts*gate_frequency)
+ * or the duty-cycle (counts/system clock cycles p. interval). The mean value over many intervals is exact, a single interval
+ * has a resolution of one count. The input starts immediately, only one PWM input could be configured.
+ *
+ * @param pwm_gpio_pin The GPIO pin of the input, has to be a B-pin of a slice (odd gpio).
+ * @param mode Frequency or duty-cycle measurement.
+ * @param gate_frequency Rate of the gate intervals, from the system clock/65535 up to the system clock/2.
+ * @param dma_channel The DMA channel that logs the counter.
+ *
+ * @return Returns the actual gate frequency on success, -1 if the pin is no B-pin or the slice is already in use,
+ * -2 for a wrong gate frequency, -3 if the DMA channel or all DMA timers are already claimed and -4 if a PWM input is already configured.
+ */
+float configure_pwm_input(uint pwm_gpio_pin, PWM_Input_Mode_t mode, float gate_frequency, uint dma_channel);
+
+/**
+ * @brief Adds the logged gate intervals since the last call to the statistic of the PWM input and returns it.
+ *
+ * Has to be called at least every 256 gate intervals, otherwise the oldest intervals are lost (counted in number_of_lost_intervals).
+ *
+ * @param statistic Output of the statistic since the configuration (or the last reset).
+ *
+ * @return Returns the number of new intervals, -1 if no PWM input is configured.
+ */
+int pwm_input_get_statistic(PWM_Input_Statistic_t *statistic);
+
+/**
+ * @brief Resets the statistic of the PWM input, the next statistic starts with the next logged interval.
+ */
+void pwm_input_reset_statistic(void);
+
 /**
  * @brief Starts or stops PWM output on the specified GPIO pin.
  *
@@ -89,10 +305,11 @@ int configure_pwm_DAC(uint dac_gpio_pin, float pwm_clk_frequency, float pwm_freq
 int start_stop_pwm(uint gpio_pin, bool new_pwm_state);
 
 /**
- * @brief De-configures PWM output on the specified GPIO pin.
+ * @brief De-configures PWM output (or input) on the specified GPIO pin.
  *
  * This function de-configures PWM output on the specified GPIO pin by de-initializing the pin and clearing
- * the PWM configuration settings associated with it.
+ * the PWM configuration settings associated with it. A PWM input also releases its DMA channel and DMA timer,
+ * a sigma-delta PWM-DAC its DMA channels. If the pin is part of the PWM group, the group is released too (pwm_group_deconfigure).
  *
  * @param pwm_gpio_pin The GPIO pin associated with the PWM output to de-configure.
  *
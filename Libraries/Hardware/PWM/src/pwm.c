@@ -5,10 +5,17 @@
     Custom pwm-wrapper around the Raspberry-Pi-Pico-SDK (hardware/pwm.h). 
     Let user configure pwm output channels with given frequency and duty cycle.
     Let user configure pwm output channel for a PWM-DAC. User could set how many bits the DAC resolution is, if the DAC should ramp up and down or only up.
+    A step callback could be called from the pwm wrap interrupt a fixed number of pwm cycles after every DAC step (e.g. to trigger a ADC capture).
+    Let user configure a sigma-delta PWM-DAC, the compare values of a pattern are written by DMA paced by the wrap DREQ of the slice, two
+    pattern buffers are used, so the CPU only writes the new pattern into the unused buffer and switches the address the control channel reloads.
+    Let user combine pwm outputs to a group, started and stopped with one write of the enable register. The update of a group is a DMA
+    scatter list: the trigger channel (paced by the wrap of the reference slice) starts the data channel, which chains to the control channel,
+    which starts the data channel with the address of the next slice, till a NULL address.
+    Let user measure frequency or duty-cycle of a PWM input on a B-pin with the gated counter modes, the counter is logged by DMA (paced by a DMA timer)
+    into a ring, the difference of two logged counter values (modulo 2^16) is the number of counts of one gate interval.
     NOTE: This module is not multi-core-save
 
     FUTURE_FEATURE: Make this module multi-core-save
-    FUTURE_FEATURE: PWM input - lets user measure frequency/duty-cycle of PWM input
     FUTURE_FEATURE: Let user control DAC hold time (at the moment this is fixed)
 */
 
@@ -27,12 +34,24 @@
 //Pico Hardware-Libraries:
 #include "hardware/pwm.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
 
 //Own Libraries:
+#include "statistic.h"
 
 //Preprocessor constants:
 #define MAX_PWM_CHANNELS 16
 
+//Pattern of the sigma-delta DAC (2^PWM_SIGMA_DELTA_MAX_EXTRA_BITS compare values, 32 bit)
+#define PWM_SIGMA_DELTA_PATTERN_SIZE (1 << PWM_SIGMA_DELTA_MAX_EXTRA_BITS)
+
+//Slices of the RP2040
+#define PWM_GROUP_MAX_SLICES 8
+
+//Logged counter values of the PWM input (power of two, the DMA write ring is aligned to the size of the log)
+#define PWM_INPUT_LOG_SIZE 256
+#define PWM_INPUT_LOG_RING_BITS 10
+
 //File global (static) variables:
 
 //Array with pwm_instances (pwm-channels)
@@ -59,6 +78,60 @@ static uint32_t dac_cycle_counter = 1; //Counts how many pwm-cycles the duty-cyc
 static const float dac_hold_time = 10e-3; //Hold the signal for 10ms
 static uint32_t dac_hold_time_in_cycles = 0; //This value will be calculated in number in cycle for a time span of 10ms
 
+//Step callback:
+static pwm_dac_step_callback_t dac_step_callback = NULL;
+static uint32_t dac_step_settle_cycles = 0;
+
+//Sigma-Delta-DAC-Instance:
+static bool sd_dac_is_configured = false;
+static uint8_t sd_dac_extra_bits = 0;
+static uint32_t sd_dac_max_level = 0;
+static uint sd_dac_data_channel = 0;
+static uint sd_dac_control_channel = 0;
+
+//Two pattern buffers, the control channel switches between them at the end of a pattern
+static uint32_t sd_dac_pattern[2][PWM_SIGMA_DELTA_PATTERN_SIZE];
+//Start address of the pattern the control channel writes into the data channel at the end of every pattern
+static uint32_t *volatile sd_dac_pattern_address = sd_dac_pattern[0];
+
+//PWM-Group-Instance:
+static bool pwm_group_is_configured = false;
+static uint32_t pwm_group_slice_mask = 0;
+static uint8_t pwm_group_number_of_slices = 0;
+static uint8_t pwm_group_slices[PWM_GROUP_MAX_SLICES];
+static uint pwm_group_trigger_channel = 0;
+static uint pwm_group_control_channel = 0;
+static uint pwm_group_data_channel = 0;
+
+//Staged compare and wrap of every slice of the group, and the values the DMA writes (compare, wrap for every slice)
+static uint32_t pwm_group_staged_values[PWM_GROUP_MAX_SLICES][2];
+static uint32_t pwm_group_dma_values[PWM_GROUP_MAX_SLICES][2];
+//Scatter list of the DMA: address of the compare register of every slice, terminated by NULL
+static volatile uint32_t *pwm_group_dma_addresses[PWM_GROUP_MAX_SLICES + 1];
+
+//PWM-Input-Instance:
+static bool pwm_input_is_configured = false;
+static uint8_t pwm_input_instance_index = 0;
+static PWM_Input_Mode_t pwm_input_mode = PWM_INPUT_FREQUENCY;
+static uint pwm_input_dma_channel = 0;
+static uint pwm_input_dma_timer = 0;
+//System clock cycles p. gate interval and gate frequency
+static uint16_t pwm_input_gate_cycles = 0;
+static float pwm_input_gate_frequency = 0;
+
+//Log of the counter, written by DMA
+static uint32_t pwm_input_log[PWM_INPUT_LOG_SIZE] __attribute__((aligned(4*PWM_INPUT_LOG_SIZE)));
+//Number of logged counter values that are added to the statistic, and the last of them (if it is valid as reference)
+static uint32_t pwm_input_processed_values = 0;
+static uint16_t pwm_input_last_count = 0;
+static bool pwm_input_has_reference = false;
+
+//Statistic of the gate intervals
+static Welford_Statistic_t pwm_input_statistic;
+static float pwm_input_min_value = 0;
+static float pwm_input_max_value = 0;
+static uint32_t pwm_input_lost_intervals = 0;
+
 //Function definition:
 
 //File global (static) function definition:
@@ -81,6 +154,20 @@ static bool is_slice_channel_used(uint gpio_pin) {
 
 }//end is_slice_channel_used
 
+//The sigma-delta DAC writes the compare register of the whole slice, the other channel of its slice could not be used
+static bool is_slice_used_by_sigma_delta_DAC(uint gpio_pin) {
+
+    return sd_dac_is_configured && pwm_instances[dac_pwm_instance_index].pwm_slice == pwm_gpio_to_slice_num(gpio_pin);
+
+}//end is_slice_used_by_sigma_delta_DAC
+
+//The group writes the compare register of its whole slices, the other channel of a group slice could not be configured later
+static bool is_slice_used_by_pwm_group(uint gpio_pin) {
+
+    return pwm_group_is_configured && (pwm_group_slice_mask & (1u << pwm_gpio_to_slice_num(gpio_pin)));
+
+}//end is_slice_used_by_pwm_group
+
 static bool dac_already_used(void) {
     for(uint8_t k = 0; k < MAX_PWM_CHANNELS; k++) {
         if(pwm_instances[k].is_dac_output) {
@@ -91,6 +178,75 @@ static bool dac_already_used(void) {
     return false;
 }
 
+//Number of counter values the DMA has logged since the start of the PWM input
+static uint32_t pwm_input_get_logged_values(void) {
+
+    return 0xFFFFFFFF - dma_hw->ch[pwm_input_dma_channel].transfer_count;
+
+}//end pwm_input_get_logged_values
+
+static void pwm_input_stop(void) {
+
+    dma_channel_abort(pwm_input_dma_channel);
+    dma_channel_unclaim(pwm_input_dma_channel);
+    dma_timer_unclaim(pwm_input_dma_timer);
+    pwm_set_enabled(pwm_instances[pwm_input_instance_index].pwm_slice, false);
+    pwm_input_is_configured = false;
+
+}//end pwm_input_stop
+
+//Index of the slice of a pin in the group, -1 if the pin is not part of the group
+static int pwm_group_get_slice_index(uint gpio_pin) {
+
+    uint8_t array_index = get_array_index(gpio_pin);
+    if(!pwm_group_is_configured || !pwm_instances[array_index].pwm_is_configured || pwm_instances[array_index].gpio_pin != gpio_pin) {
+        return -1;
+    }
+    for(uint8_t k = 0; k < pwm_group_number_of_slices; k++) {
+        if(pwm_group_slices[k] == pwm_instances[array_index].pwm_slice) {
+            return k;
+        }
+    }
+
+    return -1;
+
+}//end pwm_group_get_slice_index
+
+static void sd_dac_stop(void) {
+
+    //Abort the control channel twice, the data channel could chain to it while it is aborted
+    dma_channel_abort(sd_dac_control_channel);
+    dma_channel_abort(sd_dac_data_channel);
+    dma_channel_abort(sd_dac_control_channel);
+    dma_channel_unclaim(sd_dac_data_channel);
+    dma_channel_unclaim(sd_dac_control_channel);
+    sd_dac_is_configured = false;
+
+}//end sd_dac_stop
+
+//First order sigma-delta: the fraction of the level is accumulated, every overflow adds one count to the compare value of this period
+static void sd_dac_compute_pattern(uint32_t *pattern, uint32_t level) {
+
+    uint32_t pattern_length = 1u << sd_dac_extra_bits;
+    uint32_t fraction = level & (pattern_length - 1);
+    uint32_t compare_value = level >> sd_dac_extra_bits;
+    uint32_t accumulator = pattern_length/2;
+    //The other channel of the slice is not used (see configure_pwm_sigma_delta_DAC), its half of the compare register stays 0
+    uint8_t shift = (pwm_instances[dac_pwm_instance_index].pwm_channel == PWM_CHAN_B) ? 16 : 0;
+
+    for(uint32_t k = 0; k < pattern_length; k++) {
+        accumulator += fraction;
+        if(accumulator >= pattern_length) {
+            accumulator -= pattern_length;
+            pattern[k] = (compare_value + 1) << shift;
+        }
+        else {
+            pattern[k] = compare_value << shift;
+        }
+    }
+
+}//end sd_dac_compute_pattern
+
 static void pwm_wrap_interrupt_handler(void) {
 
     pwm_clear_irq(pwm_instances[dac_pwm_instance_index].pwm_slice);
@@ -148,7 +304,11 @@ static void pwm_wrap_interrupt_handler(void) {
         }
 
     }
-    
+
+    //The level written at step (counter 1) is latched at the next wrap (counter 2), after settle_cycles cycles with the new level call the callback
+    if(dac_step_callback != NULL && dac_cycle_counter == (dac_step_settle_cycles + 2)) {
+        dac_step_callback(dac_resolution_counter);
+    }
 
 }//end pwm_wrap_interrupt_handler
 
@@ -156,17 +316,31 @@ static void pwm_wrap_interrupt_handler(void) {
 
 float configure_pwm_output(uint pwm_gpio_pin, float pwm_clk_frequency, float pwm_frequency, float duty_cycle) {
 
-    float pwm_clk_div = 0;
     uint8_t pwm_slice = 0;
     uint8_t pwm_channel = 0;
     uint16_t pwm_lvl = 0;
     uint16_t pwm_wrap = 0;
     uint8_t array_index = 0;
+    uint32_t min_wrap = 0;
+    PWM_Divider_t divider;
 
-    if(is_slice_channel_used(pwm_gpio_pin)) {
+    if(is_slice_channel_used(pwm_gpio_pin) || is_slice_used_by_sigma_delta_DAC(pwm_gpio_pin) || is_slice_used_by_pwm_group(pwm_gpio_pin)) {
         return -1; //Error pwm channel is already used
     }
 
+    if((uint32_t)pwm_frequency == 0) {
+        return -2; //Error: frequency could not be reached
+    }
+
+    //Select divider and wrap, the wanted pwm clock gives the minimum resolution
+    min_wrap = (uint32_t)pwm_clk_frequency/(uint32_t)pwm_frequency;
+    if(min_wrap > 0) {
+        min_wrap--;
+    }
+    if(min_wrap > UINT16_MAX || pwm_solve_divider(clock_get_hz(clk_sys), (uint32_t)pwm_frequency, (uint16_t)min_wrap, PWM_DIVIDER_MIN_ERROR, &divider) < 0) {
+        return -2; //Error: frequency could not be reached
+    }
+
     //Init gpio
     gpio_init(pwm_gpio_pin);
     gpio_set_function(pwm_gpio_pin, GPIO_FUNC_PWM);
@@ -176,13 +350,11 @@ float configure_pwm_output(uint pwm_gpio_pin, float pwm_clk_frequency, float pwm
     //Get pwm channel
     pwm_channel = pwm_gpio_to_channel(pwm_gpio_pin);
 
-    //Get prescaler value
-    pwm_clk_div = (float)(clock_get_hz(clk_sys)/pwm_clk_frequency);
     //Set pwm prescaler
-    pwm_set_clkdiv(pwm_slice, pwm_clk_div);
+    pwm_set_clkdiv_int_frac(pwm_slice, divider.div_int, divider.div_frac);
 
     //If the counter reaches pwm_wrap the output toggles  period
-    pwm_wrap = (pwm_clk_frequency/pwm_frequency);
+    pwm_wrap = divider.wrap;
     pwm_set_wrap(pwm_slice, pwm_wrap);
 
     //If the counter reaches pwm_lvl the output switches from high to low - duty-cycle
@@ -201,7 +373,7 @@ float configure_pwm_output(uint pwm_gpio_pin, float pwm_clk_frequency, float pwm
     pwm_instances[array_index].pwm_is_configured = true;
     pwm_instances[array_index].is_dac_output = false;
 
-    return pwm_frequency;
+    return divider.frequency_millihertz/1000.0f;
 
 }//end configure_pwm_output
 
@@ -246,6 +418,501 @@ int configure_pwm_DAC(uint dac_gpio_pin, float pwm_clk_frequency, float pwm_freq
     
 }//end configure_pwm_DAC
 
+int pwm_dac_set_step_callback(uint32_t settle_cycles, pwm_dac_step_callback_t step_callback) {
+
+    if(!dac_already_used()) {
+        return -1; //Error: DAC is not configured
+    }
+    if((settle_cycles + 2) > dac_hold_time_in_cycles) {
+        return -2; //Error: the callback would not be called within the step
+    }
+
+    dac_step_callback = NULL;
+    dac_step_settle_cycles = settle_cycles;
+    dac_step_callback = step_callback;
+
+    return 1;
+
+}//end pwm_dac_set_step_callback
+
+uint32_t pwm_dac_get_hold_cycles(void) {
+
+    return dac_hold_time_in_cycles;
+
+}//end pwm_dac_get_hold_cycles
+
+int32_t configure_pwm_sigma_delta_DAC(uint dac_gpio_pin, float pwm_clk_frequency, float pwm_frequency, uint8_t extra_bits,
+    uint dma_data_channel, uint dma_control_channel) {
+
+    float dac_pwm_frequency = 0;
+    uint8_t pwm_slice = 0;
+    dma_channel_config dma_data_conf;
+    dma_channel_config dma_control_conf;
+
+    if(dac_already_used()) {
+        return -2; //Error: only one DAC instance allowed
+    }
+    //The DMA writes the compare register of both channels of the slice, so the other channel has to be unused
+    if(is_slice_channel_used(dac_gpio_pin) || is_slice_channel_used(dac_gpio_pin ^ 1)) {
+        return -1; //Error: pwm is already configured, or the other channel of the slice is used
+    }
+    if(extra_bits == 0 || extra_bits > PWM_SIGMA_DELTA_MAX_EXTRA_BITS) {
+        return -3; //Error: wrong number of extra bits
+    }
+    if(dma_data_channel == dma_control_channel || dma_channel_is_claimed(dma_data_channel) || dma_channel_is_claimed(dma_control_channel)) {
+        return -4; //Error: DMA channel already claimed
+    }
+
+    //Configure pwm as output
+    dac_pwm_frequency = configure_pwm_output(dac_gpio_pin, pwm_clk_frequency, pwm_frequency, 0);
+    if(dac_pwm_frequency < 0) {
+        return dac_pwm_frequency; //Error in configuration of pwm-instance
+    }
+    dma_channel_claim(dma_data_channel);
+    dma_channel_claim(dma_control_channel);
+
+    dac_pwm_instance_index = get_array_index(dac_gpio_pin);
+    pwm_instances[dac_pwm_instance_index].is_dac_output = true;
+    pwm_slice = pwm_instances[dac_pwm_instance_index].pwm_slice;
+    dac_pwm_wrap = pwm_instances[dac_pwm_instance_index].pwm_wrap;
+    dac_pwm_lvl = 0;
+
+    sd_dac_extra_bits = extra_bits;
+    //The compare value has 16 bit, with the full wrap (0xFFFF) the maximum compare value is the wrap
+    sd_dac_max_level = ((dac_pwm_wrap < UINT16_MAX) ? ((uint32_t)dac_pwm_wrap + 1) : UINT16_MAX) << extra_bits;
+    sd_dac_data_channel = dma_data_channel;
+    sd_dac_control_channel = dma_control_channel;
+    sd_dac_compute_pattern(sd_dac_pattern[0], 0);
+    sd_dac_pattern_address = sd_dac_pattern[0];
+
+    //Data channel: one compare value p. pwm period, chains to the control channel at the end of the pattern
+    dma_data_conf = dma_channel_get_default_config(dma_data_channel);
+    channel_config_set_transfer_data_size(&dma_data_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_data_conf, true);
+    channel_config_set_write_increment(&dma_data_conf, false);
+    channel_config_set_dreq(&dma_data_conf, DREQ_PWM_WRAP0 + pwm_slice);
+    channel_config_set_chain_to(&dma_data_conf, dma_control_channel);
+    dma_channel_configure(dma_data_channel, &dma_data_conf, &pwm_hw->slice[pwm_slice].cc, sd_dac_pattern_address, 1u << extra_bits, false);
+
+    //Control channel: writes the start address of the actual pattern into the data channel and re-triggers it
+    dma_control_conf = dma_channel_get_default_config(dma_control_channel);
+    channel_config_set_transfer_data_size(&dma_control_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_control_conf, false);
+    channel_config_set_write_increment(&dma_control_conf, false);
+    dma_channel_configure(dma_control_channel, &dma_control_conf, &dma_hw->ch[dma_data_channel].al3_read_addr_trig, &sd_dac_pattern_address, 1, false);
+
+    sd_dac_is_configured = true;
+    dma_channel_start(dma_data_channel);
+
+    return (int32_t)sd_dac_max_level;
+
+}//end configure_pwm_sigma_delta_DAC
+
+int pwm_sigma_delta_DAC_set_level(uint32_t level) {
+
+    uint32_t *pattern = NULL;
+    uint32_t pattern_bytes = 4u << sd_dac_extra_bits;
+
+    if(!sd_dac_is_configured) {
+        return -1; //Error: sigma-delta DAC is not configured
+    }
+    if(level > sd_dac_max_level) {
+        return -2; //Error: level out of range
+    }
+
+    pattern = (sd_dac_pattern_address == sd_dac_pattern[0]) ? sd_dac_pattern[1] : sd_dac_pattern[0];
+    //The data channel could still read the unused buffer, if the last level was set within the running pattern
+    while(dma_hw->ch[sd_dac_data_channel].read_addr - (uint32_t)pattern < pattern_bytes && dma_channel_is_busy(sd_dac_data_channel)) {
+        tight_loop_contents();
+    }
+
+    sd_dac_compute_pattern(pattern, level);
+    sd_dac_pattern_address = pattern;
+    dac_pwm_lvl = (uint16_t)(level >> sd_dac_extra_bits);
+
+    return 1;
+
+}//end pwm_sigma_delta_DAC_set_level
+
+int pwm_group_configure(const uint *gpio_pins, uint8_t num_of_pins, uint dma_trigger_channel, uint dma_control_channel, uint dma_data_channel) {
+
+    uint32_t slice_mask = 0;
+    uint8_t number_of_slices = 0;
+    dma_channel_config dma_conf;
+
+    if(pwm_group_is_configured) {
+        return -2; //Error: only one group allowed
+    }
+    if(num_of_pins == 0 || num_of_pins > MAX_PWM_CHANNELS) {
+        return -1; //Error: wrong number of pins
+    }
+
+    for(uint8_t k = 0; k < num_of_pins; k++) {
+        uint8_t array_index = get_array_index(gpio_pins[k]);
+        if(!pwm_instances[array_index].pwm_is_configured || pwm_instances[array_index].gpio_pin != gpio_pins[k] ||
+            !pwm_instances[array_index].pwm_is_output || pwm_instances[array_index].is_dac_output) {
+            return -1; //Error: pin is no configured pwm output
+        }
+        //The DMA writes the compare register of both channels of the slice, a configured other channel has to be in the group too
+        uint8_t partner_index = array_index ^ 1;
+        if(pwm_instances[partner_index].pwm_is_configured) {
+            bool partner_in_group = false;
+            for(uint8_t n = 0; n < num_of_pins; n++) {
+                if(gpio_pins[n] == pwm_instances[partner_index].gpio_pin) {
+                    partner_in_group = true;
+                }
+            }
+            if(!partner_in_group) {
+                return -4; //Error: the other channel of the slice is used outside of the group
+            }
+        }
+        uint slice = pwm_instances[array_index].pwm_slice;
+        if((slice_mask & (1u << slice)) == 0) {
+            slice_mask |= 1u << slice;
+            pwm_group_slices[number_of_slices] = slice;
+            number_of_slices++;
+        }
+    }
+
+    if(dma_trigger_channel == dma_control_channel || dma_trigger_channel == dma_data_channel || dma_control_channel == dma_data_channel ||
+        dma_channel_is_claimed(dma_trigger_channel) || dma_channel_is_claimed(dma_control_channel) || dma_channel_is_claimed(dma_data_channel)) {
+        return -3; //Error: DMA channel already claimed
+    }
+    dma_channel_claim(dma_trigger_channel);
+    dma_channel_claim(dma_control_channel);
+    dma_channel_claim(dma_data_channel);
+
+    //Staged values start with the actual values of the slices, the scatter list with the compare registers
+    for(uint8_t k = 0; k < number_of_slices; k++) {
+        pwm_group_staged_values[k][0] = pwm_hw->slice[pwm_group_slices[k]].cc;
+        pwm_group_staged_values[k][1] = pwm_hw->slice[pwm_group_slices[k]].top;
+        pwm_group_dma_addresses[k] = &pwm_hw->slice[pwm_group_slices[k]].cc;
+    }
+    pwm_group_dma_addresses[number_of_slices] = NULL;
+
+    //Data channel: compare and wrap of one slice (adjacent registers), chains to the control channel
+    dma_conf = dma_channel_get_default_config(dma_data_channel);
+    channel_config_set_transfer_data_size(&dma_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_conf, true);
+    channel_config_set_write_increment(&dma_conf, true);
+    channel_config_set_chain_to(&dma_conf, dma_control_channel);
+    dma_channel_configure(dma_data_channel, &dma_conf, NULL, pwm_group_dma_values, 2, false);
+
+    //Control channel: one address of the scatter list p. trigger, writing the address starts the data channel
+    //(starts behind the NULL address, as after a finished update)
+    dma_conf = dma_channel_get_default_config(dma_control_channel);
+    channel_config_set_transfer_data_size(&dma_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_conf, true);
+    channel_config_set_write_increment(&dma_conf, false);
+    dma_channel_configure(dma_control_channel, &dma_conf, &dma_hw->ch[dma_data_channel].al2_write_addr_trig,
+        &pwm_group_dma_addresses[number_of_slices + 1], 1, false);
+
+    //Trigger channel: waits for the wrap of the reference slice and starts the data channel with the first slice
+    dma_conf = dma_channel_get_default_config(dma_trigger_channel);
+    channel_config_set_transfer_data_size(&dma_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_conf, false);
+    channel_config_set_write_increment(&dma_conf, false);
+    channel_config_set_dreq(&dma_conf, DREQ_PWM_WRAP0 + pwm_group_slices[0]);
+    dma_channel_configure(dma_trigger_channel, &dma_conf, &dma_hw->ch[dma_data_channel].al2_write_addr_trig,
+        &pwm_group_dma_addresses[0], 1, false);
+
+    pwm_group_trigger_channel = dma_trigger_channel;
+    pwm_group_control_channel = dma_control_channel;
+    pwm_group_data_channel = dma_data_channel;
+    pwm_group_slice_mask = slice_mask;
+    pwm_group_number_of_slices = number_of_slices;
+    pwm_group_is_configured = true;
+
+    return number_of_slices;
+
+}//end pwm_group_configure
+
+int pwm_group_start_stop(bool new_pwm_state) {
+
+    if(!pwm_group_is_configured) {
+        return -1; //Error: no group configured
+    }
+
+    //One write of the enable register, all slices of the group start in the same system clock cycle
+    if(new_pwm_state) {
+        pwm_set_mask_enabled(pwm_hw->en | pwm_group_slice_mask);
+    }
+    else {
+        pwm_set_mask_enabled(pwm_hw->en & ~pwm_group_slice_mask);
+    }
+
+    return 1;
+
+}//end pwm_group_start_stop
+
+int pwm_group_set_phase(uint gpio_pin, uint16_t phase) {
+
+    int slice_index = pwm_group_get_slice_index(gpio_pin);
+
+    if(slice_index < 0) {
+        return -1; //Error: pin is not in the group
+    }
+
+    uint slice = pwm_group_slices[slice_index];
+    if(pwm_hw->en & (1u << slice)) {
+        return -2; //Error: slice is running, the phase is only defined for a common start
+    }
+    //The wrap of the next apply is the staged one
+    if(phase > pwm_group_staged_values[slice_index][1]) {
+        return -3; //Error: phase out of range
+    }
+    pwm_set_counter(slice, phase);
+
+    return 1;
+
+}//end pwm_group_set_phase
+
+int pwm_group_set_level(uint gpio_pin, uint16_t pwm_lvl) {
+
+    int slice_index = pwm_group_get_slice_index(gpio_pin);
+
+    if(slice_index < 0) {
+        return -1; //Error: pin is not in the group
+    }
+
+    //Compare register: channel A in the lower, channel B in the upper 16 bit
+    uint8_t shift = (pwm_gpio_to_channel(gpio_pin) == PWM_CHAN_B) ? 16 : 0;
+    pwm_group_staged_values[slice_index][0] = (pwm_group_staged_values[slice_index][0] & ~(0xFFFFu << shift)) | ((uint32_t)pwm_lvl << shift);
+    pwm_instances[get_array_index(gpio_pin)].pwm_lvl = pwm_lvl;
+
+    return 1;
+
+}//end pwm_group_set_level
+
+int pwm_group_set_wrap(uint gpio_pin, uint16_t pwm_wrap) {
+
+    int slice_index = pwm_group_get_slice_index(gpio_pin);
+
+    if(slice_index < 0) {
+        return -1; //Error: pin is not in the group
+    }
+
+    pwm_group_staged_values[slice_index][1] = pwm_wrap;
+    //Both channels of the slice share the wrap
+    for(uint8_t k = 0; k < MAX_PWM_CHANNELS; k++) {
+        if(pwm_instances[k].pwm_is_configured && pwm_instances[k].pwm_slice == pwm_group_slices[slice_index]) {
+            pwm_instances[k].pwm_wrap = pwm_wrap;
+        }
+    }
+
+    return 1;
+
+}//end pwm_group_set_wrap
+
+int pwm_group_apply(void) {
+
+    if(!pwm_group_is_configured) {
+        return -1; //Error: no group configured
+    }
+    if(pwm_group_update_is_pending()) {
+        return -2; //Error: last update is still pending
+    }
+
+    for(uint8_t k = 0; k < pwm_group_number_of_slices; k++) {
+        pwm_group_dma_values[k][0] = pwm_group_staged_values[k][0];
+        pwm_group_dma_values[k][1] = pwm_group_staged_values[k][1];
+    }
+
+    //Rewind the scatter list and the values, then arm the trigger channel
+    dma_channel_set_read_addr(pwm_group_data_channel, pwm_group_dma_values, false);
+    dma_channel_set_read_addr(pwm_group_control_channel, &pwm_group_dma_addresses[1], false);
+    dma_channel_set_trans_count(pwm_group_trigger_channel, 1, true);
+
+    return 1;
+
+}//end pwm_group_apply
+
+bool pwm_group_update_is_pending(void) {
+
+    if(!pwm_group_is_configured) {
+        return false;
+    }
+
+    //The update is finished when the control channel has read the NULL address
+    return dma_channel_is_busy(pwm_group_trigger_channel) || dma_channel_is_busy(pwm_group_data_channel) ||
+        dma_channel_is_busy(pwm_group_control_channel) ||
+        dma_hw->ch[pwm_group_control_channel].read_addr != (uint32_t)&pwm_group_dma_addresses[pwm_group_number_of_slices + 1];
+
+}//end pwm_group_update_is_pending
+
+int pwm_group_deconfigure(void) {
+
+    if(!pwm_group_is_configured) {
+        return -1; //Error: no group configured
+    }
+
+    //Abort the control channel twice, the data channel could chain to it while it is aborted
+    dma_channel_abort(pwm_group_trigger_channel);
+    dma_channel_abort(pwm_group_control_channel);
+    dma_channel_abort(pwm_group_data_channel);
+    dma_channel_abort(pwm_group_control_channel);
+    dma_channel_unclaim(pwm_group_trigger_channel);
+    dma_channel_unclaim(pwm_group_control_channel);
+    dma_channel_unclaim(pwm_group_data_channel);
+    pwm_group_slice_mask = 0;
+    pwm_group_number_of_slices = 0;
+    pwm_group_is_configured = false;
+
+    return 1;
+
+}//end pwm_group_deconfigure
+
+float configure_pwm_input(uint pwm_gpio_pin, PWM_Input_Mode_t mode, float gate_frequency, uint dma_channel) {
+
+    uint8_t pwm_slice = 0;
+    uint8_t array_index = 0;
+    uint32_t system_clock = clock_get_hz(clk_sys);
+    float gate_cycles = 0;
+    int dma_timer = 0;
+    pwm_config input_config;
+    dma_channel_config dma_conf;
+
+    if(pwm_input_is_configured) {
+        return -4; //Error: only one PWM input allowed
+    }
+    if(pwm_gpio_to_channel(pwm_gpio_pin) != PWM_CHAN_B || mode > PWM_INPUT_DUTY_CYCLE) {
+        return -1; //Error: only the B-pin of a slice could be an input
+    }
+    //The A-pin shares the slice, the counter could only be used for one function
+    if(is_slice_channel_used(pwm_gpio_pin) || is_slice_channel_used(pwm_gpio_pin - 1)) {
+        return -1; //Error: pwm slice is already used
+    }
+
+    //Gate interval in system clock cycles (DMA timer fraction 1/gate_cycles), at least 2 cycles for the counter
+    gate_cycles = (float)system_clock/gate_frequency;
+    if(gate_frequency <= 0 || gate_cycles < 2 || gate_cycles > UINT16_MAX) {
+        return -2; //Error: gate frequency out of range
+    }
+
+    if(dma_channel_is_claimed(dma_channel)) {
+        return -3; //Error: DMA channel already claimed
+    }
+    dma_timer = dma_claim_unused_timer(false);
+    if(dma_timer < 0) {
+        return -3; //Error: no free DMA timer
+    }
+    dma_channel_claim(dma_channel);
+
+    //Gated counter: free running over the full 16 bit, the difference of two logged values wraps correctly
+    gpio_init(pwm_gpio_pin);
+    gpio_set_function(pwm_gpio_pin, GPIO_FUNC_PWM);
+    pwm_slice = pwm_gpio_to_slice_num(pwm_gpio_pin);
+    input_config = pwm_get_default_config();
+    pwm_config_set_clkdiv_mode(&input_config, (mode == PWM_INPUT_FREQUENCY) ? PWM_DIV_B_RISING : PWM_DIV_B_HIGH);
+    pwm_config_set_clkdiv_int_frac(&input_config, 1, 0);
+    pwm_config_set_wrap(&input_config, UINT16_MAX);
+    pwm_init(pwm_slice, &input_config, false);
+
+    pwm_input_gate_cycles = (uint16_t)(gate_cycles + 0.5f);
+    pwm_input_gate_frequency = (float)system_clock/pwm_input_gate_cycles;
+    dma_timer_set_fraction((uint)dma_timer, 1, pwm_input_gate_cycles);
+
+    //Log the counter every gate interval into the ring
+    dma_conf = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&dma_conf, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma_conf, false);
+    channel_config_set_write_increment(&dma_conf, true);
+    channel_config_set_ring(&dma_conf, true, PWM_INPUT_LOG_RING_BITS);
+    channel_config_set_dreq(&dma_conf, dma_get_timer_dreq((uint)dma_timer));
+    dma_channel_configure(dma_channel, &dma_conf, pwm_input_log, &pwm_hw->slice[pwm_slice].ctr, 0xFFFFFFFF, false);
+
+    array_index = get_array_index(pwm_gpio_pin);
+    pwm_instances[array_index].gpio_pin = pwm_gpio_pin;
+    pwm_instances[array_index].pwm_channel = PWM_CHAN_B;
+    pwm_instances[array_index].pwm_slice = pwm_slice;
+    pwm_instances[array_index].pwm_wrap = UINT16_MAX;
+    pwm_instances[array_index].pwm_lvl = 0;
+    pwm_instances[array_index].pwm_is_output = false;
+    pwm_instances[array_index].pwm_is_configured = true;
+    pwm_instances[array_index].is_dac_output = false;
+
+    pwm_input_instance_index = array_index;
+    pwm_input_mode = mode;
+    pwm_input_dma_channel = dma_channel;
+    pwm_input_dma_timer = (uint)dma_timer;
+    pwm_input_processed_values = 0;
+    pwm_input_has_reference = false;
+    pwm_input_is_configured = true;
+    pwm_input_reset_statistic();
+
+    pwm_set_counter(pwm_slice, 0);
+    dma_channel_start(dma_channel);
+    pwm_set_enabled(pwm_slice, true);
+
+    return pwm_input_gate_frequency;
+
+}//end configure_pwm_input
+
+int pwm_input_get_statistic(PWM_Input_Statistic_t *statistic) {
+
+    int number_of_new_intervals = 0;
+
+    if(!pwm_input_is_configured) {
+        return -1; //Error: PWM input is not configured
+    }
+
+    uint32_t logged_values = pwm_input_get_logged_values();
+
+    while(pwm_input_processed_values < logged_values) {
+
+        uint16_t count = (uint16_t)pwm_input_log[pwm_input_processed_values%PWM_INPUT_LOG_SIZE];
+
+        //The DMA could have overwritten the value in the ring before (or while) it was read, check it after the read
+        uint32_t current_logged_values = pwm_input_get_logged_values();
+        if(current_logged_values - pwm_input_processed_values >= PWM_INPUT_LOG_SIZE) {
+            //Restart in the middle of the ring (so the restart value is not overwritten before it is read), the value is the new reference
+            uint32_t restart_value = current_logged_values - PWM_INPUT_LOG_SIZE/2;
+            pwm_input_lost_intervals += restart_value - pwm_input_processed_values + (pwm_input_has_reference ? 1 : 0);
+            pwm_input_processed_values = restart_value;
+            pwm_input_has_reference = false;
+            logged_values = current_logged_values;
+            continue;
+        }
+
+        //The first value (and the first after a loss) is the reference of the next interval
+        if(pwm_input_has_reference) {
+            uint16_t counts_in_interval = (uint16_t)(count - pwm_input_last_count);
+            float value = (pwm_input_mode == PWM_INPUT_FREQUENCY) ? counts_in_interval*pwm_input_gate_frequency :
+                (float)counts_in_interval/pwm_input_gate_cycles;
+            if(pwm_input_statistic.count == 0 || value < pwm_input_min_value) {
+                pwm_input_min_value = value;
+            }
+            if(pwm_input_statistic.count == 0 || value > pwm_input_max_value) {
+                pwm_input_max_value = value;
+            }
+            welford_add_value(&pwm_input_statistic, value);
+            number_of_new_intervals++;
+        }
+        pwm_input_last_count = count;
+        pwm_input_has_reference = true;
+        pwm_input_processed_values++;
+    }
+
+    statistic->number_of_intervals = pwm_input_statistic.count;
+    statistic->number_of_lost_intervals = pwm_input_lost_intervals;
+    statistic->mean_value = welford_get_mean_value(&pwm_input_statistic);
+    statistic->std_deviation = welford_get_std_deviation(&pwm_input_statistic);
+    statistic->min_value = pwm_input_min_value;
+    statistic->max_value = pwm_input_max_value;
+
+    return number_of_new_intervals;
+
+}//end pwm_input_get_statistic
+
+void pwm_input_reset_statistic(void) {
+
+    welford_reset(&pwm_input_statistic);
+    pwm_input_min_value = 0;
+    pwm_input_max_value = 0;
+    pwm_input_lost_intervals = 0;
+
+}//end pwm_input_reset_statistic
+
 int start_stop_pwm(uint gpio_pin, bool new_pwm_state) {
 
     uint8_t array_index = 0;
@@ -274,12 +941,24 @@ int deconfigure_pwm(uint pwm_gpio_pin) {
         return -1; //Error pwm channel is not used
     }
 
+    //A group update would write the staged values into the released slice, the group is released with its member
+    if(pwm_group_get_slice_index(pwm_gpio_pin) >= 0) {
+        pwm_group_deconfigure();
+    }
+
     //Deinit pin
     gpio_deinit(pwm_gpio_pin);
 
     array_index = get_array_index(pwm_gpio_pin);
     pwm_instances[array_index].pwm_is_configured = false;
-    pwm_instances[array_index].is_dac_output = false;
+
+    if(pwm_input_is_configured && pwm_input_instance_index == array_index) {
+        pwm_input_stop();
+    }
+
+    if(sd_dac_is_configured && pwm_instances[array_index].is_dac_output) {
+        sd_dac_stop();
+    }
 
     if(pwm_instances[array_index].is_dac_output) {
         dac_pwm_instance_index = 0;
@@ -291,6 +970,8 @@ int deconfigure_pwm(uint pwm_gpio_pin) {
         dac_cycle_counter = 1;
         dac_resolution_counter = 0;
         dac_hold_time_in_cycles = 0;
+        dac_step_callback = NULL;
+        dac_step_settle_cycles = 0;
         dac_pwm_wrap = 0;
         dac_pwm_lvl = 0;
     }
@@ -20,6 +20,7 @@
 //Libraries:
 
 //Standard-C:
+#include <string.h>
 
 //Pico:
 
@@ -48,6 +49,8 @@ typedef struct Uart_Config_s {
     volatile bool uart_rx_complete_flag;
     uint8_t uart_rx_data[MAX_UART_DATA_SIZE];
     uint8_t uart_terminator;
+    uart_tx_callback_t uart_tx_callback;
+    uart_rx_callback_t uart_rx_callback;
 
 }Uart_Config_t;
 
@@ -57,15 +60,48 @@ typedef struct Uart_Config_s {
 
 static Uart_Config_t uart_config_array[2];
 static volatile size_t uart_rx_length[2] = {0,0};
+//Received bytes and received bytes with framing, parity, break or overrun error (for the link error rate)
+static volatile uint32_t uart_rx_byte_count[2] = {0,0};
+static volatile uint32_t uart_rx_error_count[2] = {0,0};
 
 //Functions:
 
 //File global (static) function definitions
 
+//Reads one byte from the data register and counts the receive errors flagged with it
+static inline uint8_t uart_read_rx_byte(uint8_t config_index) {
+
+    uint32_t data_register = uart_get_hw(uart_config_array[config_index].uart_instance)->dr;
+
+    uart_rx_byte_count[config_index]++;
+    if(data_register & (UART_UARTDR_OE_BITS | UART_UARTDR_BE_BITS | UART_UARTDR_PE_BITS | UART_UARTDR_FE_BITS)) {
+        uart_rx_error_count[config_index]++;
+    }
+
+    return (uint8_t)(data_register & UART_UARTDR_DATA_BITS);
+
+}//end uart_read_rx_byte
+
 static void uart0_rx_interrupt_handler(void) { 
 
+    //TX interrupt: clear it and let the registered callback write the next data
+    if(uart_get_hw(uart0)->mis & UART_UARTMIS_TXMIS_BITS) {
+        uart_get_hw(uart0)->icr = UART_UARTICR_TXIC_BITS;
+        if(uart_config_array[0].uart_tx_callback != NULL) {
+            uart_config_array[0].uart_tx_callback();
+        }
+    }
+
+    //RX callback: every byte goes to the callback instead of the line buffer
+    if(uart_config_array[0].uart_rx_callback != NULL) {
+        while(uart_is_readable(uart0)) {
+            uart_config_array[0].uart_rx_callback(uart_read_rx_byte(0));
+        }
+        return;
+    }
+
     while (uart_is_readable(uart0)) {
-        uint8_t data_rx = uart_getc(uart0); //Read the received data
+        uint8_t data_rx = uart_read_rx_byte(0); //Read the received data
         if (data_rx == uart_config_array[0].uart_terminator || uart_rx_length[0] >= MAX_UART_DATA_SIZE - 1) {
             uart_config_array[0].uart_rx_data[uart_rx_length[0]] = '\0'; //Terminate the string
             uart_config_array[0].uart_rx_complete_flag = true; //Indicate that receiving is complete
@@ -78,8 +114,24 @@ static void uart0_rx_interrupt_handler(void) {
 
 static void uart1_rx_interrupt_handler(void) {
 
+    //TX interrupt: clear it and let the registered callback write the next data
+    if(uart_get_hw(uart1)->mis & UART_UARTMIS_TXMIS_BITS) {
+        uart_get_hw(uart1)->icr = UART_UARTICR_TXIC_BITS;
+        if(uart_config_array[1].uart_tx_callback != NULL) {
+            uart_config_array[1].uart_tx_callback();
+        }
+    }
+
+    //RX callback: every byte goes to the callback instead of the line buffer
+    if(uart_config_array[1].uart_rx_callback != NULL) {
+        while(uart_is_readable(uart1)) {
+            uart_config_array[1].uart_rx_callback(uart_read_rx_byte(1));
+        }
+        return;
+    }
+
     while (uart_is_readable(uart1)) {
-        uint8_t data_rx = uart_getc(uart1); //Read the received data
+        uint8_t data_rx = uart_read_rx_byte(1); //Read the received data
         if(data_rx == uart_config_array[1].uart_terminator || uart_rx_length[1] >= MAX_UART_DATA_SIZE - 1) {
             uart_config_array[1].uart_rx_data[uart_rx_length[1]] = '\0'; //Terminate the string
             uart_config_array[1].uart_rx_complete_flag = true; //Indicate that receiving is complete
@@ -242,6 +294,10 @@ int deconfigure_uart_hardware(uart_inst_t *uart_instance) {
         irq_remove_handler(UART1_IRQ, uart1_rx_interrupt_handler);
     }
     
+    //Remove TX and RX callback
+    uart_config_array[config_index].uart_tx_callback = NULL;
+    uart_config_array[config_index].uart_rx_callback = NULL;
+
     //Reset flag
     uart_config_array[config_index].is_uart_configured = false;
        
@@ -249,6 +305,39 @@ int deconfigure_uart_hardware(uart_inst_t *uart_instance) {
 
 }//end deconfigure_uart_hardware
 
+int32_t uart_change_baud_rate(uart_inst_t *uart_instance, uint baud_rate) {
+
+    uint8_t config_index = 0;
+
+    if(uart_instance == uart0) {
+        config_index = 0;
+    }
+    else if(uart_instance == uart1) {
+        config_index = 1;
+    }
+    else {
+        return -1; //Error: Given parameter does not represent real hardware
+    }
+
+    if(!(uart_config_array[config_index].is_uart_configured)) {
+        return -2; //Error: hardware is not configured
+    }
+
+    //Finish the actual transmission with the old baudrate
+    uart_tx_wait_blocking(uart_config_array[config_index].uart_instance);
+
+    uint return_baudrate = uart_set_baudrate(uart_config_array[config_index].uart_instance, baud_rate);
+
+    //Bytes received during the change are invalid: start with an empty line buffer and new error statistic
+    uart_rx_length[config_index] = 0;
+    uart_config_array[config_index].uart_rx_complete_flag = false;
+    uart_rx_byte_count[config_index] = 0;
+    uart_rx_error_count[config_index] = 0;
+
+    return (int32_t)return_baudrate;
+
+}//end uart_change_baud_rate
+
 //UART Interrupt Handling
 int enable_uart_interrupt(uart_inst_t *uart_instance, bool new_uart_rx_interrupt_state) {
 
@@ -276,6 +365,89 @@ int enable_uart_interrupt(uart_inst_t *uart_instance, bool new_uart_rx_interrupt
 
 }//end enable_uart_interrupt
 
+int uart_set_tx_interrupt_callback(uart_inst_t *uart_instance, uart_tx_callback_t tx_callback) {
+
+    uint8_t config_index = 0;
+
+    if(uart_instance == uart0) {
+        config_index = 0;
+    }
+    else if(uart_instance == uart1) {
+        config_index = 1;
+    }
+    else {
+        return -1; //Error: given parameter does not represent real hardware
+    }
+
+    if(!(uart_config_array[config_index].is_uart_configured)) {
+        return -2; //Error hardware is not configured
+    }
+
+    uart_config_array[config_index].uart_tx_callback = tx_callback;
+    //RX interrupt stays enabled, TX interrupt only if there is a callback
+    uart_set_irq_enables(uart_config_array[config_index].uart_instance, true, (tx_callback != NULL));
+    return 1;
+
+}//end uart_set_tx_interrupt_callback
+
+int uart_set_rx_interrupt_callback(uart_inst_t *uart_instance, uart_rx_callback_t rx_callback) {
+
+    uint8_t config_index = 0;
+
+    if(uart_instance == uart0) {
+        config_index = 0;
+    }
+    else if(uart_instance == uart1) {
+        config_index = 1;
+    }
+    else {
+        return -1; //Error: given parameter does not represent real hardware
+    }
+
+    if(!(uart_config_array[config_index].is_uart_configured)) {
+        return -2; //Error hardware is not configured
+    }
+
+    uart_config_array[config_index].uart_rx_callback = rx_callback;
+
+    //Start with an empty line buffer when switching back
+    if(rx_callback == NULL) {
+        uart_rx_length[config_index] = 0;
+        uart_config_array[config_index].uart_rx_complete_flag = false;
+    }
+    return 1;
+
+}//end uart_set_rx_interrupt_callback
+
+int uart_get_rx_error_statistic(uart_inst_t *uart_instance, uint32_t *received_bytes, uint32_t *error_bytes, bool reset) {
+
+    uint8_t config_index = 0;
+
+    if(uart_instance == uart0) {
+        config_index = 0;
+    }
+    else if(uart_instance == uart1) {
+        config_index = 1;
+    }
+    else {
+        return -1; //Error: given parameter does not represent real hardware
+    }
+
+    if(!(uart_config_array[config_index].is_uart_configured)) {
+        return -2; //Error hardware is not configured
+    }
+
+    *received_bytes = uart_rx_byte_count[config_index];
+    *error_bytes = uart_rx_error_count[config_index];
+
+    if(reset) {
+        uart_rx_byte_count[config_index] = 0;
+        uart_rx_error_count[config_index] = 0;
+    }
+    return 1;
+
+}//end uart_get_rx_error_statistic
+
 //UART RX:
 bool uart_get_rx_complete_flag(uart_inst_t *uart_instance) {
 
@@ -350,7 +522,7 @@ int inline uart_tx_data(uart_inst_t *uart_instance, uint8_t *tx_data) {
         uart_putc(uart_config_array[config_index].uart_instance, *tx_data++);
     }
     uart_putc(uart_config_array[config_index].uart_instance, uart_config_array[config_index].uart_terminator);
-
+    return 1;
 
 }//end uart_tx_data
 
@@ -375,9 +547,70 @@ int uart_tx_data_unterminated(uart_inst_t *uart_instance, uint8_t *tx_data) {
     while(*tx_data) {
         uart_putc(uart_config_array[config_index].uart_instance, *tx_data++);
     }
+    return 1;
 
 }//end uart_tx_data_unterminated
 
+int uart_tx_bytes(uart_inst_t *uart_instance, const uint8_t *tx_data, uint32_t num_of_bytes) {
+
+    uint8_t config_index = 0;
+
+    if(uart_instance == uart0) {
+        config_index = 0;
+    }
+    else if(uart_instance == uart1) {
+        config_index = 1;
+    }
+    else {
+        return -1; //Error: Given parameter does not represent real hardware
+    }
+
+    if(!(uart_config_array[config_index].is_uart_configured)) {
+        return -2; //Error: hardware is not configured
+    }
+
+    //Write the whole block at once
+    uart_write_blocking(uart_config_array[config_index].uart_instance, tx_data, num_of_bytes);
+    return 1;
+
+}//end uart_tx_bytes
+
+int uart_tx_iov(uart_inst_t *uart_instance, const Uart_Tx_Segment_t *segments, uint8_t num_of_segments, bool terminate) {
+
+    uint8_t config_index = 0;
+
+    if(uart_instance == uart0) {
+        config_index = 0;
+    }
+    else if(uart_instance == uart1) {
+        config_index = 1;
+    }
+    else {
+        return -1; //Error: Given parameter does not represent real hardware
+    }
+
+    if(!(uart_config_array[config_index].is_uart_configured)) {
+        return -2; //Error: hardware is not configured
+    }
+
+    //Stream every segment directly from its memory into the TX FIFO
+    for(uint8_t n = 0; n < num_of_segments; n++) {
+        if(segments[n].data == NULL) {
+            continue;
+        }
+        uint32_t length = segments[n].length;
+        if(length == UART_TX_SEGMENT_STRING) {
+            length = (uint32_t)strlen((const char*)segments[n].data);
+        }
+        uart_write_blocking(uart_config_array[config_index].uart_instance, segments[n].data, length);
+    }
+    if(terminate) {
+        uart_putc(uart_config_array[config_index].uart_instance, uart_config_array[config_index].uart_terminator);
+    }
+    return 1;
+
+}//end uart_tx_iov
+
 //Clear Buffer
 void clear_uart_buffer(uint8_t *uart_buffer) {
     for(uint16_t k = 0; k < MAX_UART_DATA_SIZE; k++) {
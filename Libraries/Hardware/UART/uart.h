@@ -28,9 +28,26 @@
 
 //Preprocessor constants:
 #define MAX_UART_DATA_SIZE 256
+//Length of a TX segment that is sent till its '\0' (e.g. string literals)
+#define UART_TX_SEGMENT_STRING 0xFFFFFFFF
 
 //Type definitions:
 
+//Callback that is called from the UART interrupt if the transmitter needs new data
+typedef void (*uart_tx_callback_t)(void);
+
+//Callback that is called from the UART interrupt for every received byte (instead of the line buffer)
+typedef void (*uart_rx_callback_t)(uint8_t rx_byte);
+
+//Part of a message for uart_tx_iov(), the parts are sent one after another without copying them into one buffer
+typedef struct Uart_Tx_Segment_s {
+
+    const uint8_t *data;
+    //Number of bytes or UART_TX_SEGMENT_STRING
+    uint32_t length;
+
+}Uart_Tx_Segment_t;
+
 //Function Prototypes:
 
 //UART hardware configuration:
@@ -77,6 +94,21 @@ int32_t reconfigure_uart_hardware(uart_inst_t *uart_instance, uint baud_rate, ui
  */
 int deconfigure_uart_hardware(uart_inst_t *uart_instance);
 
+/**
+ * @brief Changes the baudrate of a configured UART without a new configuration.
+ * 
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1).
+ * @param baud_rate The new baudrate.
+ * 
+ * @return int32_t Returns the real configured baudrate on success; otherwise, returns an error code:
+ *             -1: Given parameter does not represent real hardware.
+ *             -2: Hardware was not configured.
+ * 
+ * @note Waits till the actual transmission is finished. Interrupts and callbacks stay registered,
+ *       the line buffer and the receive error statistic are reset.
+ */
+int32_t uart_change_baud_rate(uart_inst_t *uart_instance, uint baud_rate);
+
 //UART Interrupt Handling
 
 /**
@@ -90,6 +122,53 @@ int deconfigure_uart_hardware(uart_inst_t *uart_instance);
  */
 int enable_uart_interrupt(uart_inst_t *uart_instance, bool new_uart_rx_interrupt_state);
 
+/**
+ * @brief Registers a callback that is called from the UART interrupt when the transmitter is ready for new data.
+ * 
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1).
+ * @param tx_callback Callback to register, NULL disables the UART TX interrupt again.
+ * 
+ * @return int Returns 1 on successful operation; returns a negative error code otherwise:
+ *             -1: Given parameter does not represent real hardware.
+ *             -2: Hardware was not configured.
+ * 
+ * @note The TX interrupt of the UART is triggered when the transmitter becomes empty, not while it is empty.
+ *       So the first byte of a transmission has to be written outside of the callback.
+ *       The callback is reset by deconfigure_uart_hardware().
+ */
+int uart_set_tx_interrupt_callback(uart_inst_t *uart_instance, uart_tx_callback_t tx_callback);
+
+/**
+ * @brief Registers a callback that gets every received byte from the UART interrupt, e.g. for binary protocols.
+ * 
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1).
+ * @param rx_callback Callback to register, NULL switches back to the line buffer (terminator based).
+ * 
+ * @return int Returns 1 on successful operation; returns a negative error code otherwise:
+ *             -1: Given parameter does not represent real hardware.
+ *             -2: Hardware was not configured.
+ * 
+ * @note While a callback is registered uart_get_rx_complete_flag() and uart_get_rx_data() get no data.
+ *       The callback is reset by deconfigure_uart_hardware().
+ */
+int uart_set_rx_interrupt_callback(uart_inst_t *uart_instance, uart_rx_callback_t rx_callback);
+
+
+/**
+ * @brief Gets the number of received bytes and the number of received bytes with an error (framing, parity, break or overrun).
+ * 
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1).
+ * @param received_bytes Pointer where the number of received bytes is stored.
+ * @param error_bytes Pointer where the number of received bytes with an error is stored.
+ * @param reset If true both counters are reset after reading.
+ * 
+ * @return int Returns 1 on successful operation; returns a negative error code otherwise:
+ *             -1: Given parameter does not represent real hardware.
+ *             -2: Hardware was not configured.
+ * 
+ * @note The counters are also reset by uart_change_baud_rate().
+ */
+int uart_get_rx_error_statistic(uart_inst_t *uart_instance, uint32_t *received_bytes, uint32_t *error_bytes, bool reset);
 
 //UART RX:
 
@@ -146,6 +225,37 @@ int uart_tx_data(uart_inst_t *uart_instance, uint8_t *tx_data);
  */
 int uart_tx_data_unterminated(uart_inst_t *uart_instance, uint8_t *tx_data);
 
+/**
+ * @brief Transmits a block of bytes over UART with a single bulk write.
+ * 
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1).
+ * @param tx_data Pointer to the array containing the bytes to be transmitted.
+ * @param num_of_bytes Number of bytes to transmit. Zero bytes are transmitted as well (binary data).
+ * 
+ * @return int Returns 1 upon successful transmission; otherwise, returns an error code:
+ *             -1: Given parameter does not represent real hardware.
+ *             -2: Hardware was not configured.
+ * 
+ * @note Unlike uart_tx_data() no terminator is appended and the data does not need to be a string.
+ */
+int uart_tx_bytes(uart_inst_t *uart_instance, const uint8_t *tx_data, uint32_t num_of_bytes);
+
+/**
+ * @brief Transmits a message made of several segments (scatter-gather) without building it in a buffer before.
+ * 
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1).
+ * @param segments Pointer to the array of segments (data pointer and length) in the order they are sent.
+ * @param num_of_segments Number of segments in the array.
+ * @param terminate If true the terminator of the UART configuration is sent after the last segment (like uart_tx_data()).
+ * 
+ * @return int Returns 1 upon successful transmission; otherwise, returns an error code:
+ *             -1: Given parameter does not represent real hardware.
+ *             -2: Hardware was not configured.
+ * 
+ * @note Segments with the length UART_TX_SEGMENT_STRING are sent till their '\0', segments with a NULL pointer are skipped.
+ */
+int uart_tx_iov(uart_inst_t *uart_instance, const Uart_Tx_Segment_t *segments, uint8_t num_of_segments, bool terminate);
+
 /**
  * @brief Clears the UART buffer by setting all elements to null characters ('\0').
  * 
@@ -153,6 +263,8 @@ int uart_tx_data_unterminated(uart_inst_t *uart_instance, uint8_t *tx_data);
  * 
  * This function clears the UART buffer by setting all elements to null characters ('\0').
  * The size of the buffer is determined by the constant MAX_UART_DATA_SIZE.
+ * 
+ * @note Only needed for RX buffers (uart_get_rx_data() does not terminate the data), strings for TX are terminated by sprintf.
  */
 void clear_uart_buffer(uint8_t *uart_buffer);
 
@@ -0,0 +1,350 @@
+//File: uart_arq.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Selective-repeat ARQ for bulk transfers over a configured UART.
+    Frames inside the window are sent in order, acknowledges are collected by the UART RX interrupt and processed between two frames.
+    Missing frames are sent again after a gap in the selective acknowledge (fast retransmit) or after the retransmit timeout.
+    For the protocol see uart_arq.h and arq_frame.h.
+
+*/
+
+
+//Corresponding header-file:
+#include "uart_arq.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+
+//Pico Hardware-Libraries:
+#include "hardware/watchdog.h"
+
+//Own Libraries:
+#include "uart.h"
+#include "arq_frame.h"
+#include "crc.h"
+#include "data_to_byte.h"
+
+//Preprocessor constants:
+
+//Ring buffer for received bytes, size has to be a power of two
+#define UART_ARQ_RX_BUFFER_SIZE 256
+#define UART_ARQ_RX_BUFFER_MASK (UART_ARQ_RX_BUFFER_SIZE - 1)
+
+//Acknowledge frames are short, longer frames are ignored
+#define UART_ARQ_MAX_ACK_FRAME_SIZE 32
+
+//Maximum number of data frames, the last sequence number is used by the end frame
+#define UART_ARQ_MAX_NUMBER_OF_CHUNKS 0xFFFE
+
+//Typedefs:
+
+typedef struct Uart_Arq_Slot_s {
+
+    uint64_t sent_time_us;
+    uint8_t retransmissions;
+    bool sent;
+    bool fast_retransmitted;
+
+}Uart_Arq_Slot_t;
+
+//File global (static) variables:
+
+static volatile uint8_t arq_rx_buffer[UART_ARQ_RX_BUFFER_SIZE];
+static volatile uint16_t arq_rx_head = 0;
+static volatile uint16_t arq_rx_tail = 0;
+
+//Received acknowledge frame (COBS encoded) till the next zero byte
+static uint8_t arq_ack_frame[UART_ARQ_MAX_ACK_FRAME_SIZE];
+static uint8_t arq_ack_frame_length = 0;
+static bool arq_ack_frame_overflow = false;
+
+static uint8_t arq_encoded_frame[ARQ_FRAME_MAX_ENCODED_SIZE];
+static Uart_Arq_Slot_t arq_slots[UART_ARQ_MAX_WINDOW_SIZE];
+static uint8_t arq_transfer_id = 0;
+
+//Functions:
+
+//File global (static) function definitions:
+
+static void uart_arq_rx_callback(uint8_t rx_byte) {
+
+    uint16_t next_head = (arq_rx_head + 1) & UART_ARQ_RX_BUFFER_MASK;
+
+    //Drop byte if buffer is full, the acknowledge is repeated by the receiver anyway
+    if(next_head != arq_rx_tail) {
+        arq_rx_buffer[arq_rx_head] = rx_byte;
+        arq_rx_head = next_head;
+    }
+
+}//end uart_arq_rx_callback
+
+//Reads received bytes till a valid acknowledge of the actual transfer is complete, returns false if there is none
+static bool uart_arq_get_ack(uint16_t *cumulative_ack, uint32_t *selective_ack, Uart_Arq_Statistic_t *statistic) {
+
+    Arq_Frame_Header_t header;
+    uint8_t payload[4];
+
+    while(arq_rx_tail != arq_rx_head) {
+
+        uint8_t rx_byte = arq_rx_buffer[arq_rx_tail];
+        arq_rx_tail = (arq_rx_tail + 1) & UART_ARQ_RX_BUFFER_MASK;
+
+        if(rx_byte != 0) {
+            if(arq_ack_frame_length < UART_ARQ_MAX_ACK_FRAME_SIZE) {
+                arq_ack_frame[arq_ack_frame_length++] = rx_byte;
+            }
+            else {
+                arq_ack_frame_overflow = true;
+            }
+            continue;
+        }
+
+        //Zero byte: end of frame
+        uint8_t frame_length = arq_ack_frame_length;
+        bool frame_overflow = arq_ack_frame_overflow;
+        arq_ack_frame_length = 0;
+        arq_ack_frame_overflow = false;
+
+        if(frame_length == 0 || frame_overflow) {
+            continue;
+        }
+
+        //Only ack frames have a 4 byte payload
+        if(arq_frame_decode(arq_ack_frame, frame_length, &header, payload) != 4) {
+            statistic->corrupted_frames_received++;
+            continue;
+        }
+
+        if(header.type != ARQ_FRAME_TYPE_ACK || header.transfer_id != arq_transfer_id) {
+            continue;
+        }
+
+        *cumulative_ack = header.sequence_number;
+        *selective_ack = (uint32_t)byte_array_to_uint32_t(payload);
+        statistic->acks_received++;
+        return true;
+    }
+
+    return false;
+
+}//end uart_arq_get_ack
+
+static void uart_arq_send_frame(uart_inst_t *uart_instance, Arq_Frame_Header_t header, const uint8_t *payload, Uart_Arq_Statistic_t *statistic) {
+
+    int frame_length = arq_frame_encode(header, payload, arq_encoded_frame);
+
+    if(frame_length > 0) {
+        uart_tx_bytes(uart_instance, arq_encoded_frame, (uint32_t)frame_length);
+        statistic->frames_sent++;
+    }
+
+}//end uart_arq_send_frame
+
+//Sends data frame or end frame (sequence number = number of chunks) of the given sequence number
+static void uart_arq_send_sequence(uart_inst_t *uart_instance, const uint8_t *data, uint32_t num_of_bytes, uint16_t chunk_size, uint16_t number_of_chunks,
+uint32_t data_crc, uint16_t sequence_number, Uart_Arq_Statistic_t *statistic) {
+
+    Arq_Frame_Header_t header;
+    uint8_t end_payload[4];
+
+    header.transfer_id = arq_transfer_id;
+    header.sequence_number = sequence_number;
+
+    if(sequence_number < number_of_chunks) {
+        uint32_t offset = (uint32_t)sequence_number*chunk_size;
+        header.type = ARQ_FRAME_TYPE_DATA;
+        header.payload_length = ((num_of_bytes - offset) < chunk_size) ? (uint16_t)(num_of_bytes - offset) : chunk_size;
+        uart_arq_send_frame(uart_instance, header, &data[offset], statistic);
+    }
+    else {
+        header.type = ARQ_FRAME_TYPE_END;
+        header.payload_length = 4;
+        uint32_t_to_byte_array(data_crc, end_payload);
+        uart_arq_send_frame(uart_instance, header, end_payload, statistic);
+    }
+
+}//end uart_arq_send_sequence
+
+//Function definition:
+
+int uart_arq_send(uart_inst_t *uart_instance, const uint8_t *data, uint32_t num_of_bytes, Uart_Arq_Config_t config, Uart_Arq_Statistic_t *statistic) {
+
+    Arq_Frame_Header_t header;
+    uint8_t start_payload[8];
+    uint16_t cumulative_ack = 0;
+    uint32_t selective_ack = 0;
+    uint8_t retransmissions = 0;
+    bool acknowledged = false;
+
+    if(config.window_size == 0 || config.window_size > UART_ARQ_MAX_WINDOW_SIZE || config.chunk_size == 0 || config.chunk_size > ARQ_FRAME_MAX_PAYLOAD_SIZE) {
+        return -1; //Error: wrong configuration
+    }
+
+    uint32_t number_of_chunks = (num_of_bytes + config.chunk_size - 1)/config.chunk_size;
+    if(number_of_chunks > UART_ARQ_MAX_NUMBER_OF_CHUNKS) {
+        return -4; //Error: to many frames
+    }
+    //Data frames and the end frame
+    uint32_t number_of_frames = number_of_chunks + 1;
+
+    //Reset statistic and receive buffer
+    statistic->frames_sent = 0;
+    statistic->retransmissions = 0;
+    statistic->acks_received = 0;
+    statistic->corrupted_frames_received = 0;
+    statistic->transfer_time_us = 0;
+    arq_rx_head = 0;
+    arq_rx_tail = 0;
+    arq_ack_frame_length = 0;
+    arq_ack_frame_overflow = false;
+
+    if(uart_set_rx_interrupt_callback(uart_instance, uart_arq_rx_callback) < 0) {
+        return -2; //Error: wrong uart instance or uart not configured
+    }
+
+    uint64_t start_time_us = time_us_64();
+    uint32_t data_crc = get_crc32(data, num_of_bytes);
+
+    //New transfer id, so late acknowledges of an old transfer are ignored
+    arq_transfer_id++;
+
+    //Start frame: stop and wait till the receiver is ready
+    header.type = ARQ_FRAME_TYPE_START;
+    header.transfer_id = arq_transfer_id;
+    header.sequence_number = 0;
+    header.payload_length = 8;
+    uint32_t_to_byte_array(num_of_bytes, &start_payload[0]);
+    uint16_t_to_byte_array(config.chunk_size, &start_payload[4]);
+    uint16_t_to_byte_array((uint16_t)number_of_chunks, &start_payload[6]);
+
+    while(!acknowledged) {
+
+        uart_arq_send_frame(uart_instance, header, start_payload, statistic);
+        uint64_t sent_time_us = time_us_64();
+
+        while((time_us_64() - sent_time_us) < config.retransmit_timeout_us) {
+            if(uart_arq_get_ack(&cumulative_ack, &selective_ack, statistic)) {
+                acknowledged = true;
+                break;
+            }
+            if(config.use_watchdog) {
+                watchdog_update();
+            }
+            tight_loop_contents();
+        }
+
+        if(!acknowledged) {
+            if(retransmissions >= config.max_retransmissions) {
+                uart_set_rx_interrupt_callback(uart_instance, NULL);
+                return -3; //Error: receiver does not answer
+            }
+            retransmissions++;
+            statistic->retransmissions++;
+        }
+    }
+
+    //Sliding window: bit n of acked_bitmap is set if frame window_base + n is acknowledged
+    uint32_t window_base = 0;
+    uint32_t acked_bitmap = 0;
+
+    for(uint8_t k = 0; k < UART_ARQ_MAX_WINDOW_SIZE; k++) {
+        arq_slots[k].sent = false;
+        arq_slots[k].fast_retransmitted = false;
+        arq_slots[k].retransmissions = 0;
+    }
+
+    while(window_base < number_of_frames) {
+
+        //Process all acknowledges received so far
+        while(uart_arq_get_ack(&cumulative_ack, &selective_ack, statistic)) {
+
+            if(cumulative_ack > window_base && cumulative_ack <= number_of_frames) {
+                //Free the slots of the acknowledged frames and move the window
+                for(uint32_t s = window_base; s < cumulative_ack; s++) {
+                    arq_slots[s % UART_ARQ_MAX_WINDOW_SIZE].sent = false;
+                    arq_slots[s % UART_ARQ_MAX_WINDOW_SIZE].fast_retransmitted = false;
+                    arq_slots[s % UART_ARQ_MAX_WINDOW_SIZE].retransmissions = 0;
+                }
+                uint32_t shift = cumulative_ack - window_base;
+                acked_bitmap = (shift >= 32) ? 0 : (acked_bitmap >> shift);
+                window_base = cumulative_ack;
+            }
+
+            //Selective acknowledge: bit n is frame cumulative_ack + 1 + n
+            for(uint8_t n = 0; n < 32; n++) {
+                uint32_t sequence_number = (uint32_t)cumulative_ack + 1 + n;
+                if((selective_ack & (1u << n)) && sequence_number >= window_base && (sequence_number - window_base) < config.window_size) {
+                    acked_bitmap |= (1u << (sequence_number - window_base));
+                }
+            }
+        }
+
+        if(window_base >= number_of_frames) {
+            break;
+        }
+
+        //Highest acknowledged frame inside the window, every missing frame below is lost
+        uint32_t highest_acked = window_base;
+        for(uint8_t n = 0; n < config.window_size; n++) {
+            if(acked_bitmap & (1u << n)) {
+                highest_acked = window_base + n;
+            }
+        }
+
+        uint32_t window_end = window_base + config.window_size;
+        if(window_end > number_of_frames) {
+            window_end = number_of_frames;
+        }
+
+        //Send one frame (the lowest one that is due), then look for acknowledges again
+        uint64_t now_us = time_us_64();
+        for(uint32_t s = window_base; s < window_end; s++) {
+
+            if(acked_bitmap & (1u << (s - window_base))) {
+                continue;
+            }
+
+            Uart_Arq_Slot_t *slot = &arq_slots[s % UART_ARQ_MAX_WINDOW_SIZE];
+
+            if(slot->sent) {
+                if(s < highest_acked && !slot->fast_retransmitted) {
+                    slot->fast_retransmitted = true;
+                }
+                else if((now_us - slot->sent_time_us) < config.retransmit_timeout_us) {
+                    continue;
+                }
+                if(slot->retransmissions >= config.max_retransmissions) {
+                    uart_set_rx_interrupt_callback(uart_instance, NULL);
+                    statistic->transfer_time_us = time_us_64() - start_time_us;
+                    return -3; //Error: frame was not acknowledged
+                }
+                slot->retransmissions++;
+                statistic->retransmissions++;
+            }
+
+            uart_arq_send_sequence(uart_instance, data, num_of_bytes, config.chunk_size, (uint16_t)number_of_chunks, data_crc, (uint16_t)s, statistic);
+            slot->sent = true;
+            slot->sent_time_us = time_us_64();
+            break;
+        }
+
+        if(config.use_watchdog) {
+            watchdog_update();
+        }
+    }
+
+    uart_set_rx_interrupt_callback(uart_instance, NULL);
+    statistic->transfer_time_us = time_us_64() - start_time_us;
+    return 1;
+
+}//end uart_arq_send
+
+//end file uart_arq.c
@@ -0,0 +1,83 @@
+//File: uart_arq.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Selective-repeat ARQ (automatic repeat request) for bulk transfers (e.g. test results stored in flash) over a configured UART (see uart.h).
+    The data is split into frames with sequence numbers (see arq_frame.h for the frame layout). Up to window_size frames are sent
+    without waiting for an acknowledge, so the link stays saturated although the receiver needs time to answer.
+    The receiver answers with a cumulative acknowledge (all frames below are received) and a selective acknowledge bitmap
+    (the frames after it that are received). Only frames that are missing are sent again:
+        -If a later frame is acknowledged but an earlier one not, the earlier frame is sent again once immediately (fast retransmit)
+        -If a frame is not acknowledged within the retransmit timeout it is sent again
+    The transfer starts with a start frame (total size, frame size) and ends with an end frame (CRC-32 over all data).
+    A host side receiver is in Tools/uart_arq_receiver.
+
+    To keep the link saturated the window has to cover the round trip: window_size*chunk_size > baudrate/10*round_trip_time.
+
+    NOTE: This module is not multi core save. The RX line of the UART is used by the ARQ during a transfer (see uart_set_rx_interrupt_callback()).
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+
+//Preprocessor constants:
+#define UART_ARQ_MAX_WINDOW_SIZE 32
+
+//Type definitions:
+
+typedef struct Uart_Arq_Config_s {
+
+    //Number of frames that could be sent without acknowledge (1 to UART_ARQ_MAX_WINDOW_SIZE)
+    uint8_t window_size;
+    //Data bytes p. frame (1 to ARQ_FRAME_MAX_PAYLOAD_SIZE)
+    uint16_t chunk_size;
+    //Time after a not acknowledged frame is sent again
+    uint32_t retransmit_timeout_us;
+    //Number of retransmissions of one frame before the transfer is aborted
+    uint8_t max_retransmissions;
+    bool use_watchdog;
+
+}Uart_Arq_Config_t;
+
+typedef struct Uart_Arq_Statistic_s {
+
+    uint32_t frames_sent;
+    uint32_t retransmissions;
+    uint32_t acks_received;
+    uint32_t corrupted_frames_received;
+    uint64_t transfer_time_us;
+
+}Uart_Arq_Statistic_t;
+
+//Function Prototypes:
+
+/**
+ * @brief Sends a block of data with the selective-repeat ARQ and returns after all frames are acknowledged.
+ *
+ * @param uart_instance Pointer to the configured UART instance (e.g., uart0, uart1).
+ * @param data Pointer to the data (RAM or flash via XIP address).
+ * @param num_of_bytes Number of bytes to send.
+ * @param config Window size, frame size and retransmission settings.
+ * @param statistic Pointer to a statistic structure, filled during the transfer.
+ *
+ * @return int Returns 1 if the receiver acknowledged all frames; otherwise, returns an error code:
+ *             -1: Wrong configuration.
+ *             -2: UART could not be used (wrong instance or not configured).
+ *             -3: Transfer aborted, a frame was not acknowledged after max_retransmissions.
+ *             -4: Data is to long for the given chunk size (more than 65534 frames).
+ */
+int uart_arq_send(uart_inst_t *uart_instance, const uint8_t *data, uint32_t num_of_bytes, Uart_Arq_Config_t config, Uart_Arq_Statistic_t *statistic);
+
+//end file uart_arq.h
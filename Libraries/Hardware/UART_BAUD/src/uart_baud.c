@@ -0,0 +1,489 @@
+//File: uart_baud.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Baudrate negotiation for a UART link (ladder of baudrates, verified with pattern bursts) and monitoring of the receive error rate.
+    For the protocol see uart_baud.h.
+
+*/
+
+
+//Corresponding header-file:
+#include "uart_baud.h"
+
+//Libraries:
+
+//Standard-C:
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+#include "pico/rand.h"
+
+//Pico Hardware-Libraries:
+#include "hardware/watchdog.h"
+
+//Own Libraries:
+#include "uart.h"
+#include "flash.h"
+
+//Preprocessor constants:
+
+//Time for the other end to change the baudrate after the acknowledge
+#define UART_BAUD_SWITCH_DELAY_US 1000
+//Number of requests before the other end counts as not answering
+#define UART_BAUD_REQUEST_RETRIES 3
+//The responder goes back to the actual baudrate if it gets no line for this number of response timeouts during a ladder step test
+#define UART_BAUD_TRIAL_IDLE_FACTOR 4
+
+//File global (static) variables:
+
+static const uint32_t uart_baud_ladder[UART_BAUD_LADDER_SIZE] = {
+    115200, 250000, 460800, 921600, 1000000, 1500000, 2000000, 3000000
+};
+
+//Actual ladder step p. UART instance
+static uint8_t uart_baud_ladder_index[2] = {UART_BAUD_BASE_INDEX, UART_BAUD_BASE_INDEX};
+//Real configured baudrate p. UART instance
+static uint32_t uart_baud_real_baud_rate[2] = {0, 0};
+
+//Functions:
+
+//File global (static) function definitions:
+
+static int8_t uart_baud_get_config_index(uart_inst_t *uart_instance) {
+
+    if(uart_instance == uart0) {
+        return 0;
+    }
+    else if(uart_instance == uart1) {
+        return 1;
+    }
+    return -1;
+
+}//end uart_baud_get_config_index
+
+static int32_t uart_baud_change_ladder_index(uart_inst_t *uart_instance, uint8_t config_index, uint8_t ladder_index) {
+
+    int32_t real_baud_rate = uart_change_baud_rate(uart_instance, uart_baud_ladder[ladder_index]);
+
+    if(real_baud_rate > 0) {
+        uart_baud_ladder_index[config_index] = ladder_index;
+        uart_baud_real_baud_rate[config_index] = (uint32_t)real_baud_rate;
+    }
+    return real_baud_rate;
+
+}//end uart_baud_change_ladder_index
+
+//Waits for a received line, returns false after the timeout
+static bool uart_baud_wait_for_line(uart_inst_t *uart_instance, uint8_t *rx_line, uint32_t timeout_us, bool use_watchdog) {
+
+    uint64_t start_time_us = time_us_64();
+
+    while((time_us_64() - start_time_us) < timeout_us) {
+
+        if(uart_get_rx_complete_flag(uart_instance)) {
+            clear_uart_buffer(rx_line);
+            uart_get_rx_data(uart_instance, rx_line);
+            return true;
+        }
+        if(use_watchdog) {
+            watchdog_update();
+        }
+        tight_loop_contents();
+    }
+
+    return false;
+
+}//end uart_baud_wait_for_line
+
+//Sends the request till the expected answer is received, other lines are ignored
+static bool uart_baud_request(uart_inst_t *uart_instance, char *request, char *answer, Uart_Baud_Config_t config, uint8_t retries) {
+
+    uint8_t rx_line[MAX_UART_DATA_SIZE];
+
+    for(uint8_t r = 0; r < retries; r++) {
+
+        uart_tx_data(uart_instance, (uint8_t*)request);
+
+        uint64_t sent_time_us = time_us_64();
+        uint64_t elapsed_time_us = 0;
+        while(elapsed_time_us < config.response_timeout_us) {
+            if(!uart_baud_wait_for_line(uart_instance, rx_line, config.response_timeout_us - (uint32_t)elapsed_time_us, config.use_watchdog)) {
+                break;
+            }
+            if(strcmp((char*)rx_line, answer) == 0) {
+                return true;
+            }
+            elapsed_time_us = time_us_64() - sent_time_us;
+        }
+    }
+
+    return false;
+
+}//end uart_baud_request
+
+//Tests one ladder step with a pattern burst, returns 1 if tested, 0 if the responder does not accept the step and -3 if the link is lost
+static int uart_baud_test_ladder_step(uart_inst_t *uart_instance, uint8_t config_index, uint8_t ladder_index, Uart_Baud_Config_t config, uint32_t *error_rate_ppm) {
+
+    char request[32];
+    char answer[32];
+    uint8_t tx_line[MAX_UART_DATA_SIZE];
+    uint8_t rx_line[MAX_UART_DATA_SIZE];
+    uint32_t wrong_bytes = 0;
+    uint32_t sent_bytes = 0;
+    uint8_t actual_index = uart_baud_ladder_index[config_index];
+
+    sprintf(request, "BAUD_TRY:%d", (int)ladder_index);
+    sprintf(answer, "BAUD_ACK:%d", (int)ladder_index);
+
+    if(!uart_baud_request(uart_instance, request, answer, config, UART_BAUD_REQUEST_RETRIES)) {
+        return 0;
+    }
+
+    uart_baud_change_ladder_index(uart_instance, config_index, ladder_index);
+    sleep_us(UART_BAUD_SWITCH_DELAY_US);
+
+    //Pattern burst: random printable characters, every line is echoed by the responder
+    for(uint8_t l = 0; l < config.num_of_pattern_lines; l++) {
+
+        for(uint8_t k = 0; k < config.pattern_length; k++) {
+            tx_line[k] = (uint8_t)((rand()%(126 - 33 + 1)) + 33);
+        }
+        tx_line[config.pattern_length] = '\0';
+        uart_tx_data(uart_instance, tx_line);
+        sent_bytes += config.pattern_length;
+
+        if(uart_baud_wait_for_line(uart_instance, rx_line, config.response_timeout_us, config.use_watchdog)) {
+            uint16_t rx_length = (uint16_t)strlen((char*)rx_line);
+            for(uint8_t k = 0; k < config.pattern_length; k++) {
+                if(rx_line[k] != tx_line[k]) {
+                    wrong_bytes++;
+                }
+            }
+            if(rx_length > config.pattern_length) {
+                wrong_bytes += rx_length - config.pattern_length;
+            }
+        }
+        else {
+            wrong_bytes += config.pattern_length;
+        }
+    }
+
+    //End of the test, the responder goes back after this line or after its idle timeout
+    uart_tx_data(uart_instance, "BAUD_END");
+    uart_baud_change_ladder_index(uart_instance, config_index, actual_index);
+
+    if(!uart_baud_request(uart_instance, "BAUD_PING", "BAUD_PONG", config, UART_BAUD_TRIAL_IDLE_FACTOR + 2)) {
+        return -3;
+    }
+
+    *error_rate_ppm = (uint32_t)(((uint64_t)wrong_bytes*1000000)/sent_bytes);
+    return 1;
+
+}//end uart_baud_test_ladder_step
+
+//Sets the ladder step on both ends, returns 1 if set, 2 if the actual step is kept and -3 if the link is lost
+static int uart_baud_set_ladder_step(uart_inst_t *uart_instance, uint8_t config_index, uint8_t ladder_index, Uart_Baud_Config_t config) {
+
+    char request[32];
+    char answer[32];
+    uint8_t actual_index = uart_baud_ladder_index[config_index];
+
+    sprintf(request, "BAUD_SET:%d", (int)ladder_index);
+    sprintf(answer, "BAUD_ACK:%d", (int)ladder_index);
+
+    //The acknowledge could be lost, so the new baudrate is checked in any case
+    uart_baud_request(uart_instance, request, answer, config, UART_BAUD_REQUEST_RETRIES);
+    uart_baud_change_ladder_index(uart_instance, config_index, ladder_index);
+    sleep_us(UART_BAUD_SWITCH_DELAY_US);
+
+    if(uart_baud_request(uart_instance, "BAUD_PING", "BAUD_PONG", config, UART_BAUD_REQUEST_RETRIES)) {
+        return 1;
+    }
+
+    //Responder did not change the baudrate
+    uart_baud_change_ladder_index(uart_instance, config_index, actual_index);
+
+    if(uart_baud_request(uart_instance, "BAUD_PING", "BAUD_PONG", config, UART_BAUD_REQUEST_RETRIES)) {
+        return 2;
+    }
+
+    return -3;
+
+}//end uart_baud_set_ladder_step
+
+static void uart_baud_fill_result(uint8_t config_index, Uart_Baud_Result_t *result) {
+
+    result->ladder_index = uart_baud_ladder_index[config_index];
+    result->baud_rate = uart_baud_real_baud_rate[config_index];
+
+}//end uart_baud_fill_result
+
+//Function definition:
+
+int uart_baud_init(uart_inst_t *uart_instance, uint8_t ladder_index) {
+
+    int8_t config_index = uart_baud_get_config_index(uart_instance);
+
+    if(ladder_index >= UART_BAUD_LADDER_SIZE) {
+        return -1; //Error: wrong ladder index
+    }
+    if(config_index < 0) {
+        return -2; //Error: given parameter does not represent real hardware
+    }
+
+    if(uart_baud_change_ladder_index(uart_instance, (uint8_t)config_index, ladder_index) < 0) {
+        return -2; //Error: hardware is not configured
+    }
+
+    return 1;
+
+}//end uart_baud_init
+
+uint32_t uart_baud_get_ladder_baud_rate(uint8_t ladder_index) {
+
+    if(ladder_index >= UART_BAUD_LADDER_SIZE) {
+        return 0;
+    }
+    return uart_baud_ladder[ladder_index];
+
+}//end uart_baud_get_ladder_baud_rate
+
+uint8_t uart_baud_get_ladder_index(uart_inst_t *uart_instance) {
+
+    int8_t config_index = uart_baud_get_config_index(uart_instance);
+
+    if(config_index < 0) {
+        return UART_BAUD_LADDER_SIZE;
+    }
+    return uart_baud_ladder_index[config_index];
+
+}//end uart_baud_get_ladder_index
+
+uint8_t uart_baud_get_stored_index(void) {
+
+    uint8_t utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX + 2];
+
+    if(flash_read_from_utility_user_space(utility_user_section_byte_stream, UART_BAUD_FLASH_USER_SPACE_INDEX + 2) < 0) {
+        return UART_BAUD_BASE_INDEX;
+    }
+
+    if(utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX + 1] != 1 ||
+    utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX] >= UART_BAUD_LADDER_SIZE) {
+        return UART_BAUD_BASE_INDEX;
+    }
+
+    return utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX];
+
+}//end uart_baud_get_stored_index
+
+int uart_baud_store_index(uint8_t ladder_index) {
+
+    uint8_t utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX + 2];
+
+    //Read the whole used utility user space, so the other settings are kept
+    flash_read_from_utility_user_space(utility_user_section_byte_stream, UART_BAUD_FLASH_USER_SPACE_INDEX + 2);
+
+    utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX] = ladder_index;
+    utility_user_section_byte_stream[UART_BAUD_FLASH_USER_SPACE_INDEX + 1] = 1;
+
+    if(flash_write_to_utility_user_space(utility_user_section_byte_stream, UART_BAUD_FLASH_USER_SPACE_INDEX + 2) < 0) {
+        return -1; //Error: flash could not be written
+    }
+
+    return 1;
+
+}//end uart_baud_store_index
+
+int uart_baud_negotiate(uart_inst_t *uart_instance, Uart_Baud_Config_t config, Uart_Baud_Result_t *result) {
+
+    int8_t config_index = uart_baud_get_config_index(uart_instance);
+    uint32_t received_bytes = 0;
+    uint32_t error_bytes = 0;
+    uint32_t error_rate_ppm = 0;
+
+    if(config.num_of_pattern_lines == 0 || config.pattern_length == 0 || config.pattern_length > (MAX_UART_DATA_SIZE - 2) || config.response_timeout_us == 0) {
+        return -1; //Error: wrong configuration
+    }
+    if(config_index < 0 || uart_get_rx_error_statistic(uart_instance, &received_bytes, &error_bytes, false) < 0) {
+        return -2; //Error: wrong uart instance or uart not configured
+    }
+
+    memset(result, 0, sizeof(Uart_Baud_Result_t));
+    uint8_t best_index = uart_baud_ladder_index[config_index];
+    result->highest_tested_index = best_index;
+
+    if(!uart_baud_request(uart_instance, "BAUD_PING", "BAUD_PONG", config, UART_BAUD_REQUEST_RETRIES)) {
+        return -3; //Error: responder does not answer
+    }
+
+    //Get random seed for the pattern
+    srand((unsigned int)get_rand_32());
+
+    //Step up till the first step that is not reliable
+    for(uint8_t n = best_index + 1; n < UART_BAUD_LADDER_SIZE; n++) {
+
+        int ret = uart_baud_test_ladder_step(uart_instance, (uint8_t)config_index, n, config, &error_rate_ppm);
+        if(ret < 0) {
+            return -3; //Error: responder does not answer anymore
+        }
+        if(ret == 0) {
+            break;
+        }
+
+        result->error_rate_ppm[n] = error_rate_ppm;
+        result->highest_tested_index = n;
+
+        if(error_rate_ppm > config.max_error_rate_ppm) {
+            break;
+        }
+        best_index = n;
+    }
+
+    if(best_index != uart_baud_ladder_index[config_index]) {
+        if(uart_baud_set_ladder_step(uart_instance, (uint8_t)config_index, best_index, config) < 0) {
+            return -3; //Error: responder does not answer anymore
+        }
+    }
+
+    uart_baud_fill_result((uint8_t)config_index, result);
+
+    if(config.persist_to_flash) {
+        uart_baud_store_index(result->ladder_index);
+    }
+
+    return 1;
+
+}//end uart_baud_negotiate
+
+int uart_baud_restore(uart_inst_t *uart_instance, Uart_Baud_Config_t config, Uart_Baud_Result_t *result) {
+
+    int8_t config_index = uart_baud_get_config_index(uart_instance);
+    uint32_t received_bytes = 0;
+    uint32_t error_bytes = 0;
+    int ret = 1;
+
+    if(config.response_timeout_us == 0) {
+        return -1; //Error: wrong configuration
+    }
+    if(config_index < 0 || uart_get_rx_error_statistic(uart_instance, &received_bytes, &error_bytes, false) < 0) {
+        return -2; //Error: wrong uart instance or uart not configured
+    }
+
+    memset(result, 0, sizeof(Uart_Baud_Result_t));
+    uint8_t stored_index = uart_baud_get_stored_index();
+
+    if(stored_index != uart_baud_ladder_index[config_index]) {
+        ret = uart_baud_set_ladder_step(uart_instance, (uint8_t)config_index, stored_index, config);
+        if(ret < 0) {
+            return -3; //Error: responder does not answer
+        }
+    }
+
+    uart_baud_fill_result((uint8_t)config_index, result);
+    result->highest_tested_index = result->ladder_index;
+
+    return ret;
+
+}//end uart_baud_restore
+
+bool uart_baud_handle_command(uart_inst_t *uart_instance, uint8_t *rx_line, Uart_Baud_Config_t config) {
+
+    int8_t config_index = uart_baud_get_config_index(uart_instance);
+    uint8_t tx_line[MAX_UART_DATA_SIZE];
+    uint8_t trial_line[MAX_UART_DATA_SIZE];
+
+    if(config_index < 0 || strncmp((char*)rx_line, "BAUD_", 5) != 0) {
+        return false;
+    }
+
+    //Ladder step behind the colon (if there is one)
+    char *separator = strchr((char*)rx_line, ':');
+    int ladder_index = (separator != NULL) ? atoi(separator + 1) : -1;
+    bool valid_index = (ladder_index >= 0 && ladder_index < UART_BAUD_LADDER_SIZE);
+    uint8_t actual_index = uart_baud_ladder_index[config_index];
+
+    if(strcmp((char*)rx_line, "BAUD_PING") == 0) {
+        uart_tx_data(uart_instance, "BAUD_PONG");
+    }
+    else if(strncmp((char*)rx_line, "BAUD_TRY:", 9) == 0 && valid_index) {
+
+        sprintf((char*)tx_line, "BAUD_ACK:%d", ladder_index);
+        uart_tx_data(uart_instance, tx_line);
+        uart_baud_change_ladder_index(uart_instance, (uint8_t)config_index, (uint8_t)ladder_index);
+
+        //Echo the pattern lines till the end of the test or till the initiator is gone
+        while(uart_baud_wait_for_line(uart_instance, trial_line, UART_BAUD_TRIAL_IDLE_FACTOR*config.response_timeout_us, config.use_watchdog)) {
+            if(strcmp((char*)trial_line, "BAUD_END") == 0) {
+                break;
+            }
+            uart_tx_data(uart_instance, trial_line);
+        }
+
+        uart_baud_change_ladder_index(uart_instance, (uint8_t)config_index, actual_index);
+    }
+    else if(strncmp((char*)rx_line, "BAUD_SET:", 9) == 0 && valid_index) {
+
+        sprintf((char*)tx_line, "BAUD_ACK:%d", ladder_index);
+        uart_tx_data(uart_instance, tx_line);
+        uart_baud_change_ladder_index(uart_instance, (uint8_t)config_index, (uint8_t)ladder_index);
+        if(config.persist_to_flash) {
+            uart_baud_store_index((uint8_t)ladder_index);
+        }
+    }
+    else if(strncmp((char*)rx_line, "BAUD_DOWN:", 10) == 0 && valid_index && ladder_index < actual_index) {
+
+        uart_baud_change_ladder_index(uart_instance, (uint8_t)config_index, (uint8_t)ladder_index);
+        if(config.persist_to_flash) {
+            uart_baud_store_index((uint8_t)ladder_index);
+        }
+    }
+
+    return true;
+
+}//end uart_baud_handle_command
+
+int uart_baud_monitor(uart_inst_t *uart_instance, Uart_Baud_Config_t config) {
+
+    int8_t config_index = uart_baud_get_config_index(uart_instance);
+    uint32_t received_bytes = 0;
+    uint32_t error_bytes = 0;
+    uint8_t tx_line[MAX_UART_DATA_SIZE];
+
+    if(config_index < 0 || uart_get_rx_error_statistic(uart_instance, &received_bytes, &error_bytes, false) < 0) {
+        return -2; //Error: wrong uart instance or uart not configured
+    }
+
+    if(received_bytes < config.monitor_window_bytes || received_bytes == 0) {
+        return 0;
+    }
+
+    uart_get_rx_error_statistic(uart_instance, &received_bytes, &error_bytes, true);
+
+    uint32_t error_rate_ppm = (uint32_t)(((uint64_t)error_bytes*1000000)/received_bytes);
+    uint8_t actual_index = uart_baud_ladder_index[config_index];
+
+    if(error_rate_ppm <= config.max_error_rate_ppm || actual_index == 0) {
+        return 0;
+    }
+
+    //Tell the other end and step down right after the line is sent
+    sprintf((char*)tx_line, "BAUD_DOWN:%d", (int)(actual_index - 1));
+    uart_tx_data(uart_instance, tx_line);
+    uart_baud_change_ladder_index(uart_instance, (uint8_t)config_index, actual_index - 1);
+
+    if(config.persist_to_flash) {
+        uart_baud_store_index(actual_index - 1);
+    }
+
+    return 1;
+
+}//end uart_baud_monitor
+
+//end file uart_baud.c
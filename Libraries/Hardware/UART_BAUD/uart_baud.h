@@ -0,0 +1,177 @@
+//File: uart_baud.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Baudrate negotiation for a UART link between two controllers (or a controller and a host) over a configured UART (see uart.h).
+    Both ends start with the base baudrate of the baudrate ladder (UART_BAUD_BASE_INDEX). The initiator steps up the ladder,
+    every step is verified with a burst of pattern lines that the responder echoes back. The highest baudrate with an error rate
+    below max_error_rate_ppm is set on both ends and could be stored in flash. At startup uart_baud_restore() sets the stored baudrate
+    on both ends (it sends BAUD_SET, so the other end has to be at the base step).
+    Both ends monitor the receive errors of the UART (framing, parity, break, overrun) and step down the ladder when the error rate rises.
+
+    The negotiation uses text lines (terminator of the UART configuration), so the responder could handle them in its command parser:
+
+        BAUD_TRY:<index>    Initiator: test ladder step, responder answers BAUD_ACK:<index> and echoes every line with the new baudrate
+                            till BAUD_END or a timeout, then both go back to the actual baudrate
+        BAUD_SET:<index>    Initiator: set ladder step, responder answers BAUD_ACK:<index> and changes the baudrate
+        BAUD_DOWN:<index>   Both: the sender changes to the lower ladder step right after this line (no answer)
+        BAUD_PING           Initiator: check of the link, responder answers BAUD_PONG
+
+    NOTE: This module is not multi core save. The flash functions are used for storing the baudrate (utility user space, see flash.h),
+    so the flash utility section has to be set up before if persist_to_flash is used.
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+
+//Preprocessor constants:
+#define UART_BAUD_LADDER_SIZE 8
+//Index of 250 kBd, the baudrate both ends start with
+#define UART_BAUD_BASE_INDEX 1
+
+//Bytes 0-14 of the utility user space are used by the test suite (settings and test counter)
+#define UART_BAUD_FLASH_USER_SPACE_INDEX 15
+
+//Type definitions:
+
+typedef enum Uart_Baud_Role_e {
+    UART_BAUD_INITIATOR = 0,
+    UART_BAUD_RESPONDER
+}Uart_Baud_Role_t;
+
+typedef struct Uart_Baud_Config_s {
+
+    //Pattern burst p. ladder step: number of lines and bytes p. line
+    uint8_t num_of_pattern_lines;
+    uint8_t pattern_length;
+    //Highest error rate (wrong bytes p. million bytes) of a reliable baudrate
+    uint32_t max_error_rate_ppm;
+    //Time to wait for an answer of the other end
+    uint32_t response_timeout_us;
+    //Number of received bytes before the monitor checks the error rate
+    uint32_t monitor_window_bytes;
+    //Store the negotiated baudrate to flash
+    bool persist_to_flash;
+    bool use_watchdog;
+
+}Uart_Baud_Config_t;
+
+typedef struct Uart_Baud_Result_s {
+
+    //Negotiated ladder step and real configured baudrate
+    uint8_t ladder_index;
+    uint32_t baud_rate;
+    //Highest tested ladder step and the error rate measured p. step (ppm)
+    uint8_t highest_tested_index;
+    uint32_t error_rate_ppm[UART_BAUD_LADDER_SIZE];
+
+}Uart_Baud_Result_t;
+
+//Function Prototypes:
+
+/**
+ * @brief Sets the ladder step of a configured UART and initializes the negotiation state.
+ *
+ * @param uart_instance Pointer to the configured UART instance (e.g., uart0, uart1).
+ * @param ladder_index Ladder step to start with (both ends have to use the same step, normally UART_BAUD_BASE_INDEX).
+ *
+ * @return int Returns 1 on success; otherwise, returns an error code:
+ *             -1: Wrong ladder index.
+ *             -2: UART could not be used (wrong instance or not configured).
+ */
+int uart_baud_init(uart_inst_t *uart_instance, uint8_t ladder_index);
+
+/**
+ * @brief Returns the baudrate of a ladder step (0 if the index is wrong).
+ */
+uint32_t uart_baud_get_ladder_baud_rate(uint8_t ladder_index);
+
+/**
+ * @brief Returns the actual ladder step of the UART (UART_BAUD_LADDER_SIZE if the instance is wrong).
+ */
+uint8_t uart_baud_get_ladder_index(uart_inst_t *uart_instance);
+
+/**
+ * @brief Reads the ladder step stored in flash.
+ *
+ * @return uint8_t Returns the stored ladder step or UART_BAUD_BASE_INDEX if none is stored.
+ */
+uint8_t uart_baud_get_stored_index(void);
+
+/**
+ * @brief Stores a ladder step in flash (utility user space), the other settings in the utility user space are kept.
+ *
+ * @param ladder_index Ladder step to store.
+ *
+ * @return int Returns 1 on success and -1 if the flash could not be written (utility section not set up).
+ *
+ * @note Used with persist_to_flash; an application that has to prepare the flash write (e.g. hold the other core in RAM) calls it itself.
+ */
+int uart_baud_store_index(uint8_t ladder_index);
+
+/**
+ * @brief Initiator: steps up the baudrate ladder from the actual step and sets the highest reliable baudrate on both ends.
+ *
+ * @param uart_instance Pointer to the configured UART instance (e.g., uart0, uart1).
+ * @param config Pattern burst, error rate threshold and timeouts.
+ * @param result Pointer to the result with the negotiated baudrate and the error rate of every tested step.
+ *
+ * @return int Returns 1 on success (the actual step is kept if no higher step is reliable); otherwise, returns an error code:
+ *             -1: Wrong configuration.
+ *             -2: UART could not be used (wrong instance or not configured).
+ *             -3: Responder does not answer with the actual baudrate.
+ */
+int uart_baud_negotiate(uart_inst_t *uart_instance, Uart_Baud_Config_t config, Uart_Baud_Result_t *result);
+
+/**
+ * @brief Initiator: sets the ladder step stored in flash on both ends (e.g. after startup, both ends at UART_BAUD_BASE_INDEX).
+ *
+ * @param uart_instance Pointer to the configured UART instance (e.g., uart0, uart1).
+ * @param config Timeouts.
+ * @param result Pointer to the result with the set baudrate.
+ *
+ * @return int Returns 1 if the stored step is set, 2 if the actual step is kept because the stored one does not work;
+ *             otherwise, returns an error code like uart_baud_negotiate().
+ */
+int uart_baud_restore(uart_inst_t *uart_instance, Uart_Baud_Config_t config, Uart_Baud_Result_t *result);
+
+/**
+ * @brief Responder: handles a received negotiation line (BAUD_...).
+ *
+ * @param uart_instance Pointer to the configured UART instance (e.g., uart0, uart1).
+ * @param rx_line Received line (terminated string).
+ * @param config Timeouts.
+ *
+ * @return bool Returns true if the line was a negotiation line, false if it has to be handled by the application.
+ *
+ * @note Blocks during a ladder step test (till BAUD_END or a timeout).
+ */
+bool uart_baud_handle_command(uart_inst_t *uart_instance, uint8_t *rx_line, Uart_Baud_Config_t config);
+
+/**
+ * @brief Both: checks the receive error rate of the UART and steps down the ladder if it is above max_error_rate_ppm.
+ *
+ * @param uart_instance Pointer to the configured UART instance (e.g., uart0, uart1).
+ * @param config Error rate threshold and window.
+ *
+ * @return int Returns 1 if the baudrate was stepped down, 0 if not; otherwise, returns an error code:
+ *             -2: UART could not be used (wrong instance or not configured).
+ *
+ * @note Call it periodically, the error rate is checked after monitor_window_bytes received bytes.
+ *       The other end gets BAUD_DOWN, if it misses it, it sees the receive errors and steps down too.
+ */
+int uart_baud_monitor(uart_inst_t *uart_instance, Uart_Baud_Config_t config);
+
+//end file uart_baud.h
@@ -0,0 +1,321 @@
+//File: uart_mux.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Multiplexes several virtual channels over the TX line of one configured UART.
+    Data is split into frames (channel ID, sequence number, flags, payload, CRC-32), COBS encoded and queued per channel.
+    The UART TX interrupt drains the queues with a weighted round-robin, switching channels only at frame boundaries.
+    For the frame layout see uart_mux.h.
+
+*/
+
+
+//Corresponding header-file:
+#include "uart_mux.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+
+//Pico Hardware-Libraries:
+#include "hardware/uart.h"
+#include "hardware/sync.h"
+
+//Own Libraries:
+#include "uart.h"
+#include "cobs.h"
+#include "crc.h"
+#include "data_to_byte.h"
+
+//Preprocessor constants:
+
+//Channel, sequence number and flags
+#define UART_MUX_HEADER_SIZE 3
+#define UART_MUX_CRC_SIZE 4
+#define UART_MUX_MAX_RAW_FRAME_SIZE (UART_MUX_HEADER_SIZE + UART_MUX_MAX_PAYLOAD_SIZE + UART_MUX_CRC_SIZE)
+//Encoded frame with the terminating zero byte
+#define UART_MUX_MAX_ENCODED_FRAME_SIZE (COBS_MAX_ENCODED_LENGTH(UART_MUX_MAX_RAW_FRAME_SIZE) + 1)
+
+//Queue size has to be a power of two
+#define UART_MUX_QUEUE_MASK (UART_MUX_QUEUE_SIZE - 1)
+
+//Typedefs:
+
+typedef struct Uart_Mux_Channel_s {
+
+    //Ring buffer with the encoded frames
+    uint8_t queue[UART_MUX_QUEUE_SIZE];
+    volatile uint16_t queue_head;
+    volatile uint16_t queue_tail;
+    //Frames p. round of the weighted round-robin, 0 = disabled
+    uint8_t weight;
+    uint8_t sequence_number;
+
+}Uart_Mux_Channel_t;
+
+//File global (static) variables:
+
+static Uart_Mux_Channel_t mux_channels[UART_MUX_MAX_CHANNELS];
+
+static uart_inst_t *mux_uart_instance = NULL;
+static spin_lock_t *mux_lock = NULL;
+static uint mux_lock_num = 0;
+
+//State of the TX drain
+static volatile bool mux_tx_active = false;
+static bool mux_in_frame = false;
+static uint8_t mux_active_channel = 0;
+static uint8_t mux_frame_credits = 0;
+
+//Functions:
+
+//File global (static) function definitions:
+
+static inline uint16_t uart_mux_get_used_bytes(uint8_t channel) {
+
+    return (mux_channels[channel].queue_head - mux_channels[channel].queue_tail) & UART_MUX_QUEUE_MASK;
+
+}//end uart_mux_get_used_bytes
+
+static inline uint16_t uart_mux_get_free_bytes(uint8_t channel) {
+
+    //One byte is kept free to distinguish between a full and an empty queue
+    return UART_MUX_QUEUE_SIZE - 1 - uart_mux_get_used_bytes(channel);
+
+}//end uart_mux_get_free_bytes
+
+//Selects the channel the next frame is sent from (weighted round-robin), spin lock has to be held
+static bool uart_mux_select_channel(void) {
+
+    //Stay on the active channel while it has credits and frames left (and is not disabled in the meantime)
+    if(mux_frame_credits > 0 && mux_channels[mux_active_channel].weight > 0 && uart_mux_get_used_bytes(mux_active_channel) > 0) {
+        return true;
+    }
+
+    //Next channel with queued frames, the active channel is checked last
+    for(uint8_t k = 1; k <= UART_MUX_MAX_CHANNELS; k++) {
+        uint8_t channel = (mux_active_channel + k) % UART_MUX_MAX_CHANNELS;
+        if(mux_channels[channel].weight > 0 && uart_mux_get_used_bytes(channel) > 0) {
+            mux_active_channel = channel;
+            mux_frame_credits = mux_channels[channel].weight;
+            return true;
+        }
+    }
+
+    return false;
+
+}//end uart_mux_select_channel
+
+//Writes queued bytes to the UART as long as it accepts data, spin lock has to be held
+static void __time_critical_func(uart_mux_drain)(void) {
+
+    while(uart_is_writable(mux_uart_instance)) {
+
+        if(!mux_in_frame) {
+            if(!uart_mux_select_channel()) {
+                //Nothing left, the next uart_mux_send() starts the drain again
+                mux_tx_active = false;
+                return;
+            }
+            mux_in_frame = true;
+        }
+
+        Uart_Mux_Channel_t *channel = &mux_channels[mux_active_channel];
+        uint8_t tx_byte = channel->queue[channel->queue_tail];
+        channel->queue_tail = (channel->queue_tail + 1) & UART_MUX_QUEUE_MASK;
+        uart_putc_raw(mux_uart_instance, tx_byte);
+
+        //Zero byte terminates the frame
+        if(tx_byte == 0) {
+            mux_in_frame = false;
+            mux_frame_credits--;
+        }
+    }
+
+    //UART TX interrupt continues the drain
+    mux_tx_active = true;
+
+}//end uart_mux_drain
+
+static void __time_critical_func(uart_mux_tx_callback)(void) {
+
+    uint32_t irq_state = spin_lock_blocking(mux_lock);
+    uart_mux_drain();
+    spin_unlock(mux_lock, irq_state);
+
+}//end uart_mux_tx_callback
+
+//Function definition:
+
+int uart_mux_init(uart_inst_t *uart_instance) {
+
+    if(mux_uart_instance != NULL) {
+        return -1; //Error: multiplexer is already active
+    }
+
+    //Reset channels
+    for(uint8_t k = 0; k < UART_MUX_MAX_CHANNELS; k++) {
+        mux_channels[k].queue_head = 0;
+        mux_channels[k].queue_tail = 0;
+        mux_channels[k].weight = 0;
+        mux_channels[k].sequence_number = 0;
+    }
+    mux_tx_active = false;
+    mux_in_frame = false;
+    mux_active_channel = 0;
+    mux_frame_credits = 0;
+
+    mux_lock_num = spin_lock_claim_unused(true);
+    mux_lock = spin_lock_instance(mux_lock_num);
+
+    if(uart_set_tx_interrupt_callback(uart_instance, uart_mux_tx_callback) < 0) {
+        spin_lock_unclaim(mux_lock_num);
+        return -2; //Error: wrong uart instance or uart not configured
+    }
+
+    mux_uart_instance = uart_instance;
+    return 1;
+
+}//end uart_mux_init
+
+int uart_mux_deinit(void) {
+
+    if(mux_uart_instance == NULL) {
+        return -1; //Error: multiplexer is not active
+    }
+
+    uart_mux_flush();
+    uart_set_tx_interrupt_callback(mux_uart_instance, NULL);
+    spin_lock_unclaim(mux_lock_num);
+    mux_uart_instance = NULL;
+    return 1;
+
+}//end uart_mux_deinit
+
+int uart_mux_configure_channel(uint8_t channel, uint8_t weight) {
+
+    if(mux_uart_instance == NULL) {
+        return -1; //Error: multiplexer is not active
+    }
+
+    if(channel >= UART_MUX_MAX_CHANNELS) {
+        return -2; //Error: channel does not exist
+    }
+
+    uint32_t irq_state = spin_lock_blocking(mux_lock);
+    mux_channels[channel].weight = weight;
+    spin_unlock(mux_lock, irq_state);
+    return 1;
+
+}//end uart_mux_configure_channel
+
+int uart_mux_send(uint8_t channel, const uint8_t *data, uint32_t num_of_bytes, bool blocking) {
+
+    uint8_t raw_frame[UART_MUX_MAX_RAW_FRAME_SIZE];
+    uint8_t encoded_frame[UART_MUX_MAX_ENCODED_FRAME_SIZE];
+    uint32_t data_offset = 0;
+    uint32_t payload_length = 0;
+    uint32_t encoded_length = 0;
+
+    if(mux_uart_instance == NULL) {
+        return -1; //Error: multiplexer is not active
+    }
+
+    if(channel >= UART_MUX_MAX_CHANNELS || mux_channels[channel].weight == 0) {
+        return -2; //Error: channel does not exist or is disabled
+    }
+
+    //Empty messages are sent as a single frame without payload
+    do {
+
+        payload_length = num_of_bytes - data_offset;
+        if(payload_length > UART_MUX_MAX_PAYLOAD_SIZE) {
+            payload_length = UART_MUX_MAX_PAYLOAD_SIZE;
+        }
+
+        raw_frame[0] = channel;
+        raw_frame[2] = ((data_offset + payload_length) >= num_of_bytes) ? UART_MUX_FLAG_END_OF_MESSAGE : 0;
+        for(uint32_t k = 0; k < payload_length; k++) {
+            raw_frame[UART_MUX_HEADER_SIZE + k] = data[data_offset + k];
+        }
+
+        while(true) {
+
+            uint32_t irq_state = spin_lock_blocking(mux_lock);
+
+            if(uart_mux_get_free_bytes(channel) >= UART_MUX_MAX_ENCODED_FRAME_SIZE) {
+
+                //Sequence number and crc inside the lock, so frames of two cores keep their order
+                raw_frame[1] = mux_channels[channel].sequence_number++;
+                uint32_t_to_byte_array(get_crc32(raw_frame, UART_MUX_HEADER_SIZE + payload_length), &raw_frame[UART_MUX_HEADER_SIZE + payload_length]);
+                encoded_length = cobs_encode(raw_frame, UART_MUX_HEADER_SIZE + payload_length + UART_MUX_CRC_SIZE, encoded_frame);
+                encoded_frame[encoded_length++] = 0;
+
+                for(uint32_t k = 0; k < encoded_length; k++) {
+                    mux_channels[channel].queue[mux_channels[channel].queue_head] = encoded_frame[k];
+                    mux_channels[channel].queue_head = (mux_channels[channel].queue_head + 1) & UART_MUX_QUEUE_MASK;
+                }
+
+                //Start drain if the UART is idle
+                if(!mux_tx_active) {
+                    uart_mux_drain();
+                }
+
+                spin_unlock(mux_lock, irq_state);
+                break;
+            }
+
+            spin_unlock(mux_lock, irq_state);
+
+            if(!blocking) {
+                return -3; //Error: queue is full
+            }
+            tight_loop_contents();
+        }
+
+        data_offset += payload_length;
+
+    }while(data_offset < num_of_bytes);
+
+    return 1;
+
+}//end uart_mux_send
+
+uint32_t uart_mux_get_queued_bytes(uint8_t channel) {
+
+    if(channel >= UART_MUX_MAX_CHANNELS) {
+        return 0;
+    }
+
+    return uart_mux_get_used_bytes(channel);
+
+}//end uart_mux_get_queued_bytes
+
+void uart_mux_flush(void) {
+
+    if(mux_uart_instance == NULL) {
+        return;
+    }
+
+    //Drain from here instead of waiting for the UART TX interrupt, so the flush also ends if the interrupt is masked
+    //(e.g. called from an other interrupt or with interrupts disabled). Ends if no enabled channel has queued frames left.
+    bool tx_active = true;
+    while(tx_active) {
+        uint32_t irq_state = spin_lock_blocking(mux_lock);
+        uart_mux_drain();
+        tx_active = mux_tx_active;
+        spin_unlock(mux_lock, irq_state);
+        tight_loop_contents();
+    }
+
+    uart_tx_wait_blocking(mux_uart_instance);
+
+}//end uart_mux_flush
+
+//end file uart_mux.c
@@ -0,0 +1,118 @@
+//File: uart_mux.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Multiplexes several virtual channels (e.g. control messages of core0, status of core1, test result dumps)
+    over the TX line of one configured UART (see uart.h).
+    Every channel has its own queue and a weight. Data written to a channel is split into frames, the frames are queued and
+    sent from the UART TX interrupt. The TX drain switches between the channels only at frame boundaries with a weighted round-robin:
+    a channel with weight n sends up to n frames before the next channel with queued data gets the line.
+    So a long dump on a low weight channel could not block the messages of a high weight channel for more than one frame.
+
+    Frame layout before encoding:
+
+        Byte 0:     Channel ID
+        Byte 1:     Sequence number (per channel, wraps around)
+        Byte 2:     Flags (UART_MUX_FLAG_END_OF_MESSAGE marks the last frame of a message)
+        Byte 3-n:   Payload (max. UART_MUX_MAX_PAYLOAD_SIZE bytes)
+        Byte n-n+3: CRC-32 over channel, sequence, flags and payload (little endian)
+
+    The frame is COBS encoded and terminated by a zero byte (see cobs.h).
+
+    NOTE: Only one UART could be multiplexed at a time. Sending to a channel is multi core save (hardware spin lock),
+          the TX drain runs on the core the UART interrupt is enabled on.
+    NOTE: Do not use the plain TX functions of uart.h on the multiplexed UART while the multiplexer is active.
+    NOTE: Only the TX direction is multiplexed, RX stays as it is in uart.h.
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+
+//Preprocessor constants:
+#define UART_MUX_MAX_CHANNELS 4
+#define UART_MUX_QUEUE_SIZE 2048
+#define UART_MUX_MAX_PAYLOAD_SIZE 128
+
+#define UART_MUX_FLAG_END_OF_MESSAGE 0x01
+
+//Type definitions:
+
+//Function Prototypes:
+
+/**
+ * @brief Starts the multiplexer on an already configured UART.
+ *
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1), configured with configure_uart_hardware().
+ *
+ * @return int Returns 1 on success; otherwise, returns an error code:
+ *             -1: Multiplexer is already active.
+ *             -2: UART could not be set up (wrong instance or not configured).
+ *
+ * @note All channels are disabled (weight 0) after the start, configure them with uart_mux_configure_channel().
+ */
+int uart_mux_init(uart_inst_t *uart_instance);
+
+/**
+ * @brief Stops the multiplexer after all queued frames are sent.
+ *
+ * @return int Returns 1 on success; returns -1 if the multiplexer was not active.
+ */
+int uart_mux_deinit(void);
+
+/**
+ * @brief Sets the weight of a channel.
+ *
+ * @param channel Channel ID (0 to UART_MUX_MAX_CHANNELS-1).
+ * @param weight Number of frames the channel could send in one round, 0 disables the channel.
+ *
+ * @return int Returns 1 on success; otherwise, returns an error code:
+ *             -1: Multiplexer is not active.
+ *             -2: Channel does not exist.
+ */
+int uart_mux_configure_channel(uint8_t channel, uint8_t weight);
+
+/**
+ * @brief Queues data on a channel, the data is split into frames of max. UART_MUX_MAX_PAYLOAD_SIZE bytes.
+ *
+ * @param channel Channel ID (0 to UART_MUX_MAX_CHANNELS-1).
+ * @param data Pointer to the data to send.
+ * @param num_of_bytes Number of bytes to send.
+ * @param blocking If true wait till there is space in the queue, if false return as soon as the queue is full.
+ *
+ * @return int Returns 1 if all data was queued; otherwise, returns an error code:
+ *             -1: Multiplexer is not active.
+ *             -2: Channel does not exist or is disabled.
+ *             -3: Queue is full (only non blocking), the frames queued so far are sent.
+ */
+int uart_mux_send(uint8_t channel, const uint8_t *data, uint32_t num_of_bytes, bool blocking);
+
+/**
+ * @brief Returns the number of bytes (encoded frames) that are still queued on a channel.
+ *
+ * @param channel Channel ID (0 to UART_MUX_MAX_CHANNELS-1).
+ *
+ * @return uint32_t Number of queued bytes, 0 if the channel does not exist.
+ */
+uint32_t uart_mux_get_queued_bytes(uint8_t channel);
+
+/**
+ * @brief Waits till the queues of all channels are empty and the last byte is sent.
+ *
+ * @note The queues are drained from the calling context, so the flush does not depend on the UART TX interrupt.
+ *       Frames queued on a disabled channel (weight 0) are not sent and do not block the flush.
+ */
+void uart_mux_flush(void);
+
+//end file uart_mux.h
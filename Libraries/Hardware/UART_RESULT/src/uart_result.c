@@ -0,0 +1,78 @@
+//File: uart_result.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Sends result frames over a configured UART, or over a channel of the uart multiplexer.
+    For the frame layout see result_frame.h.
+
+*/
+
+
+//Corresponding header-file:
+#include "uart_result.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+#include "uart.h"
+#include "uart_mux.h"
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Encoded frame (enclosed by zero delimiters)
+static uint8_t encoded_frame[RESULT_FRAME_MAX_ENCODED_SIZE];
+
+//Channel of the uart multiplexer (plain UART by default)
+static bool result_use_uart_mux = false;
+static uint8_t result_uart_mux_channel = 0;
+
+//Functions:
+
+//Function definition:
+
+int uart_result_send(uart_inst_t *uart_instance, Result_Frame_Header_t header, const uint8_t *payload) {
+
+    int frame_length = result_frame_encode(header, payload, encoded_frame);
+
+    if(frame_length < 0) {
+        return -1; //Error: frame could not be encoded
+    }
+    if(result_use_uart_mux) {
+        //The multiplexer owns the TX of the UART, the encoded frame is the message of the channel
+        if(uart_mux_send(result_uart_mux_channel, encoded_frame, (uint32_t)frame_length, true) < 0) {
+            return -2; //Error: frame could not be sent
+        }
+    }
+    else if(uart_tx_bytes(uart_instance, encoded_frame, (uint32_t)frame_length) < 0) {
+        return -2; //Error: frame could not be sent
+    }
+
+    return frame_length;
+
+}//end uart_result_send
+
+int uart_result_set_mux_channel(bool use_uart_mux, uint8_t channel) {
+
+    if(channel >= UART_MUX_MAX_CHANNELS) {
+        return -1; //Error: channel does not exist
+    }
+
+    result_use_uart_mux = use_uart_mux;
+    result_uart_mux_channel = channel;
+    return 1;
+
+}//end uart_result_set_mux_channel
+
+//end file uart_result.c
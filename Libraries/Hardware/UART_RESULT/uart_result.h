@@ -0,0 +1,58 @@
+//File: uart_result.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Sends test results as result frames (see result_frame.h) over a configured UART (see uart.h).
+    The frames are encoded with result_frame_encode() (including the fec configuration of result_frame_set_fec()) and written
+    to the UART. If the UART is multiplexed (uart_mux.h) the frames are queued on the channel set with uart_result_set_mux_channel()
+    instead (e.g. the bulk channel), the host demultiplexes them again (result_frame_decoder -m).
+
+    NOTE: This module is not multi-core-save (static frame buffer)
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+#include "result_frame.h"
+
+//Preprocessor constants:
+
+//Type definitions:
+
+//Function Prototypes:
+
+/**
+ * @brief Encodes a result frame and sends it over the UART (or queues it on the channel of the uart multiplexer).
+ *
+ * @param uart_instance Pointer to the UART instance (e.g., uart0, uart1), configured with configure_uart_hardware().
+ * @param header Header of the frame (test type, record type, frame index and count, payload length).
+ * @param payload Pointer to the payload (header.payload_length bytes).
+ *
+ * @return int Returns the number of sent bytes on success; otherwise, returns an error code:
+ *             -1: Frame could not be encoded (payload to long).
+ *             -2: Frame could not be sent.
+ */
+int uart_result_send(uart_inst_t *uart_instance, Result_Frame_Header_t header, const uint8_t *payload);
+
+/**
+ * @brief Sets if the result frames are sent over a channel of the uart multiplexer instead of the plain UART.
+ *
+ * @param use_uart_mux If true the frames are queued on the channel, if false they are sent over the plain UART (default).
+ * @param channel Channel ID of the uart multiplexer (0 to UART_MUX_MAX_CHANNELS-1).
+ *
+ * @return int Returns 1 on success; returns -1 if the channel does not exist.
+ */
+int uart_result_set_mux_channel(bool use_uart_mux, uint8_t channel);
+
+//end file uart_result.h
@@ -11,9 +11,23 @@
         -Sub creates a ramp output via PWM-DAC (digital to analog converter) and a passive LPF (low pass filter) of the order one at the output.
         -Main measures this ramp with the adc.
         -Per ramp step (the number of steps depends on the resolution of the DAC) there are a configure-able amount of samples taken.
-        -Out of these samples per step the mean and standard deviations are calculated
+         The ADC captures one block p. ramp step with the ADC sample rate (DMA double buffer), no CPU timing is involved.
+        -The ADC samples with 8-Bit or 12-Bit, in 12-Bit mode the samples could be oversampled and averaged (boxcar decimation) for more effective bits.
+        -Out of these samples per step the mean and standard deviations are calculated (streaming statistics, one integer pass over every DMA block)
+        -Optimized setup: the noise of every step is transformed (Q15 FFT), the spectra are averaged and only the biggest peaks are stored
+         (frequency and amplitude), interference coupled in from the gradients shows up as peaks
         -All steps are printed out as mean-value +/- standard-deviation or as raw digital values
 
+        Loopback test (single board, DAC output connected to the ADC input):
+        -Every DAC step triggers one block from the pwm wrap interrupt after a settle time (counted in pwm cycles),
+         so every block has the same position to its step and no UART synchronisation is needed.
+
+        Histogram test (loopback):
+        -Like the loopback test, but every sample only increments the bin of its code (code density test), so only the histogram
+         (256 or 4096 bins) is stored and the capture could run over several ramps.
+        -INL and DNL are calculated from the histogram at the end. The DAC ramp has to cover every ADC code
+         (DAC resolution >= ADC resolution or enough noise for dithering), otherwise the untouched codes show up as missing codes.
+
 */
 
 //Libraries:
@@ -28,6 +42,7 @@
 //Pico Hardware-Libraries:
 
 //Own Libraries:
+#include "statistic.h"
 
 //NOTE: Control preprocessor to control which ADC setup is build and used
 //#define USE_OPTIMIZED_SETUP true
@@ -36,11 +51,17 @@
 #ifdef USE_OPTIMIZED_SETUP
     #define MAX_ADC_SAMPLES_PER_RAMP 1024
     #define MAX_ADC_SAMPLES_PER_RAMP_STEP 500
+    //Noise spectrum of every ramp step: FFT size (first samples of the step) and number of stored peaks
+    #define ADC_TEST_FFT_SIZE 256
+    #define ADC_TEST_NUMBER_OF_SPECTRAL_PEAKS 8
 #else
     #define MAX_ADC_SAMPLES_PER_RAMP 1024
     #define MAX_ADC_SAMPLES_PER_RAMP_STEP 5
 #endif
 
+//Histogram test: one bin p. code of the 12-bit ADC
+#define ADC_TEST_MAX_HISTOGRAM_CODES 4096
+
 //Type definitions:
 
 typedef struct ADC_Test_Hardware_s {
@@ -69,6 +90,9 @@ typedef struct ADC_Test_Parameter_s {
     //ADC
     //ADC sample rate
     float adc_sample_rate;
+    //ADC resolution (8 or 12 bit) and oversampling ratio (power of two, 12 bit only, 1 for no oversampling)
+    uint8_t adc_resolution_in_bits;
+    uint16_t adc_oversampling_ratio;
     //ADC number of samples per ramp  and per step of the ramp
     uint32_t number_of_samples_per_ramp_step;
     uint32_t number_of_samples_per_ramp;
@@ -79,7 +103,10 @@ typedef struct ADC_Test_Parameter_s {
     float dac_pwm_frequency;
     //Resolution of the output ramp
     uint8_t dac_resolution_in_bits;
-
+    //Loopback test: time after every DAC step before the block is captured (settle time of the LPF)
+    float dac_settle_time_us;
+    //Histogram test: number of ramps that are captured into the histogram
+    uint16_t number_of_histogram_ramps;
 
 }ADC_Test_Parameter_t;
 
@@ -91,7 +118,7 @@ typedef struct ADC_Test_Structure_s {
 }ADC_Test_Structure_t;
 
 #ifdef USE_OPTIMIZED_SETUP
-//New ADC test structure that stores only mean value and standard deviation and fft:
+//New ADC test structure that stores only mean value and standard deviation and the peaks of the noise spectrum:
 typedef struct ADC_Test_Return_s {
     float adc_sample_rate;
     uint32_t number_of_samples;
@@ -101,11 +128,25 @@ typedef struct ADC_Test_Return_s {
 
     uint32_t number_of_samples_per_ramp_step;
     uint32_t number_of_samples_per_ramp;
+    //Ramp steps that were overwritten by the DMA before they were processed
+    uint32_t number_of_block_overruns;
+    //Resolution of the samples after decimation
+    uint8_t adc_resolution_in_bits;
+    //ADC instrumentation: FIFO overflows (lost samples) and conversion errors during the capture, measured conversion rate of the ADC
+    uint32_t number_of_fifo_overflows;
+    uint32_t number_of_conversion_errors;
+    float adc_effective_sample_rate;
 
     //Store mean_value, std_deviation 
     float mean_value[MAX_ADC_SAMPLES_PER_RAMP];
     float std_deviation[MAX_ADC_SAMPLES_PER_RAMP];
 
+    //Spectrum of every step (mean value removed, Hann window) averaged over the ramp, biggest peaks first (0 if the steps are to short)
+    uint16_t fft_size;
+    uint8_t number_of_spectral_peaks;
+    float spectral_peak_frequency[ADC_TEST_NUMBER_OF_SPECTRAL_PEAKS];
+    float spectral_peak_amplitude[ADC_TEST_NUMBER_OF_SPECTRAL_PEAKS];
+
 }ADC_Test_Return_t;
 #endif
 
@@ -120,17 +161,50 @@ typedef struct ADC_Test_Return_s {
 
     uint32_t number_of_samples_per_ramp_step;
     uint32_t number_of_samples_per_ramp;
+    //Ramp steps that were overwritten by the DMA before they were processed
+    uint32_t number_of_block_overruns;
+    //Resolution of the samples after decimation
+    uint8_t adc_resolution_in_bits;
+    //ADC instrumentation: FIFO overflows (lost samples) and conversion errors during the capture, measured conversion rate of the ADC
+    uint32_t number_of_fifo_overflows;
+    uint32_t number_of_conversion_errors;
+    float adc_effective_sample_rate;
 
-    uint8_t adc_samples[MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP];
+    uint16_t adc_samples[MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP];
 
 }ADC_Test_Return_t;
 #endif
 
+typedef struct ADC_Test_Histogram_Return_s {
+
+    float adc_sample_rate;
+    uint32_t number_of_samples;
+
+    uint8_t dac_resolution_in_bits;
+    float dac_pwm_frequency;
+
+    uint32_t number_of_samples_per_ramp_step;
+    uint32_t number_of_samples_per_ramp;
+    uint32_t number_of_block_overruns;
+    uint8_t adc_resolution_in_bits;
+    uint32_t number_of_fifo_overflows;
+    uint32_t number_of_conversion_errors;
+    float adc_effective_sample_rate;
+
+    //INL/DNL summary and number of samples p. code
+    Linearity_Result_t linearity;
+    uint16_t number_of_codes;
+    uint32_t histogram[ADC_TEST_MAX_HISTOGRAM_CODES];
+
+}ADC_Test_Histogram_Return_t;
+
 typedef struct ADC_Test_Output_Format_s {
 
     uint8_t values_per_line;
     uint8_t value_separator;
     bool print_raw_digital_values;
+    //Export results as binary frames (COBS, CRC-32) instead of text, see result_frame.h
+    bool binary_export;
 
 }ADC_Test_Output_Format_t;
 
@@ -138,6 +212,9 @@ typedef struct ADC_Test_Output_Format_s {
 
 int adc_test_main_read_ramp(ADC_Test_Structure_t adc_tests, ADC_Test_Return_t *return_of_test, bool use_watchdog);
 void adc_test_sub_ramp_output(ADC_Test_Structure_t adc_tests, bool use_watchdog);
+int adc_test_loopback_read_ramp(ADC_Test_Structure_t adc_tests, ADC_Test_Return_t *return_of_test, bool use_watchdog);
 void adc_test_print_test_returns(ADC_Test_Return_t *test_return, uart_inst_t *uart_to_print, ADC_Test_Output_Format_t format);
+int adc_test_loopback_histogram(ADC_Test_Structure_t adc_tests, ADC_Test_Histogram_Return_t *return_of_test, bool use_watchdog);
+void adc_test_print_histogram_returns(ADC_Test_Histogram_Return_t *test_return, uart_inst_t *uart_to_print, ADC_Test_Output_Format_t format);
 
 //end file adc_test.h
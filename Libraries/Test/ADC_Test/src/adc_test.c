@@ -11,9 +11,17 @@
         -Sub creates a ramp output via PWM-DAC (digital to analog converter) and a passive LPF (low pass filter) of the order one at the output.
         -Main measures this ramp with the adc.
         -Per ramp step (the number of steps depends on the resolution of the DAC) there are a configure-able amount of samples taken.
-        -Out of these samples per step the mean and standard deviations are calculated
+         The ADC captures one block p. ramp step with the ADC sample rate (DMA double buffer), no CPU timing is involved.
+        -The ADC samples with 8-Bit or 12-Bit, in 12-Bit mode the samples could be oversampled and averaged (boxcar decimation) for more effective bits.
+        -Out of these samples per step the mean and standard deviations are calculated (streaming statistics, one integer pass over every DMA block)
+        -Optimized setup: the noise of every step is transformed (Q15 FFT), the spectra are averaged and only the biggest peaks are stored
+         (frequency and amplitude), interference coupled in from the gradients shows up as peaks
         -All steps are printed out as mean-value +/- standard-deviation or as raw digital values
 
+        Loopback test (single board, DAC output connected to the ADC input):
+        -Every DAC step triggers one block from the pwm wrap interrupt after a settle time (counted in pwm cycles),
+         so every block has the same position to its step and no UART synchronisation is needed.
+
 */
 
 //Corresponding header-file:
@@ -39,62 +47,497 @@
 #include "adc.h"
 #include "uart.h"
 #include "pwm.h"
-#include "statistic.h"
+#include "data_to_byte.h"
+#include "uart_result.h"
+#include "number_format.h"
+#include "fft.h"
+#include "ramp_codec.h"
 
 //Preprocessor constants:
 
+//Hold time of every ramp step of the sub (PWM-DAC)
+#define ADC_TEST_RAMP_STEP_TIME_US 10000
+//A block holds one ramp step, so it is limited by the maximum sample rate
+#define ADC_TEST_MAX_BLOCK_SIZE ((ADC_MAX_SAMPLE_RATE/1000)*(ADC_TEST_RAMP_STEP_TIME_US/1000))
+//Reference voltage of the ADC
+#define ADC_TEST_V_REF 3.261
+
+//Type definitions:
+
+//Capture setup of one ramp measurement
+typedef struct ADC_Test_Capture_s {
+
+    uint32_t samples_per_step;
+    //Only every decimation-th sample is used (ADC could not sample slower than ADC_MIN_SAMPLE_RATE)
+    uint32_t decimation;
+    uint8_t adc_resolution;
+    uint16_t oversampling_ratio;
+    //Resolution after the oversampling
+    uint8_t sample_resolution;
+    uint32_t block_size;
+    float capture_sample_rate;
+    //Noise spectrum (optimized setup): FFT size and shift of the samples to Q15
+    uint16_t fft_size;
+    uint8_t fft_shift;
+    //Instrumentation of the ADC driver at the end of the capture
+    ADC_Capture_Statistic_t adc_statistic;
+
+}ADC_Test_Capture_t;
+
+//Processing of the completed block of ramp step k (adc_test_block_buffer[k%2])
+typedef void (*ADC_Test_Block_Handler_t)(ADC_Test_Capture_t *capture, uint32_t k, void *test_return);
+
 //File global (static) variables:
 
+//Double buffer of the ADC block capture (uint8_t samples in 8-bit mode, uint16_t samples in 12-bit mode)
+static uint16_t adc_test_block_buffer[2][ADC_TEST_MAX_BLOCK_SIZE];
+//DAC steps in the loopback test that could not trigger a block (ADC still capturing)
+static volatile uint32_t adc_test_missed_triggers = 0;
+
+#ifdef USE_OPTIMIZED_SETUP
+//FFT of one ramp step and sum of the magnitude spectra of all steps
+static int16_t adc_test_fft_real[ADC_TEST_FFT_SIZE];
+static int16_t adc_test_fft_imaginary[ADC_TEST_FFT_SIZE];
+static uint16_t adc_test_fft_magnitude[ADC_TEST_FFT_SIZE/2];
+static uint32_t adc_test_spectrum_sum[ADC_TEST_FFT_SIZE/2];
+#endif
+
 //Functions:
 
 //File global (static) function definitions:
 
-//Function definition:
+//Payload of the parameter frame (first frame of every adc export), returns the payload length
+static uint16_t adc_test_set_parameter_payload(uint8_t *payload, float adc_sample_rate, uint32_t number_of_samples, uint8_t dac_resolution_in_bits,
+    float dac_pwm_frequency, uint32_t number_of_samples_per_ramp_step, uint32_t number_of_samples_per_ramp, uint8_t adc_resolution_in_bits,
+    uint32_t number_of_fifo_overflows, uint32_t number_of_conversion_errors, float adc_effective_sample_rate) {
 
-int adc_test_main_read_ramp(ADC_Test_Structure_t adc_tests, ADC_Test_Return_t *return_of_test, bool use_watchdog) {
+    float_to_byte_array(adc_sample_rate, &payload[0]);
+    uint32_t_to_byte_array(number_of_samples, &payload[4]);
+    payload[8] = dac_resolution_in_bits;
+    float_to_byte_array(dac_pwm_frequency, &payload[9]);
+    uint32_t_to_byte_array(number_of_samples_per_ramp_step, &payload[13]);
+    uint32_t_to_byte_array(number_of_samples_per_ramp, &payload[17]);
+    payload[21] = adc_resolution_in_bits;
+    uint32_t_to_byte_array(number_of_fifo_overflows, &payload[22]);
+    uint32_t_to_byte_array(number_of_conversion_errors, &payload[26]);
+    float_to_byte_array(adc_effective_sample_rate, &payload[30]);
+    return 34;
 
-    uint32_t wait_between_samples_ms = 0;
-    uint32_t wait_between_samples_us = 0;
-    float precise_wait_between_samples_ms = 0;
-    bool ms_waittime = true;
+}//end adc_test_set_parameter_payload
+
+static void adc_test_export_test_returns(ADC_Test_Return_t *test_return, uart_inst_t *uart_to_print) {
+
+    static uint8_t payload[RESULT_FRAME_MAX_PAYLOAD_SIZE];
+    Result_Frame_Header_t header;
+    uint16_t number_of_data_frames = 0;
+
+    #ifndef USE_OPTIMIZED_SETUP
+    //Residuals against the fitted ramp (see ramp_codec.h), every data frame is a chunk that could be decoded on its own
+    Ramp_Codec_Model_t model;
+    uint32_t number_of_encoded_samples = 0;
+    uint32_t sample_index = 0;
+    ramp_codec_fit_model(test_return->adc_samples, test_return->number_of_samples, (uint16_t)test_return->number_of_samples_per_ramp_step, &model);
+    //First pass only counts the frames, the frame count is part of every header
+    for(sample_index = 0; sample_index < test_return->number_of_samples; sample_index += number_of_encoded_samples) {
+        ramp_codec_encode(test_return->adc_samples, sample_index, test_return->number_of_samples - sample_index, &model, payload,
+            RESULT_FRAME_MAX_PAYLOAD_SIZE, &number_of_encoded_samples);
+        number_of_data_frames++;
+    }
+    sample_index = 0;
+    header.record_type = RECORD_ADC_RAMP_CODED;
+    #else
+    //Mean value and standard deviation as float per ramp step
+    uint32_t data_length = 8*test_return->number_of_samples_per_ramp;
+    uint32_t data_offset = 0;
+    header.record_type = RECORD_ADC_MEAN_STD;
+    number_of_data_frames = (data_length + RESULT_FRAME_MAX_PAYLOAD_SIZE - 1)/RESULT_FRAME_MAX_PAYLOAD_SIZE;
+    #endif
 
+    //First frame: test parameter
+    header.test_type = RESULT_FRAME_TEST_ADC;
+    header.frame_count = number_of_data_frames + 1;
     #ifdef USE_OPTIMIZED_SETUP
-        uint8_t adc_sample_buffer_byte[MAX_ADC_SAMPLES_PER_RAMP_STEP];
-        float adc_sample_buffer[MAX_ADC_SAMPLES_PER_RAMP_STEP];
+    //Last frame: peaks of the noise spectrum
+    header.frame_count++;
     #endif
-   
-    //Get precise wait time between samples in ms - one step takes 10ms and this program will sample number_of_samples_per_ramp_step times on every step
-    //To get the waittime in ms it the step time is divided by the number of samples per step
-    precise_wait_between_samples_ms = (10/adc_tests.parameter.number_of_samples_per_ramp_step);
+    header.frame_index = 0;
+    Result_Frame_Header_t parameter_header = header;
+    parameter_header.record_type = RECORD_TEST_PARAMETER;
+    parameter_header.payload_length = adc_test_set_parameter_payload(payload, test_return->adc_sample_rate, test_return->number_of_samples,
+        test_return->dac_resolution_in_bits, test_return->dac_pwm_frequency, test_return->number_of_samples_per_ramp_step, 
+        test_return->number_of_samples_per_ramp, test_return->adc_resolution_in_bits, test_return->number_of_fifo_overflows,
+        test_return->number_of_conversion_errors, test_return->adc_effective_sample_rate);
+    uart_result_send(uart_to_print, parameter_header, payload);
+
+    //Data frames
+    for(uint16_t f = 0; f < number_of_data_frames; f++) {
+
+        header.frame_index = f + 1;
+
+        #ifndef USE_OPTIMIZED_SETUP
+        header.payload_length = (uint16_t)ramp_codec_encode(test_return->adc_samples, sample_index, test_return->number_of_samples - sample_index,
+            &model, payload, RESULT_FRAME_MAX_PAYLOAD_SIZE, &number_of_encoded_samples);
+        sample_index += number_of_encoded_samples;
+        #else
+        header.payload_length = RESULT_FRAME_MAX_PAYLOAD_SIZE;
+        if((data_length - data_offset) < RESULT_FRAME_MAX_PAYLOAD_SIZE) {
+            header.payload_length = data_length - data_offset;
+        }
+        for(uint16_t k = 0; k < header.payload_length; k += 8) {
+            uint32_t step = (data_offset + k)/8;
+            float_to_byte_array(test_return->mean_value[step], &payload[k]);
+            float_to_byte_array(test_return->std_deviation[step], &payload[k+4]);
+        }
+        data_offset += header.payload_length;
+        #endif
 
-    if(precise_wait_between_samples_ms < 1) {
-        ms_waittime = false;
+        uart_result_send(uart_to_print, header, payload);
     }
-    else {
-        ms_waittime = true;
+
+    #ifdef USE_OPTIMIZED_SETUP
+    //Frequency and amplitude as float per peak
+    header.frame_index = number_of_data_frames + 1;
+    header.record_type = RECORD_ADC_SPECTRAL_PEAKS;
+    header.payload_length = 8*test_return->number_of_spectral_peaks;
+    for(uint8_t k = 0; k < test_return->number_of_spectral_peaks; k++) {
+        float_to_byte_array(test_return->spectral_peak_frequency[k], &payload[8*k]);
+        float_to_byte_array(test_return->spectral_peak_amplitude[k], &payload[8*k + 4]);
+    }
+    uart_result_send(uart_to_print, header, payload);
+    #endif
+
+}//end adc_test_export_test_returns
+
+//Histogram export: parameter frame and the count of every code as uint32
+static void adc_test_export_histogram_returns(ADC_Test_Histogram_Return_t *test_return, uart_inst_t *uart_to_print) {
+
+    static uint8_t payload[RESULT_FRAME_MAX_PAYLOAD_SIZE];
+    Result_Frame_Header_t header;
+    uint32_t data_length = 4*(uint32_t)test_return->number_of_codes;
+    uint32_t data_offset = 0;
+    uint16_t number_of_data_frames = (data_length + RESULT_FRAME_MAX_PAYLOAD_SIZE - 1)/RESULT_FRAME_MAX_PAYLOAD_SIZE;
+
+    header.test_type = RESULT_FRAME_TEST_ADC;
+    header.frame_count = number_of_data_frames + 1;
+    header.frame_index = 0;
+    header.record_type = RECORD_TEST_PARAMETER;
+    header.payload_length = adc_test_set_parameter_payload(payload, test_return->adc_sample_rate, test_return->number_of_samples,
+        test_return->dac_resolution_in_bits, test_return->dac_pwm_frequency, test_return->number_of_samples_per_ramp_step, 
+        test_return->number_of_samples_per_ramp, test_return->adc_resolution_in_bits, test_return->number_of_fifo_overflows,
+        test_return->number_of_conversion_errors, test_return->adc_effective_sample_rate);
+    uart_result_send(uart_to_print, header, payload);
+
+    //Every data frame holds RESULT_FRAME_MAX_PAYLOAD_SIZE/4 codes, code = (frame_index - 1)*RESULT_FRAME_MAX_PAYLOAD_SIZE/4 + position
+    header.record_type = RECORD_ADC_HISTOGRAM;
+    for(uint16_t f = 0; f < number_of_data_frames; f++) {
+
+        header.frame_index = f + 1;
+        header.payload_length = RESULT_FRAME_MAX_PAYLOAD_SIZE;
+        if((data_length - data_offset) < RESULT_FRAME_MAX_PAYLOAD_SIZE) {
+            header.payload_length = data_length - data_offset;
+        }
+        for(uint16_t k = 0; k < header.payload_length; k += 4) {
+            uint32_t_to_byte_array(test_return->histogram[(data_offset + k)/4], &payload[k]);
+        }
+
+        uart_result_send(uart_to_print, header, payload);
+        data_offset += header.payload_length;
+    }
+
+}//end adc_test_export_histogram_returns
+
+//Writes "<mean> +/- <2*std><separator>" like sprintf("%f +/- %f%c") without printf
+static uint16_t adc_test_format_mean_value(uint8_t *buffer, float mean_value, float std_deviation, char separator) {
+
+    uint16_t length = number_format_fixed(buffer, mean_value, 6);
+    length += number_format_string(&buffer[length], " +/- ");
+    length += number_format_fixed(&buffer[length], 2*std_deviation, 6);
+    length += number_format_char(&buffer[length], separator);
+    return length;
+
+}//end adc_test_format_mean_value
+
+//Resolution, oversampling and block size of one block p. ramp step, the block is captured within capture_window_us
+static int adc_test_setup_capture(ADC_Test_Structure_t *adc_tests, uint32_t capture_window_us, ADC_Test_Capture_t *capture) {
+
+    capture->samples_per_step = adc_tests->parameter.number_of_samples_per_ramp_step;
+    capture->decimation = 1;
+    capture->adc_resolution = (adc_tests->parameter.adc_resolution_in_bits == 12) ? 12 : 8;
+    capture->oversampling_ratio = 1;
+
+    if(capture->samples_per_step == 0 || capture->samples_per_step > MAX_ADC_SAMPLES_PER_RAMP_STEP || 
+        adc_tests->parameter.number_of_samples_per_ramp > MAX_ADC_SAMPLES_PER_RAMP || capture_window_us == 0) {
+        return -1; //Error: wrong test parameter
+    }
+
+    //12-bit mode: every sample is the average of oversampling_ratio ADC samples (boxcar), which gives about log2(ratio)/2 bits more
+    if(capture->adc_resolution == 12 && adc_tests->parameter.adc_oversampling_ratio > 1) {
+        capture->oversampling_ratio = adc_tests->parameter.adc_oversampling_ratio;
+    }
+    if(adc_set_resolution(capture->adc_resolution) < 0 || (capture->adc_resolution == 12 && adc_set_decimation(capture->oversampling_ratio, 1) < 0)) {
+        adc_set_resolution(8);
+        return -1; //Error: wrong test parameter (or adc in use)
     }
+    capture->sample_resolution = (capture->adc_resolution == 12) ? adc_get_decimated_resolution() : 8;
 
+    //The ADC samples samples_per_step*decimation*oversampling_ratio times in the window, 
+    //every decimation-th (averaged) sample is used (the ADC could not sample slower than ADC_MIN_SAMPLE_RATE)
+    while(((float)capture->samples_per_step*capture->decimation*capture->oversampling_ratio*1000000.0f)/capture_window_us < ADC_MIN_SAMPLE_RATE) {
+        capture->decimation++;
+    }
+    capture->block_size = capture->samples_per_step*capture->decimation*capture->oversampling_ratio;
+    capture->capture_sample_rate = ((float)capture->block_size*1000000.0f)/capture_window_us;
+    if(capture->block_size > ADC_TEST_MAX_BLOCK_SIZE || capture->capture_sample_rate > ADC_MAX_SAMPLE_RATE) {
+        adc_set_resolution(8);
+        return -1; //Error: wrong test parameter, the sample rate would be higher than the maximum rate of the ADC
+    }
+
+    //Biggest power of two FFT that fits into one step, the samples are shifted to use the Q15 range
+    capture->fft_size = 0;
+    capture->fft_shift = (capture->sample_resolution < 15) ? (15 - capture->sample_resolution) : 0;
     #ifdef USE_OPTIMIZED_SETUP
-    if(ms_waittime) {
-        wait_between_samples_ms = (uint32_t)(10/adc_tests.parameter.number_of_samples_per_ramp_step);
+    for(uint16_t fft_size = ADC_TEST_FFT_SIZE; fft_size >= FFT_MIN_SIZE; fft_size >>= 1) {
+        if(fft_size <= capture->samples_per_step) {
+            capture->fft_size = fft_size;
+            break;
+        }
     }
-    else {
-        //Else get µs wait time
-        wait_between_samples_us = (uint32_t)(10000/adc_tests.parameter.number_of_samples_per_ramp_step);
-        //HACK: The wait time needs to be changed because calculating mean value and standard deviation every 500 samples also takes time..., getting all the samples is to big of a array
-        wait_between_samples_us = wait_between_samples_us - 10;
+    memset(adc_test_spectrum_sum, 0, sizeof(adc_test_spectrum_sum));
+    #endif
+
+    return 1;
+
+}//end adc_test_setup_capture
+
+#ifdef USE_OPTIMIZED_SETUP
+//Adds the magnitude spectrum of the noise (samples - mean value) of one step to the spectrum sum
+static void adc_test_add_block_spectrum(ADC_Test_Capture_t *capture, const void *block, float mean_value) {
+
+    const uint16_t *block_16_bit = (const uint16_t*)block;
+    const uint8_t *block_8_bit = (const uint8_t*)block;
+    int32_t mean = (int32_t)(mean_value + 0.5f);
+
+    if(capture->fft_size == 0) {
+        return;
+    }
+
+    for(uint16_t s = 0; s < capture->fft_size; s++) {
+        int32_t sample = (capture->adc_resolution == 12) ? block_16_bit[s*capture->decimation] : block_8_bit[s*capture->decimation];
+        int32_t value = (sample - mean)*(1 << capture->fft_shift);
+        if(value > INT16_MAX) {
+            value = INT16_MAX;
+        }
+        else if(value < INT16_MIN) {
+            value = INT16_MIN;
+        }
+        adc_test_fft_real[s] = (int16_t)value;
+        adc_test_fft_imaginary[s] = 0;
+    }
+
+    fft_apply_hann_window(adc_test_fft_real, capture->fft_size);
+    fft_q15(adc_test_fft_real, adc_test_fft_imaginary, capture->fft_size);
+    fft_magnitude(adc_test_fft_real, adc_test_fft_imaginary, capture->fft_size/2, adc_test_fft_magnitude);
+    for(uint16_t k = 0; k < capture->fft_size/2; k++) {
+        adc_test_spectrum_sum[k] += adc_test_fft_magnitude[k];
+    }
+
+}//end adc_test_add_block_spectrum
+
+//Stores the biggest peaks of the averaged spectrum in the return structure
+static void adc_test_set_spectral_peaks(ADC_Test_Capture_t *capture, uint32_t number_of_steps, ADC_Test_Return_t *return_of_test) {
+
+    FFT_Peak_t peaks[ADC_TEST_NUMBER_OF_SPECTRAL_PEAKS];
+    uint8_t number_of_peaks = 0;
+    float volts_per_lsb = ADC_TEST_V_REF/(float)((1u << capture->sample_resolution) - 1);
+
+    return_of_test->fft_size = capture->fft_size;
+    if(capture->fft_size > 0 && number_of_steps > 0) {
+        number_of_peaks = fft_find_peaks(adc_test_spectrum_sum, capture->fft_size/2, peaks, ADC_TEST_NUMBER_OF_SPECTRAL_PEAKS);
+    }
+
+    //Sine amplitude is 4*|X[k]| (Hann window, FFT scaled by 1/fft_size)
+    for(uint8_t k = 0; k < number_of_peaks; k++) {
+        float magnitude = (float)peaks[k].magnitude/number_of_steps;
+        return_of_test->spectral_peak_frequency[k] = (peaks[k].bin*return_of_test->adc_sample_rate)/capture->fft_size;
+        return_of_test->spectral_peak_amplitude[k] = ((4.0f*magnitude)/(1u << capture->fft_shift))*volts_per_lsb;
+    }
+    return_of_test->number_of_spectral_peaks = number_of_peaks;
+
+}//end adc_test_set_spectral_peaks
+#endif
+
+//Stores the samples (or the statistic) of the completed block of ramp step k
+static void adc_test_process_block(ADC_Test_Capture_t *capture, uint32_t k, void *test_return) {
+
+    ADC_Test_Return_t *return_of_test = (ADC_Test_Return_t*)test_return;
+    uint16_t *block = adc_test_block_buffer[k%2];
+    const uint8_t *block_8_bit = (const uint8_t*)block;
+    uint32_t samples_per_step = capture->samples_per_step;
+    uint32_t decimation = capture->decimation;
+
+    //Average the oversampled block in place (the DMA writes the other buffer meanwhile)
+    if(capture->adc_resolution == 12) {
+        adc_decimate_block(block, capture->block_size, block);
+    }
+
+    #ifndef USE_OPTIMIZED_SETUP
+    //Store the samples directly in return structure
+    for(uint32_t s = 0; s < samples_per_step; s++) {
+        return_of_test->adc_samples[k*samples_per_step + s] = (capture->adc_resolution == 12) ? block[s*decimation] : block_8_bit[s*decimation];
     }
     #else
-        wait_between_samples_ms = (10/adc_tests.parameter.number_of_samples_per_ramp_step);
+    //Calculate mean value and standard deviation in one integer pass over the block (streaming statistics, no sample buffer)
+    Welford_Statistic_t step_statistic;
+    float volts_per_lsb = ADC_TEST_V_REF/(float)((1u << capture->sample_resolution) - 1);
+    welford_reset(&step_statistic);
+    if(capture->adc_resolution == 12) {
+        welford_add_block_16_bit(&step_statistic, block, samples_per_step, decimation);
+    }
+    else {
+        welford_add_block_8_bit(&step_statistic, block_8_bit, samples_per_step, decimation);
+    }
+    return_of_test->mean_value[k] = welford_get_mean_value(&step_statistic)*volts_per_lsb;
+    return_of_test->std_deviation[k] = welford_get_std_deviation(&step_statistic)*volts_per_lsb;
+    adc_test_add_block_spectrum(capture, block, welford_get_mean_value(&step_statistic));
+    #endif
+
+}//end adc_test_process_block
+
+static void adc_test_set_test_returns(ADC_Test_Structure_t *adc_tests, ADC_Test_Capture_t *capture, uint32_t block_overruns, ADC_Test_Return_t *return_of_test) {
+
+    return_of_test->adc_sample_rate = capture->capture_sample_rate/(capture->decimation*capture->oversampling_ratio);
+    return_of_test->adc_resolution_in_bits = capture->sample_resolution;
+    return_of_test->number_of_samples = adc_tests->parameter.number_of_samples_per_ramp*adc_tests->parameter.number_of_samples_per_ramp_step;
+    return_of_test->number_of_samples_per_ramp_step = adc_tests->parameter.number_of_samples_per_ramp_step;
+    return_of_test->number_of_samples_per_ramp = adc_tests->parameter.number_of_samples_per_ramp;
+    return_of_test->dac_pwm_frequency = adc_tests->parameter.dac_pwm_frequency;
+    return_of_test->dac_resolution_in_bits = adc_tests->parameter.dac_resolution_in_bits;
+    return_of_test->number_of_block_overruns = block_overruns;
+    return_of_test->number_of_fifo_overflows = capture->adc_statistic.fifo_overflows;
+    return_of_test->number_of_conversion_errors = capture->adc_statistic.conversion_errors;
+    return_of_test->adc_effective_sample_rate = capture->adc_statistic.effective_sample_rate;
+    #ifdef USE_OPTIMIZED_SETUP
+    adc_test_set_spectral_peaks(capture, return_of_test->number_of_samples_per_ramp, return_of_test);
     #endif
+
+}//end adc_test_set_test_returns
+
+//Called from the pwm wrap interrupt when the DAC step settled
+static void adc_test_dac_step_callback(uint16_t dac_step) {
+
+    if(adc_arm_block_capture() < 0) {
+        adc_test_missed_triggers++;
+    }
+
+}//end adc_test_dac_step_callback
+
+//Stores every sample of the completed block of ramp step k in the histogram
+static void adc_test_histogram_block(ADC_Test_Capture_t *capture, uint32_t k, void *test_return) {
+
+    ADC_Test_Histogram_Return_t *return_of_test = (ADC_Test_Histogram_Return_t*)test_return;
+    uint16_t *block = adc_test_block_buffer[k%2];
+
+    if(capture->adc_resolution == 12) {
+        histogram_add_block_16_bit(return_of_test->histogram, ADC_TEST_MAX_HISTOGRAM_CODES, block, capture->block_size, 1);
+    }
+    else {
+        histogram_add_block_8_bit(return_of_test->histogram, (const uint8_t*)block, capture->block_size, 1);
+    }
+
+}//end adc_test_histogram_block
+
+//Loopback measurement: DAC and ADC on the same board, every DAC step triggers one block that is passed to block_handler
+static int adc_test_run_loopback(ADC_Test_Structure_t *adc_tests, ADC_Test_Capture_t *capture, uint32_t number_of_blocks, 
+    ADC_Test_Block_Handler_t block_handler, void *test_return, bool use_watchdog, uint32_t *block_overruns) {
+
+    float pwm_period_us = 1000000.0f/adc_tests->parameter.dac_pwm_frequency;
+    uint32_t settle_cycles = (uint32_t)ceilf(adc_tests->parameter.dac_settle_time_us/pwm_period_us);
+    
+    //The block has to fit between the end of the settle time and the next step (one cycle for the latched level, one as margin)
+    float capture_window_us = ADC_TEST_RAMP_STEP_TIME_US - (settle_cycles + 2)*pwm_period_us;
+    if(capture_window_us <= 0) {
+        return -1; //Error: wrong test parameter, settle time is longer than the step
+    }
+    if(adc_test_setup_capture(adc_tests, (uint32_t)capture_window_us, capture) < 0) {
+        return -1; //Error: wrong test parameter
+    }
+
+    //DAC and ADC on the same board (output looped back to the ADC input)
+    if(configure_pwm_DAC(adc_tests->hardware.pwm_dac_pin, adc_tests->parameter.dac_pwm_clk_frequency, 
+    adc_tests->parameter.dac_pwm_frequency, adc_tests->parameter.dac_resolution_in_bits, false) < 0) {
+        adc_set_resolution(8);
+        return -2; //Error: DAC could not be configured
+    }
+    if(configure_adc_block_capture(adc_tests->hardware.adc_channel, capture->capture_sample_rate, adc_tests->hardware.dma_adc_capture_channel,
+    adc_tests->hardware.dma_adc_control_channel, adc_test_block_buffer[0], adc_test_block_buffer[1], capture->block_size, NULL) < 0) {
+        deconfigure_pwm(adc_tests->hardware.pwm_dac_pin);
+        adc_set_resolution(8);
+        return -2; //Error: ADC could not be configured
+    }
+    //Every DAC step arms one block after the settle time
+    adc_test_missed_triggers = 0;
+    if(pwm_dac_set_step_callback(settle_cycles, adc_test_dac_step_callback) < 0) {
+        deconfigure_adc();
+        deconfigure_pwm(adc_tests->hardware.pwm_dac_pin);
+        adc_set_resolution(8);
+        return -1; //Error: wrong test parameter, settle time is longer than the step
+    }
+
+    start_stop_pwm(adc_tests->hardware.pwm_dac_pin, true);
+
+    *block_overruns = 0;
+    for(uint32_t k = 0; k < number_of_blocks; k++) {
+
+        //Wait till the block of this step is complete
+        while(adc_get_block_count() <= k) {
+            if(use_watchdog) {
+                watchdog_update();
+            }
+            tight_loop_contents();
+        }
+        block_handler(capture, k, test_return);
+
+        if(adc_get_block_count() > (k + 1)) {
+            (*block_overruns)++;
+        }
+    }
+
+    start_stop_pwm(adc_tests->hardware.pwm_dac_pin, false);
+    pwm_dac_set_step_callback(0, NULL);
+    deconfigure_pwm(adc_tests->hardware.pwm_dac_pin);
+    adc_get_capture_statistic(&capture->adc_statistic);
+    deconfigure_adc();
+    adc_set_resolution(8);
+
+    //A trigger while the last block was still captured shifts the following steps
+    *block_overruns += adc_test_missed_triggers;
+
+    return 1;
+
+}//end adc_test_run_loopback
+
+//Function definition:
+
+int adc_test_main_read_ramp(ADC_Test_Structure_t adc_tests, ADC_Test_Return_t *return_of_test, bool use_watchdog) {
+
+    ADC_Test_Capture_t capture;
+    uint32_t block_overruns = 0;
+
+    if(adc_test_setup_capture(&adc_tests, ADC_TEST_RAMP_STEP_TIME_US, &capture) < 0) {
+        return -1; //Error: wrong test parameter
+    }
     
     //Configure UART for communication between main and sub
     configure_uart_hardware(adc_tests.hardware.uart_instance, adc_tests.hardware.uart_rx_pin, adc_tests.hardware.uart_tx_pin, 
     adc_tests.hardware.uart_baudrate, 8, 1, UART_PARITY_NONE, false, false, '\n');
 
-    //Configure ADC for single channel multi sample conversion mode
-    configure_adc_single_channel(adc_tests.hardware.adc_channel, adc_tests.parameter.adc_sample_rate, adc_tests.hardware.dma_adc_capture_channel,
-    adc_tests.hardware.dma_adc_control_channel);
+    //Configure ADC for double buffered block capture, the DMA fills one buffer while the other one is processed
+    if(configure_adc_block_capture(adc_tests.hardware.adc_channel, capture.capture_sample_rate, adc_tests.hardware.dma_adc_capture_channel,
+    adc_tests.hardware.dma_adc_control_channel, adc_test_block_buffer[0], adc_test_block_buffer[1], capture.block_size, NULL) < 0) {
+        deconfigure_uart_hardware(adc_tests.hardware.uart_instance);
+        adc_set_resolution(8);
+        return -2; //Error: ADC could not be configured
+    }
 
     uart_tx_data(adc_tests.hardware.uart_instance, "READY TO MEASURE!");
 
@@ -111,67 +554,91 @@ int adc_test_main_read_ramp(ADC_Test_Structure_t adc_tests, ADC_Test_Return_t *r
     }
     adc_start_measurement(true);
 
-    #ifndef USE_OPTIMIZED_SETUP     
-
-    //Get samples and store them directly in return structure
-    for(uint32_t s = 0; s < adc_tests.parameter.number_of_samples_per_ramp*adc_tests.parameter.number_of_samples_per_ramp_step; s++) {
-        adc_get_gpio_measurement(adc_tests.hardware.adc_gpio_pin, &return_of_test->adc_samples[s]);
-        if(use_watchdog) {
-            watchdog_update();
-        }
-        busy_wait_ms(wait_between_samples_ms); 
-    }
-    //HACK: Wait for another 20ms
-    busy_wait_us(20*1000);
-    #endif
-
-    #ifdef USE_OPTIMIZED_SETUP
     for(uint32_t k = 0; k < adc_tests.parameter.number_of_samples_per_ramp; k++) {
 
-        for(uint32_t s = 0; s < adc_tests.parameter.number_of_samples_per_ramp_step; s++) {
-            //Get samples
-            adc_get_gpio_measurement(adc_tests.hardware.adc_gpio_pin, &adc_sample_buffer_byte[s]);
-            adc_sample_buffer[s] = ((float)adc_sample_buffer_byte[s]*3.261)/255;
-
+        //Wait till the block of this step is complete
+        while(adc_get_block_count() <= k) {
             if(use_watchdog) {
                 watchdog_update();
             }
+            tight_loop_contents();
+        }
+        adc_test_process_block(&capture, k, return_of_test);
 
-            if(ms_waittime) {
-                busy_wait_ms(wait_between_samples_ms);
-            }
-            else {
-                busy_wait_us(wait_between_samples_us);
-            }
-             
+        //If the next block is complete already, the DMA has written into this buffer while it was processed
+        if(adc_get_block_count() > (k + 1)) {
+            block_overruns++;
         }
-        //Calculate mean value and standard deviation;
-        return_of_test->mean_value[k] = get_mean_value(adc_sample_buffer, MAX_ADC_SAMPLES_PER_RAMP_STEP);
-        return_of_test->std_deviation[k] = get_std_deviation(adc_sample_buffer, MAX_ADC_SAMPLES_PER_RAMP_STEP);
     }
-    //HACK: Wait for another 250ms
-    busy_wait_us(250*1000);
-   
-    #endif
 
     //TX back to sub that measurement is finished
     uart_tx_data(adc_tests.hardware.uart_instance, "FINISHED_MEASUREMENT");
     adc_start_measurement(false);
-    //Deconfigure ADC
+    adc_get_capture_statistic(&capture.adc_statistic);
+    //Deconfigure ADC, other users expect the default resolution
     deconfigure_adc();
+    adc_set_resolution(8);
     //Deconfigure UART after test
     deconfigure_uart_hardware(adc_tests.hardware.uart_instance);
 
-    return_of_test->adc_sample_rate = adc_tests.parameter.adc_sample_rate;
-    return_of_test->number_of_samples = adc_tests.parameter.number_of_samples_per_ramp*adc_tests.parameter.number_of_samples_per_ramp_step;
-    return_of_test->number_of_samples_per_ramp_step = adc_tests.parameter.number_of_samples_per_ramp_step;
-    return_of_test->number_of_samples_per_ramp = adc_tests.parameter.number_of_samples_per_ramp;
+    adc_test_set_test_returns(&adc_tests, &capture, block_overruns, return_of_test);
+
+    return 1;
+
+}//end adc_test_main_read_ramp
+
+int adc_test_loopback_read_ramp(ADC_Test_Structure_t adc_tests, ADC_Test_Return_t *return_of_test, bool use_watchdog) {
+
+    ADC_Test_Capture_t capture;
+    uint32_t block_overruns = 0;
+
+    int result = adc_test_run_loopback(&adc_tests, &capture, adc_tests.parameter.number_of_samples_per_ramp, adc_test_process_block, 
+        return_of_test, use_watchdog, &block_overruns);
+    if(result < 0) {
+        return result;
+    }
+    adc_test_set_test_returns(&adc_tests, &capture, block_overruns, return_of_test);
+
+    return 1;
+
+}//end adc_test_loopback_read_ramp
+
+int adc_test_loopback_histogram(ADC_Test_Structure_t adc_tests, ADC_Test_Histogram_Return_t *return_of_test, bool use_watchdog) {
+
+    ADC_Test_Capture_t capture;
+    uint32_t block_overruns = 0;
+    uint16_t number_of_ramps = (adc_tests.parameter.number_of_histogram_ramps > 0) ? adc_tests.parameter.number_of_histogram_ramps : 1;
+
+    //Code density of the raw ADC codes, no oversampling
+    adc_tests.parameter.adc_oversampling_ratio = 1;
+    memset(return_of_test->histogram, 0, sizeof(return_of_test->histogram));
+
+    int result = adc_test_run_loopback(&adc_tests, &capture, number_of_ramps*adc_tests.parameter.number_of_samples_per_ramp, 
+        adc_test_histogram_block, return_of_test, use_watchdog, &block_overruns);
+    if(result < 0) {
+        return result;
+    }
+
+    return_of_test->adc_sample_rate = capture.capture_sample_rate;
+    return_of_test->adc_resolution_in_bits = capture.adc_resolution;
+    return_of_test->number_of_codes = 1u << capture.adc_resolution;
+    return_of_test->number_of_samples = number_of_ramps*adc_tests.parameter.number_of_samples_per_ramp*capture.block_size;
+    return_of_test->number_of_samples_per_ramp_step = capture.block_size;
+    return_of_test->number_of_samples_per_ramp = number_of_ramps*adc_tests.parameter.number_of_samples_per_ramp;
     return_of_test->dac_pwm_frequency = adc_tests.parameter.dac_pwm_frequency;
     return_of_test->dac_resolution_in_bits = adc_tests.parameter.dac_resolution_in_bits;
+    return_of_test->number_of_block_overruns = block_overruns;
+    return_of_test->number_of_fifo_overflows = capture.adc_statistic.fifo_overflows;
+    return_of_test->number_of_conversion_errors = capture.adc_statistic.conversion_errors;
+    return_of_test->adc_effective_sample_rate = capture.adc_statistic.effective_sample_rate;
+    if(histogram_get_linearity(return_of_test->histogram, return_of_test->number_of_codes, &return_of_test->linearity) < 0) {
+        memset(&return_of_test->linearity, 0, sizeof(return_of_test->linearity));
+        return -3; //Error: ramp did not cover enough codes
+    }
 
     return 1;
 
-}//end adc_test_main_read_ramp
+}//end adc_test_loopback_histogram
 
 void adc_test_sub_ramp_output(ADC_Test_Structure_t adc_tests, bool use_watchdog) {
 
@@ -236,19 +703,26 @@ void adc_test_sub_ramp_output(ADC_Test_Structure_t adc_tests, bool use_watchdog)
 void adc_test_print_test_returns(ADC_Test_Return_t *test_return, uart_inst_t *uart_to_print, ADC_Test_Output_Format_t format) {
     
     uint8_t uart_tx_string[MAX_UART_DATA_SIZE];
+    uint16_t length = 0;
     uint8_t j = 0;
 
+    if(format.binary_export) {
+        adc_test_export_test_returns(test_return, uart_to_print);
+        return;
+    }
+
     uart_tx_data(uart_to_print, "#######################ADC-Test########################");
     uart_tx_data(uart_to_print, "");
     uart_tx_data(uart_to_print, "#################ADC-Test-Parameter:########################");
     sprintf(uart_tx_string, "DAC-Parameter: Resolution: %ld-Bit, PWM-Frequency: %f Hz, Hold-time: 10 ms", 
     test_return->dac_resolution_in_bits, test_return->dac_pwm_frequency);
     uart_tx_data(uart_to_print, uart_tx_string);
-    clear_uart_buffer(uart_tx_string);
-    sprintf(uart_tx_string, "ADC-Parameter: Resolution: 8-Bit, ADC-Sample-Rate: %f S/s, Samples-per-ramp-step: %ld, Samples-per-ramp: %ld", 
-    test_return->adc_sample_rate, test_return->number_of_samples_per_ramp_step, test_return->number_of_samples_per_ramp);
+    sprintf(uart_tx_string, "ADC-Parameter: Resolution: %ld-Bit, ADC-Sample-Rate: %f S/s, Samples-per-ramp-step: %ld, Samples-per-ramp: %ld, Block-overruns: %ld", 
+    test_return->adc_resolution_in_bits, test_return->adc_sample_rate, test_return->number_of_samples_per_ramp_step, test_return->number_of_samples_per_ramp, test_return->number_of_block_overruns);
+    uart_tx_data(uart_to_print, uart_tx_string);
+    sprintf(uart_tx_string, "ADC-Instrumentation: FIFO-overflows: %ld, Conversion-errors: %ld, Effective-ADC-Sample-Rate: %f S/s", 
+    test_return->number_of_fifo_overflows, test_return->number_of_conversion_errors, test_return->adc_effective_sample_rate);
     uart_tx_data(uart_to_print, uart_tx_string);
-    clear_uart_buffer(uart_tx_string);
     uart_tx_data(uart_to_print, "");
     uart_tx_data(uart_to_print, "##############Start-ADC-measurement-file###############");
     uart_tx_data(uart_to_print, "");
@@ -261,21 +735,24 @@ void adc_test_print_test_returns(ADC_Test_Return_t *test_return, uart_inst_t *ua
     for(uint32_t k = 0; k < test_return->number_of_samples_per_ramp; k++) {
 
         //Print the values
-        if(m < format.values_per_line) {
-            sprintf(uart_tx_string, "%f +/- %f%c", test_return->mean_value[k], 2*(test_return->std_deviation[k]), format.value_separator);
-            uart_tx_data_unterminated(uart_to_print, uart_tx_string);
-            clear_uart_buffer(uart_tx_string);
-            m++;
-        }
-        else {
+        if(m >= format.values_per_line) {
             uart_tx_data(uart_to_print, "");
-            sprintf(uart_tx_string, "%f +/- %f%c", test_return->mean_value[k], 2*(test_return->std_deviation[k]), format.value_separator);
-            uart_tx_data_unterminated(uart_to_print, uart_tx_string);
-            clear_uart_buffer(uart_tx_string);
-            m = 1;
+            m = 0;
         }
+        length = adc_test_format_mean_value(uart_tx_string, test_return->mean_value[k], test_return->std_deviation[k], format.value_separator);
+        uart_tx_bytes(uart_to_print, uart_tx_string, length);
+        m++;
 
     }
+
+    uart_tx_data(uart_to_print, "");
+    uart_tx_data(uart_to_print, "##############Spectral-peaks (frequency in Hz, amplitude in V):###############");
+    for(uint8_t k = 0; k < test_return->number_of_spectral_peaks; k++) {
+        length = number_format_fixed(uart_tx_string, test_return->spectral_peak_frequency[k], 1);
+        length += number_format_char(&uart_tx_string[length], format.value_separator);
+        length += number_format_fixed(&uart_tx_string[length], test_return->spectral_peak_amplitude[k], 6);
+        uart_tx_data(uart_to_print, uart_tx_string);
+    }
                 
     #endif
 
@@ -283,64 +760,43 @@ void adc_test_print_test_returns(ADC_Test_Return_t *test_return, uart_inst_t *ua
     if(format.print_raw_digital_values == true) {
 
         for(uint32_t k = 0; k < test_return->number_of_samples; k++) {
-            if(j < format.values_per_line) {  
-                sprintf(uart_tx_string, "%ld%c", test_return->adc_samples[k], format.value_separator);
-                uart_tx_data_unterminated(uart_to_print, uart_tx_string);
-                clear_uart_buffer(uart_tx_string);
-                j++;
-            }
-            else {
+            if(j >= format.values_per_line) {
                 uart_tx_data(uart_to_print, "");
-                sprintf(uart_tx_string, "%ld%c", test_return->adc_samples[k], format.value_separator);
-                uart_tx_data_unterminated(uart_to_print, uart_tx_string);
-                clear_uart_buffer(uart_tx_string);
                 j = 0;
-            } 
+            }
+            length = number_format_uint32(uart_tx_string, test_return->adc_samples[k]);
+            length += number_format_char(&uart_tx_string[length], format.value_separator);
+            uart_tx_bytes(uart_to_print, uart_tx_string, length);
+            j++;
         }
 
     }
     else {
 
-        float voltage = 0;
-        float voltage_samples_per_step[MAX_ADC_SAMPLES_PER_RAMP_STEP];
-        float mean_value = 0;
-        float std_deviation = 0;
+        float full_scale = (float)((1u << test_return->adc_resolution_in_bits) - 1);
+        Welford_Statistic_t step_statistic;
         uint8_t m = 0;
-        
+
+        welford_reset(&step_statistic);
         for(uint32_t k = 0; k < test_return->number_of_samples; k++) {
-            //Calculate voltage for every number of samples per ramp step and save them to buffer
-            if(j < test_return->number_of_samples_per_ramp_step) {
-                voltage = ((float)test_return->adc_samples[k]*3.261)/255;
-                voltage_samples_per_step[j] = voltage;
-                j++;
+
+            //Add the voltage of every sample to the statistic of its ramp step
+            welford_add_value(&step_statistic, ((float)test_return->adc_samples[k]*ADC_TEST_V_REF)/full_scale);
+            if(step_statistic.count < test_return->number_of_samples_per_ramp_step) {
+                continue;
             }
-            else {
-                
-                //Get mean and standard deviation for every ramp step
-                mean_value = get_mean_value(voltage_samples_per_step, test_return->number_of_samples_per_ramp_step);
-                std_deviation = get_std_deviation(voltage_samples_per_step, test_return->number_of_samples_per_ramp_step);
-
-                //Print the values
-                if(m < format.values_per_line) {
-                    sprintf(uart_tx_string, "%f +/- %f%c", mean_value, 2*std_deviation, format.value_separator);
-                    uart_tx_data_unterminated(uart_to_print, uart_tx_string);
-                    clear_uart_buffer(uart_tx_string);
-                    m++;
-                }
-                else {
-                    uart_tx_data(uart_to_print, "");
-                    sprintf(uart_tx_string, "%f +/- %f%c", mean_value, 2*std_deviation, format.value_separator);
-                    uart_tx_data_unterminated(uart_to_print, uart_tx_string);
-                    clear_uart_buffer(uart_tx_string);
-                    m = 1;
-                }
-
-                //Get  voltage from next sample
-                j = 0;
-                voltage = ((float)test_return->adc_samples[k]*3.261)/255;
-                voltage_samples_per_step[j] = voltage;
-                j++;
+
+            //Print the values
+            if(m >= format.values_per_line) {
+                uart_tx_data(uart_to_print, "");
+                m = 0;
             }
+            length = adc_test_format_mean_value(uart_tx_string, welford_get_mean_value(&step_statistic), welford_get_std_deviation(&step_statistic), 
+                format.value_separator);
+            uart_tx_bytes(uart_to_print, uart_tx_string, length);
+            m++;
+
+            welford_reset(&step_statistic);
         }
     }
     #endif
@@ -352,4 +808,54 @@ void adc_test_print_test_returns(ADC_Test_Return_t *test_return, uart_inst_t *ua
 
 }//end adc_test_print_test_returns
 
+void adc_test_print_histogram_returns(ADC_Test_Histogram_Return_t *test_return, uart_inst_t *uart_to_print, ADC_Test_Output_Format_t format) {
+
+    uint8_t uart_tx_string[MAX_UART_DATA_SIZE];
+    uint16_t length = 0;
+    Linearity_Result_t *linearity = &test_return->linearity;
+    float inl = 0;
+
+    if(format.binary_export) {
+        adc_test_export_histogram_returns(test_return, uart_to_print);
+        return;
+    }
+
+    uart_tx_data(uart_to_print, "#######################ADC-Histogram-Test########################");
+    uart_tx_data(uart_to_print, "");
+    sprintf(uart_tx_string, "DAC-Parameter: Resolution: %ld-Bit, PWM-Frequency: %f Hz, Hold-time: 10 ms", 
+    test_return->dac_resolution_in_bits, test_return->dac_pwm_frequency);
+    uart_tx_data(uart_to_print, uart_tx_string);
+    sprintf(uart_tx_string, "ADC-Parameter: Resolution: %ld-Bit, ADC-Sample-Rate: %f S/s, Samples: %ld, Ramp-steps: %ld, Block-overruns: %ld", 
+    test_return->adc_resolution_in_bits, test_return->adc_sample_rate, test_return->number_of_samples, test_return->number_of_samples_per_ramp, 
+    test_return->number_of_block_overruns);
+    uart_tx_data(uart_to_print, uart_tx_string);
+    sprintf(uart_tx_string, "ADC-Instrumentation: FIFO-overflows: %ld, Conversion-errors: %ld, Effective-ADC-Sample-Rate: %f S/s", 
+    test_return->number_of_fifo_overflows, test_return->number_of_conversion_errors, test_return->adc_effective_sample_rate);
+    uart_tx_data(uart_to_print, uart_tx_string);
+    sprintf(uart_tx_string, "Linearity (codes %d-%d): DNL: %f/%f LSB, INL: %f/%f LSB, Missing-codes: %d", linearity->first_code + 1, 
+    linearity->last_code - 1, linearity->min_dnl, linearity->max_dnl, linearity->min_inl, linearity->max_inl, linearity->number_of_missing_codes);
+    uart_tx_data(uart_to_print, uart_tx_string);
+    uart_tx_data(uart_to_print, "");
+    uart_tx_data(uart_to_print, "##############Start-ADC-histogram-file (code, count, DNL, INL)###############");
+
+    //DNL and INL p. code from the histogram, the INL is the sum of the DNL
+    for(uint16_t code = 0; code < test_return->number_of_codes; code++) {
+        float dnl = histogram_get_dnl(test_return->histogram, linearity, code);
+        inl += dnl;
+        length = number_format_uint32(uart_tx_string, code);
+        length += number_format_char(&uart_tx_string[length], format.value_separator);
+        length += number_format_uint32(&uart_tx_string[length], test_return->histogram[code]);
+        length += number_format_char(&uart_tx_string[length], format.value_separator);
+        length += number_format_fixed(&uart_tx_string[length], dnl, 3);
+        length += number_format_char(&uart_tx_string[length], format.value_separator);
+        number_format_fixed(&uart_tx_string[length], inl, 3);
+        uart_tx_data(uart_to_print, uart_tx_string);
+    }
+
+    uart_tx_data(uart_to_print, "");
+    uart_tx_data(uart_to_print, "##############End-ADC-histogram-file#################");
+    uart_tx_data(uart_to_print, "");
+
+}//end adc_test_print_histogram_returns
+
 //end file adc_test.c
\ No newline at end of file
@@ -0,0 +1,92 @@
+//File: fec_test.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    This is a handler for benchmarking the forward error correction (fec.h) of the optical UART link on the RP2040 (Cortex-M0+).
+
+    The test setup for FEC is:
+
+        -Only one Raspberry-Pi-Pico-Board is needed, the link errors are injected in software
+        -Random frames are encoded and decoded as result frames (result_frame.h, COBS and fec), the time for encoding and decoding
+         is measured (throughput in bytes/s)
+        -With the given probability a burst of wrong bytes (like a burst error during gradient switching) is written into a frame,
+         anywhere on the line including the zero delimiters
+        -Every frame is checked after decoding, frames that could not be corrected count as failed (would need a retransmission)
+        -The goodput is the payload that reaches the receiver per second on the link with the given baudrate,
+         failed frames are counted as retransmitted. It is compared to the goodput of the same link without fec,
+         where every frame with a wrong byte has to be retransmitted.
+        -The encoding is done while the previous frame is sent, so the link is limited by the slower of both
+        -The fec configuration of the result export is set for the test and reset to no fec afterwards
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+#include "result_frame.h" //Result frames with fec (fec.h)
+
+//Preprocessor constants:
+#define MAX_FEC_TEST_FRAME_SIZE 1024
+
+//Type definitions:
+
+typedef struct FEC_Test_Parameter_s {
+
+    //Parameters of the test
+
+    //FEC configuration (parity bytes p. codeword and interleave depth)
+    Fec_Config_t fec_config;
+    //Number of payload bytes p. frame and number of frames p. test
+    uint16_t frame_size;
+    uint16_t number_of_frames;
+    //Number of wrong bytes in a row and probability (in percent) that a frame gets a burst
+    uint16_t burst_length;
+    uint8_t burst_probability;
+    //Baudrate of the link for the goodput
+    uint32_t link_baud_rate;
+
+}FEC_Test_Parameter_t;
+
+typedef struct FEC_Test_Structure_s {
+
+    FEC_Test_Parameter_t parameter;
+
+}FEC_Test_Structure_t;
+
+typedef struct FEC_Test_Return_s {
+
+    FEC_Test_Parameter_t parameter;
+    uint32_t encoded_frame_size;
+    //Sum of the time for encoding and decoding of all frames
+    uint64_t encode_time_us;
+    uint64_t decode_time_us;
+    //Bytes (payload) p. second
+    float encode_throughput;
+    float decode_throughput;
+    //Frames with a burst, frames with a burst that were corrected, frames that could not be corrected
+    uint32_t frames_with_errors;
+    uint32_t frames_corrected;
+    uint32_t frames_failed;
+    uint32_t corrected_bytes;
+    //Payload bytes p. second on the link
+    float goodput_with_fec;
+    float goodput_without_fec;
+
+}FEC_Test_Return_t;
+
+//Function Prototypes:
+
+int fec_test_main(FEC_Test_Structure_t fec_tests, FEC_Test_Return_t *return_of_test, bool use_watchdog);
+void fec_test_print_test_returns(FEC_Test_Return_t *test_return, uint8_t num_of_tests, uart_inst_t *uart_to_print);
+
+//end file fec_test.h
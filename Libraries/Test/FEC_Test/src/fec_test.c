@@ -0,0 +1,216 @@
+//File: fec_test.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Benchmark of the forward error correction (fec.h) with injected burst errors.
+    The frames take the full path of the result export: result_frame_encode(), burst on the line (delimiters included), split on the
+    zero bytes like the receiver does and result_frame_decode(). Measures encode/decode throughput on the RP2040 and calculates
+    the goodput of the link with and without fec.
+
+*/
+
+
+//Corresponding header-file:
+#include "fec_test.h"
+
+//Libraries:
+
+//Standard-C:
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+#include "pico/rand.h"
+
+//Pico Hardware-Libraries:
+#include "hardware/watchdog.h"
+
+//Own Libraries:
+#include "uart.h"
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+static uint8_t tx_frame[MAX_FEC_TEST_FRAME_SIZE];
+static uint8_t rx_frame[MAX_FEC_TEST_FRAME_SIZE];
+static uint8_t encoded_frame[RESULT_FRAME_MAX_ENCODED_SIZE];
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Time in us to send an encoded frame of the given size (10 bit p. byte)
+static float fec_test_get_link_time_us(uint32_t encoded_size, uint32_t baud_rate) {
+
+    return ((float)encoded_size*10.0f*1000000.0f)/(float)baud_rate;
+
+}//end fec_test_get_link_time_us
+
+//Receiver: splits the encoded frame on the zero bytes once and decodes every segment once (a frame with a corrupted delimiter is lost)
+static int fec_test_receive_frame(const uint8_t *frame, uint32_t frame_length, Result_Frame_Header_t *header, uint8_t *payload) {
+
+    uint32_t segment_start = 0;
+    int ret = -1;
+
+    for(uint32_t k = 0; k <= frame_length; k++) {
+        if(k < frame_length && frame[k] != 0) {
+            continue;
+        }
+        uint32_t segment_length = k - segment_start;
+        if(segment_length > 0) {
+            ret = result_frame_decode(&frame[segment_start], segment_length, header, payload);
+            if(ret >= 0) {
+                return ret;
+            }
+        }
+        segment_start = k + 1;
+    }
+
+    return ret;
+
+}//end fec_test_receive_frame
+
+//Function definition:
+
+int fec_test_main(FEC_Test_Structure_t fec_tests, FEC_Test_Return_t *return_of_test, bool use_watchdog) {
+
+    FEC_Test_Parameter_t parameter = fec_tests.parameter;
+    Result_Frame_Header_t header = {RESULT_FRAME_TEST_UART, RECORD_TRANSFER, 0, 0, 0};
+    Result_Frame_Header_t rx_header;
+    uint64_t start_time = 0;
+    uint32_t corrected_bytes = 0;
+    int encoded_length = 0;
+    int decoded_length = 0;
+
+    if(parameter.frame_size == 0 || parameter.frame_size > MAX_FEC_TEST_FRAME_SIZE || parameter.number_of_frames == 0 || parameter.link_baud_rate == 0) {
+        return -1; //Error: wrong test parameter
+    }
+
+    if(result_frame_set_fec(parameter.fec_config) < 0) {
+        return -2; //Error: wrong fec configuration for this frame size
+    }
+
+    //Clear return
+    memset(return_of_test, 0, sizeof(FEC_Test_Return_t));
+    return_of_test->parameter = parameter;
+
+    //Get random seed for rng
+    uint32_t rng_seed = get_rand_32();
+    //Set rng with seed
+    srand((unsigned int)rng_seed);
+
+    header.frame_count = parameter.number_of_frames;
+    header.payload_length = parameter.frame_size;
+    corrected_bytes = result_frame_get_corrected_bytes();
+
+    for(uint16_t f = 0; f < parameter.number_of_frames; f++) {
+
+        for(uint16_t k = 0; k < parameter.frame_size; k++) {
+            tx_frame[k] = (uint8_t)rand();
+        }
+        header.frame_index = f;
+
+        start_time = time_us_64();
+        encoded_length = result_frame_encode(header, tx_frame, encoded_frame);
+        return_of_test->encode_time_us += time_us_64() - start_time;
+        //The COBS encoding adds a few bytes depending on the data, the largest frame is reported
+        if((uint32_t)encoded_length > return_of_test->encoded_frame_size) {
+            return_of_test->encoded_frame_size = (uint32_t)encoded_length;
+        }
+
+        //Inject burst error, anywhere on the line (delimiters included)
+        bool burst = ((uint8_t)(rand()%100) < parameter.burst_probability) && parameter.burst_length > 0;
+        if(burst) {
+            uint32_t burst_length = (parameter.burst_length < encoded_length) ? parameter.burst_length : (uint32_t)encoded_length;
+            uint32_t burst_start = rand()%((uint32_t)encoded_length - burst_length + 1);
+            for(uint32_t k = burst_start; k < (burst_start + burst_length); k++) {
+                encoded_frame[k] ^= (uint8_t)((rand()%255) + 1);
+            }
+            return_of_test->frames_with_errors++;
+        }
+
+        start_time = time_us_64();
+        decoded_length = fec_test_receive_frame(encoded_frame, (uint32_t)encoded_length, &rx_header, rx_frame);
+        return_of_test->decode_time_us += time_us_64() - start_time;
+
+        if(decoded_length != parameter.frame_size || rx_header.frame_index != f || memcmp(tx_frame, rx_frame, parameter.frame_size) != 0) {
+            return_of_test->frames_failed++;
+        }
+        else if(burst) {
+            return_of_test->frames_corrected++;
+        }
+
+        if(use_watchdog) {
+            watchdog_update();
+        }
+    }
+
+    return_of_test->corrected_bytes = result_frame_get_corrected_bytes() - corrected_bytes;
+    //Result export without fec again (default)
+    result_frame_set_fec((Fec_Config_t){0, 0});
+
+    uint32_t payload_bytes = (uint32_t)parameter.frame_size*parameter.number_of_frames;
+    if(return_of_test->encode_time_us > 0) {
+        return_of_test->encode_throughput = ((float)payload_bytes*1000000.0f)/(float)return_of_test->encode_time_us;
+    }
+    if(return_of_test->decode_time_us > 0) {
+        return_of_test->decode_throughput = ((float)payload_bytes*1000000.0f)/(float)return_of_test->decode_time_us;
+    }
+
+    //Goodput: encoding runs while the previous frame is sent, the slower one limits the link
+    float frame_time_fec = fec_test_get_link_time_us(return_of_test->encoded_frame_size, parameter.link_baud_rate);
+    float encode_time_p_frame = (float)return_of_test->encode_time_us/(float)parameter.number_of_frames;
+    if(encode_time_p_frame > frame_time_fec) {
+        frame_time_fec = encode_time_p_frame;
+    }
+    float frame_time_plain = fec_test_get_link_time_us(COBS_MAX_ENCODED_LENGTH(parameter.frame_size + RESULT_FRAME_HEADER_SIZE + RESULT_FRAME_CRC_SIZE) + 2,
+    parameter.link_baud_rate);
+
+    return_of_test->goodput_with_fec = ((float)parameter.frame_size*(parameter.number_of_frames - return_of_test->frames_failed)*1000000.0f)/
+    (frame_time_fec*parameter.number_of_frames);
+    return_of_test->goodput_without_fec = ((float)parameter.frame_size*(parameter.number_of_frames - return_of_test->frames_with_errors)*1000000.0f)/
+    (frame_time_plain*parameter.number_of_frames);
+
+    return 1;
+
+}//end fec_test_main
+
+void fec_test_print_test_returns(FEC_Test_Return_t *test_return, uint8_t num_of_tests, uart_inst_t *uart_to_print) {
+
+    uint8_t out_buff[MAX_UART_DATA_SIZE];
+
+    uart_tx_data(uart_to_print, "#################FEC-Test-Result-Print:######################");
+    uart_tx_data(uart_to_print, "");
+
+    for(uint8_t n = 0; n < num_of_tests; n++) {
+
+        sprintf(out_buff, "########################FEC-Test Nr: %ld############################", n+1);
+        uart_tx_data(uart_to_print, out_buff);
+        uart_tx_data(uart_to_print, "#################FEC-Test-Parameter:#######################");
+        sprintf(out_buff, "Parity bytes: %ld, Interleave depth: %ld, Frame size: %ld, Encoded frame size: %ld, Frames: %ld",
+        test_return[n].parameter.fec_config.num_of_parity_bytes, test_return[n].parameter.fec_config.interleave_depth,
+        test_return[n].parameter.frame_size, test_return[n].encoded_frame_size, test_return[n].parameter.number_of_frames);
+        uart_tx_data(uart_to_print, out_buff);
+        sprintf(out_buff, "Burst length: %ld Bytes, Burst probability: %ld%c, Link baudrate: %ld", test_return[n].parameter.burst_length,
+        test_return[n].parameter.burst_probability, '%', test_return[n].parameter.link_baud_rate);
+        uart_tx_data(uart_to_print, out_buff);
+        uart_tx_data(uart_to_print, "#################FEC-Test-Result:#######################");
+        sprintf(out_buff, "Encode throughput: %f Bytes/s, Decode throughput: %f Bytes/s", test_return[n].encode_throughput, test_return[n].decode_throughput);
+        uart_tx_data(uart_to_print, out_buff);
+        sprintf(out_buff, "Frames with errors: %ld, Frames corrected: %ld, Frames failed: %ld, Bytes corrected: %ld", test_return[n].frames_with_errors,
+        test_return[n].frames_corrected, test_return[n].frames_failed, test_return[n].corrected_bytes);
+        uart_tx_data(uart_to_print, out_buff);
+        sprintf(out_buff, "Goodput with FEC: %f Bytes/s, Goodput without FEC: %f Bytes/s", test_return[n].goodput_with_fec, test_return[n].goodput_without_fec);
+        uart_tx_data(uart_to_print, out_buff);
+        uart_tx_data(uart_to_print, "");
+    }
+
+}//end fec_test_print_test_returns
+
+//end file fec_test.c
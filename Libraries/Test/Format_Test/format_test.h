@@ -0,0 +1,82 @@
+//File: format_test.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    This is a handler for benchmarking the printf-free number formatting (number_format.h) against sprintf on the RP2040 (Cortex-M0+).
+
+    The test setup for the formatting is:
+
+        -Only one Raspberry-Pi-Pico-Board is needed, nothing is sent during the measurement
+        -Random values are formatted in the same way as the test result printers do it:
+            Float:  "%f +/- %f%c" (mean value and deviation of the ADC-Test)
+            Int:    "%ld%c" (raw ADC samples)
+            Hex:    "TX: 0x%02X RX: 0x%02X%c" (SPI- and UART-Test bytes)
+        -Every format is timed once with sprintf and once with number_format (characters p. second)
+        -After the timing both outputs are compared, every value with a different text counts as mismatch
+
+*/
+
+//Libraries:
+
+//Standard-C:
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h" //Pico Standard-Lib for pico specific datatypes in function prototypes
+
+//Pico Hardware-Libraries:
+
+//Own Libraries:
+#include "number_format.h"
+
+//Preprocessor constants:
+#define MAX_FORMAT_TEST_VALUES 512
+#define FORMAT_TEST_NUM_OF_FORMATS 3
+
+//Type definitions:
+
+typedef enum Format_Test_Format_e {
+    FORMAT_TEST_FLOAT = 0,
+    FORMAT_TEST_INT,
+    FORMAT_TEST_HEX
+}Format_Test_Format_t;
+
+typedef struct Format_Test_Parameter_s {
+
+    //Parameters of the test
+
+    //Number of formatted values p. format
+    uint16_t number_of_values;
+    //Random float values are between 0 and max_float_value (e.g. 3.3 V for ADC results)
+    float max_float_value;
+
+}Format_Test_Parameter_t;
+
+typedef struct Format_Test_Structure_s {
+
+    Format_Test_Parameter_t parameter;
+
+}Format_Test_Structure_t;
+
+typedef struct Format_Test_Return_s {
+
+    Format_Test_Parameter_t parameter;
+    //Sum of the formatting time of all values p. format
+    uint64_t sprintf_time_us[FORMAT_TEST_NUM_OF_FORMATS];
+    uint64_t number_format_time_us[FORMAT_TEST_NUM_OF_FORMATS];
+    //Characters p. second
+    float sprintf_throughput[FORMAT_TEST_NUM_OF_FORMATS];
+    float number_format_throughput[FORMAT_TEST_NUM_OF_FORMATS];
+    //Values with a different text than sprintf
+    uint32_t mismatches[FORMAT_TEST_NUM_OF_FORMATS];
+
+}Format_Test_Return_t;
+
+//Function Prototypes:
+
+int format_test_main(Format_Test_Structure_t format_tests, Format_Test_Return_t *return_of_test, bool use_watchdog);
+void format_test_print_test_returns(Format_Test_Return_t *test_return, uint8_t num_of_tests, uart_inst_t *uart_to_print);
+
+//end file format_test.h
@@ -0,0 +1,206 @@
+//File: format_test.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Benchmark of the printf-free number formatting (number_format.h) against sprintf.
+    Measures the characters p. second of both for the formats of the test result printers and checks that both write the same text.
+
+*/
+
+
+//Corresponding header-file:
+#include "format_test.h"
+
+//Libraries:
+
+//Standard-C:
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Pico:
+
+//Pico High-LvL-Libraries:
+#include "pico/stdlib.h"
+#include "pico/rand.h"
+
+//Pico Hardware-Libraries:
+#include "hardware/watchdog.h"
+
+//Own Libraries:
+#include "uart.h"
+
+//Preprocessor constants:
+#define FORMAT_TEST_MAX_TEXT_LENGTH 64
+#define FORMAT_TEST_SEPARATOR ','
+
+//File global (static) variables:
+
+static float float_values[MAX_FORMAT_TEST_VALUES][2];
+static uint32_t int_values[MAX_FORMAT_TEST_VALUES];
+static uint8_t byte_values[MAX_FORMAT_TEST_VALUES][2];
+
+static const char *format_test_format_names[FORMAT_TEST_NUM_OF_FORMATS] = {
+    "Float '%f +/- %f%c'", "Int '%ld%c'", "Hex 'TX: 0x%02X RX: 0x%02X%c'"
+};
+
+//Functions:
+
+//File global (static) function definitions:
+
+static uint16_t format_test_sprintf(Format_Test_Format_t format, uint16_t k, char *buffer) {
+
+    switch(format) {
+        case FORMAT_TEST_FLOAT:
+            return (uint16_t)sprintf(buffer, "%f +/- %f%c", float_values[k][0], 2*float_values[k][1], FORMAT_TEST_SEPARATOR);
+        case FORMAT_TEST_INT:
+            return (uint16_t)sprintf(buffer, "%ld%c", int_values[k], FORMAT_TEST_SEPARATOR);
+        case FORMAT_TEST_HEX:
+            return (uint16_t)sprintf(buffer, "TX: 0x%02X RX: 0x%02X%c", byte_values[k][0], byte_values[k][1], FORMAT_TEST_SEPARATOR);
+        default:
+            return 0;
+    }
+
+}//end format_test_sprintf
+
+static uint16_t format_test_number_format(Format_Test_Format_t format, uint16_t k, uint8_t *buffer) {
+
+    uint16_t length = 0;
+
+    switch(format) {
+        case FORMAT_TEST_FLOAT:
+            length = number_format_fixed(buffer, float_values[k][0], 6);
+            length += number_format_string(&buffer[length], " +/- ");
+            length += number_format_fixed(&buffer[length], 2*float_values[k][1], 6);
+            break;
+        case FORMAT_TEST_INT:
+            length = number_format_uint32(buffer, int_values[k]);
+            break;
+        case FORMAT_TEST_HEX:
+            length = number_format_string(buffer, "TX: 0x");
+            length += number_format_hex8(&buffer[length], byte_values[k][0]);
+            length += number_format_string(&buffer[length], " RX: 0x");
+            length += number_format_hex8(&buffer[length], byte_values[k][1]);
+            break;
+        default:
+            return 0;
+    }
+    length += number_format_char(&buffer[length], FORMAT_TEST_SEPARATOR);
+
+    return length;
+
+}//end format_test_number_format
+
+//Function definition:
+
+int format_test_main(Format_Test_Structure_t format_tests, Format_Test_Return_t *return_of_test, bool use_watchdog) {
+
+    Format_Test_Parameter_t parameter = format_tests.parameter;
+    char sprintf_text[FORMAT_TEST_MAX_TEXT_LENGTH];
+    uint8_t number_format_text[FORMAT_TEST_MAX_TEXT_LENGTH];
+    uint64_t start_time = 0;
+
+    if(parameter.number_of_values == 0 || parameter.number_of_values > MAX_FORMAT_TEST_VALUES || !(parameter.max_float_value > 0) ||
+    parameter.max_float_value > 1000000.0f) {
+        return -1; //Error: wrong test parameter
+    }
+
+    //Clear return
+    memset(return_of_test, 0, sizeof(Format_Test_Return_t));
+    return_of_test->parameter = parameter;
+
+    //Get random seed for rng
+    uint32_t rng_seed = get_rand_32();
+    //Set rng with seed
+    srand((unsigned int)rng_seed);
+
+    //Values like the ADC-Test results: mean value in the range and a small deviation, 8-bit samples are extended to the full 32-bit range
+    for(uint16_t k = 0; k < parameter.number_of_values; k++) {
+        float_values[k][0] = ((float)rand()/(float)RAND_MAX)*parameter.max_float_value;
+        float_values[k][1] = ((float)rand()/(float)RAND_MAX)*parameter.max_float_value*0.01f;
+        int_values[k] = (uint32_t)rand() >> (rand()%32);
+        byte_values[k][0] = (uint8_t)rand();
+        byte_values[k][1] = (uint8_t)rand();
+    }
+
+    for(uint8_t f = 0; f < FORMAT_TEST_NUM_OF_FORMATS; f++) {
+
+        uint32_t sprintf_characters = 0;
+        uint32_t number_format_characters = 0;
+
+        start_time = time_us_64();
+        for(uint16_t k = 0; k < parameter.number_of_values; k++) {
+            sprintf_characters += format_test_sprintf((Format_Test_Format_t)f, k, sprintf_text);
+        }
+        return_of_test->sprintf_time_us[f] = time_us_64() - start_time;
+
+        if(use_watchdog) {
+            watchdog_update();
+        }
+
+        start_time = time_us_64();
+        for(uint16_t k = 0; k < parameter.number_of_values; k++) {
+            number_format_characters += format_test_number_format((Format_Test_Format_t)f, k, number_format_text);
+        }
+        return_of_test->number_format_time_us[f] = time_us_64() - start_time;
+
+        //Check the text of every value (not timed)
+        for(uint16_t k = 0; k < parameter.number_of_values; k++) {
+            format_test_sprintf((Format_Test_Format_t)f, k, sprintf_text);
+            format_test_number_format((Format_Test_Format_t)f, k, number_format_text);
+            if(strcmp(sprintf_text, (char*)number_format_text) != 0) {
+                return_of_test->mismatches[f]++;
+            }
+        }
+
+        if(return_of_test->sprintf_time_us[f] > 0) {
+            return_of_test->sprintf_throughput[f] = ((float)sprintf_characters*1000000.0f)/(float)return_of_test->sprintf_time_us[f];
+        }
+        if(return_of_test->number_format_time_us[f] > 0) {
+            return_of_test->number_format_throughput[f] = ((float)number_format_characters*1000000.0f)/
+            (float)return_of_test->number_format_time_us[f];
+        }
+
+        if(use_watchdog) {
+            watchdog_update();
+        }
+    }
+
+    return 1;
+
+}//end format_test_main
+
+void format_test_print_test_returns(Format_Test_Return_t *test_return, uint8_t num_of_tests, uart_inst_t *uart_to_print) {
+
+    uint8_t out_buff[MAX_UART_DATA_SIZE];
+
+    uart_tx_data(uart_to_print, "###############Format-Test-Result-Print:#####################");
+    uart_tx_data(uart_to_print, "");
+
+    for(uint8_t n = 0; n < num_of_tests; n++) {
+
+        sprintf(out_buff, "#######################Format-Test Nr: %ld###########################", n+1);
+        uart_tx_data(uart_to_print, out_buff);
+        uart_tx_data(uart_to_print, "################Format-Test-Parameter:######################");
+        sprintf(out_buff, "Values p. format: %ld, Max. float value: %f", test_return[n].parameter.number_of_values,
+        test_return[n].parameter.max_float_value);
+        uart_tx_data(uart_to_print, out_buff);
+        uart_tx_data(uart_to_print, "################Format-Test-Result:######################");
+
+        for(uint8_t f = 0; f < FORMAT_TEST_NUM_OF_FORMATS; f++) {
+            float speedup = 0;
+            if(test_return[n].number_format_time_us[f] > 0) {
+                speedup = (float)test_return[n].sprintf_time_us[f]/(float)test_return[n].number_format_time_us[f];
+            }
+            sprintf(out_buff, "%s: sprintf: %ld us (%f chars/s), number_format: %ld us (%f chars/s), Speedup: %f, Mismatches: %ld",
+            format_test_format_names[f], (uint32_t)test_return[n].sprintf_time_us[f], test_return[n].sprintf_throughput[f],
+            (uint32_t)test_return[n].number_format_time_us[f], test_return[n].number_format_throughput[f], speedup, test_return[n].mismatches[f]);
+            uart_tx_data(uart_to_print, out_buff);
+        }
+        uart_tx_data(uart_to_print, "");
+    }
+
+}//end format_test_print_test_returns
+
+//end file format_test.c
@@ -82,6 +82,8 @@ typedef struct SPI_Test_Output_Format_s {
 
     uint8_t separator;
     uint8_t bytes_per_line;
+    //Export results as binary frames (COBS, CRC-32) instead of text, see result_frame.h
+    bool binary_export;
 
 }SPI_Test_Output_Format_t;
 
@@ -40,7 +40,7 @@
 
 //Utility:
 #include "data_to_byte.h"
-#include "statistic.h"
+#include "ramp_codec.h"
 
 //Hardware:
 #include "uart.h"
@@ -49,6 +49,13 @@
 
 //Preprocessor constants:
 
+//Buffer for the adc samples of one flash write: format byte and coded or raw 16-bit samples (write_bytes_to_flash() writes up to 65535 bytes)
+#define ADC_RAMP_CODED_FLASH_SIZE (1 + 2*MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP)
+
+//Format of the adc samples in flash (first byte), noisy captures that do not code smaller than raw are stored raw
+#define ADC_FLASH_FORMAT_RAMP_CODED 1
+#define ADC_FLASH_FORMAT_RAW 2
+
 //File global (static) variables:
 
 //Functions:
@@ -306,14 +313,29 @@ int print_settings(Test_Suite_Settings_t settings, uart_inst_t *uart_to_print) {
 
 }//end print_settings
 
+//Start of the background system monitor for get_system_parameters()
+int init_system_parameters(void) {
+
+    int return_value = adc_system_monitor_start(SYSTEM_PARAMETER_MONITOR_PERIOD_MS);
+    if(return_value == -2) {
+        return 1; //Monitor is running already
+    }
+
+    return return_value;
+
+}//end init_system_parameters
+
 //Get system parameter function
 int get_system_parameters(System_Parameters_t *system_parameters) {
     
+    //VSYS (channel 3) and temperature sensor (channel 4) are sampled together in one 12-bit round-robin block
+    static uint16_t system_parameter_blocks[2][2*NUM_OF_SAMPLES_SYSTEM_PARAMETER];
+    uint adc_channels[2] = {3, 4};
     uint16_t temperature_samples_bytes[NUM_OF_SAMPLES_SYSTEM_PARAMETER];
-    uint8_t system_voltage_samples_bytes[NUM_OF_SAMPLES_SYSTEM_PARAMETER];
+    uint16_t system_voltage_samples_bytes[NUM_OF_SAMPLES_SYSTEM_PARAMETER];
+    void *channel_samples[MAX_ADC_CHANNELS] = {NULL, NULL, NULL, system_voltage_samples_bytes, temperature_samples_bytes};
     
     float temperature_samples[NUM_OF_SAMPLES_SYSTEM_PARAMETER];
-    float temp_test_samples[NUM_OF_SAMPLES_SYSTEM_PARAMETER];
     float system_voltage_samples[NUM_OF_SAMPLES_SYSTEM_PARAMETER];
 
     float temperature_mean = 0;
@@ -322,42 +344,52 @@ int get_system_parameters(System_Parameters_t *system_parameters) {
     float vsys_sigma = 0;
 
     int return_value = 0;
+    uint8_t caller_resolution = adc_get_resolution();
+    ADC_System_Monitor_Statistic_t monitor_statistic;
+
+    system_parameters->system_clock_frequency = (float)clock_get_hz(clk_sys);
 
-    //Configure adc as single channel
-    return_value = configure_adc_single_channel(3, 500*1000, 0, 1);
+    //Rolling statistic of the background monitor (O(1), sampled in the gaps between the ADC captures)
+    if(adc_system_monitor_get_statistic(&monitor_statistic) > 0 && monitor_statistic.number_of_samples >= SYSTEM_PARAMETER_MIN_MONITOR_SAMPLES) {
+        float volts_per_lsb = 3.261/4095;
+        system_parameters->system_voltage = monitor_statistic.vsys_mean_value*volts_per_lsb*3;
+        system_parameters->sigma_system_voltage = monitor_statistic.vsys_std_deviation*volts_per_lsb*3;
+        system_parameters->system_temperature = 27 - (monitor_statistic.temperature_mean_value*volts_per_lsb - 0.706)/0.001721;
+        system_parameters->sigma_system_temperature = (monitor_statistic.temperature_std_deviation*volts_per_lsb)/0.001721;
+        return 1;
+    }
+    //Monitor is not running (see init_system_parameters()) or has to few samples yet: measure once with a block capture
+    //Configure adc for a multi channel block capture, 100 kS/s p. channel
+    return_value = adc_set_resolution(12);
     if(return_value < 0) {
         return return_value;
     }
+    return_value = configure_adc_multi_channel_block_capture(adc_channels, 2, 100*1000, 0, 1, system_parameter_blocks[0], system_parameter_blocks[1], 
+        2*NUM_OF_SAMPLES_SYSTEM_PARAMETER, NULL);
+    if(return_value < 0) {
+        adc_set_resolution(caller_resolution);
+        return return_value;
+    }
 
     adc_start_measurement(true);
-    busy_wait_us_32(2);
-    for(uint16_t k = 0; k < NUM_OF_SAMPLES_SYSTEM_PARAMETER; k++) {
-        adc_get_gpio_measurement(29, &system_voltage_samples_bytes[k]);
-        busy_wait_us_32(4);
+    while(adc_get_block_count() == 0) {
+        tight_loop_contents();
     }
     adc_start_measurement(false);
 
+    adc_deinterleave_block(system_parameter_blocks[0], 2*NUM_OF_SAMPLES_SYSTEM_PARAMETER, channel_samples);
+
     return_value = deconfigure_adc();
+    //The resolution of the caller is set again for its following configurations
+    adc_set_resolution(caller_resolution);
     if(return_value < 0) {
         return return_value;
     }
-   
-    adc_init();
-    adc_set_temp_sensor_enabled(true);
-    adc_select_input(4);
-
-    for(uint16_t p = 0; p < NUM_OF_SAMPLES_SYSTEM_PARAMETER; p++) {
-        float temp_volt = 0;
-        temperature_samples_bytes[p] = adc_read();
-        busy_wait_us_32(4);
-    }
 
-    adc_set_temp_sensor_enabled(false);
-    
     for(uint16_t k = 0; k < NUM_OF_SAMPLES_SYSTEM_PARAMETER; k++) {
 
         float temp_voltage = 0;
-        system_voltage_samples[k] = (((float)(system_voltage_samples_bytes[k])*3.261*3)/(255));
+        system_voltage_samples[k] = (((float)(system_voltage_samples_bytes[k])*3.261*3)/(4095));
         temp_voltage = (((float)(temperature_samples_bytes[k])*3.261)/(4095));
         temperature_samples[k] = 27 - (temp_voltage-0.706)/0.001721;
     }
@@ -371,7 +403,6 @@ int get_system_parameters(System_Parameters_t *system_parameters) {
     system_parameters->sigma_system_voltage = vsys_sigma;
     system_parameters->system_temperature = temperature_mean;
     system_parameters->sigma_system_temperature = temperature_sigma;
-    system_parameters->system_clock_frequency = (float)clock_get_hz(clk_sys);
 
     return 1;
 
@@ -576,9 +607,7 @@ int get_test_header(Test_Header_t *header, Test_Type_t test_type, uint8_t number
 int print_test_header(Test_Header_t test_header, uart_inst_t *uart_to_print) {
 
     uint8_t test_type_string[10];
-    uint8_t out_buff[MAX_UART_DATA_SIZE];
     uint16_t test_counter = 0;
-    clear_uart_buffer(out_buff);
     
     switch(test_header.type) {
         case UART:  sprintf(test_type_string, "UART");
@@ -590,16 +619,10 @@ int print_test_header(Test_Header_t test_header, uart_inst_t *uart_to_print) {
         default:    return -1; //Error: Wrong Parameter
     }
     uart_tx_data(uart_to_print, "");
-    sprintf(out_buff, "Test Type: %s", test_type_string);
-    uart_tx_data_unterminated(uart_to_print, out_buff);
-    clear_uart_buffer(out_buff);
-    sprintf(out_buff, " Time: ");
-    uart_tx_data_unterminated(uart_to_print, out_buff);
-    clear_uart_buffer(out_buff);
+    Uart_Tx_Segment_t segments[3] = {{"Test Type: ", UART_TX_SEGMENT_STRING}, {test_type_string, UART_TX_SEGMENT_STRING}, {" Time: ", UART_TX_SEGMENT_STRING}};
+    uart_tx_iov(uart_to_print, segments, 3, false);
     print_date_time(uart_to_print, &test_header.time_stamp);
-    sprintf(out_buff, " MRI-Sequence: FILL IN MRI SEQUENCE AFTER TEST");
-    uart_tx_data(uart_to_print, out_buff);
-    clear_uart_buffer(out_buff);
+    uart_tx_data(uart_to_print, " MRI-Sequence: FILL IN MRI SEQUENCE AFTER TEST");
     print_system_parameters(test_header.system_parameter, uart_to_print);
     uart_tx_data(uart_to_print, "");
 
@@ -796,7 +819,8 @@ int read_spi_test_results_from_flash(SPI_Test_Return_t *test_returns, uint8_t nu
 int save_adc_test_results_to_flash(ADC_Test_Return_t *test_returns, uint32_t *flash_read_address) {
     //Array of bytes to store to flash
     #ifndef USE_OPTIMIZED_SETUP
-    uint8_t adc_byte_stream[MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP];
+    //Samples as residuals against the fitted ramp (see ramp_codec.h) or raw 16-bit if the coding is not smaller
+    static uint8_t adc_byte_stream[ADC_RAMP_CODED_FLASH_SIZE];
     #else
     //Floats are four byte in size, the structure stores two float values
     uint8_t adc_byte_stream[2*MAX_ADC_SAMPLES_PER_RAMP*4];
@@ -806,10 +830,31 @@ int save_adc_test_results_to_flash(ADC_Test_Return_t *test_returns, uint32_t *fl
     int return_value = 0;
 
     #ifndef USE_OPTIMIZED_SETUP
-    for(uint32_t k = 0; k < test_returns->number_of_samples; k++) {
-        adc_byte_stream[k] = test_returns->adc_samples[k];
+    Ramp_Codec_Model_t model;
+    uint32_t number_of_encoded_samples = 0;
+    uint32_t raw_length = 2*test_returns->number_of_samples;
+    if(1 + raw_length > sizeof(adc_byte_stream)) {
+        return -3; //Error: the samples do not fit into one flash write
+    }
+    ramp_codec_fit_model(test_returns->adc_samples, test_returns->number_of_samples, (uint16_t)test_returns->number_of_samples_per_ramp_step, &model);
+    //The coded samples have to be smaller than the raw samples
+    int32_t encoded_length = ramp_codec_encode(test_returns->adc_samples, 0, test_returns->number_of_samples, &model, &adc_byte_stream[1],
+        raw_length, &number_of_encoded_samples);
+    if(encoded_length < 0 || number_of_encoded_samples < test_returns->number_of_samples) {
+        //Store raw 16-bit samples
+        adc_byte_stream[0] = ADC_FLASH_FORMAT_RAW;
+        for(uint32_t k = 0; k < test_returns->number_of_samples; k++) {
+            uint16_t_to_byte_array(test_returns->adc_samples[k], &adc_byte_stream[1 + 2*k]);
+        }
+        encoded_length = (int32_t)raw_length;
+    }
+    else {
+        adc_byte_stream[0] = ADC_FLASH_FORMAT_RAMP_CODED;
+    }
+    return_value = write_bytes_to_flash(flash_read_address, adc_byte_stream, (uint16_t)(1 + encoded_length));
+    if(return_value > 0) {
+        return (int)(1 + encoded_length);
     }
-    return_value = write_bytes_to_flash(flash_read_address, adc_byte_stream, test_returns->number_of_samples);
     #else 
     uint32_t j = 0;
     uint8_t mean_byte_buff[4];
@@ -832,17 +877,16 @@ int save_adc_test_results_to_flash(ADC_Test_Return_t *test_returns, uint32_t *fl
         j++;
     }
     return_value = write_bytes_to_flash(flash_read_address, adc_byte_stream, 2*test_returns->number_of_samples_per_ramp*4);
-    #endif
-    
     if(return_value > 0) {
         return (int)(2*test_returns->number_of_samples_per_ramp*4);
     }
+    #endif
     
     return return_value;
 }//end save_adc_test_results_to_flash
 int read_adc_test_results_from_flash(ADC_Test_Return_t *test_returns, uint32_t flash_read_address, uint16_t number_of_bytes_written_to_flash) {
     #ifndef USE_OPTIMIZED_SETUP
-    uint8_t adc_byte_stream[MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP];
+    static uint8_t adc_byte_stream[ADC_RAMP_CODED_FLASH_SIZE];
     #else
     uint8_t adc_byte_stream[2*MAX_ADC_SAMPLES_PER_RAMP*4];
     #endif
@@ -856,8 +900,30 @@ int read_adc_test_results_from_flash(ADC_Test_Return_t *test_returns, uint32_t f
     }
 
     #ifndef USE_OPTIMIZED_SETUP
-    for(uint32_t k = 0; k < number_of_bytes_written_to_flash; k++) {
-        test_returns->adc_samples[k] = adc_byte_stream[k];
+    if(number_of_bytes_written_to_flash < 1) {
+        return -2; //Error: no valid samples in flash
+    }
+    if(adc_byte_stream[0] == ADC_FLASH_FORMAT_RAW) {
+        uint32_t number_of_samples = (number_of_bytes_written_to_flash - 1)/2;
+        if(number_of_samples > MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP) {
+            return -2; //Error: no valid samples in flash
+        }
+        for(uint32_t k = 0; k < number_of_samples; k++) {
+            test_returns->adc_samples[k] = (uint16_t)byte_array_to_uint16_t(&adc_byte_stream[1 + 2*k]);
+        }
+        test_returns->number_of_samples = number_of_samples;
+    }
+    else if(adc_byte_stream[0] == ADC_FLASH_FORMAT_RAMP_CODED) {
+        uint32_t first_sample = 0;
+        int32_t number_of_samples = ramp_codec_decode(&adc_byte_stream[1], number_of_bytes_written_to_flash - 1, test_returns->adc_samples,
+            MAX_ADC_SAMPLES_PER_RAMP*MAX_ADC_SAMPLES_PER_RAMP_STEP, &first_sample);
+        if(number_of_samples < 0) {
+            return -2; //Error: no valid coded samples in flash
+        }
+        test_returns->number_of_samples = (uint32_t)number_of_samples;
+    }
+    else {
+        return -2; //Error: unknown format of the samples in flash
     }
     #else
     uint32_t j = 0;
@@ -32,6 +32,9 @@
 //Preprocessor constants:
 
 #define NUM_OF_SAMPLES_SYSTEM_PARAMETER 100
+//Background system monitor (see adc_system_monitor_start()): sample period and samples needed before its statistic is used
+#define SYSTEM_PARAMETER_MONITOR_PERIOD_MS 100
+#define SYSTEM_PARAMETER_MIN_MONITOR_SAMPLES 16
 #define MAX_NUMBER_OF_AUTOMATIC_TESTS 180
 #define MAX_DELAY_BETWEEN_TESTS_IN_MS 10*1000
 
@@ -160,7 +163,8 @@ int get_delay_between_test_from_user(Test_Suite_Settings_t *settings, uart_inst_
 //Printing settings
 int print_settings(Test_Suite_Settings_t settings, uart_inst_t *uart_to_print);
 
-//Get system parameter function
+//Get system parameter function (init_system_parameters() starts the background monitor, call it once during the init)
+int init_system_parameters(void);
 int get_system_parameters(System_Parameters_t *system_parameters);
 int print_system_parameters(System_Parameters_t system_parameter, uart_inst_t *uart_to_print);
 
@@ -30,6 +30,9 @@
 
 //Own Libraries:
 #include "uart.h"
+#include "data_to_byte.h"
+#include "uart_result.h"
+#include "number_format.h"
 
 //Preprocessor constants:
 
@@ -40,6 +43,51 @@
 
 //File global (static) function definitions
 
+static void uart_test_export_test_returns(Uart_Test_Return_t *test_return, uint8_t num_of_tests, uart_inst_t *uart_to_print) {
+
+    static uint8_t payload[RESULT_FRAME_MAX_PAYLOAD_SIZE];
+    Result_Frame_Header_t header;
+    uint16_t frame_count = 0;
+    uint16_t number_of_bytes = 0;
+
+    //One parameter frame p. test and one frame p. transfer
+    for(uint8_t n = 0; n < num_of_tests; n++) {
+        frame_count += 1 + test_return[n].num_of_transfers;
+    }
+
+    header.test_type = RESULT_FRAME_TEST_UART;
+    header.frame_count = frame_count;
+    header.frame_index = 0;
+
+    for(uint8_t n = 0; n < num_of_tests; n++) {
+
+        //Parameter frame: test nr, baudrate, number of transfers
+        header.record_type = RECORD_TEST_PARAMETER;
+        header.payload_length = 6;
+        payload[0] = n;
+        uint32_t_to_byte_array(test_return[n].baudrate, &payload[1]);
+        payload[5] = test_return[n].num_of_transfers;
+        uart_result_send(uart_to_print, header, payload);
+        header.frame_index++;
+
+        //Transfer frames: test nr, transfer nr, number of bytes, tx bytes, rx bytes
+        for(uint8_t k = 0; k < test_return[n].num_of_transfers; k++) {
+
+            number_of_bytes = 1 << (k);
+            header.record_type = RECORD_TRANSFER;
+            header.payload_length = 4 + 2*number_of_bytes;
+            payload[0] = n;
+            payload[1] = k;
+            uint16_t_to_byte_array(number_of_bytes, &payload[2]);
+            memcpy(&payload[4], test_return[n].tx_data[k], number_of_bytes);
+            memcpy(&payload[4 + number_of_bytes], test_return[n].rx_data[k], number_of_bytes);
+            uart_result_send(uart_to_print, header, payload);
+            header.frame_index++;
+        }
+    }
+
+}//end uart_test_export_test_returns
+
 //Function definitions:
 
 int uart_test_echo_main(Uart_Test_Structure_t uart_tests, Uart_Test_Return_t *return_of_test, bool use_watchdog) {
@@ -184,22 +232,24 @@ void uart_test_print_test_returns(Uart_Test_Return_t *test_return, uint8_t num_o
     float byte_fail_rate = 0;
     float byte_success_rate = 0;
 
+    if(format.binary_export) {
+        uart_test_export_test_returns(test_return, num_of_tests, uart_to_print);
+        return;
+    }
+
     uart_tx_data(uart_to_print, "#################UART-Test-Result-Print:######################");
     uart_tx_data(uart_to_print, "");
     sprintf(out_buff, "%ld tests performed with different baudrates. All tests are performed with Datasize from 1-Byte to %ld-Bytes", num_of_tests, (uint8_t)pow(2, test_return[0].num_of_transfers));
     uart_tx_data(uart_to_print, out_buff);
-    clear_uart_buffer;
     uart_tx_data(uart_to_print, "");
 
     for(uint8_t n = 0; n < num_of_tests; n++) {
         sprintf(out_buff, "########################UART-Test Nr: %ld############################", n+1);
         uart_tx_data(uart_to_print, out_buff);
-        clear_uart_buffer;
         uart_tx_data(uart_to_print, "");
         uart_tx_data(uart_to_print, "#################UART-Test-Parameter:#######################");
         sprintf(out_buff, "Baudrate: %ld", test_return[n].baudrate);
         uart_tx_data(uart_to_print, out_buff);
-        clear_uart_buffer(out_buff);
         uart_tx_data(uart_to_print, "");
         uart_tx_data(uart_to_print, "################Start-UART-Test-Output-File#################");
         uart_tx_data(uart_to_print, "");
@@ -209,23 +259,21 @@ void uart_test_print_test_returns(Uart_Test_Return_t *test_return, uint8_t num_o
                 
                sprintf(out_buff, "#####################Transfer Nr. %ld, with %ld Bytes####################", k+1, (uint8_t) pow(2,k));
                uart_tx_data(uart_to_print, out_buff);
-               clear_uart_buffer(out_buff);
                l = 0;
                 for(uint j = 0; j < pow(2,k); j++) {
 
-                    if(l < format.bytes_per_line) {  
-                        sprintf(out_buff, "TX: 0x%02X RX: 0x%02X%c" ,test_return[n].tx_data[k][j], test_return[n].rx_data[k][j], format.separator);
-                        uart_tx_data_unterminated(uart_to_print, out_buff);
-                        clear_uart_buffer(out_buff);
-                        l++;
-                    }
-                    else {
+                    if(l >= format.bytes_per_line) {
                         uart_tx_data(uart_to_print, "");
-                        sprintf(out_buff, "TX: 0x%02X RX: 0x%02X%c" ,test_return[n].tx_data[k][j], test_return[n].rx_data[k][j], format.separator);
-                        uart_tx_data_unterminated(uart_to_print, out_buff);
-                        clear_uart_buffer(out_buff);
-                        l = 1;
-                    } 
+                        l = 0;
+                    }
+                    //"TX: 0x%02X RX: 0x%02X%c" without printf, the constant parts are sent from flash
+                    uint8_t tx_hex[3];
+                    uint8_t rx_hex[3];
+                    number_format_hex8(tx_hex, test_return[n].tx_data[k][j]);
+                    number_format_hex8(rx_hex, test_return[n].rx_data[k][j]);
+                    Uart_Tx_Segment_t segments[5] = {{"TX: 0x", 6}, {tx_hex, 2}, {" RX: 0x", 7}, {rx_hex, 2}, {&format.separator, 1}};
+                    uart_tx_iov(uart_to_print, segments, 5, false);
+                    l++;
                     if(uart_compare_tx_rx_byte(test_return[n].rx_data[k][j], test_return[n].tx_data[k][j])) {
                         transfer_byte_success_counter++;
                     }
@@ -241,7 +289,6 @@ void uart_test_print_test_returns(Uart_Test_Return_t *test_return, uint8_t num_o
                 sprintf(out_buff, "######Transfer-nr.%ld, byte-success-rate: %f%c, byte-fail-rate %f%c######", k+1, byte_success_rate, '%',
                 byte_fail_rate, '%');
                 uart_tx_data(uart_to_print, out_buff);
-                clear_uart_buffer(out_buff);
             }//end transfer loop
         }
         else {
@@ -250,26 +297,21 @@ void uart_test_print_test_returns(Uart_Test_Return_t *test_return, uint8_t num_o
 
                 sprintf(out_buff, "Transfer Nr: %ld", k+1);
                 uart_tx_data(uart_to_print, out_buff);
-                clear_uart_buffer(out_buff);
                 sprintf(out_buff, "TX: %s" ,&test_return[n].tx_data[k][0]);
                 uart_tx_data(uart_to_print, out_buff);
-                clear_uart_buffer(out_buff);
                 sprintf(out_buff, "RX: %s",  &test_return[n].rx_data[k][0]);
                 uart_tx_data(uart_to_print, out_buff);
-                clear_uart_buffer(out_buff);
                 if(uart_compare_tx_rx_string(test_return[n].rx_data[k], test_return[n].tx_data[k])) {
                     sprintf(out_buff, "#####################Transfer Nr %ld: result: PASSED####################", k+1);
                     transfer_success_counter++;
                     uart_tx_data(uart_to_print, out_buff);
                     uart_tx_data(uart_to_print, "");
-                    clear_uart_buffer(out_buff);
                 }
                 else {
                     sprintf(out_buff, "#####################Transfer Nr %ld: result: FAILED####################", k+1);
                     transfer_failed_counter++;
                     uart_tx_data(uart_to_print, out_buff);
                     uart_tx_data(uart_to_print, "");
-                    clear_uart_buffer(out_buff);
                 }    
             }//end transfer loop
 
@@ -280,7 +322,6 @@ void uart_test_print_test_returns(Uart_Test_Return_t *test_return, uint8_t num_o
             sprintf(out_buff, "Test Nr: %ld with baudrate %ld results: %f%c of transfers succeeded and %f%c of transfers failed.", n+1, 
             test_return[n].baudrate, percentage_of_transfers_succeeded, '%', percentage_of_transfers_failed, '%');
             uart_tx_data(uart_to_print, out_buff);
-            clear_uart_buffer(out_buff);
         }
         uart_tx_data(uart_to_print, "");
         uart_tx_data(uart_to_print, "################End-UART-Test-Output-File#################");
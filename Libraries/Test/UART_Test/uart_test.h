@@ -77,6 +77,8 @@ typedef struct Uart_Test_Output_Format_s {
     bool single_byte;
     uint8_t separator;
     uint8_t bytes_per_line;
+    //Export results as binary frames (COBS, CRC-32) instead of text, see result_frame.h
+    bool binary_export;
 
 }Uart_Test_Output_Format_t;
 
@@ -0,0 +1,67 @@
+//File: arq_frame.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Utility functions to pack and unpack the frames of the selective-repeat ARQ (see uart_arq.h) for bulk transfers over UART.
+    Used on the device (sender) and on the host side (receiver).
+
+    Frame layout before encoding (all values little endian):
+
+        Byte 0:     Frame type (ARQ_FRAME_TYPE_...)
+        Byte 1:     Transfer ID (frames of an old transfer are ignored)
+        Byte 2-3:   Sequence number (data and end frames), cumulative acknowledge (ack frames: all frames below are received)
+        Byte 4-5:   Payload length in bytes
+        Byte 6-n:   Payload
+        Byte n-n+3: CRC-32 over header and payload
+
+    Payload of the frame types:
+
+        START:  Total number of bytes (uint32), bytes p. data frame (uint16), number of data frames (uint16)
+        DATA:   Data bytes of the chunk with the index of the sequence number
+        END:    CRC-32 over all data bytes (uint32), sequence number is the number of data frames
+        ACK:    Selective acknowledge bitmap (uint32), bit n set: frame cumulative acknowledge + 1 + n is received
+
+    The frame is COBS encoded and enclosed by zero bytes.
+    NOTE: This module is not multi-core-save (static frame buffer)
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+#include "cobs.h"
+
+//Preprocessor constants:
+
+#define ARQ_FRAME_TYPE_START 0x01
+#define ARQ_FRAME_TYPE_DATA 0x02
+#define ARQ_FRAME_TYPE_END 0x03
+#define ARQ_FRAME_TYPE_ACK 0x81
+
+#define ARQ_FRAME_HEADER_SIZE 6
+#define ARQ_FRAME_CRC_SIZE 4
+#define ARQ_FRAME_MAX_PAYLOAD_SIZE 512
+
+//Size of the raw frame and maximum size of an encoded frame with both zero delimiters
+#define ARQ_FRAME_MAX_RAW_SIZE (ARQ_FRAME_HEADER_SIZE + ARQ_FRAME_MAX_PAYLOAD_SIZE + ARQ_FRAME_CRC_SIZE)
+#define ARQ_FRAME_MAX_ENCODED_SIZE (COBS_MAX_ENCODED_LENGTH(ARQ_FRAME_MAX_RAW_SIZE) + 2)
+
+//Type definitions:
+
+typedef struct Arq_Frame_Header_s {
+
+    uint8_t type;
+    uint8_t transfer_id;
+    uint16_t sequence_number;
+    uint16_t payload_length;
+
+}Arq_Frame_Header_t;
+
+//Function Prototypes:
+
+int arq_frame_encode(Arq_Frame_Header_t header, const uint8_t *payload, uint8_t *encoded_frame);
+int arq_frame_decode(const uint8_t *encoded_frame, uint32_t encoded_length, Arq_Frame_Header_t *header, uint8_t *payload);
+
+//end file arq_frame.h
@@ -0,0 +1,110 @@
+//File: arq_frame.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Utility functions to pack and unpack the frames of the selective-repeat ARQ for bulk transfers over UART.
+    The frame is made of a small header, the payload and a CRC-32. It is COBS encoded and enclosed by zero bytes.
+    For the exact layout see arq_frame.h.
+
+*/
+
+
+//Corresponding header-file:
+#include "arq_frame.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Own Libraries:
+#include "crc.h"
+#include "data_to_byte.h"
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Raw (not encoded) frame
+static uint8_t raw_frame[ARQ_FRAME_MAX_RAW_SIZE];
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Function definition:
+
+int arq_frame_encode(Arq_Frame_Header_t header, const uint8_t *payload, uint8_t *encoded_frame) {
+
+    uint32_t raw_length = 0;
+    uint32_t encoded_length = 0;
+
+    if(header.payload_length > ARQ_FRAME_MAX_PAYLOAD_SIZE) {
+        return -1; //Error: payload does not fit into one frame
+    }
+
+    //Write header
+    raw_frame[0] = header.type;
+    raw_frame[1] = header.transfer_id;
+    uint16_t_to_byte_array(header.sequence_number, &raw_frame[2]);
+    uint16_t_to_byte_array(header.payload_length, &raw_frame[4]);
+    raw_length = ARQ_FRAME_HEADER_SIZE;
+
+    //Write payload
+    for(uint16_t k = 0; k < header.payload_length; k++) {
+        raw_frame[raw_length] = payload[k];
+        raw_length++;
+    }
+
+    //Append crc over header and payload
+    uint32_t_to_byte_array(get_crc32(raw_frame, raw_length), &raw_frame[raw_length]);
+    raw_length += ARQ_FRAME_CRC_SIZE;
+
+    //Encode frame, enclosed by zero delimiters
+    encoded_frame[0] = 0;
+    encoded_length = cobs_encode(raw_frame, raw_length, &encoded_frame[1]) + 1;
+    encoded_frame[encoded_length] = 0;
+    encoded_length++;
+
+    return (int)encoded_length;
+
+}//end arq_frame_encode
+
+int arq_frame_decode(const uint8_t *encoded_frame, uint32_t encoded_length, Arq_Frame_Header_t *header, uint8_t *payload) {
+
+    int32_t raw_length = 0;
+    uint16_t payload_length = 0;
+
+    if(encoded_length > COBS_MAX_ENCODED_LENGTH(ARQ_FRAME_MAX_RAW_SIZE)) {
+        return -1; //Error: frame is to long
+    }
+
+    //Decode frame (without zero delimiters)
+    raw_length = cobs_decode(encoded_frame, encoded_length, raw_frame);
+    if(raw_length < (ARQ_FRAME_HEADER_SIZE + ARQ_FRAME_CRC_SIZE)) {
+        return -1; //Error: not a valid cobs frame or frame is to short
+    }
+
+    payload_length = (uint16_t)byte_array_to_uint16_t(&raw_frame[4]);
+    if((payload_length + ARQ_FRAME_HEADER_SIZE + ARQ_FRAME_CRC_SIZE) != raw_length) {
+        return -2; //Error: length in header does not match the frame length
+    }
+
+    if(get_crc32(raw_frame, raw_length - ARQ_FRAME_CRC_SIZE) != (uint32_t)byte_array_to_uint32_t(&raw_frame[raw_length - ARQ_FRAME_CRC_SIZE])) {
+        return -3; //Error: crc does not match, frame is corrupted
+    }
+
+    header->type = raw_frame[0];
+    header->transfer_id = raw_frame[1];
+    header->sequence_number = (uint16_t)byte_array_to_uint16_t(&raw_frame[2]);
+    header->payload_length = payload_length;
+
+    for(uint16_t k = 0; k < payload_length; k++) {
+        payload[k] = raw_frame[ARQ_FRAME_HEADER_SIZE + k];
+    }
+
+    return (int)payload_length;
+
+}//end arq_frame_decode
+
+//end file arq_frame.c
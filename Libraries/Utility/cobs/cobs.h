@@ -0,0 +1,29 @@
+//File: cobs.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Utility functions for COBS (Consistent Overhead Byte Stuffing) encoding and decoding of byte arrays.
+    The encoded data contains no zero bytes, so a single zero byte can be used as frame delimiter on a byte stream (UART).
+    The encoding adds one byte of overhead per started block of 254 bytes.
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Maximum size of the encoded data for a given length of data (without the zero delimiter)
+#define COBS_MAX_ENCODED_LENGTH(data_length) ((data_length) + ((data_length)/254) + 1)
+
+//Type definitions:
+
+//Function Prototypes:
+
+uint32_t cobs_encode(const uint8_t *data, uint32_t data_length, uint8_t *encoded_data);
+int32_t cobs_decode(const uint8_t *encoded_data, uint32_t encoded_length, uint8_t *data);
+
+//end file cobs.h
@@ -0,0 +1,101 @@
+//File: cobs.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Utility functions for COBS (Consistent Overhead Byte Stuffing) encoding and decoding of byte arrays.
+    The encoded data contains no zero bytes, so a single zero byte can be used as frame delimiter on a byte stream (UART).
+    The encoding adds one byte of overhead per started block of 254 bytes.
+
+*/
+
+
+//Corresponding header-file:
+#include "cobs.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Function definition:
+
+uint32_t cobs_encode(const uint8_t *data, uint32_t data_length, uint8_t *encoded_data) {
+
+    //Index of the code byte of the actual block, the code byte holds the distance to the next zero
+    uint32_t code_index = 0;
+    uint32_t write_index = 1;
+    uint8_t code = 1;
+
+    for(uint32_t k = 0; k < data_length; k++) {
+
+        if(data[k] == 0) {
+            //Close block: the code byte points to the replaced zero
+            encoded_data[code_index] = code;
+            code_index = write_index;
+            write_index++;
+            code = 1;
+        }
+        else {
+            encoded_data[write_index] = data[k];
+            write_index++;
+            code++;
+            //Block with 254 non zero bytes is full, start a new one without an implicit zero
+            if(code == 0xFF) {
+                encoded_data[code_index] = code;
+                code_index = write_index;
+                write_index++;
+                code = 1;
+            }
+        }
+    }
+    encoded_data[code_index] = code;
+
+    return write_index;
+
+}//end cobs_encode
+
+int32_t cobs_decode(const uint8_t *encoded_data, uint32_t encoded_length, uint8_t *data) {
+
+    uint32_t read_index = 0;
+    uint32_t write_index = 0;
+
+    while(read_index < encoded_length) {
+
+        uint8_t code = encoded_data[read_index];
+
+        if(code == 0 || (read_index + code) > encoded_length) {
+            return -1; //Error: zero byte inside encoded data or block points outside of the data
+        }
+        read_index++;
+
+        for(uint8_t k = 1; k < code; k++) {
+            if(encoded_data[read_index] == 0) {
+                return -1; //Error: zero byte inside encoded data
+            }
+            data[write_index] = encoded_data[read_index];
+            write_index++;
+            read_index++;
+        }
+
+        //Every block shorter then 254 bytes stands for a zero, except the last block
+        if(code != 0xFF && read_index < encoded_length) {
+            data[write_index] = 0;
+            write_index++;
+        }
+    }
+
+    return (int32_t)write_index;
+
+}//end cobs_decode
+
+//end file cobs.c
@@ -0,0 +1,29 @@
+//File: crc.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Utility functions for calculating the CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) of byte arrays.
+    The lookup table is stored as constant (in flash), so no initialisation is needed.
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Start value to calculate a crc over several data arrays with update_crc32
+#define CRC32_START_VALUE 0xFFFFFFFF
+
+//Type definitions:
+
+//Function Prototypes:
+
+uint32_t get_crc32(const uint8_t *data, uint32_t data_length);
+uint32_t update_crc32(uint32_t crc, const uint8_t *data, uint32_t data_length);
+uint32_t finish_crc32(uint32_t crc);
+
+//end file crc.h
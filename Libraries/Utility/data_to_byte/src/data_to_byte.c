@@ -77,9 +77,9 @@ void uint32_t_to_byte_array(unsigned long int_to_transform, unsigned char *byte_
 }//end uint32_t_to_byte_array
 unsigned long byte_array_to_uint32_t(unsigned char *byte_array) {
     unsigned long result = byte_array[0];//Initialize with least significant byte
-    result |= (byte_array[1] << 8);
-    result |= (byte_array[2] << 16);
-    result |= (byte_array[3] << 24);//Add most significant byte
+    result |= ((unsigned long)byte_array[1] << 8);
+    result |= ((unsigned long)byte_array[2] << 16);
+    result |= ((unsigned long)byte_array[3] << 24);//Add most significant byte (cast, so it also works where long is 64-bit, e.g. host side)
     return result;
 }//end byte_array_to_uint32_t
 
@@ -0,0 +1,47 @@
+//File: fec.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Utility functions for forward error correction (FEC) of byte arrays with interleaved Reed-Solomon codes over GF(256)
+    (primitive polynomial 0x11D, first consecutive root alpha^0).
+    The encoded data is systematic: the data bytes followed by the parity bytes. Byte n of the encoded data (data and parity)
+    belongs to the (shortened) codeword n % interleave_depth.
+    Every codeword gets num_of_parity_bytes parity bytes and corrects up to num_of_parity_bytes/2 wrong bytes,
+    so a burst of up to interleave_depth*num_of_parity_bytes/2 wrong bytes could be corrected.
+    NOTE: This module is not multi-core-save (generator polynomial is cached in a static buffer)
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+#define FEC_MAX_PARITY_BYTES 32
+#define FEC_MAX_INTERLEAVE_DEPTH 16
+#define FEC_MAX_CODEWORD_LENGTH 255
+
+//Maximum size of the encoded data for a given length of data
+#define FEC_MAX_ENCODED_LENGTH(data_length) ((data_length) + (FEC_MAX_PARITY_BYTES*FEC_MAX_INTERLEAVE_DEPTH))
+
+//Type definitions:
+
+typedef struct Fec_Config_s {
+
+    //Parity bytes p. codeword (even number, 0 = no FEC)
+    uint8_t num_of_parity_bytes;
+    //Minimum number of interleaved codewords, is increased if the data does not fit into the codewords
+    uint8_t interleave_depth;
+
+}Fec_Config_t;
+
+//Function Prototypes:
+
+int32_t fec_get_encoded_length(Fec_Config_t config, uint32_t data_length);
+int32_t fec_encode(Fec_Config_t config, const uint8_t *data, uint32_t data_length, uint8_t *encoded_data);
+int32_t fec_decode(Fec_Config_t config, const uint8_t *encoded_data, uint32_t encoded_length, uint8_t *data, uint32_t *corrected_bytes);
+
+//end file fec.h
@@ -0,0 +1,419 @@
+//File: fec.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Utility functions for forward error correction (FEC) of byte arrays with interleaved Reed-Solomon codes over GF(256).
+    Encoding divides every codeword by the generator polynomial (LFSR), decoding uses syndromes, Berlekamp-Massey,
+    Chien search and Forney's algorithm. The GF(256) tables are stored as constants (in flash), so no initialisation is needed.
+
+*/
+
+
+//Corresponding header-file:
+#include "fec.h"
+
+//Libraries:
+
+//Standard-C:
+#include <stdbool.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Antilog table alpha^i, doubled so the sum of two logarithms needs no modulo
+static const uint8_t gf_exp[512] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26,
+    0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0,
+    0x9D, 0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+    0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1,
+    0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0,
+    0xFD, 0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+    0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE,
+    0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC,
+    0x85, 0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+    0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73,
+    0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF,
+    0xE3, 0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6,
+    0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09,
+    0x12, 0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+    0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26, 0x4C,
+    0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D,
+    0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23, 0x46,
+    0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1, 0x5F,
+    0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD,
+    0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2, 0xD9,
+    0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE, 0x81,
+    0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85,
+    0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54, 0xA8,
+    0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73, 0xE6,
+    0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3,
+    0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41, 0x82,
+    0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6, 0x51,
+    0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12,
+    0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16, 0x2C,
+    0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01, 0x02
+};
+
+//Log table, gf_log[0] is not defined
+static const uint8_t gf_log[256] = {
+    0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE, 0x1B, 0x68, 0xC7, 0x4B,
+    0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81, 0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71,
+    0x05, 0x8A, 0x65, 0x2F, 0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+    0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78, 0x4D, 0xE4, 0x72, 0xA6,
+    0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD, 0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88,
+    0x36, 0xD0, 0x94, 0xCE, 0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+    0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54, 0xFA, 0x85, 0xBA, 0x3D,
+    0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B, 0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57,
+    0x07, 0x70, 0xC0, 0xF7, 0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+    0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9, 0x23, 0x20, 0x89, 0x2E,
+    0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD, 0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61,
+    0xF2, 0x56, 0xD3, 0xAB, 0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+    0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC, 0x7F, 0x0C, 0x6F, 0xF6,
+    0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA, 0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A,
+    0xCB, 0x59, 0x5F, 0xB0, 0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+    0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA, 0xA8, 0x50, 0x58, 0xAF
+};
+
+//Generator polynomial (highest degree first) of the last used number of parity bytes
+static uint8_t generator[FEC_MAX_PARITY_BYTES + 1];
+static uint8_t generator_degree = 0;
+
+//Functions:
+
+//File global (static) function definitions:
+
+static inline uint8_t gf_mul(uint8_t a, uint8_t b) {
+
+    if(a == 0 || b == 0) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+
+}//end gf_mul
+
+static inline uint8_t gf_div(uint8_t a, uint8_t b) {
+
+    if(a == 0) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + 255 - gf_log[b]];
+
+}//end gf_div
+
+//Builds g(x) = (x + alpha^0)(x + alpha^1)...(x + alpha^(n-1)) if not already done for this number of parity bytes
+static void fec_build_generator(uint8_t num_of_parity_bytes) {
+
+    if(generator_degree == num_of_parity_bytes && generator[0] == 1) {
+        return;
+    }
+
+    generator[0] = 1;
+    for(uint8_t i = 0; i < num_of_parity_bytes; i++) {
+        generator[i+1] = 0;
+        for(uint8_t j = i + 1; j > 0; j--) {
+            generator[j] ^= gf_mul(generator[j-1], gf_exp[i]);
+        }
+    }
+    generator_degree = num_of_parity_bytes;
+
+}//end fec_build_generator
+
+static int32_t fec_get_interleave_depth(Fec_Config_t config, uint32_t data_length) {
+
+    uint32_t max_data_p_codeword = FEC_MAX_CODEWORD_LENGTH - config.num_of_parity_bytes;
+    uint32_t interleave_depth = (data_length + max_data_p_codeword - 1)/max_data_p_codeword;
+
+    if(interleave_depth < config.interleave_depth) {
+        interleave_depth = config.interleave_depth;
+    }
+    if(interleave_depth == 0) {
+        interleave_depth = 1;
+    }
+    if(interleave_depth > FEC_MAX_INTERLEAVE_DEPTH) {
+        return -1; //Error: data does not fit into the maximum number of codewords
+    }
+
+    return (int32_t)interleave_depth;
+
+}//end fec_get_interleave_depth
+
+//Corrects one codeword in place, returns the number of corrected bytes or -1 if there are to many errors
+static int32_t fec_decode_codeword(uint8_t *codeword, uint32_t codeword_length, uint8_t num_of_parity_bytes) {
+
+    uint8_t syndromes[FEC_MAX_PARITY_BYTES];
+    uint8_t error_locator[FEC_MAX_PARITY_BYTES + 1];
+    uint8_t last_locator[FEC_MAX_PARITY_BYTES + 1];
+    uint8_t temp_locator[FEC_MAX_PARITY_BYTES + 1];
+    uint8_t error_evaluator[FEC_MAX_PARITY_BYTES];
+    uint8_t error_positions[FEC_MAX_PARITY_BYTES/2];
+    bool has_errors = false;
+
+    //Syndromes S_i = c(alpha^i)
+    for(uint8_t i = 0; i < num_of_parity_bytes; i++) {
+        uint8_t syndrome = 0;
+        for(uint32_t j = 0; j < codeword_length; j++) {
+            syndrome = gf_mul(syndrome, gf_exp[i]) ^ codeword[j];
+        }
+        syndromes[i] = syndrome;
+        if(syndrome != 0) {
+            has_errors = true;
+        }
+    }
+
+    if(!has_errors) {
+        return 0;
+    }
+
+    //Berlekamp-Massey: error locator polynomial (lowest degree first)
+    for(uint8_t i = 0; i <= num_of_parity_bytes; i++) {
+        error_locator[i] = 0;
+        last_locator[i] = 0;
+    }
+    error_locator[0] = 1;
+    last_locator[0] = 1;
+    uint8_t number_of_errors = 0;
+    uint8_t shift = 1;
+    uint8_t last_discrepancy = 1;
+
+    for(uint8_t n = 0; n < num_of_parity_bytes; n++) {
+
+        uint8_t discrepancy = syndromes[n];
+        for(uint8_t i = 1; i <= number_of_errors; i++) {
+            discrepancy ^= gf_mul(error_locator[i], syndromes[n-i]);
+        }
+
+        if(discrepancy == 0) {
+            shift++;
+            continue;
+        }
+
+        uint8_t coefficient = gf_div(discrepancy, last_discrepancy);
+
+        if(2*number_of_errors <= n) {
+            for(uint8_t i = 0; i <= num_of_parity_bytes; i++) {
+                temp_locator[i] = error_locator[i];
+            }
+            for(uint8_t i = 0; (i + shift) <= num_of_parity_bytes; i++) {
+                error_locator[i + shift] ^= gf_mul(coefficient, last_locator[i]);
+            }
+            number_of_errors = n + 1 - number_of_errors;
+            for(uint8_t i = 0; i <= num_of_parity_bytes; i++) {
+                last_locator[i] = temp_locator[i];
+            }
+            last_discrepancy = discrepancy;
+            shift = 1;
+        }
+        else {
+            for(uint8_t i = 0; (i + shift) <= num_of_parity_bytes; i++) {
+                error_locator[i + shift] ^= gf_mul(coefficient, last_locator[i]);
+            }
+            shift++;
+        }
+    }
+
+    if(2*number_of_errors > num_of_parity_bytes) {
+        return -1; //Error: to many errors
+    }
+
+    //Chien search: byte j has the power e = length-1-j, it is wrong if the locator has a root at alpha^(-e)
+    uint8_t errors_found = 0;
+    for(uint32_t j = 0; j < codeword_length; j++) {
+
+        uint8_t power = (uint8_t)((255 - (codeword_length - 1 - j)) % 255);
+        uint8_t value = 0;
+        for(uint8_t i = 0; i <= number_of_errors; i++) {
+            value ^= gf_mul(error_locator[i], gf_exp[(power*i) % 255]);
+        }
+
+        if(value == 0) {
+            if(errors_found == number_of_errors) {
+                return -1; //Error: more roots than errors, not decodable
+            }
+            error_positions[errors_found++] = j;
+        }
+    }
+
+    if(errors_found != number_of_errors) {
+        return -1; //Error: locator has roots outside of the (shortened) codeword
+    }
+
+    //Error evaluator: Omega(x) = S(x)*Lambda(x) mod x^n
+    for(uint8_t k = 0; k < num_of_parity_bytes; k++) {
+        error_evaluator[k] = 0;
+        for(uint8_t i = 0; i <= k && i <= number_of_errors; i++) {
+            error_evaluator[k] ^= gf_mul(syndromes[k-i], error_locator[i]);
+        }
+    }
+
+    //Forney: e = X*Omega(1/X)/Lambda'(1/X)
+    for(uint8_t k = 0; k < errors_found; k++) {
+
+        uint32_t location_power = codeword_length - 1 - error_positions[k];
+        uint8_t inverse_power = (uint8_t)((255 - location_power) % 255);
+        uint8_t omega = 0;
+        uint8_t lambda_derivative = 0;
+
+        for(uint8_t i = 0; i < num_of_parity_bytes; i++) {
+            omega ^= gf_mul(error_evaluator[i], gf_exp[(inverse_power*i) % 255]);
+        }
+        //Formal derivative: only odd terms are left in GF(2^m)
+        for(uint8_t i = 1; i <= number_of_errors; i += 2) {
+            lambda_derivative ^= gf_mul(error_locator[i], gf_exp[(inverse_power*(i-1)) % 255]);
+        }
+
+        if(lambda_derivative == 0) {
+            return -1; //Error: not decodable
+        }
+
+        codeword[error_positions[k]] ^= gf_mul(gf_exp[location_power % 255], gf_div(omega, lambda_derivative));
+    }
+
+    return errors_found;
+
+}//end fec_decode_codeword
+
+//Function definition:
+
+int32_t fec_get_encoded_length(Fec_Config_t config, uint32_t data_length) {
+
+    if(config.num_of_parity_bytes == 0) {
+        return (int32_t)data_length;
+    }
+
+    if(config.num_of_parity_bytes > FEC_MAX_PARITY_BYTES) {
+        return -1; //Error: to many parity bytes
+    }
+
+    int32_t interleave_depth = fec_get_interleave_depth(config, data_length);
+    if(interleave_depth < 0) {
+        return -1; //Error: data to long
+    }
+
+    return (int32_t)data_length + interleave_depth*config.num_of_parity_bytes;
+
+}//end fec_get_encoded_length
+
+int32_t fec_encode(Fec_Config_t config, const uint8_t *data, uint32_t data_length, uint8_t *encoded_data) {
+
+    uint8_t parity[FEC_MAX_PARITY_BYTES];
+    uint8_t num_of_parity_bytes = config.num_of_parity_bytes;
+
+    int32_t encoded_length = fec_get_encoded_length(config, data_length);
+    if(encoded_length < 0) {
+        return -1; //Error: wrong configuration or data to long
+    }
+
+    //Systematic code: data is copied as it is
+    for(uint32_t k = 0; k < data_length; k++) {
+        encoded_data[k] = data[k];
+    }
+
+    if(num_of_parity_bytes == 0) {
+        return encoded_length;
+    }
+
+    uint32_t interleave_depth = (uint32_t)fec_get_interleave_depth(config, data_length);
+    fec_build_generator(num_of_parity_bytes);
+
+    for(uint32_t codeword = 0; codeword < interleave_depth; codeword++) {
+
+        for(uint8_t m = 0; m < num_of_parity_bytes; m++) {
+            parity[m] = 0;
+        }
+
+        //Remainder of data(x)*x^n / g(x)
+        for(uint32_t j = codeword; j < data_length; j += interleave_depth) {
+            uint8_t feedback = data[j] ^ parity[0];
+            for(uint8_t m = 0; m < (num_of_parity_bytes - 1); m++) {
+                parity[m] = parity[m+1] ^ gf_mul(generator[m+1], feedback);
+            }
+            parity[num_of_parity_bytes - 1] = gf_mul(generator[num_of_parity_bytes], feedback);
+        }
+
+        //Parity bytes continue the interleaving of the data: byte n of the encoded data belongs to codeword n % interleave_depth
+        uint32_t parity_offset = data_length + (codeword + interleave_depth - (data_length % interleave_depth)) % interleave_depth;
+        for(uint8_t m = 0; m < num_of_parity_bytes; m++) {
+            encoded_data[parity_offset + m*interleave_depth] = parity[m];
+        }
+    }
+
+    return encoded_length;
+
+}//end fec_encode
+
+int32_t fec_decode(Fec_Config_t config, const uint8_t *encoded_data, uint32_t encoded_length, uint8_t *data, uint32_t *corrected_bytes) {
+
+    uint8_t codeword[FEC_MAX_CODEWORD_LENGTH];
+    uint8_t num_of_parity_bytes = config.num_of_parity_bytes;
+    uint32_t data_length = 0;
+    int32_t interleave_depth = -1;
+    int32_t return_value = 0;
+
+    *corrected_bytes = 0;
+
+    if(num_of_parity_bytes > FEC_MAX_PARITY_BYTES) {
+        return -1; //Error: to many parity bytes
+    }
+
+    if(num_of_parity_bytes == 0) {
+        for(uint32_t k = 0; k < encoded_length; k++) {
+            data[k] = encoded_data[k];
+        }
+        return (int32_t)encoded_length;
+    }
+
+    //Find the interleave depth the encoder used for this length
+    for(int32_t depth = 1; depth <= FEC_MAX_INTERLEAVE_DEPTH; depth++) {
+        if((uint32_t)(depth*num_of_parity_bytes) > encoded_length) {
+            break;
+        }
+        if(fec_get_interleave_depth(config, encoded_length - depth*num_of_parity_bytes) == depth) {
+            interleave_depth = depth;
+            data_length = encoded_length - depth*num_of_parity_bytes;
+            break;
+        }
+    }
+
+    if(interleave_depth < 0) {
+        return -1; //Error: length does not match the configuration
+    }
+
+    return_value = (int32_t)data_length;
+
+    for(int32_t cw = 0; cw < interleave_depth; cw++) {
+
+        //Collect codeword: data bytes followed by the parity bytes
+        uint32_t codeword_length = 0;
+        for(uint32_t j = cw; j < data_length; j += interleave_depth) {
+            codeword[codeword_length++] = encoded_data[j];
+        }
+        uint32_t parity_offset = data_length + (cw + interleave_depth - (data_length % interleave_depth)) % interleave_depth;
+        for(uint8_t m = 0; m < num_of_parity_bytes; m++) {
+            codeword[codeword_length++] = encoded_data[parity_offset + m*interleave_depth];
+        }
+
+        int32_t corrected = fec_decode_codeword(codeword, codeword_length, num_of_parity_bytes);
+        if(corrected < 0) {
+            return_value = -2; //Error: codeword could not be corrected, data is copied uncorrected
+        }
+        else {
+            *corrected_bytes += corrected;
+        }
+
+        uint32_t k = 0;
+        for(uint32_t j = cw; j < data_length; j += interleave_depth) {
+            data[j] = codeword[k++];
+        }
+    }
+
+    return return_value;
+
+}//end fec_decode
+
+//end file fec.c
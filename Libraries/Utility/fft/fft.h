@@ -0,0 +1,41 @@
+//File: fft.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Fixed-point (Q15) radix-2 FFT for spectral analysis of ADC blocks (no float, the RP2040 has no FPU).
+    The FFT works in place on separate real and imaginary arrays (decimation in time, bit reversed input order is done by the function).
+    Every stage is scaled by 1/2 so no butterfly could overflow, the result is X[k]/fft_size.
+    The twiddle factors (and the Hann window) are taken from one quarter sine table of FFT_MAX_SIZE/4 + 1 entries (const, in flash).
+    Amplitude of a sine with amplitude A in the (Hann windowed) input: |X[k]| = A/4 (A/2 without window).
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Biggest FFT (power of two), size of the sine table
+#define FFT_MAX_SIZE 1024
+#define FFT_MIN_SIZE 4
+
+//Type definitions:
+
+typedef struct FFT_Peak_s {
+
+    uint16_t bin;
+    uint32_t magnitude;
+
+}FFT_Peak_t;
+
+//Function Prototypes:
+
+int fft_q15(int16_t *real, int16_t *imaginary, uint16_t fft_size);
+int fft_apply_hann_window(int16_t *samples, uint16_t fft_size);
+void fft_magnitude(const int16_t *real, const int16_t *imaginary, uint16_t num_of_bins, uint16_t *magnitude);
+uint8_t fft_find_peaks(const uint32_t *spectrum, uint16_t num_of_bins, FFT_Peak_t *peaks, uint8_t max_num_of_peaks);
+
+//end file fft.h
@@ -0,0 +1,232 @@
+//File: fft.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Q15 radix-2 FFT, Hann window, magnitude spectrum and peak search (see fft.h).
+    Butterflies use 16x16 bit products (single cycle multiplier of the M0+) with rounding, the sine table is const
+    so it stays in flash and needs no RAM and no startup calculation.
+
+*/
+
+
+//Corresponding header-file:
+#include "fft.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Own Libraries:
+
+//Preprocessor constants:
+#define FFT_QUARTER_SIZE (FFT_MAX_SIZE/4)
+
+//File global (static) variables:
+
+//sin(2*pi*k/FFT_MAX_SIZE) in Q15 for k = 0 ... FFT_MAX_SIZE/4
+static const int16_t fft_sine_table[FFT_QUARTER_SIZE + 1] = {
+    0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210, 2411, 2611, 2811, 3012,
+    3212, 3412, 3612, 3812, 4011, 4211, 4410, 4609, 4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195,
+    6393, 6590, 6787, 6983, 7180, 7376, 7571, 7767, 7962, 8157, 8351, 8546, 8740, 8933, 9127, 9319,
+    9512, 9704, 9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605, 11793, 11980, 12167, 12354,
+    12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828, 14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+    15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+    18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001, 20160, 20318, 20475, 20632,
+    20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856, 22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028,
+    23170, 23312, 23453, 23593, 23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+    25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+    27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002, 28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803,
+    28899, 28993, 29086, 29178, 29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+    30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298,
+    31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737, 31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099,
+    32138, 32177, 32214, 32251, 32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+    32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753, 32758, 32762, 32766, 32767,
+    32767
+};
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Sine and cosine of 2*pi*index/FFT_MAX_SIZE for index < FFT_MAX_SIZE/2
+static inline void fft_get_sine_cosine(uint32_t index, int16_t *sine, int16_t *cosine) {
+
+    if(index <= FFT_QUARTER_SIZE) {
+        *sine = fft_sine_table[index];
+        *cosine = fft_sine_table[FFT_QUARTER_SIZE - index];
+    }
+    else {
+        *sine = fft_sine_table[2*FFT_QUARTER_SIZE - index];
+        *cosine = -fft_sine_table[index - FFT_QUARTER_SIZE];
+    }
+
+}//end fft_get_sine_cosine
+
+static inline int16_t fft_multiply_q15(int16_t a, int16_t b) {
+
+    return (int16_t)(((int32_t)a*b + (1 << 14)) >> 15);
+
+}//end fft_multiply_q15
+
+static uint32_t fft_square_root(uint32_t value) {
+
+    uint32_t result = 0;
+    uint32_t bit = 1u << 30;
+
+    while(bit > value) {
+        bit >>= 2;
+    }
+    while(bit != 0) {
+        if(value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+
+}//end fft_square_root
+
+static int fft_get_log2_size(uint16_t fft_size) {
+
+    int log2_size = 0;
+
+    if(fft_size < FFT_MIN_SIZE || fft_size > FFT_MAX_SIZE || (fft_size & (fft_size - 1)) != 0) {
+        return -1; //Error: no power of two or out of range
+    }
+    while((1u << log2_size) < fft_size) {
+        log2_size++;
+    }
+    return log2_size;
+
+}//end fft_get_log2_size
+
+//Function definition:
+
+int fft_q15(int16_t *real, int16_t *imaginary, uint16_t fft_size) {
+
+    int log2_size = fft_get_log2_size(fft_size);
+    if(log2_size < 0) {
+        return -1; //Error: wrong fft size
+    }
+
+    //Bit reversed order of the input
+    for(uint32_t k = 0, j = 0; k < fft_size; k++) {
+        if(k < j) {
+            int16_t temp = real[k];
+            real[k] = real[j];
+            real[j] = temp;
+            temp = imaginary[k];
+            imaginary[k] = imaginary[j];
+            imaginary[j] = temp;
+        }
+        uint32_t bit = fft_size >> 1;
+        while(j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+
+    //Stages, every butterfly scaled by 1/2
+    for(uint32_t length = 2; length <= fft_size; length <<= 1) {
+        uint32_t half = length >> 1;
+        uint32_t table_step = FFT_MAX_SIZE/length;
+
+        for(uint32_t j = 0; j < half; j++) {
+            //w = exp(-i*2*pi*j/length)
+            int16_t sine, cosine;
+            fft_get_sine_cosine(j*table_step, &sine, &cosine);
+
+            for(uint32_t k = j; k < fft_size; k += length) {
+                uint32_t m = k + half;
+                int32_t t_real = ((int32_t)real[m]*cosine + (int32_t)imaginary[m]*sine + (1 << 14)) >> 15;
+                int32_t t_imaginary = ((int32_t)imaginary[m]*cosine - (int32_t)real[m]*sine + (1 << 14)) >> 15;
+                int32_t u_real = real[k];
+                int32_t u_imaginary = imaginary[k];
+
+                real[k] = (int16_t)((u_real + t_real) >> 1);
+                imaginary[k] = (int16_t)((u_imaginary + t_imaginary) >> 1);
+                real[m] = (int16_t)((u_real - t_real) >> 1);
+                imaginary[m] = (int16_t)((u_imaginary - t_imaginary) >> 1);
+            }
+        }
+    }
+
+    return 1;
+
+}//end fft_q15
+
+int fft_apply_hann_window(int16_t *samples, uint16_t fft_size) {
+
+    if(fft_get_log2_size(fft_size) < 0) {
+        return -1; //Error: wrong fft size
+    }
+    uint32_t table_step = FFT_MAX_SIZE/fft_size;
+
+    for(uint32_t k = 0; k < fft_size; k++) {
+        //w = (1 - cos(2*pi*k/fft_size))/2, cos is symmetric to pi
+        uint32_t index = k*table_step;
+        if(index > FFT_MAX_SIZE/2) {
+            index = FFT_MAX_SIZE - index;
+        }
+        int16_t sine, cosine;
+        if(index == FFT_MAX_SIZE/2) {
+            cosine = -32767;
+        }
+        else {
+            fft_get_sine_cosine(index, &sine, &cosine);
+        }
+        int16_t window = (int16_t)((32767 - (int32_t)cosine) >> 1);
+        samples[k] = fft_multiply_q15(samples[k], window);
+    }
+
+    return 1;
+
+}//end fft_apply_hann_window
+
+void fft_magnitude(const int16_t *real, const int16_t *imaginary, uint16_t num_of_bins, uint16_t *magnitude) {
+
+    for(uint16_t k = 0; k < num_of_bins; k++) {
+        uint32_t power = (uint32_t)((int32_t)real[k]*real[k]) + (uint32_t)((int32_t)imaginary[k]*imaginary[k]);
+        magnitude[k] = (uint16_t)fft_square_root(power);
+    }
+
+}//end fft_magnitude
+
+uint8_t fft_find_peaks(const uint32_t *spectrum, uint16_t num_of_bins, FFT_Peak_t *peaks, uint8_t max_num_of_peaks) {
+
+    uint8_t num_of_peaks = 0;
+
+    if(max_num_of_peaks == 0) {
+        return 0;
+    }
+
+    //Local maxima (DC bin is skipped), sorted by magnitude (biggest first)
+    for(uint16_t k = 1; k < num_of_bins; k++) {
+        uint32_t value = spectrum[k];
+        if(value == 0 || value <= spectrum[k - 1] || ((k + 1) < num_of_bins && value < spectrum[k + 1])) {
+            continue;
+        }
+        if(num_of_peaks == max_num_of_peaks && value <= peaks[num_of_peaks - 1].magnitude) {
+            continue;
+        }
+
+        uint8_t position = (num_of_peaks < max_num_of_peaks) ? num_of_peaks++ : (num_of_peaks - 1);
+        while(position > 0 && peaks[position - 1].magnitude < value) {
+            peaks[position] = peaks[position - 1];
+            position--;
+        }
+        peaks[position].bin = k;
+        peaks[position].magnitude = value;
+    }
+
+    return num_of_peaks;
+
+}//end fft_find_peaks
+
+//end file fft.c
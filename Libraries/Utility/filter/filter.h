@@ -0,0 +1,95 @@
+//File: filter.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Fixed-point filters for ADC sample blocks (no float, the RP2040 has no FPU):
+        -FIR: Q15 coefficients, delay line of 2*num_of_taps samples (every sample is stored twice, so the convolution needs no modulo)
+        -Biquad IIR: direct form I, Q2.14 coefficients (a0 = 1 is implicit, a1 and a2 with the sign of the difference equation
+         y = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]) and first order error feedback for low cutoff frequencies
+        -CIC decimator: order 1 to FILTER_CIC_MAX_ORDER, power of two ratio, integrators and combs in 32 bit (wrap around is intended)
+    Samples are Q15 (int16_t), products are 32 bit (hardware multiplier of the M0+) and summed up in a 64 bit (Q31 and more) accumulator,
+    the results are rounded and saturated to Q15.
+    Stages could be chained with filter_pipeline_process(), all stages work in place on one block and keep their state between blocks.
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+#define FILTER_Q15_SHIFT 15
+#define FILTER_BIQUAD_COEFFICIENT_SHIFT 14
+#define FILTER_CIC_MAX_ORDER 4
+//Bit growth of the CIC is order*log2(ratio), the 32 bit integrators allow 16 bit of growth for Q15 samples
+#define FILTER_CIC_MAX_BIT_GROWTH 16
+
+//Type definitions:
+
+typedef enum Filter_Type_e {
+
+    FILTER_FIR = 0,
+    FILTER_BIQUAD,
+    FILTER_CIC,
+
+}Filter_Type_t;
+
+typedef struct Filter_FIR_s {
+
+    const int16_t *coefficients;
+    //Delay line with 2*num_of_taps samples
+    int16_t *state;
+    uint16_t num_of_taps;
+    uint16_t state_index;
+
+}Filter_FIR_t;
+
+typedef struct Filter_Biquad_s {
+
+    //b0, b1, b2, a1, a2 in Q2.14
+    int16_t coefficients[5];
+    int16_t x1, x2, y1, y2;
+    //Truncation error of the last output (error feedback)
+    int32_t error;
+
+}Filter_Biquad_t;
+
+typedef struct Filter_CIC_s {
+
+    uint8_t order;
+    uint8_t ratio_shift;
+    uint16_t phase;
+    int32_t integrator[FILTER_CIC_MAX_ORDER];
+    int32_t comb[FILTER_CIC_MAX_ORDER];
+
+}Filter_CIC_t;
+
+typedef struct Filter_Stage_s {
+
+    Filter_Type_t type;
+    void *filter;
+
+}Filter_Stage_t;
+
+//Function Prototypes:
+
+int filter_fir_init(Filter_FIR_t *fir, const int16_t *coefficients, uint16_t num_of_taps, int16_t *state);
+void filter_fir_reset(Filter_FIR_t *fir);
+uint32_t filter_fir_process(Filter_FIR_t *fir, int16_t *block, uint32_t num_of_samples);
+
+void filter_biquad_init(Filter_Biquad_t *biquad, const int16_t coefficients[5]);
+void filter_biquad_reset(Filter_Biquad_t *biquad);
+uint32_t filter_biquad_process(Filter_Biquad_t *biquad, int16_t *block, uint32_t num_of_samples);
+
+int filter_cic_init(Filter_CIC_t *cic, uint8_t order, uint16_t ratio);
+void filter_cic_reset(Filter_CIC_t *cic);
+uint32_t filter_cic_process(Filter_CIC_t *cic, int16_t *block, uint32_t num_of_samples);
+
+int filter_pipeline_process(Filter_Stage_t *stages, uint8_t num_of_stages, int16_t *block, uint32_t num_of_samples);
+
+void filter_adc_to_q15(const void *adc_block, uint32_t num_of_samples, uint8_t resolution_in_bits, int16_t *block);
+
+//end file filter.h
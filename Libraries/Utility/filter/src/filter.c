@@ -0,0 +1,262 @@
+//File: filter.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Fixed-point FIR, biquad IIR and CIC decimator for Q15 sample blocks (see filter.h).
+    All products are 16x16 bit, so they fit into the 32 bit result of the M0+ multiplier (MULS, single cycle),
+    the sums are 64 bit (two instructions p. add on the M0+), no 64x64 bit multiplication is needed.
+
+*/
+
+
+//Corresponding header-file:
+#include "filter.h"
+
+//Libraries:
+
+//Standard-C:
+#include <stddef.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Functions:
+
+//File global (static) function definitions:
+
+static inline int16_t filter_saturate_q15(int64_t value) {
+
+    if(value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if(value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+
+}//end filter_saturate_q15
+
+//Function definition:
+
+int filter_fir_init(Filter_FIR_t *fir, const int16_t *coefficients, uint16_t num_of_taps, int16_t *state) {
+
+    if(coefficients == NULL || state == NULL || num_of_taps == 0) {
+        return -1; //Error: wrong parameters
+    }
+    fir->coefficients = coefficients;
+    fir->state = state;
+    fir->num_of_taps = num_of_taps;
+    filter_fir_reset(fir);
+    return 1;
+
+}//end filter_fir_init
+
+void filter_fir_reset(Filter_FIR_t *fir) {
+
+    for(uint32_t k = 0; k < 2*(uint32_t)fir->num_of_taps; k++) {
+        fir->state[k] = 0;
+    }
+    fir->state_index = 0;
+
+}//end filter_fir_reset
+
+uint32_t filter_fir_process(Filter_FIR_t *fir, int16_t *block, uint32_t num_of_samples) {
+
+    uint16_t num_of_taps = fir->num_of_taps;
+    const int16_t *coefficients = fir->coefficients;
+    uint16_t index = fir->state_index;
+
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        //Newest sample at state[index] and state[index + num_of_taps], so state[index..index + num_of_taps - 1] is the whole delay line (newest first)
+        index = (index == 0) ? (num_of_taps - 1) : (index - 1);
+        fir->state[index] = block[n];
+        fir->state[index + num_of_taps] = block[n];
+
+        const int16_t *delay_line = &fir->state[index];
+        int64_t accumulator = 0;
+        for(uint16_t k = 0; k < num_of_taps; k++) {
+            accumulator += (int32_t)coefficients[k]*delay_line[k];
+        }
+        block[n] = filter_saturate_q15((accumulator + (1 << (FILTER_Q15_SHIFT - 1))) >> FILTER_Q15_SHIFT);
+    }
+
+    fir->state_index = index;
+    return num_of_samples;
+
+}//end filter_fir_process
+
+void filter_biquad_init(Filter_Biquad_t *biquad, const int16_t coefficients[5]) {
+
+    for(uint8_t k = 0; k < 5; k++) {
+        biquad->coefficients[k] = coefficients[k];
+    }
+    filter_biquad_reset(biquad);
+
+}//end filter_biquad_init
+
+void filter_biquad_reset(Filter_Biquad_t *biquad) {
+
+    biquad->x1 = 0;
+    biquad->x2 = 0;
+    biquad->y1 = 0;
+    biquad->y2 = 0;
+    biquad->error = 0;
+
+}//end filter_biquad_reset
+
+uint32_t filter_biquad_process(Filter_Biquad_t *biquad, int16_t *block, uint32_t num_of_samples) {
+
+    int32_t b0 = biquad->coefficients[0];
+    int32_t b1 = biquad->coefficients[1];
+    int32_t b2 = biquad->coefficients[2];
+    int32_t a1 = biquad->coefficients[3];
+    int32_t a2 = biquad->coefficients[4];
+    int16_t x1 = biquad->x1, x2 = biquad->x2, y1 = biquad->y1, y2 = biquad->y2;
+    int32_t error = biquad->error;
+
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        int16_t x0 = block[n];
+        //Error feedback: the truncated bits of the last output are added again, so the rounding error does not accumulate in the poles
+        int64_t accumulator = (int64_t)error;
+        accumulator += b0*x0;
+        accumulator += b1*x1;
+        accumulator += b2*x2;
+        accumulator -= a1*y1;
+        accumulator -= a2*y2;
+
+        int64_t y0 = accumulator >> FILTER_BIQUAD_COEFFICIENT_SHIFT;
+        error = (int32_t)(accumulator - (y0 << FILTER_BIQUAD_COEFFICIENT_SHIFT));
+        int16_t output = filter_saturate_q15(y0);
+        if(output != y0) {
+            error = 0; //Saturated, the error feedback would only wind up
+        }
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = output;
+        block[n] = output;
+    }
+
+    biquad->x1 = x1;
+    biquad->x2 = x2;
+    biquad->y1 = y1;
+    biquad->y2 = y2;
+    biquad->error = error;
+    return num_of_samples;
+
+}//end filter_biquad_process
+
+int filter_cic_init(Filter_CIC_t *cic, uint8_t order, uint16_t ratio) {
+
+    uint8_t ratio_shift = 0;
+
+    if(order == 0 || order > FILTER_CIC_MAX_ORDER || ratio == 0 || (ratio & (ratio - 1)) != 0) {
+        return -1; //Error: order out of range or ratio is not a power of two
+    }
+    while((1u << ratio_shift) < ratio) {
+        ratio_shift++;
+    }
+    if(order*ratio_shift > FILTER_CIC_MAX_BIT_GROWTH) {
+        return -1; //Error: integrators would overflow
+    }
+
+    cic->order = order;
+    cic->ratio_shift = ratio_shift;
+    filter_cic_reset(cic);
+    return 1;
+
+}//end filter_cic_init
+
+void filter_cic_reset(Filter_CIC_t *cic) {
+
+    for(uint8_t k = 0; k < FILTER_CIC_MAX_ORDER; k++) {
+        cic->integrator[k] = 0;
+        cic->comb[k] = 0;
+    }
+    cic->phase = 0;
+
+}//end filter_cic_reset
+
+uint32_t filter_cic_process(Filter_CIC_t *cic, int16_t *block, uint32_t num_of_samples) {
+
+    uint32_t num_of_outputs = 0;
+    uint16_t ratio_mask = (uint16_t)((1u << cic->ratio_shift) - 1);
+    //DC gain of the CIC is ratio^order
+    uint8_t gain_shift = cic->order*cic->ratio_shift;
+
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        //Integrators at the input rate, the overflow (modulo 2^32) is cancelled by the combs
+        uint32_t value = (uint32_t)(int32_t)block[n];
+        for(uint8_t k = 0; k < cic->order; k++) {
+            cic->integrator[k] = (int32_t)((uint32_t)cic->integrator[k] + value);
+            value = (uint32_t)cic->integrator[k];
+        }
+
+        cic->phase = (cic->phase + 1) & ratio_mask;
+        if(cic->phase != 0) {
+            continue;
+        }
+
+        //Combs at the output rate (differential delay 1)
+        for(uint8_t k = 0; k < cic->order; k++) {
+            uint32_t difference = value - (uint32_t)cic->comb[k];
+            cic->comb[k] = (int32_t)value;
+            value = difference;
+        }
+        int32_t output = (int32_t)value;
+        //Output index is never bigger than the input index, so the block could be used in place
+        block[num_of_outputs++] = filter_saturate_q15((output + ((1 << gain_shift) >> 1)) >> gain_shift);
+    }
+
+    return num_of_outputs;
+
+}//end filter_cic_process
+
+int filter_pipeline_process(Filter_Stage_t *stages, uint8_t num_of_stages, int16_t *block, uint32_t num_of_samples) {
+
+    for(uint8_t k = 0; k < num_of_stages; k++) {
+        switch(stages[k].type) {
+            case FILTER_FIR:
+                num_of_samples = filter_fir_process((Filter_FIR_t*)stages[k].filter, block, num_of_samples);
+                break;
+            case FILTER_BIQUAD:
+                num_of_samples = filter_biquad_process((Filter_Biquad_t*)stages[k].filter, block, num_of_samples);
+                break;
+            case FILTER_CIC:
+                num_of_samples = filter_cic_process((Filter_CIC_t*)stages[k].filter, block, num_of_samples);
+                break;
+            default:
+                return -1; //Error: unknown filter type
+        }
+    }
+
+    return (int)num_of_samples;
+
+}//end filter_pipeline_process
+
+void filter_adc_to_q15(const void *adc_block, uint32_t num_of_samples, uint8_t resolution_in_bits, int16_t *block) {
+
+    //Mid scale is 0, full scale is +-1 (Q15)
+    if(resolution_in_bits <= 8) {
+        const uint8_t *samples = (const uint8_t*)adc_block;
+        for(uint32_t k = 0; k < num_of_samples; k++) {
+            block[k] = (int16_t)(((int32_t)samples[k] - 128)*256);
+        }
+    }
+    else {
+        const uint16_t *samples = (const uint16_t*)adc_block;
+        uint8_t shift = 16 - resolution_in_bits;
+        int32_t mid_scale = 1 << (resolution_in_bits - 1);
+        for(uint32_t k = 0; k < num_of_samples; k++) {
+            block[k] = (int16_t)(((int32_t)samples[k] - mid_scale)*(1 << shift));
+        }
+    }
+
+}//end filter_adc_to_q15
+
+//end file filter.c
@@ -0,0 +1,40 @@
+//File: number_format.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Utility functions for printing numbers as text without printf (decimal, fixed-point decimal and hex).
+    The functions write straight into a buffer (e.g. the UART TX buffer) and return the number of written characters,
+    so several values could be appended to one line: n += number_format_uint32(&buffer[n], value);
+    Every function terminates the buffer with '\0' (not counted in the returned length).
+    The float formatting uses integer math only, the output matches sprintf("%.<decimals>f") for |value| < 2^64
+    (larger values are written as "ovf", NaN as "nan" without sign).
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Maximum number of characters written by one call (without '\0')
+#define NUMBER_FORMAT_MAX_UINT32_LENGTH 10
+#define NUMBER_FORMAT_MAX_INT32_LENGTH 11
+#define NUMBER_FORMAT_MAX_DECIMALS 9
+#define NUMBER_FORMAT_MAX_FIXED_LENGTH (1 + 20 + 1 + NUMBER_FORMAT_MAX_DECIMALS)
+
+//Type definitions:
+
+//Function Prototypes:
+
+uint16_t number_format_string(uint8_t *buffer, const char *string);
+uint16_t number_format_char(uint8_t *buffer, char character);
+uint16_t number_format_uint32(uint8_t *buffer, uint32_t value);
+uint16_t number_format_int32(uint8_t *buffer, int32_t value);
+uint16_t number_format_hex8(uint8_t *buffer, uint8_t value);
+uint16_t number_format_hex32(uint8_t *buffer, uint32_t value);
+uint16_t number_format_fixed(uint8_t *buffer, float value, uint8_t decimals);
+
+//end file number_format.h
@@ -0,0 +1,246 @@
+//File: number_format.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Utility functions for printing numbers as text without printf (decimal, fixed-point decimal and hex).
+    Decimal digits are written in pairs from a lookup table (one division p. two digits).
+    Floats are split into integer and fractional part with the bits of the IEEE-754 representation,
+    so no float (or double) arithmetic is needed and the rounding (half to even) is exact like sprintf("%f").
+
+*/
+
+
+//Corresponding header-file:
+#include "number_format.h"
+
+//Libraries:
+
+//Standard-C:
+#include <string.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+#define NUMBER_FORMAT_FLOAT_MANTISSA_BITS 23
+#define NUMBER_FORMAT_FLOAT_EXPONENT_BIAS 150
+
+//File global (static) variables:
+
+//Two decimal digits p. value 0-99
+static const char number_format_digit_pairs[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static const char number_format_hex_digits[16] = {
+    '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'
+};
+
+static const uint32_t number_format_power_of_ten[NUMBER_FORMAT_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Writes exactly num_of_digits digits (with leading zeros) of value, buffer is not terminated
+static void number_format_write_digits(uint8_t *buffer, uint32_t value, uint8_t num_of_digits) {
+
+    while(num_of_digits >= 2) {
+        uint32_t pair = value%100;
+        value = value/100;
+        num_of_digits -= 2;
+        buffer[num_of_digits] = (uint8_t)number_format_digit_pairs[2*pair];
+        buffer[num_of_digits + 1] = (uint8_t)number_format_digit_pairs[2*pair + 1];
+    }
+    if(num_of_digits == 1) {
+        buffer[0] = (uint8_t)('0' + value%10);
+    }
+
+}//end number_format_write_digits
+
+static uint8_t number_format_count_digits(uint32_t value) {
+
+    uint8_t num_of_digits = 1;
+    while(num_of_digits < 10 && value >= number_format_power_of_ten[num_of_digits]) {
+        num_of_digits++;
+    }
+    return num_of_digits;
+
+}//end number_format_count_digits
+
+//Integer part of a float could have up to 20 digits, written in chunks of 9 digits
+static uint16_t number_format_uint64(uint8_t *buffer, uint64_t value) {
+
+    uint32_t chunks[3];
+    uint8_t num_of_chunks = 0;
+    uint16_t length = 0;
+
+    if(value <= UINT32_MAX) {
+        return number_format_uint32(buffer, (uint32_t)value);
+    }
+
+    while(value > 0) {
+        chunks[num_of_chunks++] = (uint32_t)(value%1000000000);
+        value = value/1000000000;
+    }
+
+    length = number_format_uint32(buffer, chunks[num_of_chunks - 1]);
+    for(int8_t k = num_of_chunks - 2; k >= 0; k--) {
+        number_format_write_digits(&buffer[length], chunks[k], 9);
+        length += 9;
+    }
+    buffer[length] = '\0';
+
+    return length;
+
+}//end number_format_uint64
+
+//Function definition:
+
+uint16_t number_format_string(uint8_t *buffer, const char *string) {
+
+    uint16_t length = (uint16_t)strlen(string);
+    memcpy(buffer, string, length + 1);
+    return length;
+
+}//end number_format_string
+
+uint16_t number_format_char(uint8_t *buffer, char character) {
+
+    buffer[0] = (uint8_t)character;
+    buffer[1] = '\0';
+    return 1;
+
+}//end number_format_char
+
+uint16_t number_format_uint32(uint8_t *buffer, uint32_t value) {
+
+    uint8_t num_of_digits = number_format_count_digits(value);
+    number_format_write_digits(buffer, value, num_of_digits);
+    buffer[num_of_digits] = '\0';
+    return num_of_digits;
+
+}//end number_format_uint32
+
+uint16_t number_format_int32(uint8_t *buffer, int32_t value) {
+
+    if(value < 0) {
+        buffer[0] = '-';
+        //Cast before negation, -INT32_MIN does not fit into int32_t
+        return 1 + number_format_uint32(&buffer[1], (uint32_t)0 - (uint32_t)value);
+    }
+    return number_format_uint32(buffer, (uint32_t)value);
+
+}//end number_format_int32
+
+uint16_t number_format_hex8(uint8_t *buffer, uint8_t value) {
+
+    buffer[0] = (uint8_t)number_format_hex_digits[value >> 4];
+    buffer[1] = (uint8_t)number_format_hex_digits[value & 0x0F];
+    buffer[2] = '\0';
+    return 2;
+
+}//end number_format_hex8
+
+uint16_t number_format_hex32(uint8_t *buffer, uint32_t value) {
+
+    for(uint8_t k = 0; k < 8; k++) {
+        buffer[k] = (uint8_t)number_format_hex_digits[(value >> (28 - 4*k)) & 0x0F];
+    }
+    buffer[8] = '\0';
+    return 8;
+
+}//end number_format_hex32
+
+uint16_t number_format_fixed(uint8_t *buffer, float value, uint8_t decimals) {
+
+    uint32_t bits = 0;
+    uint16_t length = 0;
+    uint64_t integer_part = 0;
+    uint32_t fraction_part = 0;
+
+    if(decimals > NUMBER_FORMAT_MAX_DECIMALS) {
+        decimals = NUMBER_FORMAT_MAX_DECIMALS;
+    }
+
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t mantissa = bits & ((1u << NUMBER_FORMAT_FLOAT_MANTISSA_BITS) - 1);
+    uint32_t exponent = (bits >> NUMBER_FORMAT_FLOAT_MANTISSA_BITS) & 0xFF;
+
+    if(exponent == 0xFF && mantissa != 0) {
+        return number_format_string(buffer, "nan");
+    }
+    if(bits >> 31) {
+        buffer[length++] = '-';
+    }
+    if(exponent == 0xFF) {
+        return length + number_format_string(&buffer[length], "inf");
+    }
+
+    //value = mantissa*2^shift (subnormals have no hidden bit)
+    int32_t shift = 0;
+    if(exponent == 0) {
+        shift = 1 - NUMBER_FORMAT_FLOAT_EXPONENT_BIAS;
+    }
+    else {
+        mantissa |= (1u << NUMBER_FORMAT_FLOAT_MANTISSA_BITS);
+        shift = (int32_t)exponent - NUMBER_FORMAT_FLOAT_EXPONENT_BIAS;
+    }
+
+    if(shift >= 0) {
+        if(shift > (64 - NUMBER_FORMAT_FLOAT_MANTISSA_BITS - 1)) {
+            return length + number_format_string(&buffer[length], "ovf"); //Integer part does not fit into 64 bit
+        }
+        integer_part = (uint64_t)mantissa << shift;
+    }
+    else {
+        //fraction = fraction_bits/2^(-shift), fraction*10^decimals is exact in 64 bit (24 bit mantissa, 10^9 < 2^30)
+        uint32_t fraction_shift = (uint32_t)(-shift);
+        uint64_t fraction_bits = mantissa;
+        if(fraction_shift <= NUMBER_FORMAT_FLOAT_MANTISSA_BITS) {
+            integer_part = mantissa >> fraction_shift;
+            fraction_bits = mantissa & ((1u << fraction_shift) - 1);
+        }
+        //For shifts of 64 and more the fraction is below 2^-40, the scaled value rounds to 0
+        if(fraction_shift < 64) {
+            uint64_t scaled = fraction_bits*number_format_power_of_ten[decimals];
+            uint64_t remainder = scaled & ((1ull << fraction_shift) - 1);
+            uint64_t half = 1ull << (fraction_shift - 1);
+            fraction_part = (uint32_t)(scaled >> fraction_shift);
+
+            //Round half to even (like printf), the last printed digit is the integer part for 0 decimals
+            uint32_t last_digit = (decimals == 0) ? (uint32_t)integer_part : fraction_part;
+            if(remainder > half || (remainder == half && (last_digit & 1))) {
+                fraction_part++;
+                if(fraction_part >= number_format_power_of_ten[decimals]) {
+                    fraction_part = 0;
+                    integer_part++;
+                }
+            }
+        }
+    }
+
+    length += number_format_uint64(&buffer[length], integer_part);
+    if(decimals > 0) {
+        buffer[length++] = '.';
+        number_format_write_digits(&buffer[length], fraction_part, decimals);
+        length += decimals;
+    }
+    buffer[length] = '\0';
+
+    return length;
+
+}//end number_format_fixed
+
+//end file number_format.c
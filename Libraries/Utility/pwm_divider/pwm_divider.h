@@ -0,0 +1,50 @@
+//File: pwm_divider.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Integer solver for the divider (8.4 bit) and the wrap of a pwm slice (RP2040) for a frequency.
+    All 4080 dividers (1.0 ... 255.9375) are searched, for every divider the wrap nearest to the exact period is used.
+    The goal selects the smallest frequency error or the biggest wrap (resolution), the smallest allowed wrap is min_wrap.
+    pwm_solve_divider() returns 1 on success and -1 if no divider with a wrap from min_wrap to 65535 reaches the frequency.
+    A fractional divider gives the exact mean period, single periods jitter by one system clock cycle.
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Type definitions:
+
+typedef enum PWM_Divider_Goal_e {
+
+    //Smallest frequency error, the biggest wrap of all dividers with the same error
+    PWM_DIVIDER_MIN_ERROR = 0,
+    //Biggest wrap (resolution) of all dividers (with their nearest wrap), the smallest frequency error of all dividers with the same wrap
+    PWM_DIVIDER_MAX_WRAP,
+
+}PWM_Divider_Goal_t;
+
+typedef struct PWM_Divider_s {
+
+    //Divider of the system clock: div_int + div_frac/16
+    uint8_t div_int;
+    uint8_t div_frac;
+    uint16_t wrap;
+    //Exact period in 1/16 system clock cycles: (16*div_int + div_frac)*(wrap + 1)
+    uint32_t period_sixteenths;
+    //Achieved frequency (rounded) and its error to the target frequency
+    uint64_t frequency_millihertz;
+    int32_t error_ppm;
+
+}PWM_Divider_t;
+
+//Function Prototypes:
+
+int pwm_solve_divider(uint32_t system_clock_hz, uint32_t pwm_frequency_hz, uint16_t min_wrap, PWM_Divider_Goal_t goal, PWM_Divider_t *divider);
+
+//end file pwm_divider.h
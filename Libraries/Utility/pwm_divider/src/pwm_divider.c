@@ -0,0 +1,122 @@
+//File: pwm_divider.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Integer solver for the divider (8.4 bit) and the wrap of a pwm slice (RP2040) for a frequency.
+    The period is compared in 1/16 system clock cycles, so the search does not need any floating point math.
+
+*/
+
+
+//Corresponding header-file:
+#include "pwm_divider.h"
+
+//Libraries:
+
+//Standard-C:
+#include <stdbool.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Compares two candidates of the divider solver: error_a/period_a < error_b/period_b (errors in 1/16 Hz*period, cross-multiplied)
+static bool pwm_divider_error_is_smaller(uint64_t error_a, uint64_t period_a, uint64_t error_b, uint64_t period_b) {
+
+    return error_a*period_b < error_b*period_a;
+
+}//end pwm_divider_error_is_smaller
+
+//Function definition:
+
+int pwm_solve_divider(uint32_t system_clock_hz, uint32_t pwm_frequency_hz, uint16_t min_wrap, PWM_Divider_Goal_t goal, PWM_Divider_t *divider) {
+
+    //Period in 1/16 system clock cycles: 16*system_clock/pwm_frequency
+    uint64_t clock_sixteenths = 16*(uint64_t)system_clock_hz;
+    bool found = false;
+    uint32_t best_div = 0;
+    uint32_t best_wrap_plus_one = 0;
+    uint64_t best_error = 0;
+    uint64_t best_period = 0;
+
+    if(pwm_frequency_hz == 0 || system_clock_hz == 0) {
+        return -1; //Error: no frequency
+    }
+
+    for(uint32_t div = 16; div <= 255*16 + 15; div++) {
+
+        uint64_t wrap_plus_one = clock_sixteenths/((uint64_t)pwm_frequency_hz*div);
+        uint64_t divider_wrap_plus_one = 0;
+        uint64_t divider_error = 0;
+        uint64_t divider_period = 0;
+
+        //The nearest wrap of this divider is below or above the exact period
+        for(uint8_t k = 0; k < 2; k++, wrap_plus_one++) {
+
+            if(wrap_plus_one < (uint64_t)min_wrap + 1 || wrap_plus_one > (uint64_t)UINT16_MAX + 1) {
+                continue;
+            }
+
+            uint64_t period = div*wrap_plus_one;
+            uint64_t frequency_period = (uint64_t)pwm_frequency_hz*period;
+            //Frequency error times period (1/16 Hz)
+            uint64_t error = (frequency_period > clock_sixteenths) ? (frequency_period - clock_sixteenths) : (clock_sixteenths - frequency_period);
+
+            if(divider_wrap_plus_one == 0 || pwm_divider_error_is_smaller(error, period, divider_error, divider_period)) {
+                divider_wrap_plus_one = wrap_plus_one;
+                divider_error = error;
+                divider_period = period;
+            }
+        }
+        if(divider_wrap_plus_one == 0) {
+            continue;
+        }
+
+        bool is_better = false;
+        if(!found) {
+            is_better = true;
+        }
+        else if(goal == PWM_DIVIDER_MAX_WRAP) {
+            is_better = divider_wrap_plus_one > best_wrap_plus_one ||
+                (divider_wrap_plus_one == best_wrap_plus_one && pwm_divider_error_is_smaller(divider_error, divider_period, best_error, best_period));
+        }
+        else {
+            is_better = pwm_divider_error_is_smaller(divider_error, divider_period, best_error, best_period) ||
+                (!pwm_divider_error_is_smaller(best_error, best_period, divider_error, divider_period) && divider_wrap_plus_one > best_wrap_plus_one);
+        }
+
+        if(is_better) {
+            found = true;
+            best_div = div;
+            best_wrap_plus_one = (uint32_t)divider_wrap_plus_one;
+            best_error = divider_error;
+            best_period = divider_period;
+        }
+    }
+
+    if(!found) {
+        return -1; //Error: frequency not reachable with a wrap from min_wrap to 65535
+    }
+
+    divider->div_int = (uint8_t)(best_div/16);
+    divider->div_frac = (uint8_t)(best_div%16);
+    divider->wrap = (uint16_t)(best_wrap_plus_one - 1);
+    divider->period_sixteenths = (uint32_t)best_period;
+    divider->frequency_millihertz = (1000*clock_sixteenths + best_period/2)/best_period;
+    //Relative error: (frequency - target)/target in ppm, rounded, from the exact period (the rounded frequency is to coarse for low frequencies)
+    int64_t error_period = (int64_t)clock_sixteenths - (int64_t)pwm_frequency_hz*(int64_t)best_period;
+    int64_t target_period = (int64_t)pwm_frequency_hz*(int64_t)best_period;
+    divider->error_ppm = (int32_t)((error_period*1000000 + ((error_period < 0) ? -target_period/2 : target_period/2))/target_period);
+
+    return 1;
+
+}//end pwm_solve_divider
+
+//end file pwm_divider.c
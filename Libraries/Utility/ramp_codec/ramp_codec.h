@@ -0,0 +1,47 @@
+//File: ramp_codec.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Lossless compression of adc ramp captures (samples of a dac ramp, samples_per_step samples p. step).
+    The samples are predicted by a linear model of the ramp (expected value = offset + step*gain, least squares fit),
+    only the residuals are stored: zig-zag mapped and Rice coded with an own Rice parameter p. group of RAMP_CODEC_GROUP_SIZE samples.
+    A residual that does not fit the Rice code (wrong sample, glitch) is stored raw after an escape, so the coding is lossless for all inputs.
+    Every encoded chunk starts with a header (first sample index, number of samples and the model), so chunks could be decoded on
+    their own (e.g. one chunk p. result frame).
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+
+//Preprocessor constants:
+
+//Header: first sample (uint32), number of samples (uint32), offset (int32), gain (int32), samples p. step (uint16)
+#define RAMP_CODEC_HEADER_SIZE 18
+//Samples p. Rice parameter
+#define RAMP_CODEC_GROUP_SIZE 32
+//Maximum size of an encoded chunk of num_of_samples samples (every residual escaped)
+#define RAMP_CODEC_MAX_ENCODED_LENGTH(num_of_samples) (RAMP_CODEC_HEADER_SIZE + ((num_of_samples)*33 + ((num_of_samples)/RAMP_CODEC_GROUP_SIZE + 1)*4 + 7)/8)
+
+//Type definitions:
+
+typedef struct Ramp_Codec_Model_s {
+
+    //Expected value of step s: (offset_q16 + s*gain_q16)/2^16 (rounded)
+    int32_t offset_q16;
+    int32_t gain_q16;
+    uint16_t samples_per_step;
+
+}Ramp_Codec_Model_t;
+
+//Function Prototypes:
+
+void ramp_codec_fit_model(const uint16_t *samples, uint32_t num_of_samples, uint16_t samples_per_step, Ramp_Codec_Model_t *model);
+int32_t ramp_codec_encode(const uint16_t *samples, uint32_t first_sample, uint32_t num_of_samples, const Ramp_Codec_Model_t *model,
+    uint8_t *encoded, uint32_t max_length, uint32_t *num_of_encoded_samples);
+int32_t ramp_codec_decode(const uint8_t *encoded, uint32_t encoded_length, uint16_t *samples, uint32_t max_samples, uint32_t *first_sample);
+
+//end file ramp_codec.h
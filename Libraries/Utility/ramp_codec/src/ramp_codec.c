@@ -0,0 +1,333 @@
+//File: ramp_codec.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Lossless compression of adc ramp captures with a linear ramp model and Rice coded residuals.
+    Bit stream (MSB first): p. group a 4 bit Rice parameter k, then p. sample the zig-zag mapped residual u as
+    unary quotient (u >> k ones and a zero) and the k low bits of u. A quotient of RAMP_CODEC_ESCAPE_LENGTH or more is
+    written as RAMP_CODEC_ESCAPE_LENGTH ones followed by u with RAMP_CODEC_RAW_BITS bits.
+    The encoder takes the k with the fewest bits for every group (exact cost), the decoder reads 32 bits at once and
+    counts the ones of the quotient with one count leading zeros instruction.
+    The model uses integer math only, so encoder (pico) and decoder (host) predict exactly the same values.
+
+*/
+
+
+//Corresponding header-file:
+#include "ramp_codec.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Own Libraries:
+#include "data_to_byte.h"
+
+//Preprocessor constants:
+#define RAMP_CODEC_PARAMETER_BITS 4
+#define RAMP_CODEC_MAX_PARAMETER 15
+#define RAMP_CODEC_ESCAPE_LENGTH 16
+//Residuals of uint16_t samples are -65535 ... 65535, 17 bit after the zig-zag mapping
+#define RAMP_CODEC_RAW_BITS 17
+
+//Type definitions:
+
+typedef struct Ramp_Codec_Bit_Writer_s {
+
+    uint8_t *data;
+    uint32_t byte_index;
+    uint32_t buffer;
+    uint8_t number_of_bits;
+
+}Ramp_Codec_Bit_Writer_t;
+
+typedef struct Ramp_Codec_Bit_Reader_s {
+
+    const uint8_t *data;
+    uint32_t length;
+    uint32_t byte_index;
+    //Left aligned, number_of_bits valid bits
+    uint32_t buffer;
+    uint8_t number_of_bits;
+
+}Ramp_Codec_Bit_Reader_t;
+
+//File global (static) variables:
+
+//Functions:
+
+//File global (static) function definitions:
+
+static inline uint16_t ramp_codec_expected_value(const Ramp_Codec_Model_t *model, uint32_t sample_index) {
+
+    int64_t step = (int64_t)(sample_index/model->samples_per_step);
+    int64_t expected = ((int64_t)model->offset_q16 + step*(int64_t)model->gain_q16 + 32768)/65536;
+
+    if(expected < 0) {
+        return 0;
+    }
+    if(expected > UINT16_MAX) {
+        return UINT16_MAX;
+    }
+    return (uint16_t)expected;
+
+}//end ramp_codec_expected_value
+
+static inline uint32_t ramp_codec_zig_zag(const Ramp_Codec_Model_t *model, const uint16_t *samples, uint32_t sample_index) {
+
+    int32_t residual = (int32_t)samples[sample_index] - (int32_t)ramp_codec_expected_value(model, sample_index);
+    return (residual >= 0) ? ((uint32_t)residual << 1) : ((((uint32_t)(-residual)) << 1) - 1);
+
+}//end ramp_codec_zig_zag
+
+static inline int32_t ramp_codec_un_zig_zag(uint32_t value) {
+
+    return (value & 1) ? -(int32_t)((value + 1) >> 1) : (int32_t)(value >> 1);
+
+}//end ramp_codec_un_zig_zag
+
+static inline uint32_t ramp_codec_code_length(uint32_t value, uint8_t k) {
+
+    uint32_t quotient = value >> k;
+    if(quotient >= RAMP_CODEC_ESCAPE_LENGTH) {
+        return RAMP_CODEC_ESCAPE_LENGTH + RAMP_CODEC_RAW_BITS;
+    }
+    return quotient + 1 + k;
+
+}//end ramp_codec_code_length
+
+//Writes up to 24 bits
+static inline void ramp_codec_write_bits(Ramp_Codec_Bit_Writer_t *writer, uint32_t value, uint8_t number_of_bits) {
+
+    writer->buffer = (writer->buffer << number_of_bits) | (value & ((1u << number_of_bits) - 1));
+    writer->number_of_bits += number_of_bits;
+    while(writer->number_of_bits >= 8) {
+        writer->number_of_bits -= 8;
+        writer->data[writer->byte_index++] = (uint8_t)(writer->buffer >> writer->number_of_bits);
+    }
+
+}//end ramp_codec_write_bits
+
+static inline void ramp_codec_flush_bits(Ramp_Codec_Bit_Writer_t *writer) {
+
+    if(writer->number_of_bits > 0) {
+        writer->data[writer->byte_index++] = (uint8_t)(writer->buffer << (8 - writer->number_of_bits));
+        writer->number_of_bits = 0;
+    }
+
+}//end ramp_codec_flush_bits
+
+//Refills the reader to at least 25 valid bits (zeros after the end of the data)
+static inline void ramp_codec_refill(Ramp_Codec_Bit_Reader_t *reader) {
+
+    while(reader->number_of_bits <= 24) {
+        uint32_t byte = (reader->byte_index < reader->length) ? reader->data[reader->byte_index] : 0;
+        reader->byte_index++;
+        reader->buffer |= byte << (24 - reader->number_of_bits);
+        reader->number_of_bits += 8;
+    }
+
+}//end ramp_codec_refill
+
+//Reads up to 24 bits
+static inline uint32_t ramp_codec_read_bits(Ramp_Codec_Bit_Reader_t *reader, uint8_t number_of_bits) {
+
+    if(number_of_bits == 0) {
+        return 0;
+    }
+    ramp_codec_refill(reader);
+    uint32_t value = reader->buffer >> (32 - number_of_bits);
+    reader->buffer <<= number_of_bits;
+    reader->number_of_bits -= number_of_bits;
+    return value;
+
+}//end ramp_codec_read_bits
+
+//Counts the ones of the unary quotient (stops at RAMP_CODEC_ESCAPE_LENGTH) and removes them with the terminating zero
+static inline uint32_t ramp_codec_read_unary(Ramp_Codec_Bit_Reader_t *reader) {
+
+    ramp_codec_refill(reader);
+    uint32_t inverted = ~reader->buffer;
+    uint32_t ones = (inverted == 0) ? 32 : (uint32_t)__builtin_clz(inverted);
+
+    if(ones >= RAMP_CODEC_ESCAPE_LENGTH) {
+        reader->buffer <<= RAMP_CODEC_ESCAPE_LENGTH;
+        reader->number_of_bits -= RAMP_CODEC_ESCAPE_LENGTH;
+        return RAMP_CODEC_ESCAPE_LENGTH;
+    }
+    reader->buffer <<= (ones + 1);
+    reader->number_of_bits -= (uint8_t)(ones + 1);
+    return ones;
+
+}//end ramp_codec_read_unary
+
+//Function definition:
+
+void ramp_codec_fit_model(const uint16_t *samples, uint32_t num_of_samples, uint16_t samples_per_step, Ramp_Codec_Model_t *model) {
+
+    //Integer sums (exact), least squares of sample over step index
+    uint64_t sum_step = 0;
+    uint64_t sum_step_square = 0;
+    uint64_t sum_sample = 0;
+    uint64_t sum_step_sample = 0;
+
+    if(samples_per_step == 0) {
+        samples_per_step = 1;
+    }
+    model->samples_per_step = samples_per_step;
+    model->offset_q16 = 0;
+    model->gain_q16 = 0;
+
+    if(num_of_samples == 0) {
+        return;
+    }
+
+    for(uint32_t k = 0; k < num_of_samples; k++) {
+        uint64_t step = k/samples_per_step;
+        sum_step += step;
+        sum_step_square += step*step;
+        sum_sample += samples[k];
+        sum_step_sample += step*samples[k];
+    }
+
+    double n = (double)num_of_samples;
+    double denominator = n*(double)sum_step_square - (double)sum_step*(double)sum_step;
+    double gain = 0;
+    if(denominator > 0) {
+        gain = (n*(double)sum_step_sample - (double)sum_step*(double)sum_sample)/denominator;
+    }
+    double offset = ((double)sum_sample - gain*(double)sum_step)/n;
+
+    //Limited to the int32_t range, a wrong model only costs compression
+    double gain_q16 = gain*65536.0;
+    double offset_q16 = offset*65536.0;
+    if(gain_q16 > INT32_MAX || gain_q16 < INT32_MIN) {
+        gain_q16 = 0;
+    }
+    if(offset_q16 > INT32_MAX || offset_q16 < INT32_MIN) {
+        offset_q16 = 0;
+    }
+    model->gain_q16 = (int32_t)(gain_q16 + ((gain_q16 >= 0) ? 0.5 : -0.5));
+    model->offset_q16 = (int32_t)(offset_q16 + ((offset_q16 >= 0) ? 0.5 : -0.5));
+
+}//end ramp_codec_fit_model
+
+int32_t ramp_codec_encode(const uint16_t *samples, uint32_t first_sample, uint32_t num_of_samples, const Ramp_Codec_Model_t *model,
+    uint8_t *encoded, uint32_t max_length, uint32_t *num_of_encoded_samples) {
+
+    Ramp_Codec_Bit_Writer_t writer = {encoded, RAMP_CODEC_HEADER_SIZE, 0, 0};
+    uint64_t available_bits = 0;
+    uint32_t k = 0;
+
+    *num_of_encoded_samples = 0;
+    if(max_length < RAMP_CODEC_HEADER_SIZE + 1 || model->samples_per_step == 0) {
+        return -1; //Error: no space for the header or wrong model
+    }
+    available_bits = 8*(uint64_t)(max_length - RAMP_CODEC_HEADER_SIZE);
+
+    while(k < num_of_samples) {
+
+        uint32_t group_size = num_of_samples - k;
+        if(group_size > RAMP_CODEC_GROUP_SIZE) {
+            group_size = RAMP_CODEC_GROUP_SIZE;
+        }
+
+        //Rice parameter with the fewest bits for the group
+        uint32_t values[RAMP_CODEC_GROUP_SIZE];
+        for(uint32_t j = 0; j < group_size; j++) {
+            values[j] = ramp_codec_zig_zag(model, samples, first_sample + k + j);
+        }
+        uint8_t best_parameter = 0;
+        uint32_t best_length = UINT32_MAX;
+        for(uint8_t parameter = 0; parameter <= RAMP_CODEC_MAX_PARAMETER; parameter++) {
+            uint32_t length = RAMP_CODEC_PARAMETER_BITS;
+            for(uint32_t j = 0; j < group_size; j++) {
+                length += ramp_codec_code_length(values[j], parameter);
+            }
+            if(length < best_length) {
+                best_length = length;
+                best_parameter = parameter;
+            }
+        }
+
+        //Only complete groups are written
+        if(best_length > available_bits) {
+            break;
+        }
+        available_bits -= best_length;
+
+        ramp_codec_write_bits(&writer, best_parameter, RAMP_CODEC_PARAMETER_BITS);
+        for(uint32_t j = 0; j < group_size; j++) {
+            uint32_t quotient = values[j] >> best_parameter;
+            if(quotient >= RAMP_CODEC_ESCAPE_LENGTH) {
+                ramp_codec_write_bits(&writer, (1u << RAMP_CODEC_ESCAPE_LENGTH) - 1, RAMP_CODEC_ESCAPE_LENGTH);
+                ramp_codec_write_bits(&writer, values[j], RAMP_CODEC_RAW_BITS);
+            }
+            else {
+                //Quotient ones and the terminating zero
+                ramp_codec_write_bits(&writer, ((1u << quotient) - 1) << 1, (uint8_t)(quotient + 1));
+                ramp_codec_write_bits(&writer, values[j], best_parameter);
+            }
+        }
+        k += group_size;
+    }
+    ramp_codec_flush_bits(&writer);
+
+    uint32_t_to_byte_array(first_sample, &encoded[0]);
+    uint32_t_to_byte_array(k, &encoded[4]);
+    int32_t_to_byte_array(model->offset_q16, &encoded[8]);
+    int32_t_to_byte_array(model->gain_q16, &encoded[12]);
+    uint16_t_to_byte_array(model->samples_per_step, &encoded[16]);
+
+    *num_of_encoded_samples = k;
+    return (int32_t)writer.byte_index;
+
+}//end ramp_codec_encode
+
+int32_t ramp_codec_decode(const uint8_t *encoded, uint32_t encoded_length, uint16_t *samples, uint32_t max_samples, uint32_t *first_sample) {
+
+    Ramp_Codec_Model_t model;
+    Ramp_Codec_Bit_Reader_t reader = {encoded, encoded_length, RAMP_CODEC_HEADER_SIZE, 0, 0};
+
+    if(encoded_length < RAMP_CODEC_HEADER_SIZE) {
+        return -1; //Error: no header
+    }
+    *first_sample = byte_array_to_uint32_t((uint8_t*)&encoded[0]);
+    uint32_t num_of_samples = byte_array_to_uint32_t((uint8_t*)&encoded[4]);
+    model.offset_q16 = (int32_t)byte_array_to_int32_t((uint8_t*)&encoded[8]);
+    model.gain_q16 = (int32_t)byte_array_to_int32_t((uint8_t*)&encoded[12]);
+    model.samples_per_step = (uint16_t)byte_array_to_uint16_t((uint8_t*)&encoded[16]);
+
+    if(num_of_samples > max_samples) {
+        return -2; //Error: output buffer is to small
+    }
+    if(model.samples_per_step == 0) {
+        return -1; //Error: wrong header
+    }
+
+    uint8_t parameter = 0;
+    for(uint32_t k = 0; k < num_of_samples; k++) {
+        if((k%RAMP_CODEC_GROUP_SIZE) == 0) {
+            parameter = (uint8_t)ramp_codec_read_bits(&reader, RAMP_CODEC_PARAMETER_BITS);
+        }
+        uint32_t value = ramp_codec_read_unary(&reader);
+        if(value >= RAMP_CODEC_ESCAPE_LENGTH) {
+            value = ramp_codec_read_bits(&reader, RAMP_CODEC_RAW_BITS);
+        }
+        else {
+            value = (value << parameter) | ramp_codec_read_bits(&reader, parameter);
+        }
+        samples[k] = (uint16_t)((int32_t)ramp_codec_expected_value(&model, *first_sample + k) + ramp_codec_un_zig_zag(value));
+    }
+
+    //The reader must not run over the end of the data (truncated chunk)
+    if(8*(uint64_t)reader.byte_index - reader.number_of_bits > 8*(uint64_t)encoded_length) {
+        return -3; //Error: data is truncated
+    }
+
+    return (int32_t)num_of_samples;
+
+}//end ramp_codec_decode
+
+//end file ramp_codec.c
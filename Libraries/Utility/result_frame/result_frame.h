@@ -0,0 +1,104 @@
+//File: result_frame.h
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Utility functions to pack test results into binary frames for the export over UART, and to unpack them again (host side).
+
+    Frame layout before encoding (all values little endian):
+
+        Byte 0:     Magic byte (RESULT_FRAME_MAGIC)
+        Byte 1:     Version of the frame layout (RESULT_FRAME_VERSION)
+        Byte 2:     Test type (UART, SPI, ADC - same values as Test_Type_t of the test suite)
+        Byte 3:     Record type (what the payload contains)
+        Byte 4-5:   Index of the frame in the export stream
+        Byte 6-7:   Number of frames in the export stream
+        Byte 8-9:   Payload length in bytes
+        Byte 10-n:  Payload
+        Byte n-n+3: CRC-32 over header and payload
+
+    The frame is COBS encoded and enclosed by zero bytes, so the receiver could always re-synchronise on the next zero byte,
+    even if text output or corrupted bytes are in between.
+
+    Optional forward error correction (see fec.h): if enabled with result_frame_set_fec() the COBS encoded frame is protected with
+    interleaved Reed-Solomon codes, so the fec covers the bytes on the line and a burst could not spread over a COBS block.
+    The parity bytes are sent with 7 bit p. byte (top bit set), so they contain no zero byte either:
+
+        0, COBS encoded frame, parity bytes (7 bit p. byte), 0
+
+    The length of the COBS encoded frame follows from the frame length. Receiver and transmitter need the same configuration.
+    Wrong bytes are corrected in place. The receiver splits the stream on the zero delimiters once and decodes every segment exactly once,
+    a frame with a corrupted delimiter (split or merged with the next frame) is dropped.
+    The frames are sent over the UART with uart_result_send() (see uart_result.h).
+    NOTE: This module is not multi-core-save (static frame buffer)
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdint.h>
+
+//Own Libraries:
+#include "cobs.h"
+#include "fec.h"
+
+//Preprocessor constants:
+
+#define RESULT_FRAME_MAGIC 0xA5
+#define RESULT_FRAME_VERSION 1
+
+#define RESULT_FRAME_HEADER_SIZE 10
+#define RESULT_FRAME_CRC_SIZE 4
+#define RESULT_FRAME_MAX_PAYLOAD_SIZE 1024
+
+//Size of the raw frame, of the COBS encoded frame, of the COBS encoded frame with fec and maximum size of an encoded frame with both zero delimiters
+#define RESULT_FRAME_MAX_RAW_SIZE (RESULT_FRAME_HEADER_SIZE + RESULT_FRAME_MAX_PAYLOAD_SIZE + RESULT_FRAME_CRC_SIZE)
+#define RESULT_FRAME_MAX_COBS_SIZE COBS_MAX_ENCODED_LENGTH(RESULT_FRAME_MAX_RAW_SIZE)
+#define RESULT_FRAME_MAX_FEC_SIZE FEC_MAX_ENCODED_LENGTH(RESULT_FRAME_MAX_COBS_SIZE)
+#define RESULT_FRAME_MAX_ENCODED_SIZE (RESULT_FRAME_MAX_COBS_SIZE + ((RESULT_FRAME_MAX_FEC_SIZE - RESULT_FRAME_MAX_COBS_SIZE)*8 + 6)/7 + 2)
+
+//Test types - same values as Test_Type_t inside test_suite.h
+#define RESULT_FRAME_TEST_UART 0
+#define RESULT_FRAME_TEST_SPI 1
+#define RESULT_FRAME_TEST_ADC 2
+
+//Type definitions:
+
+typedef enum Result_Frame_Record_Type_e {
+
+    //Parameters of the test (first frame of every test)
+    RECORD_TEST_PARAMETER = 0,
+    //Raw 8-bit adc samples
+    RECORD_ADC_RAW_SAMPLES,
+    //Mean value and standard deviation per ramp step as float pairs
+    RECORD_ADC_MEAN_STD,
+    //Transfer of a uart or spi test: transfer nr., number of bytes, tx bytes, rx bytes
+    RECORD_TRANSFER,
+    //Raw adc samples with more than 8 bit (12-bit mode, oversampled) as uint16
+    RECORD_ADC_RAW_SAMPLES_16,
+    //Peaks of the adc noise spectrum: frequency (Hz) and amplitude (V) as float pairs
+    RECORD_ADC_SPECTRAL_PEAKS,
+    //Code density histogram of the adc: count p. code as uint32
+    RECORD_ADC_HISTOGRAM,
+    //Adc samples as residuals against the fitted ramp, one chunk p. frame (see ramp_codec.h)
+    RECORD_ADC_RAMP_CODED,
+
+}Result_Frame_Record_Type_t;
+
+typedef struct Result_Frame_Header_s {
+
+    uint8_t test_type;
+    uint8_t record_type;
+    uint16_t frame_index;
+    uint16_t frame_count;
+    uint16_t payload_length;
+
+}Result_Frame_Header_t;
+
+//Function Prototypes:
+
+int result_frame_encode(Result_Frame_Header_t header, const uint8_t *payload, uint8_t *encoded_frame);
+int result_frame_decode(const uint8_t *encoded_frame, uint32_t encoded_length, Result_Frame_Header_t *header, uint8_t *payload);
+int result_frame_set_fec(Fec_Config_t fec_config);
+uint32_t result_frame_get_corrected_bytes(void);
+
+//end file result_frame.h
@@ -0,0 +1,281 @@
+//File: result_frame.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+
+    Utility functions to pack test results into binary frames for the export over UART, and to unpack them again (host side).
+    The frame is made of a small header, the payload and a CRC-32. It is COBS encoded, optionally protected by fec and enclosed by zero bytes.
+    For the exact layout see result_frame.h.
+
+*/
+
+
+//Corresponding header-file:
+#include "result_frame.h"
+
+//Libraries:
+
+//Standard-C:
+
+//Own Libraries:
+#include "crc.h"
+#include "data_to_byte.h"
+
+//Preprocessor constants:
+
+//File global (static) variables:
+
+//Raw (not encoded) frame
+static uint8_t raw_frame[RESULT_FRAME_MAX_RAW_SIZE];
+
+//COBS encoded frame, COBS encoded frame with fec parity bytes, fec configuration (no fec by default) and number of corrected bytes
+static uint8_t cobs_frame[RESULT_FRAME_MAX_COBS_SIZE];
+static uint8_t fec_frame[RESULT_FRAME_MAX_FEC_SIZE];
+static Fec_Config_t frame_fec_config = {0, 0};
+static uint32_t fec_corrected_bytes = 0;
+
+//Functions:
+
+//File global (static) function definitions:
+
+//Number of bytes of the parity bytes with 7 bit p. byte
+static uint32_t result_frame_get_packed_length(uint32_t num_of_parity_bytes) {
+
+    return (num_of_parity_bytes*8 + 6)/7;
+
+}//end result_frame_get_packed_length
+
+//Sends the parity bytes with 7 bit p. byte (msb first), the top bit is set so no byte is zero
+static uint32_t result_frame_pack_parity(const uint8_t *parity, uint32_t num_of_parity_bytes, uint8_t *packed) {
+
+    uint32_t bits = 0;
+    uint8_t num_of_bits = 0;
+    uint32_t packed_length = 0;
+
+    for(uint32_t k = 0; k < num_of_parity_bytes; k++) {
+        bits = (bits << 8) | parity[k];
+        num_of_bits += 8;
+        while(num_of_bits >= 7) {
+            num_of_bits -= 7;
+            packed[packed_length] = 0x80 | (uint8_t)((bits >> num_of_bits) & 0x7F);
+            packed_length++;
+        }
+    }
+    if(num_of_bits > 0) {
+        packed[packed_length] = 0x80 | (uint8_t)((bits << (7 - num_of_bits)) & 0x7F);
+        packed_length++;
+    }
+
+    return packed_length;
+
+}//end result_frame_pack_parity
+
+//Parity bytes back from the 7 bit p. byte format
+static void result_frame_unpack_parity(const uint8_t *packed, uint32_t num_of_parity_bytes, uint8_t *parity) {
+
+    uint32_t bits = 0;
+    uint8_t num_of_bits = 0;
+    uint32_t k = 0;
+
+    while(k < num_of_parity_bytes) {
+        bits = (bits << 7) | (*packed & 0x7F);
+        packed++;
+        num_of_bits += 7;
+        if(num_of_bits >= 8) {
+            num_of_bits -= 8;
+            parity[k] = (uint8_t)(bits >> num_of_bits);
+            k++;
+        }
+    }
+
+}//end result_frame_unpack_parity
+
+//Length of the COBS encoded frame in a frame with fec (without zero delimiters), the number of parity bytes depends on the interleave depth
+static int32_t result_frame_get_cobs_length(uint32_t encoded_length) {
+
+    for(uint32_t depth = 1; depth <= FEC_MAX_INTERLEAVE_DEPTH; depth++) {
+        uint32_t num_of_parity_bytes = depth*frame_fec_config.num_of_parity_bytes;
+        uint32_t packed_length = result_frame_get_packed_length(num_of_parity_bytes);
+        if(encoded_length <= packed_length || (encoded_length - packed_length) > RESULT_FRAME_MAX_COBS_SIZE) {
+            continue;
+        }
+        uint32_t cobs_length = encoded_length - packed_length;
+        if(fec_get_encoded_length(frame_fec_config, cobs_length) == (int32_t)(cobs_length + num_of_parity_bytes)) {
+            return (int32_t)cobs_length;
+        }
+    }
+
+    return -1; //Error: no frame has this length
+
+}//end result_frame_get_cobs_length
+
+//Corrects the COBS encoded frame with the parity bytes and decodes it into the raw frame
+static int32_t result_frame_decode_fec(const uint8_t *encoded_frame, uint32_t encoded_length, uint32_t *corrected_bytes) {
+
+    int32_t cobs_length = result_frame_get_cobs_length(encoded_length);
+    if(cobs_length < 0) {
+        return -1; //Error: wrong frame length
+    }
+
+    uint32_t num_of_parity_bytes = (uint32_t)fec_get_encoded_length(frame_fec_config, (uint32_t)cobs_length) - (uint32_t)cobs_length;
+    for(int32_t k = 0; k < cobs_length; k++) {
+        fec_frame[k] = encoded_frame[k];
+    }
+    result_frame_unpack_parity(&encoded_frame[cobs_length], num_of_parity_bytes, &fec_frame[cobs_length]);
+
+    if(fec_decode(frame_fec_config, fec_frame, (uint32_t)cobs_length + num_of_parity_bytes, cobs_frame, corrected_bytes) < 0) {
+        return -3; //Error: to many wrong bytes, frame is corrupted
+    }
+
+    return cobs_decode(cobs_frame, (uint32_t)cobs_length, raw_frame);
+
+}//end result_frame_decode_fec
+
+//Checks the raw frame and copies header and payload
+static int result_frame_unpack(int32_t raw_length, Result_Frame_Header_t *header, uint8_t *payload) {
+
+    uint16_t payload_length = 0;
+
+    if(raw_length < (RESULT_FRAME_HEADER_SIZE + RESULT_FRAME_CRC_SIZE)) {
+        return -1; //Error: not a valid cobs frame or frame is to short
+    }
+
+    if(raw_frame[0] != RESULT_FRAME_MAGIC || raw_frame[1] != RESULT_FRAME_VERSION) {
+        return -2; //Error: unknown frame
+    }
+
+    payload_length = (uint16_t)byte_array_to_uint16_t(&raw_frame[8]);
+    if((payload_length + RESULT_FRAME_HEADER_SIZE + RESULT_FRAME_CRC_SIZE) != raw_length) {
+        return -2; //Error: length in header does not match the frame length
+    }
+
+    if(get_crc32(raw_frame, raw_length - RESULT_FRAME_CRC_SIZE) != (uint32_t)byte_array_to_uint32_t(&raw_frame[raw_length - RESULT_FRAME_CRC_SIZE])) {
+        return -3; //Error: crc does not match, frame is corrupted
+    }
+
+    header->test_type = raw_frame[2];
+    header->record_type = raw_frame[3];
+    header->frame_index = (uint16_t)byte_array_to_uint16_t(&raw_frame[4]);
+    header->frame_count = (uint16_t)byte_array_to_uint16_t(&raw_frame[6]);
+    header->payload_length = payload_length;
+
+    for(uint16_t k = 0; k < payload_length; k++) {
+        payload[k] = raw_frame[RESULT_FRAME_HEADER_SIZE + k];
+    }
+
+    return (int)payload_length;
+
+}//end result_frame_unpack
+
+//Function definition:
+
+int result_frame_encode(Result_Frame_Header_t header, const uint8_t *payload, uint8_t *encoded_frame) {
+
+    uint32_t raw_length = 0;
+    uint32_t encoded_length = 0;
+    uint8_t byte_buffer[4];
+
+    if(header.payload_length > RESULT_FRAME_MAX_PAYLOAD_SIZE) {
+        return -1; //Error: payload does not fit into one frame
+    }
+
+    //Write header
+    raw_frame[0] = RESULT_FRAME_MAGIC;
+    raw_frame[1] = RESULT_FRAME_VERSION;
+    raw_frame[2] = header.test_type;
+    raw_frame[3] = header.record_type;
+    uint16_t_to_byte_array(header.frame_index, &raw_frame[4]);
+    uint16_t_to_byte_array(header.frame_count, &raw_frame[6]);
+    uint16_t_to_byte_array(header.payload_length, &raw_frame[8]);
+    raw_length = RESULT_FRAME_HEADER_SIZE;
+
+    //Write payload
+    for(uint16_t k = 0; k < header.payload_length; k++) {
+        raw_frame[raw_length] = payload[k];
+        raw_length++;
+    }
+
+    //Append crc over header and payload
+    uint32_t_to_byte_array(get_crc32(raw_frame, raw_length), byte_buffer);
+    for(uint8_t k = 0; k < RESULT_FRAME_CRC_SIZE; k++) {
+        raw_frame[raw_length] = byte_buffer[k];
+        raw_length++;
+    }
+
+    //Encode frame and add the fec parity bytes over the encoded frame (7 bit p. byte), enclosed by zero delimiters
+    if(frame_fec_config.num_of_parity_bytes > 0) {
+        uint32_t cobs_length = cobs_encode(raw_frame, raw_length, cobs_frame);
+        int32_t fec_length = fec_encode(frame_fec_config, cobs_frame, cobs_length, fec_frame);
+        if(fec_length < 0) {
+            return -1; //Error: frame does not fit into the fec codewords
+        }
+        encoded_frame[0] = 0;
+        for(uint32_t k = 0; k < cobs_length; k++) {
+            encoded_frame[k + 1] = cobs_frame[k];
+        }
+        encoded_length = cobs_length + 1;
+        encoded_length += result_frame_pack_parity(&fec_frame[cobs_length], (uint32_t)fec_length - cobs_length, &encoded_frame[encoded_length]);
+        encoded_frame[encoded_length] = 0;
+        encoded_length++;
+        return (int)encoded_length;
+    }
+
+    //Encode frame, enclosed by zero delimiters
+    encoded_frame[0] = 0;
+    encoded_length = cobs_encode(raw_frame, raw_length, &encoded_frame[1]) + 1;
+    encoded_frame[encoded_length] = 0;
+    encoded_length++;
+
+    return (int)encoded_length;
+
+}//end result_frame_encode
+
+int result_frame_decode(const uint8_t *encoded_frame, uint32_t encoded_length, Result_Frame_Header_t *header, uint8_t *payload) {
+
+    //Decode frame (without zero delimiters)
+    if(frame_fec_config.num_of_parity_bytes == 0) {
+        if(encoded_length > RESULT_FRAME_MAX_COBS_SIZE) {
+            return -1; //Error: frame is to long
+        }
+        return result_frame_unpack(cobs_decode(encoded_frame, encoded_length, raw_frame), header, payload);
+    }
+
+    if(encoded_length > (RESULT_FRAME_MAX_ENCODED_SIZE - 2)) {
+        return -1; //Error: frame is to long
+    }
+
+    //The segment is decoded once: the length of the COBS encoded frame follows from the segment length, fec corrects wrong bytes inside it
+    uint32_t corrected_bytes = 0;
+    int32_t raw_length = result_frame_decode_fec(encoded_frame, encoded_length, &corrected_bytes);
+    if(raw_length == -3) {
+        return -3; //Error: to many wrong bytes, frame is corrupted
+    }
+
+    int ret = result_frame_unpack(raw_length, header, payload);
+    if(ret >= 0) {
+        fec_corrected_bytes += corrected_bytes;
+    }
+
+    return ret;
+
+}//end result_frame_decode
+
+int result_frame_set_fec(Fec_Config_t fec_config) {
+
+    //Check if the largest frame still fits into the codewords
+    if(fec_get_encoded_length(fec_config, RESULT_FRAME_MAX_COBS_SIZE) < 0) {
+        return -1; //Error: wrong fec configuration
+    }
+
+    frame_fec_config = fec_config;
+    return 1;
+
+}//end result_frame_set_fec
+
+uint32_t result_frame_get_corrected_bytes(void) {
+
+    return fec_corrected_bytes;
+
+}//end result_frame_get_corrected_bytes
+
+//end file result_frame.c
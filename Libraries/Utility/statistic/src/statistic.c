@@ -4,6 +4,8 @@
 /* Description:
 
    Utility functions for getting mean value and standard deviation of given data set
+   Streaming statistics (Welford) for values and blocks of integer samples, see statistic.h
+   Code density histogram and INL/DNL of an ADC, see statistic.h
 
 */
 
@@ -28,6 +30,21 @@
 
 //File global (static) function definitions:
 
+//Merges an exact integer block sum into the statistic: block mean = sum/n, block M2 = (n*sum_of_squares - sum^2)/n
+static void welford_add_block_sums(Welford_Statistic_t *statistic, uint32_t num_of_samples, uint64_t sum, uint64_t sum_of_squares) {
+
+    Welford_Statistic_t block_statistic;
+
+    if(num_of_samples == 0) {
+        return;
+    }
+    block_statistic.count = num_of_samples;
+    block_statistic.mean_value = (float)sum/num_of_samples;
+    block_statistic.m2 = (float)(num_of_samples*sum_of_squares - sum*sum)/num_of_samples;
+    welford_merge(statistic, &block_statistic);
+
+}//end welford_add_block_sums
+
 //Function definition:
 
 float get_mean_value(float *data, unsigned long data_length) {
@@ -54,4 +71,157 @@ float get_std_deviation(float *data, unsigned long data_length) {
 
 }//end get_std_deviation
 
+void welford_reset(Welford_Statistic_t *statistic) {
+
+    statistic->count = 0;
+    statistic->mean_value = 0;
+    statistic->m2 = 0;
+
+}//end welford_reset
+
+void welford_add_value(Welford_Statistic_t *statistic, float value) {
+
+    statistic->count++;
+    float delta = value - statistic->mean_value;
+    statistic->mean_value = statistic->mean_value + delta/statistic->count;
+    statistic->m2 = statistic->m2 + delta*(value - statistic->mean_value);
+
+}//end welford_add_value
+
+void welford_add_block_8_bit(Welford_Statistic_t *statistic, const uint8_t *block, uint32_t num_of_samples, uint32_t stride) {
+
+    //Integer sums are exact and cheap (no float operation p. sample)
+    uint32_t sum = 0;
+    uint64_t sum_of_squares = 0;
+
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        uint32_t sample = block[n*stride];
+        sum += sample;
+        sum_of_squares += sample*sample;
+    }
+    welford_add_block_sums(statistic, num_of_samples, sum, sum_of_squares);
+
+}//end welford_add_block_8_bit
+
+void welford_add_block_16_bit(Welford_Statistic_t *statistic, const uint16_t *block, uint32_t num_of_samples, uint32_t stride) {
+
+    uint64_t sum = 0;
+    uint64_t sum_of_squares = 0;
+
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        uint32_t sample = block[n*stride];
+        sum += sample;
+        sum_of_squares += sample*sample;
+    }
+    welford_add_block_sums(statistic, num_of_samples, sum, sum_of_squares);
+
+}//end welford_add_block_16_bit
+
+void welford_merge(Welford_Statistic_t *statistic, const Welford_Statistic_t *other) {
+
+    if(other->count == 0) {
+        return;
+    }
+    uint32_t count = statistic->count + other->count;
+    float delta = other->mean_value - statistic->mean_value;
+    float weight = (float)other->count/count;
+
+    statistic->mean_value = statistic->mean_value + delta*weight;
+    statistic->m2 = statistic->m2 + other->m2 + delta*delta*statistic->count*weight;
+    statistic->count = count;
+
+}//end welford_merge
+
+float welford_get_mean_value(const Welford_Statistic_t *statistic) {
+
+    return statistic->mean_value;
+
+}//end welford_get_mean_value
+
+float welford_get_std_deviation(const Welford_Statistic_t *statistic) {
+
+    //Sample standard deviation like get_std_deviation()
+    if(statistic->count < 2) {
+        return 0;
+    }
+    return sqrtf(statistic->m2/(statistic->count - 1));
+
+}//end welford_get_std_deviation
+
+void histogram_add_block_8_bit(uint32_t *histogram, const uint8_t *block, uint32_t num_of_samples, uint32_t stride) {
+
+    //Every 8-bit code has a bin (256 bins)
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        histogram[block[n*stride]]++;
+    }
+
+}//end histogram_add_block_8_bit
+
+void histogram_add_block_16_bit(uint32_t *histogram, uint16_t num_of_codes, const uint16_t *block, uint32_t num_of_samples, uint32_t stride) {
+
+    for(uint32_t n = 0; n < num_of_samples; n++) {
+        uint16_t code = block[n*stride];
+        //Out of range codes (e.g. the error bit of the ADC) are counted as highest code
+        if(code >= num_of_codes) {
+            code = num_of_codes - 1;
+        }
+        histogram[code]++;
+    }
+
+}//end histogram_add_block_16_bit
+
+int histogram_get_linearity(const uint32_t *histogram, uint16_t num_of_codes, Linearity_Result_t *result) {
+
+    uint64_t sum = 0;
+    float inl = 0;
+
+    result->first_code = 0;
+    result->last_code = 0;
+    while(result->first_code < num_of_codes && histogram[result->first_code] == 0) {
+        result->first_code++;
+    }
+    for(uint16_t k = result->first_code; k < num_of_codes; k++) {
+        if(histogram[k] != 0) {
+            result->last_code = k;
+        }
+    }
+    if(result->first_code >= num_of_codes || (result->last_code - result->first_code) < 2) {
+        return -1; //Error: less than three codes hit, no linearity could be calculated
+    }
+
+    for(uint16_t k = result->first_code + 1; k < result->last_code; k++) {
+        sum += histogram[k];
+    }
+    result->average_count = (float)sum/(result->last_code - result->first_code - 1);
+
+    result->max_dnl = -1;
+    result->min_dnl = 0;
+    result->max_inl = 0;
+    result->min_inl = 0;
+    result->number_of_missing_codes = 0;
+    for(uint16_t k = result->first_code + 1; k < result->last_code; k++) {
+        float dnl = histogram_get_dnl(histogram, result, k);
+        inl += dnl;
+        if(histogram[k] == 0) {
+            result->number_of_missing_codes++;
+        }
+        result->max_dnl = (dnl > result->max_dnl) ? dnl : result->max_dnl;
+        result->min_dnl = (dnl < result->min_dnl) ? dnl : result->min_dnl;
+        result->max_inl = (inl > result->max_inl) ? inl : result->max_inl;
+        result->min_inl = (inl < result->min_inl) ? inl : result->min_inl;
+    }
+
+    return 1;
+
+}//end histogram_get_linearity
+
+float histogram_get_dnl(const uint32_t *histogram, const Linearity_Result_t *result, uint16_t code) {
+
+    if(code <= result->first_code || code >= result->last_code || result->average_count <= 0) {
+        return 0;
+    }
+    return (float)histogram[code]/result->average_count - 1.0f;
+
+}//end histogram_get_dnl
+
 //end file statistic.c
\ No newline at end of file
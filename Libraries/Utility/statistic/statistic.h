@@ -3,11 +3,18 @@
 
 /* Description:
     Utility functions for getting mean value and standard deviation of given data set
+    Streaming statistics (Welford): count, mean value and M2 (sum of squared differences to the mean) are updated incrementally,
+    so no data set has to be stored. Blocks of integer samples (e.g. an ADC DMA block) are summed up exactly with integers and merged
+    into the running statistic with one float update p. block (Chan et al. parallel variance).
+    Code density (histogram) test: every sample increments the bin of its code, the linearity of the ADC is calculated from the histogram
+    of a uniform input (e.g. a slow ramp): DNL[k] = count[k]/average_count - 1, INL[k] = sum of DNL[first_code + 1 ... k].
+    The first and the last hit code are not used (they collect everything below and above the input range), so INL is endpoint fitted.
 */
 
 //Libraries:
 
 //Standard-C:
+#include <stdint.h>
 
 //Own Libraries:
 
@@ -15,9 +22,47 @@
 
 //Type definitions:
 
+typedef struct Welford_Statistic_s {
+
+    uint32_t count;
+    float mean_value;
+    //Sum of squared differences to the mean value
+    float m2;
+
+}Welford_Statistic_t;
+
+typedef struct Linearity_Result_s {
+
+    //Lowest and highest hit code (not part of the result)
+    uint16_t first_code;
+    uint16_t last_code;
+    //Average count of the codes between first and last code (1 LSB)
+    float average_count;
+    //DNL and INL in LSB
+    float max_dnl;
+    float min_dnl;
+    float max_inl;
+    float min_inl;
+    uint16_t number_of_missing_codes;
+
+}Linearity_Result_t;
+
 //Function Prototypes:
 
 float get_mean_value(float *data, unsigned long data_length);
 float get_std_deviation(float *data, unsigned long data_length);
 
+void welford_reset(Welford_Statistic_t *statistic);
+void welford_add_value(Welford_Statistic_t *statistic, float value);
+void welford_add_block_8_bit(Welford_Statistic_t *statistic, const uint8_t *block, uint32_t num_of_samples, uint32_t stride);
+void welford_add_block_16_bit(Welford_Statistic_t *statistic, const uint16_t *block, uint32_t num_of_samples, uint32_t stride);
+void welford_merge(Welford_Statistic_t *statistic, const Welford_Statistic_t *other);
+float welford_get_mean_value(const Welford_Statistic_t *statistic);
+float welford_get_std_deviation(const Welford_Statistic_t *statistic);
+
+void histogram_add_block_8_bit(uint32_t *histogram, const uint8_t *block, uint32_t num_of_samples, uint32_t stride);
+void histogram_add_block_16_bit(uint32_t *histogram, uint16_t num_of_codes, const uint16_t *block, uint32_t num_of_samples, uint32_t stride);
+int histogram_get_linearity(const uint32_t *histogram, uint16_t num_of_codes, Linearity_Result_t *result);
+float histogram_get_dnl(const uint32_t *histogram, const Linearity_Result_t *result, uint16_t code);
+
 //end file statistic.h
@@ -0,0 +1,116 @@
+//File: pwm_divider_test.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Host side test of the pwm divider solver (see pwm_divider.h).
+    Solves hand-computed cases for a system clock of 125 MHz and compares divider, wrap and error with the expected values,
+    every case is printed with PASS/FAIL to stdout.
+
+    Build (host):
+        gcc -O2 -I../../Libraries/Utility/pwm_divider pwm_divider_test.c ../../Libraries/Utility/pwm_divider/src/pwm_divider.c
+            -o pwm_divider_test
+    Usage:
+        pwm_divider_test
+        Returns 0 if all cases pass, 1 otherwise.
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdio.h>
+#include <stdint.h>
+
+//Own Libraries:
+#include "pwm_divider.h"
+
+//Preprocessor constants:
+
+#define PWM_DIVIDER_TEST_SYSTEM_CLOCK_HZ 125000000
+
+//Type definitions:
+
+typedef struct PWM_Divider_Test_Case_s {
+
+    uint32_t pwm_frequency_hz;
+    uint16_t min_wrap;
+    PWM_Divider_Goal_t goal;
+    //Expected return value, divider, wrap and error (only checked on success)
+    int expected_return;
+    uint8_t div_int;
+    uint8_t div_frac;
+    uint16_t wrap;
+    int32_t error_ppm;
+
+}PWM_Divider_Test_Case_t;
+
+//File global (static) variables:
+
+/*
+    Periods in 1/16 system clock cycles (16*125 MHz/frequency), period = (16*div_int + div_frac)*(wrap + 1):
+    100 kHz:  20000 exact with divider 1.0 and wrap 1249 (the biggest wrap of all exact dividers).
+    3 MHz:    666.67, 667 = 23*29 is the nearest product (divider 1.4375, wrap 28, -499.75 ppm),
+              the biggest wrap is reached with divider 1.0 and wrap 41 (672, -7937 ppm).
+    44.1 kHz: 45351.47, 45351 and 45352 have no factor from 16 to 4095 with a cofactor up to 65536,
+              45350 = 25*1814 (divider 1.5625, wrap 1813, +32.5 ppm). The biggest wrap is 2833 with divider 1.0 (45344, +165 ppm).
+    8 Hz:     250000000 = 4000*62500 exact (divider 250.0, wrap 62499). The biggest wrap is 65530 with divider 238.4375
+              (3815*65531 = 250000765, -3.06 ppm, below the 1 mHz resolution of the achieved frequency).
+    7 Hz and 1 Hz need more than 255.9375*65536 system clock cycles and are not reachable.
+    A minimum wrap above the biggest wrap of the frequency is not reachable either.
+*/
+static const PWM_Divider_Test_Case_t test_cases[] = {
+    {100000, 0, PWM_DIVIDER_MIN_ERROR, 1, 1, 0, 1249, 0},
+    {100000, 1249, PWM_DIVIDER_MIN_ERROR, 1, 1, 0, 1249, 0},
+    {100000, 0, PWM_DIVIDER_MAX_WRAP, 1, 1, 0, 1249, 0},
+    {100000, 2000, PWM_DIVIDER_MIN_ERROR, -1, 0, 0, 0, 0},
+    {3000000, 0, PWM_DIVIDER_MIN_ERROR, 1, 1, 7, 28, -500},
+    {3000000, 0, PWM_DIVIDER_MAX_WRAP, 1, 1, 0, 41, -7937},
+    {44100, 0, PWM_DIVIDER_MIN_ERROR, 1, 1, 9, 1813, 33},
+    {44100, 0, PWM_DIVIDER_MAX_WRAP, 1, 1, 0, 2833, 165},
+    {8, 0, PWM_DIVIDER_MIN_ERROR, 1, 250, 0, 62499, 0},
+    {8, 0, PWM_DIVIDER_MAX_WRAP, 1, 238, 7, 65530, -3},
+    {7, 0, PWM_DIVIDER_MIN_ERROR, -1, 0, 0, 0, 0},
+    {1, 0, PWM_DIVIDER_MIN_ERROR, -1, 0, 0, 0, 0},
+    {1, 0, PWM_DIVIDER_MAX_WRAP, -1, 0, 0, 0, 0},
+};
+
+//File global (static) function definitions:
+
+static int run_test_case(PWM_Divider_Test_Case_t test_case) {
+
+    PWM_Divider_t divider = {0};
+    int ret = pwm_solve_divider(PWM_DIVIDER_TEST_SYSTEM_CLOCK_HZ, test_case.pwm_frequency_hz, test_case.min_wrap, test_case.goal, &divider);
+    int passed = (ret == test_case.expected_return);
+
+    if(passed && ret > 0) {
+        passed = divider.div_int == test_case.div_int && divider.div_frac == test_case.div_frac && divider.wrap == test_case.wrap &&
+            divider.error_ppm == test_case.error_ppm &&
+            divider.period_sixteenths == (16*(uint32_t)divider.div_int + divider.div_frac)*((uint32_t)divider.wrap + 1);
+    }
+
+    printf("%s: %lu Hz, min_wrap %u, %s: return %d, divider %u+%u/16, wrap %u, %llu mHz, %ld ppm\n", passed ? "PASS" : "FAIL",
+        (unsigned long)test_case.pwm_frequency_hz, test_case.min_wrap, (test_case.goal == PWM_DIVIDER_MAX_WRAP) ? "max wrap" : "min error",
+        ret, divider.div_int, divider.div_frac, divider.wrap, (unsigned long long)divider.frequency_millihertz, (long)divider.error_ppm);
+
+    return passed;
+
+}//end run_test_case
+
+//Function definition:
+
+int main(void) {
+
+    uint32_t number_of_failed_cases = 0;
+
+    for(uint32_t k = 0; k < sizeof(test_cases)/sizeof(test_cases[0]); k++) {
+        if(!run_test_case(test_cases[k])) {
+            number_of_failed_cases++;
+        }
+    }
+
+    printf("%lu of %lu cases failed\n", (unsigned long)number_of_failed_cases, (unsigned long)(sizeof(test_cases)/sizeof(test_cases[0])));
+
+    return (number_of_failed_cases == 0) ? 0 : 1;
+
+}//end main
+
+//end file pwm_divider_test.c
@@ -0,0 +1,363 @@
+//File: result_frame_decoder.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Host side decoder for the binary test result export (see result_frame.h).
+    Reads the raw byte stream captured from the UART (file or stdin), splits it on the zero delimiters,
+    checks every frame and prints the content as CSV to stdout. Text output in between the frames is skipped.
+    Corrupted frames (wrong crc) and malformed frames (broken COBS code, wrong length or header) are reported on stderr and skipped.
+    Every segment is decoded exactly once (with fec wrong bytes inside the segment are corrected). A segment that is split or merged by
+    a corrupted delimiter is dropped, the decoder re-synchronises on the next zero byte.
+
+    Build (host):
+        gcc -O2 -I../../Libraries/Utility/cobs -I../../Libraries/Utility/crc -I../../Libraries/Utility/result_frame
+            -I../../Libraries/Utility/data_to_byte -I../../Libraries/Utility/fec -I../../Libraries/Utility/ramp_codec result_frame_decoder.c
+            ../../Libraries/Utility/cobs/src/cobs.c ../../Libraries/Utility/crc/src/crc.c
+            ../../Libraries/Utility/result_frame/src/result_frame.c ../../Libraries/Utility/data_to_byte/src/data_to_byte.c
+            ../../Libraries/Utility/fec/src/fec.c ../../Libraries/Utility/ramp_codec/src/ramp_codec.c -o result_frame_decoder
+    Usage:
+        result_frame_decoder [-f parity_bytes interleave_depth] [-m channel] [capture_file]
+        -f: frames are protected with fec, same configuration as on the device (result_frame_set_fec)
+        -m: the UART is multiplexed (uart_mux.h), the result frames are taken from the payload of this channel
+            (uart_result_set_mux_channel, e.g. the bulk channel 2 of main.c). Frames of the other channels are skipped.
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Own Libraries:
+#include "result_frame.h"
+#include "data_to_byte.h"
+#include "ramp_codec.h"
+#include "cobs.h"
+#include "crc.h"
+
+//Preprocessor constants:
+
+//Frame layout of the uart multiplexer (see uart_mux.h): channel, sequence number, flags, payload, crc-32
+#define MUX_HEADER_SIZE 3
+#define MUX_CRC_SIZE 4
+#define MUX_MAX_CHANNELS 4
+#define MUX_MAX_PAYLOAD_SIZE 128
+#define MUX_MAX_RAW_FRAME_SIZE (MUX_HEADER_SIZE + MUX_MAX_PAYLOAD_SIZE + MUX_CRC_SIZE)
+
+//File global (static) variables:
+
+//Segment between two zero bytes
+static uint8_t encoded_frame[RESULT_FRAME_MAX_ENCODED_SIZE];
+static uint8_t payload[RESULT_FRAME_MAX_PAYLOAD_SIZE];
+//Decoded samples of one ramp coded frame (at least 1 bit p. sample)
+static uint16_t ramp_samples[8*RESULT_FRAME_MAX_PAYLOAD_SIZE];
+
+//Result frame that is received and counters of the result frames
+static uint32_t frame_length = 0;
+static uint32_t frames_ok = 0;
+static uint32_t frames_failed = 0;
+static uint32_t frames_malformed = 0;
+static uint32_t text_segments = 0;
+
+//Multiplexer frame that is received, expected sequence number p. channel and counters of the multiplexer frames
+static uint8_t mux_encoded_frame[COBS_MAX_ENCODED_LENGTH(MUX_MAX_RAW_FRAME_SIZE)];
+static uint8_t mux_raw_frame[COBS_MAX_ENCODED_LENGTH(MUX_MAX_RAW_FRAME_SIZE)];
+static uint32_t mux_frame_length = 0;
+static bool mux_sequence_number_valid[MUX_MAX_CHANNELS];
+static uint8_t mux_sequence_number[MUX_MAX_CHANNELS];
+static uint32_t mux_frames_ok = 0;
+static uint32_t mux_frames_failed = 0;
+static uint32_t mux_frames_lost = 0;
+static uint32_t mux_frames_skipped = 0;
+
+//File global (static) function definitions:
+
+//Text output between two frames contains only printable characters and line endings
+static bool is_text_segment(const uint8_t *segment, uint32_t segment_length) {
+
+    for(uint32_t k = 0; k < segment_length; k++) {
+        if((segment[k] < 0x20 || segment[k] > 0x7E) && segment[k] != '\r' && segment[k] != '\n' && segment[k] != '\t') {
+            return false;
+        }
+    }
+    return true;
+
+}//end is_text_segment
+
+static void print_adc_parameter(uint8_t *payload, uint16_t payload_length) {
+
+    //Older firmware sends no adc resolution (always 8 bit)
+    uint8_t adc_resolution = (payload_length >= 22) ? payload[21] : 8;
+
+    printf("adc_parameter,sample_rate=%f,number_of_samples=%lu,dac_resolution=%u,dac_pwm_frequency=%f,samples_per_step=%lu,samples_per_ramp=%lu,adc_resolution=%u\n",
+        byte_array_to_float(&payload[0]), byte_array_to_uint32_t(&payload[4]), payload[8],
+        byte_array_to_float(&payload[9]), byte_array_to_uint32_t(&payload[13]), byte_array_to_uint32_t(&payload[17]), adc_resolution);
+
+    //ADC instrumentation (newer firmware)
+    if(payload_length >= 34) {
+        printf("adc_instrumentation,fifo_overflows=%lu,conversion_errors=%lu,effective_sample_rate=%f\n",
+            byte_array_to_uint32_t(&payload[22]), byte_array_to_uint32_t(&payload[26]), byte_array_to_float(&payload[30]));
+    }
+
+}//end print_adc_parameter
+
+static void print_frame(Result_Frame_Header_t header, uint8_t *payload) {
+
+    switch(header.record_type) {
+
+        case RECORD_TEST_PARAMETER:
+            if(header.test_type == RESULT_FRAME_TEST_ADC) {
+                print_adc_parameter(payload, header.payload_length);
+            }
+            else {
+                printf("%s_parameter,test=%u,%s=%lu,number_of_transfers=%u\n", (header.test_type == RESULT_FRAME_TEST_UART) ? "uart" : "spi",
+                    payload[0], (header.test_type == RESULT_FRAME_TEST_UART) ? "baudrate" : "clk_frequency",
+                    byte_array_to_uint32_t(&payload[1]), payload[5]);
+            }
+        break;
+
+        case RECORD_ADC_RAW_SAMPLES:
+            for(uint16_t k = 0; k < header.payload_length; k++) {
+                printf("sample,%u\n", payload[k]);
+            }
+        break;
+
+        case RECORD_ADC_RAW_SAMPLES_16:
+            for(uint16_t k = 0; (k + 2) <= header.payload_length; k += 2) {
+                printf("sample,%u\n", byte_array_to_uint16_t(&payload[k]));
+            }
+        break;
+
+        case RECORD_ADC_RAMP_CODED: {
+            //Same output as the raw samples, every frame is decoded on its own
+            uint32_t first_sample = 0;
+            int32_t number_of_samples = ramp_codec_decode(payload, header.payload_length, ramp_samples,
+                sizeof(ramp_samples)/sizeof(ramp_samples[0]), &first_sample);
+            if(number_of_samples < 0) {
+                fprintf(stderr, "Frame %u: ramp coded samples could not be decoded (error %ld)\n", header.frame_index, (long)number_of_samples);
+            }
+            for(int32_t k = 0; k < number_of_samples; k++) {
+                printf("sample,%u\n", ramp_samples[k]);
+            }
+        }
+        break;
+
+        case RECORD_ADC_MEAN_STD:
+            for(uint16_t k = 0; (k + 8) <= header.payload_length; k += 8) {
+                printf("step,%f,%f\n", byte_array_to_float(&payload[k]), byte_array_to_float(&payload[k+4]));
+            }
+        break;
+
+        case RECORD_ADC_SPECTRAL_PEAKS:
+            for(uint16_t k = 0; (k + 8) <= header.payload_length; k += 8) {
+                printf("peak,%f,%f\n", byte_array_to_float(&payload[k]), byte_array_to_float(&payload[k+4]));
+            }
+        break;
+
+        case RECORD_ADC_HISTOGRAM:
+            //Data frames are full except the last one, so the first code of the frame follows from the frame index
+            for(uint16_t k = 0; (k + 4) <= header.payload_length; k += 4) {
+                printf("code,%lu,%lu\n", (unsigned long)((header.frame_index - 1)*(RESULT_FRAME_MAX_PAYLOAD_SIZE/4) + k/4),
+                    byte_array_to_uint32_t(&payload[k]));
+            }
+        break;
+
+        case RECORD_TRANSFER: {
+            uint16_t number_of_bytes = byte_array_to_uint16_t(&payload[2]);
+            for(uint16_t k = 0; k < number_of_bytes; k++) {
+                printf("transfer,%u,%u,%u,0x%02X,0x%02X\n", payload[0], payload[1], k, payload[4 + k], payload[4 + number_of_bytes + k]);
+            }
+        }
+        break;
+
+        default:
+            fprintf(stderr, "Frame %u: unknown record type %u\n", header.frame_index, header.record_type);
+        break;
+    }
+
+}//end print_frame
+
+//Counts a rejected segment as dropped or malformed frame or as text output
+static void count_rejected_segment(const uint8_t *segment, uint32_t segment_length, int error) {
+
+    if(error == -3) {
+        fprintf(stderr, "Frame dropped (error %d)\n", error);
+        frames_failed++;
+    }
+    //Text output between two frames is no valid frame, every other rejected segment is a malformed frame
+    else if(is_text_segment(segment, (segment_length < sizeof(encoded_frame)) ? segment_length : sizeof(encoded_frame))) {
+        text_segments++;
+    }
+    else {
+        fprintf(stderr, "Malformed frame dropped (error %d, %lu bytes)\n", error, (unsigned long)segment_length);
+        frames_malformed++;
+    }
+
+}//end count_rejected_segment
+
+//Decodes one segment between two zero bytes
+static void decode_segment(const uint8_t *segment, uint32_t segment_length) {
+
+    Result_Frame_Header_t header;
+    int ret = result_frame_decode(segment, segment_length, &header, payload);
+
+    if(ret >= 0) {
+        print_frame(header, payload);
+        frames_ok++;
+    }
+    else {
+        count_rejected_segment(segment, segment_length, ret);
+    }
+
+}//end decode_segment
+
+//Adds one byte of the stream to the result frame, a zero byte ends the frame
+static void decode_result_frame_byte(uint8_t c) {
+
+    if(c != 0) {
+        //Drop overlong garbage, resync on the next delimiter
+        if(frame_length < sizeof(encoded_frame)) {
+            encoded_frame[frame_length] = c;
+        }
+        frame_length++;
+        return;
+    }
+
+    if(frame_length > sizeof(encoded_frame)) {
+        count_rejected_segment(encoded_frame, frame_length, -1);
+    }
+    else if(frame_length > 0) {
+        decode_segment(encoded_frame, frame_length);
+    }
+    frame_length = 0;
+
+}//end decode_result_frame_byte
+
+//Adds one byte of the stream to the multiplexer frame, a zero byte ends the frame and the payload of the channel goes to the result frames
+static void demux_byte(uint8_t c, uint8_t channel) {
+
+    if(c != 0) {
+        if(mux_frame_length < sizeof(mux_encoded_frame)) {
+            mux_encoded_frame[mux_frame_length] = c;
+        }
+        mux_frame_length++;
+        return;
+    }
+
+    if(mux_frame_length == 0) {
+        return;
+    }
+
+    int32_t raw_length = -1;
+    if(mux_frame_length <= sizeof(mux_encoded_frame)) {
+        raw_length = cobs_decode(mux_encoded_frame, mux_frame_length, mux_raw_frame);
+    }
+    mux_frame_length = 0;
+
+    if(raw_length < (MUX_HEADER_SIZE + MUX_CRC_SIZE) || mux_raw_frame[0] >= MUX_MAX_CHANNELS ||
+    get_crc32(mux_raw_frame, (uint32_t)raw_length - MUX_CRC_SIZE) != (uint32_t)byte_array_to_uint32_t(&mux_raw_frame[raw_length - MUX_CRC_SIZE])) {
+        fprintf(stderr, "Multiplexer frame dropped\n");
+        mux_frames_failed++;
+        return;
+    }
+
+    uint8_t frame_channel = mux_raw_frame[0];
+    uint8_t sequence_number = mux_raw_frame[1];
+
+    //Frames lost in between (per channel sequence number)
+    if(mux_sequence_number_valid[frame_channel] && sequence_number != mux_sequence_number[frame_channel]) {
+        uint8_t lost = (uint8_t)(sequence_number - mux_sequence_number[frame_channel]);
+        fprintf(stderr, "Channel %u: %u multiplexer frames lost\n", frame_channel, lost);
+        if(frame_channel == channel) {
+            mux_frames_lost += lost;
+        }
+    }
+    mux_sequence_number_valid[frame_channel] = true;
+    mux_sequence_number[frame_channel] = sequence_number + 1;
+
+    if(frame_channel != channel) {
+        mux_frames_skipped++;
+        return;
+    }
+
+    mux_frames_ok++;
+    for(int32_t k = MUX_HEADER_SIZE; k < raw_length - MUX_CRC_SIZE; k++) {
+        decode_result_frame_byte(mux_raw_frame[k]);
+    }
+
+}//end demux_byte
+
+//Function definition:
+
+int main(int argc, char **argv) {
+
+    FILE *input = stdin;
+    Fec_Config_t fec_config = {0, 0};
+    bool use_mux = false;
+    uint8_t mux_channel = 0;
+    int arg_index = 1;
+    int c;
+
+    while(arg_index < argc && argv[arg_index][0] == '-') {
+        if(strcmp(argv[arg_index], "-f") == 0 && argc > arg_index + 2) {
+            fec_config.num_of_parity_bytes = (uint8_t)atoi(argv[arg_index + 1]);
+            fec_config.interleave_depth = (uint8_t)atoi(argv[arg_index + 2]);
+            if(result_frame_set_fec(fec_config) < 0) {
+                fprintf(stderr, "Wrong fec configuration\n");
+                return 1;
+            }
+            arg_index += 3;
+        }
+        else if(strcmp(argv[arg_index], "-m") == 0 && argc > arg_index + 1) {
+            use_mux = true;
+            mux_channel = (uint8_t)atoi(argv[arg_index + 1]);
+            if(mux_channel >= MUX_MAX_CHANNELS) {
+                fprintf(stderr, "Wrong multiplexer channel\n");
+                return 1;
+            }
+            arg_index += 2;
+        }
+        else {
+            fprintf(stderr, "Usage: result_frame_decoder [-f parity_bytes interleave_depth] [-m channel] [capture_file]\n");
+            return 1;
+        }
+    }
+
+    if(argc > arg_index) {
+        input = fopen(argv[arg_index], "rb");
+        if(input == NULL) {
+            fprintf(stderr, "Could not open %s\n", argv[arg_index]);
+            return 1;
+        }
+    }
+
+    while((c = fgetc(input)) != EOF) {
+        if(use_mux) {
+            demux_byte((uint8_t)c, mux_channel);
+        }
+        else {
+            decode_result_frame_byte((uint8_t)c);
+        }
+    }
+
+    if(use_mux) {
+        fprintf(stderr, "%lu multiplexer frames of channel %u, %lu frames of other channels skipped, %lu frames dropped, %lu frames lost\n",
+            (unsigned long)mux_frames_ok, mux_channel, (unsigned long)mux_frames_skipped, (unsigned long)mux_frames_failed,
+            (unsigned long)mux_frames_lost);
+    }
+    fprintf(stderr, "%lu frames decoded, %lu frames dropped, %lu malformed frames dropped, %lu text segments skipped, %lu bytes corrected\n",
+        (unsigned long)frames_ok, (unsigned long)frames_failed, (unsigned long)frames_malformed, (unsigned long)text_segments,
+        (unsigned long)result_frame_get_corrected_bytes());
+
+    if(input != stdin) {
+        fclose(input);
+    }
+
+    return (frames_failed == 0 && frames_malformed == 0) ? 0 : 2;
+
+}//end main
+
+//end file result_frame_decoder.c
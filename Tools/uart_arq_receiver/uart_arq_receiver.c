@@ -0,0 +1,234 @@
+//File: uart_arq_receiver.c
+//Project: Pico_MRI_Test_M
+
+/* Description:
+    Host side receiver for bulk transfers with the selective-repeat ARQ (see uart_arq.h and arq_frame.h).
+    Reads the frames from the serial port, answers every valid frame with a cumulative and selective acknowledge,
+    checks the CRC-32 over all data at the end and writes the received data to a file.
+    After the transfer it keeps answering for a second, in case the last acknowledge got lost.
+
+    Build (host, POSIX):
+        gcc -O2 -I../../Libraries/Utility/cobs -I../../Libraries/Utility/crc -I../../Libraries/Utility/arq_frame
+            -I../../Libraries/Utility/data_to_byte uart_arq_receiver.c ../../Libraries/Utility/cobs/src/cobs.c
+            ../../Libraries/Utility/crc/src/crc.c ../../Libraries/Utility/arq_frame/src/arq_frame.c
+            ../../Libraries/Utility/data_to_byte/src/data_to_byte.c -o uart_arq_receiver
+    Usage:
+        uart_arq_receiver serial_device output_file
+        The serial port has to be configured before (e.g. stty -F /dev/ttyUSB0 250000 raw -echo).
+*/
+
+//Libraries:
+
+//Standard-C:
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+//POSIX:
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+//Own Libraries:
+#include "arq_frame.h"
+#include "crc.h"
+#include "data_to_byte.h"
+
+//File global (static) variables:
+
+static int serial_fd = -1;
+
+static uint8_t encoded_frame[ARQ_FRAME_MAX_ENCODED_SIZE];
+static uint32_t encoded_length = 0;
+static uint8_t payload[ARQ_FRAME_MAX_PAYLOAD_SIZE];
+
+//State of the transfer
+static bool transfer_started = false;
+static bool transfer_complete = false;
+static uint8_t transfer_id = 0;
+static uint32_t total_bytes = 0;
+static uint16_t chunk_size = 0;
+static uint16_t number_of_chunks = 0;
+static uint32_t data_crc = 0;
+static uint8_t *received_data = NULL;
+//One flag p. frame (data frames and end frame)
+static bool *frame_received = NULL;
+static uint32_t frames_received = 0;
+static uint32_t duplicate_frames = 0;
+static uint32_t corrupted_frames = 0;
+
+//File global (static) function definitions:
+
+static void send_ack(void) {
+
+    Arq_Frame_Header_t header;
+    uint8_t ack_payload[4];
+    uint8_t ack_frame[ARQ_FRAME_HEADER_SIZE + 4 + ARQ_FRAME_CRC_SIZE + 4];
+    uint32_t number_of_frames = (uint32_t)number_of_chunks + 1;
+    uint32_t cumulative_ack = 0;
+    uint32_t selective_ack = 0;
+
+    while(cumulative_ack < number_of_frames && frame_received[cumulative_ack]) {
+        cumulative_ack++;
+    }
+    for(uint8_t n = 0; n < 32; n++) {
+        uint32_t sequence_number = cumulative_ack + 1 + n;
+        if(sequence_number < number_of_frames && frame_received[sequence_number]) {
+            selective_ack |= (1u << n);
+        }
+    }
+
+    header.type = ARQ_FRAME_TYPE_ACK;
+    header.transfer_id = transfer_id;
+    header.sequence_number = (uint16_t)cumulative_ack;
+    header.payload_length = 4;
+    uint32_t_to_byte_array(selective_ack, ack_payload);
+
+    int length = arq_frame_encode(header, ack_payload, ack_frame);
+    if(length > 0 && write(serial_fd, ack_frame, (size_t)length) != length) {
+        fprintf(stderr, "Could not write acknowledge\n");
+    }
+
+}//end send_ack
+
+static void handle_frame(void) {
+
+    Arq_Frame_Header_t header;
+    int payload_length = arq_frame_decode(encoded_frame, encoded_length, &header, payload);
+
+    if(payload_length < 0) {
+        corrupted_frames++;
+        return;
+    }
+
+    if(header.type == ARQ_FRAME_TYPE_START && payload_length == 8) {
+
+        //New transfer (a repeated start frame of the actual transfer is only acknowledged again)
+        if(!transfer_started || header.transfer_id != transfer_id) {
+            transfer_id = header.transfer_id;
+            total_bytes = (uint32_t)byte_array_to_uint32_t(&payload[0]);
+            chunk_size = (uint16_t)byte_array_to_uint16_t(&payload[4]);
+            number_of_chunks = (uint16_t)byte_array_to_uint16_t(&payload[6]);
+            free(received_data);
+            free(frame_received);
+            received_data = calloc(total_bytes + 1, 1);
+            frame_received = calloc((size_t)number_of_chunks + 1, sizeof(bool));
+            frames_received = 0;
+            transfer_started = true;
+            transfer_complete = false;
+            fprintf(stderr, "Transfer %u: %lu bytes in %u frames\n", transfer_id, (unsigned long)total_bytes, number_of_chunks);
+        }
+        send_ack();
+        return;
+    }
+
+    if(!transfer_started || header.transfer_id != transfer_id || header.sequence_number > number_of_chunks) {
+        return;
+    }
+
+    if(frame_received[header.sequence_number]) {
+        duplicate_frames++;
+    }
+    else if(header.type == ARQ_FRAME_TYPE_DATA && header.sequence_number < number_of_chunks) {
+        uint32_t offset = (uint32_t)header.sequence_number*chunk_size;
+        if((offset + (uint32_t)payload_length) <= total_bytes) {
+            memcpy(&received_data[offset], payload, (size_t)payload_length);
+            frame_received[header.sequence_number] = true;
+            frames_received++;
+        }
+    }
+    else if(header.type == ARQ_FRAME_TYPE_END && header.sequence_number == number_of_chunks && payload_length == 4) {
+        data_crc = (uint32_t)byte_array_to_uint32_t(payload);
+        frame_received[header.sequence_number] = true;
+        frames_received++;
+    }
+
+    if(frames_received == (uint32_t)number_of_chunks + 1) {
+        transfer_complete = true;
+    }
+
+    send_ack();
+
+}//end handle_frame
+
+static void handle_byte(uint8_t rx_byte) {
+
+    if(rx_byte != 0) {
+        if(encoded_length < sizeof(encoded_frame)) {
+            encoded_frame[encoded_length] = rx_byte;
+        }
+        encoded_length++;
+        return;
+    }
+
+    if(encoded_length > 0 && encoded_length <= sizeof(encoded_frame)) {
+        handle_frame();
+    }
+    encoded_length = 0;
+
+}//end handle_byte
+
+//Function definition:
+
+int main(int argc, char **argv) {
+
+    uint8_t read_buffer[256];
+
+    if(argc < 3) {
+        fprintf(stderr, "Usage: %s serial_device output_file\n", argv[0]);
+        return 1;
+    }
+
+    serial_fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if(serial_fd < 0) {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    while(true) {
+
+        fd_set read_set;
+        struct timeval timeout = {1, 0};
+        FD_ZERO(&read_set);
+        FD_SET(serial_fd, &read_set);
+
+        int ready = select(serial_fd + 1, &read_set, NULL, NULL, transfer_complete ? &timeout : NULL);
+        if(ready == 0) {
+            //Nothing received for a second after the transfer was complete
+            break;
+        }
+        if(ready < 0) {
+            fprintf(stderr, "Could not read from %s\n", argv[1]);
+            return 1;
+        }
+
+        ssize_t length = read(serial_fd, read_buffer, sizeof(read_buffer));
+        for(ssize_t k = 0; k < length; k++) {
+            handle_byte(read_buffer[k]);
+        }
+    }
+
+    close(serial_fd);
+
+    if(get_crc32(received_data, total_bytes) != data_crc) {
+        fprintf(stderr, "CRC of the received data does not match\n");
+        return 2;
+    }
+
+    FILE *output = fopen(argv[2], "wb");
+    if(output == NULL || fwrite(received_data, 1, total_bytes, output) != total_bytes) {
+        fprintf(stderr, "Could not write %s\n", argv[2]);
+        return 1;
+    }
+    fclose(output);
+
+    fprintf(stderr, "%lu bytes received, %lu duplicate frames, %lu corrupted frames\n", (unsigned long)total_bytes, (unsigned long)duplicate_frames,
+        (unsigned long)corrupted_frames);
+
+    return 0;
+
+}//end main
+
+//end file uart_arq_receiver.c
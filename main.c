@@ -51,9 +51,14 @@
 #include "hardware/clocks.h"
 #include "hardware/spi.h"
 #include "hardware/pwm.h"
+#include "hardware/flash.h"
 
 // Own library:
 #include "uart.h"
+#include "uart_mux.h"
+#include "uart_baud.h"
+#include "uart_result.h"
+#include "flash.h"
 #include "pwm.h"
 
 // Preprocessor:
@@ -74,6 +79,49 @@
 */
 #define EN_UART_TX false
 
+// Control messages are sent in up to 4 parts (see get_ctrl_msg_segments)
+#define CTRL_MSG_MAX_SEGMENTS 4
+
+/*
+    Preprocessor that controls if ctrl messages are sent over virtual 
+    channels (uart_mux) instead of plain text lines. Each core gets its own 
+    channel, so messages of one core never wait for a long output of the 
+    other core. The control channel of core0 has the higher weight.
+    Result frames (uart_result_send) go to the bulk channel with the 
+    lowest weight, the host splits the channels with result_frame_decoder -m.
+    Needs EN_UART_TX set to true.
+*/
+#define EN_UART_MUX false
+
+#define UART_MUX_CH_CORE0 0
+#define UART_MUX_CH_CORE1 1
+#define UART_MUX_CH_BULK 2
+
+#define UART_MUX_WEIGHT_CORE0 4
+#define UART_MUX_WEIGHT_CORE1 2
+#define UART_MUX_WEIGHT_BULK 1
+
+/*
+    Preprocessor that controls if the sub answers the baudrate negotiation
+    (uart_baud) of the other end. The UART starts with UART_BAUD_RATE, which
+    is the base step of the baudrate ladder. The sub steps down the ladder
+    when its receive error rate rises. With the command NEGOTIATE_BAUD_RATE
+    the sub steps up the ladder itself (initiator), the other end answers.
+    The ladder step is stored in the flash utility section (last flash
+    sector) and restored at init, before the first control message is sent.
+    Core1 runs from flash, so it waits in RAM while core0 writes the ladder
+    step.
+    Needs EN_UART_TX set to true and EN_UART_MUX set to false.
+*/
+#define EN_UART_BAUD_NEGOTIATION false
+
+#define UART_BAUD_RESPONSE_TIMEOUT_US 20000
+#define UART_BAUD_MAX_ERROR_RATE_PPM 1000
+#define UART_BAUD_MONITOR_WINDOW_BYTES 4096
+#define UART_BAUD_PATTERN_LINES 16
+#define UART_BAUD_PATTERN_LENGTH 64
+#define UART_BAUD_FLASH_UTILITY_OFFSET (FLASH_END_OFFSET - FLASH_SECTOR_SIZE)
+
 // PWM:
 #define PWM_PIN 8
 #define PWM_CLK_FREQUENCY 125*MHZ
@@ -132,6 +180,7 @@ typedef enum User_Cmd_e {
     UCMD_STOP_ADC,
     UCMD_STOP_SPI,
     UCMD_RESET,
+    UCMD_NEGOTIATE_BAUD,
     UCMD_INV_CMD
 
 }User_Cmd_t;
@@ -192,11 +241,12 @@ static uint16_t pwm_lvl_table_index = 0;
 
 // Core1 variables (Do not use them in CORE0 ISR or static functions!!!)
 
-// Flag to set that core1 received message interrupt from core0
+// Flag to set that core1 received a command from core0 (set by core0 with 
+// send_core1_cmd, the SIO FIFO is used by the multicore lockout)
 static volatile bool core1_received_cmd = false;
 
 // CMD from core0
-Core_Cmd_t cmd_from_core0 = CCMD_STOP;
+static volatile Core_Cmd_t cmd_from_core0 = CCMD_STOP;
 
 // PWM hold time timer:
 static struct repeating_timer spi_ht_timer;
@@ -225,8 +275,8 @@ static bool pwm_hold_time_timer_cb(struct repeating_timer *t);
 
 static bool spi_hold_time_timer_cb(struct repeating_timer *t);
 
-// Multicore communication interrupt in core1
-static void __not_in_flash_func (core1_fifo_isr)(void);
+// Multicore communication: command from core0 to core1
+static void send_core1_cmd(Core_Cmd_t cmd);
 
 // State to string functions:
 static void get_str_from_c0_state(CORE0_State_t state, uint8_t *state_str);
@@ -239,11 +289,15 @@ CORE1_State_t new_state, uint8_t *str);
 // Command parsing
 
 static User_Cmd_t get_user_cmd(uint8_t *cmd_str);
-static Core_Cmd_t get_core_cmd(uint32_t cmd);
+
+#if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
+    // Flash storing of the ladder step
+    static void store_uart_baud_index(uint8_t ladder_index);
+#endif
 
 // PWM Setup:
 
-static uint16_t setup_pwm_dac(uint8_t pwm_dac_gpio, uint dma_ch, 
+static int32_t setup_pwm_dac(uint8_t pwm_dac_gpio, uint dma_ch, 
     float pwm_clk_freq, float pwm_freq, uint16_t *pwm_lvl_table);
 static int8_t start_pwm_dac(uint8_t pwm_dac_gpio, uint dma_ch, 
     uint16_t *pwm_lvl_table, uint32_t hold_time, bool hold_time_ms, 
@@ -266,7 +320,8 @@ static int8_t stop_spi_tx(uint dma_data_ch, uint dma_ctrl_ch,
 // Core control message functions:
 static Ctrl_Msg_t get_ctrl_msg(Ctrl_Msg_Type_t type, Core_ID_t id, 
     uint8_t *data);
-static void get_ctrl_msg_str(Ctrl_Msg_t ctrl_msg, uint8_t *ctrl_msg_str);
+static uint8_t get_ctrl_msg_segments(Ctrl_Msg_t *ctrl_msg, 
+    Uart_Tx_Segment_t *segments);
 static void send_ctrl_msg(Ctrl_Msg_t ctrl_msg, uart_inst_t *uart_hw, 
 semaphore_t *uart_sem);
 
@@ -290,7 +345,6 @@ void main_core1(void) {
 
     // Buffer to transmit acquired data
     uint8_t uart_tx_buffer[MAX_UART_DATA_SIZE];
-    clear_uart_buffer(uart_tx_buffer);
 
     // Core 1 super loop
     while(true) {
@@ -299,10 +353,9 @@ void main_core1(void) {
         switch(state) {
             case C1_INIT:
 
-                // Enable core 1 FIFO interrupt - to communicate with core0
-                multicore_fifo_clear_irq();
-                irq_set_exclusive_handler(SIO_IRQ_PROC1, core1_fifo_isr);
-                irq_set_enabled(SIO_IRQ_PROC1, true);
+                // Core0 could hold core1 in RAM while it writes the flash
+                // (multicore lockout over the SIO FIFO interrupt)
+                multicore_lockout_victim_init();
 
                 // Reset flag
                 core1_received_cmd = false;
@@ -416,8 +469,10 @@ void main_core1(void) {
             case C1_SLEEP:
                 core1_ctrl_msg = get_ctrl_msg(GO_SLEEP, CORE1, NULL);
                 send_ctrl_msg(core1_ctrl_msg, UART_ID, &uart_sem);
-                // Set core to sleep
-                __wfi();
+                // Set core to sleep till core0 sends a command
+                while(!core1_received_cmd) {
+                    __wfe();
+                }
                 core1_ctrl_msg = get_ctrl_msg(WAKEUP, CORE1, NULL);
                 send_ctrl_msg(core1_ctrl_msg, UART_ID, &uart_sem);
                 break;
@@ -475,7 +530,6 @@ int main() {
     // UART RX and TX buffers
     uint8_t uart_tx_buffer[MAX_UART_DATA_SIZE];
     uint8_t uart_rx_buffer[MAX_UART_DATA_SIZE];
-    clear_uart_buffer(uart_tx_buffer);
     clear_uart_buffer(uart_rx_buffer);
 
     // User command
@@ -487,6 +541,28 @@ int main() {
     // Control message to user
     Ctrl_Msg_t core0_ctrl_msg;
 
+    // PWM DAC is only started if its frequency could be set
+    bool pwm_dac_is_configured = false;
+
+    #if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
+        // Baudrate negotiation settings (the pattern burst is only used if
+        // the sub is the initiator)
+        Uart_Baud_Config_t uart_baud_config = {
+            .num_of_pattern_lines = UART_BAUD_PATTERN_LINES,
+            .pattern_length = UART_BAUD_PATTERN_LENGTH,
+            .max_error_rate_ppm = UART_BAUD_MAX_ERROR_RATE_PPM,
+            .response_timeout_us = UART_BAUD_RESPONSE_TIMEOUT_US,
+            .monitor_window_bytes = UART_BAUD_MONITOR_WINDOW_BYTES,
+            // Stored by store_uart_baud_index(), core1 has to be held in RAM
+            .persist_to_flash = false,
+            .use_watchdog = false
+        };
+
+        // Result of the restore at init and the ladder step stored in flash
+        Uart_Baud_Result_t uart_baud_result;
+        uint8_t uart_baud_stored_index = UART_BAUD_BASE_INDEX;
+    #endif
+
     // Main super loop
     while(true) {
 
@@ -511,6 +587,32 @@ int main() {
                 // Init semaphore
                 sem_init(&uart_sem, 1, 1);
 
+                #if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
+                    // Both ends start at the base step of the baudrate ladder,
+                    // the stored step is restored before the first control
+                    // message (core1 is not running yet, flash is usable)
+                    flash_set_flash_utility_section_offset(
+                        UART_BAUD_FLASH_UTILITY_OFFSET);
+                    init_flash();
+                    uart_baud_init(UART_ID, UART_BAUD_BASE_INDEX);
+                    uart_baud_restore(UART_ID, uart_baud_config, 
+                        &uart_baud_result);
+                    uart_baud_stored_index = uart_baud_get_ladder_index(UART_ID);
+                #endif
+
+                #if EN_UART_TX && EN_UART_MUX
+                    // Setup virtual channels on UART
+                    uart_mux_init(UART_ID);
+                    uart_mux_configure_channel(UART_MUX_CH_CORE0, 
+                        UART_MUX_WEIGHT_CORE0);
+                    uart_mux_configure_channel(UART_MUX_CH_CORE1, 
+                        UART_MUX_WEIGHT_CORE1);
+                    uart_mux_configure_channel(UART_MUX_CH_BULK, 
+                        UART_MUX_WEIGHT_BULK);
+                    // Result frames must not use the plain UART TX anymore
+                    uart_result_set_mux_channel(true, UART_MUX_CH_BULK);
+                #endif
+
                 core0_ctrl_msg = get_ctrl_msg(FIN_INIT, CORE0, NULL);
                 send_ctrl_msg(core0_ctrl_msg, UART_ID, &uart_sem);
 
@@ -521,9 +623,16 @@ int main() {
                 c1_state = C1_SLEEP;
 
                 // Init PWM
-                uint16_t pwm_wrap = 
+                int32_t pwm_wrap = 
                 setup_pwm_dac(PWM_PIN, PWM_LVL_DMA_CH, PWM_CLK_FREQUENCY, 
                     PWM_FREQUENCY, pwm_lvl_table);
+                pwm_dac_is_configured = (pwm_wrap >= 0);
+                if(!pwm_dac_is_configured) {
+                    core0_ctrl_msg = get_ctrl_msg(ERROR, CORE0, 
+                        "PWM frequency not reachable");
+                    send_ctrl_msg(core0_ctrl_msg, UART_ID, &uart_sem);
+                    pwm_wrap = 0;
+                }
 
                 /*
                     Generate pwm lvl table.
@@ -568,8 +677,11 @@ int main() {
                 send_ctrl_msg(core0_ctrl_msg, UART_ID, &uart_sem);
 
                 // Start PWM
-                start_pwm_dac(PWM_PIN, PWM_LVL_DMA_CH, pwm_lvl_table, 
-                    PWM_HOLD_TIME_MS, true, &pwm_ht_timer, pwm_hold_time_timer_cb);
+                if(pwm_dac_is_configured) {
+                    start_pwm_dac(PWM_PIN, PWM_LVL_DMA_CH, pwm_lvl_table, 
+                        PWM_HOLD_TIME_MS, true, &pwm_ht_timer, 
+                        pwm_hold_time_timer_cb);
+                }
                 
                 last_state = state;
                 
@@ -597,6 +709,25 @@ int main() {
 
             clear_uart_buffer(uart_rx_buffer);
             uart_get_rx_data(UART_ID, uart_rx_buffer);
+
+            #if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
+                // Baudrate negotiation lines are no user commands, core1 
+                // must not send during a ladder step test
+                sem_acquire_blocking(&uart_sem);
+                bool baud_cmd = uart_baud_handle_command(UART_ID, 
+                    uart_rx_buffer, uart_baud_config);
+                sem_release(&uart_sem);
+                if(baud_cmd) {
+                    if(uart_baud_get_ladder_index(UART_ID) != 
+                        uart_baud_stored_index) {
+                        uart_baud_stored_index = 
+                        uart_baud_get_ladder_index(UART_ID);
+                        store_uart_baud_index(uart_baud_stored_index);
+                    }
+                    continue;
+                }
+            #endif
+
             core0_ctrl_msg = get_ctrl_msg(CMD_RCVD, CORE0, uart_rx_buffer);
             send_ctrl_msg(core0_ctrl_msg, UART_ID, &uart_sem);
             user_cmd = get_user_cmd(uart_rx_buffer);
@@ -608,7 +739,7 @@ int main() {
                     next_state = C0_SLEEP;
                     //If core1 is not already processing command to read/proc
                     if(c1_state != C1_GENERATE) {
-                        multicore_fifo_push_blocking(1);
+                        send_core1_cmd(CCMD_START);
                         c1_state = C1_GENERATE;
                     }
                     break;
@@ -617,7 +748,7 @@ int main() {
                     next_state = C0_SLEEP;
                     //If core1 is not sleeping command it to do so
                     if(c1_state != C1_SLEEP) {
-                        multicore_fifo_push_blocking(0);
+                        send_core1_cmd(CCMD_STOP);
                         c1_state = C1_SLEEP;
                     }
                     break;
@@ -629,7 +760,7 @@ int main() {
                     // Send command to core1 to start SPI
                     //If core1 is not already reading processing command it
                     if(c1_state != C1_GENERATE) {
-                        multicore_fifo_push_blocking(1);
+                        send_core1_cmd(CCMD_START);
                         c1_state = C1_GENERATE;
                     }
                     state = C0_SLEEP;
@@ -642,16 +773,53 @@ int main() {
                 case UCMD_STOP_SPI:
                     //If core1 is not sleeping command it to do so
                     if(c1_state != C1_SLEEP) {
-                        multicore_fifo_push_blocking(0);
+                        send_core1_cmd(CCMD_STOP);
                         c1_state = C1_SLEEP;
                     }
                     state = C0_SLEEP;
                     next_state = C0_SLEEP;
                     break;
+                case UCMD_NEGOTIATE_BAUD:
+                    #if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
+                        // Core1 must not send during a ladder step test
+                        sem_acquire_blocking(&uart_sem);
+                        int baud_ret = uart_baud_negotiate(UART_ID, 
+                            uart_baud_config, &uart_baud_result);
+                        sem_release(&uart_sem);
+                        if(baud_ret < 0) {
+                            core0_ctrl_msg = get_ctrl_msg(ERROR, CORE0, 
+                                "BAUDRATE NEGOTIATION FAILED");
+                        }
+                        else {
+                            sprintf(uart_tx_buffer, "BAUDRATE: %lu", 
+                                (unsigned long)uart_baud_result.baud_rate);
+                            core0_ctrl_msg = get_ctrl_msg(CHANGE_STATE, 
+                                CORE0, uart_tx_buffer);
+                        }
+                        send_ctrl_msg(core0_ctrl_msg, UART_ID, &uart_sem);
+                        if(uart_baud_get_ladder_index(UART_ID) != 
+                            uart_baud_stored_index) {
+                            uart_baud_stored_index = 
+                            uart_baud_get_ladder_index(UART_ID);
+                            store_uart_baud_index(uart_baud_stored_index);
+                        }
+                    #endif
+                    break;
                 default: break;
             }
         }
 
+        #if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
+            // Step down the baudrate ladder if the receive error rate rises
+            sem_acquire_blocking(&uart_sem);
+            uart_baud_monitor(UART_ID, uart_baud_config);
+            sem_release(&uart_sem);
+            if(uart_baud_get_ladder_index(UART_ID) != uart_baud_stored_index) {
+                uart_baud_stored_index = uart_baud_get_ladder_index(UART_ID);
+                store_uart_baud_index(uart_baud_stored_index);
+            }
+        #endif
+
        tight_loop_contents();
  
     } // end main super loop
@@ -683,32 +851,6 @@ static bool pwm_hold_time_timer_cb(struct repeating_timer *t) {
 
 // Interrupt service routine core 1: 
 
-// Multicore communication interrupt in core1
-
-static void __not_in_flash_func (core1_fifo_isr)(void) {
-
-    // Flag that core1 program is notified that action needs to be taken
-    core1_received_cmd = true;
-
-    // Clear interrupt
-    multicore_fifo_clear_irq();
-
-    // If valid data is in the FIFO
-    if(multicore_fifo_rvalid()) {
-
-        // Read all data that is in the FIFO (Should be one uint32_t)
-        while(multicore_fifo_rvalid()) {
-            uint32_t core0_msg = multicore_fifo_pop_blocking();
-            // Parse command for core 1
-            cmd_from_core0 = get_core_cmd(core0_msg);
-            break;
-        }
-        // Drain FIFO for next command.
-        multicore_fifo_drain();
-    }
-
-} // end core1_fifo_isr
-
 static bool spi_hold_time_timer_cb(struct repeating_timer *t) {
 
     // If index reached end of table restart again.
@@ -828,31 +970,64 @@ static User_Cmd_t get_user_cmd(uint8_t *cmd_str) {
     else if(strcmp(cmd_str, "STOP_SPI") == 0) {
         return UCMD_STOP_SPI;
     }
+    else if(strcmp(cmd_str, "NEGOTIATE_BAUD_RATE") == 0) {
+        return UCMD_NEGOTIATE_BAUD;
+    }
     else {
         return UCMD_INV_CMD;
     }
 
 } // end get_user_cmd
 
-static Core_Cmd_t get_core_cmd(uint32_t cmd) {
+// Multicore communication:
 
-    if(cmd == 0) {
-        return CCMD_STOP;
-    }
-    else if(cmd == 1) {
-        return CCMD_START;
-    }
+static void send_core1_cmd(Core_Cmd_t cmd) {
+
+    // Core1 reads the command after the flag, __sev wakes it from __wfe
+    cmd_from_core0 = cmd;
+    core1_received_cmd = true;
+    __sev();
+
+} // end send_core1_cmd
+
+#if EN_UART_TX && EN_UART_BAUD_NEGOTIATION && !EN_UART_MUX
 
-    // Else return invalid command
-    return CCMD_INV_CMD;
+// Flash storing of the ladder step:
 
-} // end get_core_cmd
+static void store_uart_baud_index(uint8_t ladder_index) {
+
+    // Hold core1 in RAM, the XIP is off while the flash is written
+    multicore_lockout_start_blocking();
+    uart_baud_store_index(ladder_index);
+    multicore_lockout_end_blocking();
+
+} // end store_uart_baud_index
+
+#endif
 
 // PWM Setup:
 
-static uint16_t setup_pwm_dac(uint8_t pwm_dac_gpio, uint dma_ch, 
+static int32_t setup_pwm_dac(uint8_t pwm_dac_gpio, uint dma_ch, 
     float pwm_clk_freq, float pwm_freq, uint16_t *pwm_lvl_table) {
 
+    /*
+        Select divider and wrap with the integer solver (exact frequency).
+        The pwm clock frequency gives the minimum resolution (wrap).
+    */
+    PWM_Divider_t divider;
+    if((uint32_t)pwm_freq == 0) {
+        return -1; // Error: frequency could not be reached
+    }
+    uint32_t min_wrap = (uint32_t)pwm_clk_freq/(uint32_t)pwm_freq;
+    if(min_wrap > 0) {
+        min_wrap--;
+    }
+    if(min_wrap > UINT16_MAX || pwm_solve_divider(clock_get_hz(clk_sys), 
+        (uint32_t)pwm_freq, (uint16_t)min_wrap, PWM_DIVIDER_MIN_ERROR, 
+        &divider) < 0) {
+        return -1; // Error: frequency could not be reached
+    }
+
     // Get slice and channel from gpio pin
     uint8_t pwm_slice = pwm_gpio_to_slice_num(pwm_dac_gpio);
     uint8_t pwm_channel = pwm_gpio_to_channel(pwm_dac_gpio);
@@ -862,16 +1037,12 @@ static uint16_t setup_pwm_dac(uint8_t pwm_dac_gpio, uint dma_ch,
     gpio_set_function(pwm_dac_gpio, GPIO_FUNC_PWM);
     gpio_set_dir(pwm_dac_gpio, true);
 
-    //Get prescaler value
-    float pwm_clk_div = (float)(clock_get_hz(clk_sys)/pwm_clk_freq);
-    //Set pwm prescaler
-    pwm_set_clkdiv(pwm_slice, pwm_clk_div);
-    
     /*
-        Set pwm wrap. 
-        If pwm counter reaches wrap -> toggle. Therefore sets high time
+        Set the selected divider and wrap.
+        If counter reaches wrap -> toggle. Therefore sets high time
     */
-    uint16_t pwm_wrap = (uint16_t)(pwm_clk_freq/pwm_freq);
+    pwm_set_clkdiv_int_frac(pwm_slice, divider.div_int, divider.div_frac);
+    uint16_t pwm_wrap = divider.wrap;
     pwm_set_wrap(pwm_slice, pwm_wrap);
 
     /*
@@ -1105,78 +1276,103 @@ static Ctrl_Msg_t get_ctrl_msg(Ctrl_Msg_Type_t type, Core_ID_t id,
     
     } // end get_ctrl_msg
 
-static void get_ctrl_msg_str(Ctrl_Msg_t ctrl_msg, uint8_t *ctrl_msg_str) {
+// Splits a control message into the parts "<core> <level>: <text>", the
+// parts are sent without building the whole message in a buffer.
+static uint8_t get_ctrl_msg_segments(Ctrl_Msg_t *ctrl_msg, 
+    Uart_Tx_Segment_t *segments) {
 
-    uint8_t core_str[6];
-    if(ctrl_msg.src_id == CORE0) {
-        strcpy(core_str, "CORE0");
-    }
-    else {
-        strcpy(core_str, "CORE1");
-    }
+    const uint8_t *level_str = " INFO: ";
+    const uint8_t *text_str = NULL;
+
+    segments[0].data = (ctrl_msg->src_id == CORE0) ? "CORE0" : "CORE1";
+    segments[0].length = UART_TX_SEGMENT_STRING;
 
-    switch(ctrl_msg.type) {
+    switch(ctrl_msg->type) {
     case FIN_INIT:
-        sprintf(ctrl_msg_str, "%s INFO: INITIALIZATION FINISHED", core_str);
-        return;
+        text_str = "INITIALIZATION FINISHED";
+        break;
     case GO_SLEEP:
-        sprintf(ctrl_msg_str, "%s INFO: CORE GOES SLEEPING", core_str);
-        return;
+        text_str = "CORE GOES SLEEPING";
+        break;
     case WAKEUP:
-        sprintf(ctrl_msg_str, "%s INFO: CORE WAKEUP FROM INTERRUPT", core_str);
-        return;
+        text_str = "CORE WAKEUP FROM INTERRUPT";
+        break;
     case START_ADC:
-        sprintf(ctrl_msg_str, "%s INFO: START_PWM", core_str);
-        return;
+        text_str = "START_PWM";
+        break;
     case STOP_ADC:
-        sprintf(ctrl_msg_str, "%s INFO: STOP_PWM", core_str);
-        return;
+        text_str = "STOP_PWM";
+        break;
     case START_SPI:
-        sprintf(ctrl_msg_str, "%s INFO: START_SPI", core_str);
-        return;
+        text_str = "START_SPI";
+        break;
     case STOP_SPI:
-        sprintf(ctrl_msg_str, "%s INFO: STOP_SPI", core_str);
-        return;
+        text_str = "STOP_SPI";
+        break;
     case RESET:
-        sprintf(ctrl_msg_str, "%s INFO: RESET", core_str);
-        return;
+        text_str = "RESET";
+        break;
     case CMD_RCVD:
-        sprintf(
-            ctrl_msg_str,
-            
-            "%s INFO: COMMAND: ""%s"" RECEIVED ", 
-            core_str, ctrl_msg.data
-        );
-        return;
+        segments[1] = (Uart_Tx_Segment_t){" INFO: COMMAND: ", 
+            UART_TX_SEGMENT_STRING};
+        segments[2] = (Uart_Tx_Segment_t){ctrl_msg->data, 
+            UART_TX_SEGMENT_STRING};
+        segments[3] = (Uart_Tx_Segment_t){" RECEIVED ", 
+            UART_TX_SEGMENT_STRING};
+        return 4;
     case CHANGE_STATE:
-        sprintf(ctrl_msg_str,"%s INFO: %s",core_str, ctrl_msg.data);
-        return;
+        text_str = ctrl_msg->data;
+        break;
     case ERROR:
-        sprintf(ctrl_msg_str,"%s ERROR: %s",core_str,ctrl_msg.data);
-        return;
+        level_str = " ERROR: ";
+        text_str = ctrl_msg->data;
+        break;
     case DEBUG:
-        sprintf(ctrl_msg_str,"%s DEBUG: %s",core_str,ctrl_msg.data);
-        return;
-    default:
-        strcpy(ctrl_msg_str, "EMPTY");
+        level_str = " DEBUG: ";
+        text_str = ctrl_msg->data;
         break;
+    default:
+        segments[0].data = "EMPTY";
+        return 1;
     }
 
-}// end get_ctrl_msg_str
+    segments[1] = (Uart_Tx_Segment_t){level_str, UART_TX_SEGMENT_STRING};
+    segments[2] = (Uart_Tx_Segment_t){text_str, UART_TX_SEGMENT_STRING};
+    return 3;
+
+}// end get_ctrl_msg_segments
 
 static void send_ctrl_msg(Ctrl_Msg_t ctrl_msg, uart_inst_t *uart_hw,
 semaphore_t *uart_sem) {
 
-    uint8_t ctrl_msg_str[MAX_UART_DATA_SIZE];
-    get_ctrl_msg_str(ctrl_msg, ctrl_msg_str);
+    Uart_Tx_Segment_t segments[CTRL_MSG_MAX_SEGMENTS];
+    uint8_t num_of_segments = get_ctrl_msg_segments(&ctrl_msg, segments);
 
     // Preprocessor that controls if ctrl messages get transmitted.
-    #if EN_UART_TX
+    #if EN_UART_TX && EN_UART_MUX
+        // The multiplexer needs the whole message for its frame, gather the
+        // parts into one buffer.
+        uint8_t ctrl_msg_str[MAX_UART_DATA_SIZE];
+        uint32_t ctrl_msg_length = 0;
+        for(uint8_t n = 0; n < num_of_segments; n++) {
+            uint32_t length = strlen((char *)segments[n].data);
+            if((ctrl_msg_length + length) >= MAX_UART_DATA_SIZE) {
+                length = MAX_UART_DATA_SIZE - 1 - ctrl_msg_length;
+            }
+            memcpy(&ctrl_msg_str[ctrl_msg_length], segments[n].data, length);
+            ctrl_msg_length += length;
+        }
+
+        // Queue control message on the channel of the sending core, the 
+        // multiplexer takes care of the synchronisation.
+        uart_mux_send((ctrl_msg.src_id == CORE0) ? UART_MUX_CH_CORE0 : 
+            UART_MUX_CH_CORE1, ctrl_msg_str, ctrl_msg_length, true);
+    #elif EN_UART_TX
         // Block till semaphore is free
         sem_acquire_blocking(uart_sem);
 
         // Send control message
-        uart_tx_data(uart_hw, ctrl_msg_str);
+        uart_tx_iov(uart_hw, segments, num_of_segments, true);
 
         // Release semaphore again signaling the resource is not in use anymore.
         sem_release(uart_sem);